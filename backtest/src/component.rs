@@ -0,0 +1,110 @@
+//! The trait objects a backtest is made of, and how they are built from layout nodes.
+
+use anyhow::{anyhow, Result};
+use orchestrator_protocol::model::Node;
+use std::collections::HashMap;
+use trading::traits::data_feed::DataFeed;
+use trading::{Broker, Executor, Manager, Multiplexist, Strategist};
+
+/// One layout node, instantiated in process.
+pub enum Component {
+    Feed(Box<dyn DataFeed + Send>),
+    Strategy(Box<dyn Strategist>),
+    Multiplexer(Box<dyn Multiplexist>),
+    Manager(Box<dyn Manager>),
+    Executor(Box<dyn Executor>),
+    Broker(Box<dyn Broker>),
+}
+
+/// Kind of payload carried by a port.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum PayloadKind {
+    MarketData,
+    Allocation,
+    Target,
+    Orders,
+    Executions,
+    Portfolio,
+}
+
+impl Component {
+    /// Returns the input ports of the component, named as in the service manifests.
+    pub fn inputs(&self) -> &'static [(&'static str, PayloadKind)] {
+        use PayloadKind::*;
+        match self {
+            Component::Feed(_) => &[],
+            Component::Strategy(_) => &[("market_data", MarketData)],
+            Component::Multiplexer(_) => &[("strategies", Allocation)],
+            Component::Manager(_) => &[
+                ("allocation", Allocation),
+                ("portfolio", Portfolio),
+                ("market_data", MarketData),
+            ],
+            Component::Executor(_) => &[("target", Target), ("execution_result", Executions)],
+            Component::Broker(_) => &[("orders", Orders), ("market_data", MarketData)],
+        }
+    }
+
+    /// Returns the output ports of the component, named as in the service manifests.
+    pub fn outputs(&self) -> &'static [(&'static str, PayloadKind)] {
+        use PayloadKind::*;
+        match self {
+            Component::Feed(_) => &[("market_data", MarketData)],
+            Component::Strategy(_) | Component::Multiplexer(_) => &[("allocation", Allocation)],
+            Component::Manager(_) => &[("target", Target)],
+            Component::Executor(_) => &[("orders", Orders), ("portfolio", Portfolio)],
+            Component::Broker(_) => &[("execution_result", Executions), ("portfolio", Portfolio)],
+        }
+    }
+}
+
+/// Builds a component for a layout node.
+pub type Factory = Box<dyn Fn(&Node) -> Result<Component>>;
+
+/// Maps the `service` of layout nodes to the code that instantiates them.
+///
+/// This is the in-process counterpart of the orchestrator's service catalog:
+/// instead of a binary per service type, a factory returning the trait object the
+/// binary would have wrapped.
+#[derive(Default)]
+pub struct ComponentRegistry {
+    factories: HashMap<String, Factory>,
+}
+
+impl ComponentRegistry {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Registers (or replaces) the factory of a service type.
+    ///
+    /// # Arguments
+    ///
+    /// * `service` - The `service` field of the layout nodes to build.
+    /// * `factory` - Builds the component, given the node.
+    pub fn register(
+        &mut self,
+        service: &str,
+        factory: impl Fn(&Node) -> Result<Component> + 'static,
+    ) -> &mut Self {
+        self.factories
+            .insert(service.to_string(), Box::new(factory));
+        self
+    }
+
+    /// Instantiates a node.
+    ///
+    /// # Returns
+    ///
+    /// * `Err` if no factory is registered for the node's service, or the factory fails.
+    pub fn create(&self, node: &Node) -> Result<Component> {
+        let factory = self.factories.get(node.service()).ok_or_else(|| {
+            anyhow!(
+                "No backtest component registered for service '{}' (node '{}')",
+                node.service(),
+                node.id()
+            )
+        })?;
+        factory(node)
+    }
+}
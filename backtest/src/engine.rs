@@ -0,0 +1,526 @@
+//! The fused event loop of a backtest.
+
+use crate::component::{Component, ComponentRegistry, PayloadKind};
+use anyhow::{bail, Result};
+use log::info;
+use orchestrator_protocol::model::Layout;
+use std::collections::{HashMap, VecDeque};
+use trading::model::{
+    allocation_batch::AllocationBatch,
+    execution_batch::ExecutionBatch,
+    market_data::MarketDataBatch,
+    order_batch::OrderBatch,
+    portfolio::{Actual, Target},
+};
+
+/// A payload in flight between two nodes.
+#[derive(Clone)]
+enum Message {
+    MarketData(MarketDataBatch),
+    Allocation(AllocationBatch),
+    Target(Target),
+    Orders(OrderBatch),
+    Executions(ExecutionBatch),
+    Portfolio(Actual),
+}
+
+struct Delivery {
+    source: usize,
+    target: usize,
+    message: Message,
+}
+
+struct Slot {
+    component: Component,
+    /// Targets of every output port.
+    routes: HashMap<&'static str, Vec<usize>>,
+    /// Next batch of a feed, read ahead to merge feeds by timestamp.
+    pending: Option<MarketDataBatch>,
+    exhausted: bool,
+}
+
+/// What a backtest did.
+#[derive(Debug, Clone, Default)]
+pub struct BacktestReport {
+    /// Market data batches published by the feeds.
+    pub market_data_batches: u64,
+    /// Messages handed to a node.
+    pub deliveries: u64,
+    /// Orders received by brokers.
+    pub orders: u64,
+    /// Execution reports produced by brokers.
+    pub executions: u64,
+    /// Simulated time: the latest market data timestamp published.
+    pub clock: u64,
+    /// Last portfolio snapshot published by a broker.
+    pub last_actual: Option<Actual>,
+}
+
+/// A layout running in a single thread, with every edge a direct function call.
+///
+/// Feeds are merged in timestamp order (ties go to the node listed first) and each
+/// market data batch is processed to completion, breadth-first, before the next
+/// one is read: given deterministic components, every run is identical. Time is
+/// simulated: it advances with the market data, nothing ever sleeps, and feed
+/// pacing is ignored. Brokers are flushed after every batch, as the broker
+/// gateway's idle tick would.
+///
+/// A feed returning `None` is considered exhausted. Outputs fanning out to several
+/// nodes are cloned once per extra target; `Target` is shared, not copied.
+pub struct Backtest {
+    slots: Vec<Slot>,
+    queue: VecDeque<Delivery>,
+    report: BacktestReport,
+}
+
+impl Backtest {
+    /// Instantiates every node of a layout and checks its edges.
+    ///
+    /// # Arguments
+    ///
+    /// * `layout` - The layout, as deployed by the orchestrator.
+    /// * `registry` - Builds the component of each node.
+    ///
+    /// # Returns
+    ///
+    /// * `Err` if a node cannot be built, or an edge names an unknown node or port or
+    ///   connects ports of different payload kinds.
+    pub fn from_layout(layout: &Layout, registry: &ComponentRegistry) -> Result<Self> {
+        let mut slots = Vec::with_capacity(layout.nodes().len());
+        let mut index = HashMap::new();
+        for node in layout.nodes() {
+            if index.insert(node.id(), slots.len()).is_some() {
+                bail!("Duplicate node '{}' in layout '{}'", node.id(), layout.id());
+            }
+            slots.push(Slot {
+                component: registry.create(node)?,
+                routes: HashMap::new(),
+                pending: None,
+                exhausted: false,
+            });
+        }
+
+        for edge in layout.edges() {
+            let (Some(&source), Some(&target)) =
+                (index.get(edge.source()), index.get(edge.target()))
+            else {
+                bail!("Edge '{}' connects unknown nodes", edge.id());
+            };
+            let Some(output) = port(slots[source].component.outputs(), edge.source_port()) else {
+                bail!(
+                    "Edge '{}': node '{}' has no output '{}'",
+                    edge.id(),
+                    edge.source(),
+                    edge.source_port()
+                );
+            };
+            let Some(input) = port(slots[target].component.inputs(), edge.target_port()) else {
+                bail!(
+                    "Edge '{}': node '{}' has no input '{}'",
+                    edge.id(),
+                    edge.target(),
+                    edge.target_port()
+                );
+            };
+            if output.1 != input.1 {
+                bail!(
+                    "Edge '{}' connects a {:?} output to a {:?} input",
+                    edge.id(),
+                    output.1,
+                    input.1
+                );
+            }
+            slots[source]
+                .routes
+                .entry(output.0)
+                .or_default()
+                .push(target);
+        }
+
+        Ok(Self {
+            slots,
+            queue: VecDeque::new(),
+            report: BacktestReport::default(),
+        })
+    }
+
+    /// Publishes the next market data batch and processes every message it causes.
+    ///
+    /// # Returns
+    ///
+    /// * `false` once every feed is exhausted.
+    pub fn step(&mut self) -> bool {
+        let clock = self.report.clock;
+        let mut next: Option<(u64, usize)> = None;
+        for (index, slot) in self.slots.iter_mut().enumerate() {
+            let Component::Feed(feed) = &mut slot.component else {
+                continue;
+            };
+            if slot.pending.is_none() && !slot.exhausted {
+                slot.pending = feed.get_market_data();
+                slot.exhausted = slot.pending.is_none();
+            }
+            if let Some(batch) = &slot.pending {
+                let timestamp = batch
+                    .get_timestamps()
+                    .iter()
+                    .max()
+                    .copied()
+                    .unwrap_or(clock);
+                if next.map_or(true, |(earliest, _)| timestamp < earliest) {
+                    next = Some((timestamp, index));
+                }
+            }
+        }
+        let Some((timestamp, feed)) = next else {
+            return false;
+        };
+
+        let batch = self.slots[feed].pending.take().unwrap();
+        self.report.clock = clock.max(timestamp);
+        self.report.market_data_batches += 1;
+        self.emit(feed, "market_data", Message::MarketData(batch));
+        self.drain();
+
+        // The simulated counterpart of the broker gateway's idle tick: snapshots held
+        // back by a broker's rate limit go out once the batch is processed.
+        for broker in 0..self.slots.len() {
+            let actual = match &mut self.slots[broker].component {
+                Component::Broker(component) => component.flush(),
+                _ => None,
+            };
+            if let Some(actual) = actual {
+                self.report.last_actual = Some(actual.clone());
+                self.emit(broker, "portfolio", Message::Portfolio(actual));
+                self.drain();
+            }
+        }
+        true
+    }
+
+    fn drain(&mut self) {
+        while let Some(delivery) = self.queue.pop_front() {
+            self.deliver(delivery);
+        }
+    }
+
+    /// Runs until every feed is exhausted.
+    pub fn run(mut self) -> BacktestReport {
+        while self.step() {}
+        info!(
+            "Backtest done: {} market data batches, {} orders, {} executions",
+            self.report.market_data_batches, self.report.orders, self.report.executions
+        );
+        self.report
+    }
+
+    /// Returns what the backtest did so far.
+    pub fn report(&self) -> &BacktestReport {
+        &self.report
+    }
+
+    fn emit(&mut self, source: usize, port: &'static str, message: Message) {
+        let Some(targets) = self.slots[source].routes.get(port) else {
+            return;
+        };
+        let Some((&last, rest)) = targets.split_last() else {
+            return;
+        };
+        for &target in rest {
+            self.queue.push_back(Delivery {
+                source,
+                target,
+                message: message.clone(),
+            });
+        }
+        self.queue.push_back(Delivery {
+            source,
+            target: last,
+            message,
+        });
+    }
+
+    fn deliver(&mut self, delivery: Delivery) {
+        self.report.deliveries += 1;
+        let Delivery {
+            source,
+            target,
+            message,
+        } = delivery;
+        let report = &mut self.report;
+
+        // Input kinds are unique per component, so the payload identifies the port.
+        let (first, second): (
+            Option<(&'static str, Message)>,
+            Option<(&'static str, Message)>,
+        ) = match (&mut self.slots[target].component, message) {
+            (Component::Strategy(strategy), Message::MarketData(batch)) => {
+                (allocation(strategy.on_market_data(batch)), None)
+            }
+            (Component::Multiplexer(multiplexer), Message::Allocation(batch)) => {
+                let aggregate = multiplexer.on_allocation_batch(source, batch);
+                (allocation(aggregate), None)
+            }
+            (Component::Manager(manager), Message::Allocation(batch)) => {
+                (manager.on_allocation(batch).map(target_output), None)
+            }
+            (Component::Manager(manager), Message::Portfolio(actual)) => {
+                (manager.on_portfolio(actual).map(target_output), None)
+            }
+            (Component::Manager(manager), Message::MarketData(batch)) => {
+                (manager.on_market_data_batch(batch).map(target_output), None)
+            }
+            (Component::Executor(executor), Message::Target(target)) => {
+                let mut orders = Vec::new();
+                let actual = executor.on_target_into(target, &mut orders);
+                (order_output(orders), actual.map(portfolio_output))
+            }
+            (Component::Executor(executor), Message::Executions(batch)) => {
+                let mut orders = Vec::new();
+                let actual = executor.on_executions_into(batch, &mut orders);
+                (order_output(orders), actual.map(portfolio_output))
+            }
+            (Component::Broker(broker), Message::Orders(batch)) => {
+                report.orders += batch.len() as u64;
+                let (executions, actual) = broker.on_orders(batch);
+                broker_output(report, executions, actual)
+            }
+            (Component::Broker(broker), Message::MarketData(batch)) => {
+                let (executions, actual) = broker.on_market_data(batch.view());
+                broker_output(report, executions, actual)
+            }
+            _ => unreachable!("edge payload kinds are checked when the layout is built"),
+        };
+
+        for (port, message) in first.into_iter().chain(second) {
+            self.emit(target, port, message);
+        }
+    }
+}
+
+fn port(
+    ports: &'static [(&'static str, PayloadKind)],
+    name: &str,
+) -> Option<(&'static str, PayloadKind)> {
+    ports.iter().copied().find(|(port, _)| *port == name)
+}
+
+fn allocation(batch: AllocationBatch) -> Option<(&'static str, Message)> {
+    (!batch.is_empty()).then(|| ("allocation", Message::Allocation(batch)))
+}
+
+fn target_output(target: Target) -> (&'static str, Message) {
+    ("target", Message::Target(target))
+}
+
+fn order_output(orders: Vec<trading::Order>) -> Option<(&'static str, Message)> {
+    (!orders.is_empty()).then(|| ("orders", Message::Orders(OrderBatch::new(orders))))
+}
+
+/// Accounts for what a broker reported and routes it to its outputs.
+fn broker_output(
+    report: &mut BacktestReport,
+    executions: ExecutionBatch,
+    actual: Option<Actual>,
+) -> (
+    Option<(&'static str, Message)>,
+    Option<(&'static str, Message)>,
+) {
+    report.executions += executions.len() as u64;
+    if let Some(actual) = &actual {
+        report.last_actual = Some(actual.clone());
+    }
+    let executions =
+        (!executions.is_empty()).then(|| ("execution_result", Message::Executions(executions)));
+    (executions, actual.map(portfolio_output))
+}
+
+fn portfolio_output(actual: Actual) -> (&'static str, Message) {
+    ("portfolio", Message::Portfolio(actual))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::layout_from_json;
+    use std::sync::{Arc, Mutex};
+    use trading::model::{
+        allocation::Allocation,
+        market_data::PriceUpdate,
+        order::{OrderSide, OrderType},
+        portfolio::Portfolio,
+    };
+    use trading::traits::data_feed::DataFeed;
+    use trading::{
+        Broker, ExecutionResult, ExecutionStatus, Executor, Manager, Multiplexist, Order,
+        Strategist,
+    };
+
+    struct VecFeed(VecDeque<MarketDataBatch>);
+
+    impl DataFeed for VecFeed {
+        fn get_market_data(&mut self) -> Option<MarketDataBatch> {
+            self.0.pop_front()
+        }
+    }
+
+    /// Targets one unit of instrument 1 per unit of timestamp, and records what it saw.
+    struct TimestampStrategy(Arc<Mutex<Vec<u64>>>);
+
+    impl Strategist for TimestampStrategy {
+        fn on_market_data(&mut self, md: MarketDataBatch) -> AllocationBatch {
+            let timestamp = md.get_timestamps()[0];
+            self.0.lock().unwrap().push(timestamp);
+            let mut allocation = Allocation::new();
+            allocation.update_position(1, timestamp as f64);
+            AllocationBatch::new(vec![allocation])
+        }
+    }
+
+    struct PassThrough;
+
+    impl Multiplexist for PassThrough {
+        fn on_allocation_batch(
+            &mut self,
+            _source_id: usize,
+            batch: AllocationBatch,
+        ) -> AllocationBatch {
+            batch
+        }
+    }
+
+    struct Follow;
+
+    impl Manager for Follow {
+        fn on_allocation(&mut self, batch: AllocationBatch) -> Option<Target> {
+            let mut portfolio = Portfolio::new();
+            for position in batch.iter().last()?.get_positions() {
+                portfolio
+                    .positions
+                    .set(position.get_instrument_id(), position.get_quantity());
+            }
+            Some(Target::new(portfolio))
+        }
+        fn on_portfolio(&mut self, _portfolio: Actual) -> Option<Target> {
+            None
+        }
+        fn on_market_data(&mut self, _market_data: PriceUpdate) -> Option<Target> {
+            None
+        }
+    }
+
+    /// Orders the full target quantity every time.
+    struct Naive(u64);
+
+    impl Executor for Naive {
+        fn on_target(&mut self, target: Target) -> (Vec<Order>, Option<Actual>) {
+            let orders = target
+                .0
+                .positions
+                .iter()
+                .map(|position| {
+                    self.0 += 1;
+                    Order::new(
+                        self.0,
+                        position.get_instrument_id(),
+                        OrderSide::buy(),
+                        OrderType::market(),
+                        0.0,
+                        position.get_quantity(),
+                        0,
+                    )
+                })
+                .collect();
+            (orders, None)
+        }
+        fn on_execution(&mut self, _execution: ExecutionResult) -> (Vec<Order>, Option<Actual>) {
+            (Vec::new(), None)
+        }
+    }
+
+    #[derive(Default)]
+    struct Fill(Portfolio);
+
+    impl Broker for Fill {
+        fn on_order(&mut self, order: Order) -> (Vec<ExecutionResult>, Option<Actual>) {
+            self.0
+                .positions
+                .add(order.get_instrument_id(), order.get_quantity());
+            let execution = ExecutionResult::new(
+                order.get_id(),
+                order.get_instrument_id(),
+                ExecutionStatus::Filled,
+                0,
+            );
+            (vec![execution], Some(Actual(self.0.clone())))
+        }
+    }
+
+    fn feed(timestamps: &[u64]) -> Component {
+        Component::Feed(Box::new(VecFeed(
+            timestamps
+                .iter()
+                .map(|&t| MarketDataBatch::new(vec![PriceUpdate::new(1, 9.0, 11.0, 10.0, t)]))
+                .collect(),
+        )))
+    }
+
+    #[test]
+    fn test_layout_runs_in_timestamp_order() {
+        let layout = layout_from_json(
+            r#"{ "layouts": { "bt": {
+                "id": "bt",
+                "nodes": [
+                    { "id": "a", "name": "A", "service": "feed_a", "status": "" },
+                    { "id": "b", "name": "B", "service": "feed_b", "status": "" },
+                    { "id": "s", "name": "S", "service": "strategy", "status": "" },
+                    { "id": "m", "name": "M", "service": "mux", "status": "" },
+                    { "id": "p", "name": "P", "service": "pm", "status": "" },
+                    { "id": "e", "name": "E", "service": "exec", "status": "" },
+                    { "id": "g", "name": "G", "service": "broker", "status": "" }
+                ],
+                "edges": [
+                    { "id": "1", "source": "a", "source_port": "market_data", "target": "s", "target_port": "market_data" },
+                    { "id": "2", "source": "b", "source_port": "market_data", "target": "s", "target_port": "market_data" },
+                    { "id": "3", "source": "s", "source_port": "allocation", "target": "m", "target_port": "strategies" },
+                    { "id": "4", "source": "m", "source_port": "allocation", "target": "p", "target_port": "allocation" },
+                    { "id": "5", "source": "p", "source_port": "target", "target": "e", "target_port": "target" },
+                    { "id": "6", "source": "e", "source_port": "orders", "target": "g", "target_port": "orders" },
+                    { "id": "7", "source": "g", "source_port": "execution_result", "target": "e", "target_port": "execution_result" }
+                ]
+            } } }"#,
+            "bt",
+        )
+        .unwrap();
+
+        let seen = Arc::new(Mutex::new(Vec::new()));
+        let strategy_seen = Arc::clone(&seen);
+        let mut registry = ComponentRegistry::new();
+        registry
+            .register("feed_a", |_| Ok(feed(&[1, 3])))
+            .register("feed_b", |_| Ok(feed(&[2])))
+            .register("strategy", move |_| {
+                Ok(Component::Strategy(Box::new(TimestampStrategy(
+                    Arc::clone(&strategy_seen),
+                ))))
+            })
+            .register("mux", |_| Ok(Component::Multiplexer(Box::new(PassThrough))))
+            .register("pm", |_| Ok(Component::Manager(Box::new(Follow))))
+            .register("exec", |_| Ok(Component::Executor(Box::new(Naive(0)))))
+            .register("broker", |_| {
+                Ok(Component::Broker(Box::new(Fill::default())))
+            });
+
+        let report = Backtest::from_layout(&layout, &registry).unwrap().run();
+        assert_eq!(*seen.lock().unwrap(), vec![1, 2, 3]);
+        assert_eq!(report.market_data_batches, 3);
+        assert_eq!(report.orders, 3);
+        assert_eq!(report.executions, 3);
+        assert_eq!(report.clock, 3);
+        let actual = report.last_actual.unwrap();
+        assert_eq!(actual.0.positions.quantity(1), 6.0);
+
+        registry.register("pm", |_| Ok(Component::Broker(Box::new(Fill::default()))));
+        assert!(Backtest::from_layout(&layout, &registry).is_err());
+    }
+}
@@ -0,0 +1,59 @@
+//! In-process backtests.
+//!
+//! Runs a layout (the same JSON the orchestrator deploys) in a single thread: every
+//! node is the trait object its service would have wrapped, and every edge is a
+//! direct call instead of a serialized ZMQ hop. Strategy code is unchanged.
+//!
+//! - `component`: the trait objects and the registry building them from layout nodes.
+//! - `engine`: the event loop and its simulated clock.
+//! - `services`: the default registry, building the in-repo services.
+//! - `sweep`: runs a backtest per point of a parameter grid, across cores.
+//!
+//! The `backtest` binary runs a layout of `layouts.json` over a tick file.
+
+pub mod component;
+pub mod engine;
+pub mod services;
+pub mod sweep;
+
+pub use component::{Component, ComponentRegistry};
+pub use engine::{Backtest, BacktestReport};
+pub use sweep::{ParameterGrid, ParameterSet, Sweep, SweepSummary};
+
+use anyhow::{Context, Result};
+use orchestrator_protocol::Layout;
+use serde::Deserialize;
+use std::collections::HashMap;
+use std::path::Path;
+
+/// The layouts file of the supervisor (`layouts.json`).
+#[derive(Deserialize)]
+struct LayoutStore {
+    layouts: HashMap<String, Layout>,
+}
+
+/// Reads one layout from a layouts file.
+///
+/// # Arguments
+///
+/// * `path` - A `layouts.json` file.
+/// * `id` - The layout to read.
+pub fn load_layout(path: &Path, id: &str) -> Result<Layout> {
+    let json = std::fs::read_to_string(path)
+        .with_context(|| format!("Failed to read {}", path.display()))?;
+    layout_from_json(&json, id).with_context(|| format!("In {}", path.display()))
+}
+
+/// Reads one layout from the contents of a layouts file.
+///
+/// # Arguments
+///
+/// * `json` - The layouts file contents.
+/// * `id` - The layout to read.
+pub fn layout_from_json(json: &str, id: &str) -> Result<Layout> {
+    let mut store: LayoutStore = serde_json::from_str(json).context("Invalid layouts file")?;
+    store
+        .layouts
+        .remove(id)
+        .with_context(|| format!("No layout '{}'", id))
+}
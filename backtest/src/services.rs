@@ -0,0 +1,117 @@
+//! The in-repo services, as backtest components.
+//!
+//! Each factory builds the state its service binary runs, so a layout deployed by
+//! the orchestrator backtests with the same code. The exceptions are the ones that
+//! would make a run depend on wall-clock time: the paper broker paces its snapshots
+//! in market data time, and feeds replay tick files at maximum speed.
+
+use crate::component::{Component, ComponentRegistry};
+use broker_gateway::paper::PaperBroker;
+use execution_engine::engine::Engine;
+use multiplexer::kelly_multiplexer::{KellyMultiplexer, MultiplexerConfig};
+use portfolio_manager::{risk_guard::RiskGuard, PortfolioManager};
+use replay_feed::feed::{ReplaySpeed, TickReplayFeed};
+use std::sync::Arc;
+use strategy_lab::DummyStrategy;
+use trading_core::fs::TickStore;
+
+/// Cash of the paper wallet, as in the broker gateway binary.
+const INITIAL_CASH: f64 = 1_000_000.0;
+
+/// Minimum time between two broker snapshots, in tick file time (Unix nanos):
+/// the live default of 50ms.
+const SNAPSHOT_INTERVAL: u64 = 50_000_000;
+
+/// Rows per market data batch of a replay, as in the replay feed.
+const MAX_BATCH_ROWS: usize = 4096;
+
+impl ComponentRegistry {
+    /// Returns a registry of every in-repo service type except `Feeder`, whose
+    /// data has to be given with `register_replay`.
+    pub fn with_defaults() -> Self {
+        let mut registry = Self::new();
+        registry
+            .register("Strategy", |_| {
+                Ok(Component::Strategy(Box::new(DummyStrategy::new(
+                    1_000_000.0,
+                ))))
+            })
+            .register("Multiplexer", |_| {
+                let config = MultiplexerConfig {
+                    kelly_fraction: 1.0,
+                };
+                Ok(Component::Multiplexer(Box::new(KellyMultiplexer::new(
+                    config, 0,
+                ))))
+            })
+            .register("PortfolioManager", |_| {
+                Ok(Component::Manager(Box::new(
+                    PortfolioManager::with_default_policies(RiskGuard::new()),
+                )))
+            })
+            .register("ExecutionEngine", |_| {
+                Ok(Component::Executor(Box::new(Engine::new())))
+            })
+            .register("BrokerGateway", |_| {
+                let broker = PaperBroker::new(INITIAL_CASH)
+                    .with_market_data_snapshot_interval(SNAPSHOT_INTERVAL);
+                Ok(Component::Broker(Box::new(broker)))
+            });
+        registry
+    }
+
+    /// Makes every `Feeder` node replay a tick file, from its first frame.
+    ///
+    /// # Arguments
+    ///
+    /// * `store` - The tick file, shared by the feeds.
+    pub fn register_replay(&mut self, store: Arc<TickStore>) -> &mut Self {
+        self.register("Feeder", move |_| {
+            let feed = TickReplayFeed::new(store.clone(), ReplaySpeed::Max, MAX_BATCH_ROWS)?;
+            Ok(Component::Feed(Box::new(feed)))
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{layout_from_json, Backtest};
+    use trading::model::market_data::{MarketDataBatch, PriceUpdate};
+    use trading_core::fs::TickWriter;
+
+    #[test]
+    fn test_pipeline_layout_runs_with_defaults() {
+        let path = std::env::temp_dir().join(format!("backtest_{}.ticks", std::process::id()));
+        let mut writer = TickWriter::create(&path).unwrap();
+        for frame in 0..3u64 {
+            let timestamp = frame * SNAPSHOT_INTERVAL;
+            writer
+                .append(&MarketDataBatch::new(vec![PriceUpdate::new(
+                    1, 9.0, 11.0, 10.0, timestamp,
+                )]))
+                .unwrap();
+        }
+        writer.finish().unwrap();
+        let store = Arc::new(TickStore::open(&path).unwrap());
+        std::fs::remove_file(&path).ok();
+
+        let layouts = format!(
+            r#"{{ "layouts": {{ "bench": {} }} }}"#,
+            include_str!("../../bench_pipeline_layout.json")
+        );
+        let layout = layout_from_json(&layouts, "bench").unwrap();
+        let mut registry = ComponentRegistry::with_defaults();
+        registry.register_replay(store);
+
+        let run = || Backtest::from_layout(&layout, &registry).unwrap().run();
+        let (first, second) = (run(), run());
+        assert_eq!(first.market_data_batches, 1);
+        // Feed to strategy and broker, strategy to multiplexer, multiplexer to manager.
+        assert!(first.deliveries >= 4);
+        assert_eq!(
+            (first.orders, first.executions, first.deliveries),
+            (second.orders, second.executions, second.deliveries)
+        );
+    }
+}
@@ -0,0 +1,343 @@
+//! Parameter sweeps: many backtests of the same layout, spread across cores.
+
+use crate::engine::{Backtest, BacktestReport};
+use anyhow::{bail, Result};
+use log::{info, warn};
+use serde::Serialize;
+use std::io::Write;
+use std::panic::{catch_unwind, AssertUnwindSafe};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::Mutex;
+
+/// The values to try for every parameter.
+///
+/// Points are never materialized: the `i`-th point is decoded from `i` on demand,
+/// so a grid costs the size of its axes whatever the number of combinations.
+#[derive(Debug, Clone, Default)]
+pub struct ParameterGrid {
+    axes: Vec<(String, Vec<String>)>,
+}
+
+impl ParameterGrid {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Adds a parameter and the values to try for it.
+    ///
+    /// Values are strings, like the values of the admin `Registry`, so that they can
+    /// be applied with `Registry::update` as well as parsed directly.
+    ///
+    /// # Arguments
+    ///
+    /// * `name` - The parameter name.
+    /// * `values` - The values to try, at least one.
+    pub fn axis<V: ToString>(mut self, name: &str, values: impl IntoIterator<Item = V>) -> Self {
+        self.axes.push((
+            name.to_string(),
+            values.into_iter().map(|v| v.to_string()).collect(),
+        ));
+        self
+    }
+
+    /// Returns the number of points of the grid.
+    pub fn len(&self) -> usize {
+        self.axes.iter().map(|(_, values)| values.len()).product()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Returns the `index`-th point, the last axis varying fastest.
+    ///
+    /// # Arguments
+    ///
+    /// * `index` - Below `len()`.
+    pub fn point(&self, index: usize) -> ParameterSet<'_> {
+        let mut rest = index;
+        let mut choices = vec![0; self.axes.len()];
+        for (choice, (_, values)) in choices.iter_mut().zip(&self.axes).rev() {
+            *choice = rest % values.len();
+            rest /= values.len();
+        }
+        ParameterSet {
+            grid: self,
+            choices,
+        }
+    }
+}
+
+/// One point of a `ParameterGrid`.
+#[derive(Debug, Clone)]
+pub struct ParameterSet<'a> {
+    grid: &'a ParameterGrid,
+    choices: Vec<usize>,
+}
+
+impl ParameterSet<'_> {
+    /// Returns the value of a parameter, if it is an axis of the grid.
+    pub fn get(&self, name: &str) -> Option<&str> {
+        self.iter()
+            .find(|(axis, _)| *axis == name)
+            .map(|(_, value)| value)
+    }
+
+    /// Returns the value of a parameter parsed as a float.
+    ///
+    /// # Returns
+    ///
+    /// * `Err` if the parameter is missing or not a number.
+    pub fn get_f64(&self, name: &str) -> Result<f64> {
+        let Some(value) = self.get(name) else {
+            bail!("Parameter '{}' is not part of the sweep", name);
+        };
+        value
+            .parse()
+            .map_err(|e| anyhow::anyhow!("Parameter '{}' = '{}': {}", name, value, e))
+    }
+
+    /// Iterates over `(name, value)` pairs, in axis order.
+    pub fn iter(&self) -> impl Iterator<Item = (&str, &str)> {
+        self.grid
+            .axes
+            .iter()
+            .zip(&self.choices)
+            .map(|((name, values), &choice)| (name.as_str(), values[choice].as_str()))
+    }
+}
+
+/// Outcome of a whole sweep.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct SweepSummary {
+    pub runs: usize,
+    pub failed: usize,
+}
+
+/// One line of the summary file.
+#[derive(Serialize)]
+struct RunRecord<'a> {
+    run: usize,
+    params: Vec<(&'a str, &'a str)>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    error: Option<String>,
+    market_data_batches: u64,
+    orders: u64,
+    executions: u64,
+    clock: u64,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    equity: Option<f64>,
+}
+
+impl<'a> RunRecord<'a> {
+    /// Builds and runs the backtest of a point, recording why it failed if it could
+    /// not be built or panicked.
+    fn of<F>(run: usize, params: &'a ParameterSet<'_>, build: F) -> Self
+    where
+        F: Fn(&ParameterSet<'_>) -> Result<Backtest>,
+    {
+        let mut record = RunRecord {
+            run,
+            params: params.iter().collect(),
+            error: None,
+            market_data_batches: 0,
+            orders: 0,
+            executions: 0,
+            clock: 0,
+            equity: None,
+        };
+        // A panicking run must not take the worker, and the sweep, down with it.
+        let outcome = catch_unwind(AssertUnwindSafe(|| -> Result<BacktestReport> {
+            Ok(build(params)?.run())
+        }))
+        .unwrap_or_else(|panic| {
+            let message = panic
+                .downcast_ref::<&str>()
+                .map(|message| message.to_string())
+                .or_else(|| panic.downcast_ref::<String>().cloned())
+                .unwrap_or_else(|| "unknown panic".to_string());
+            Err(anyhow::anyhow!("panicked: {}", message))
+        });
+        match outcome {
+            Ok(report) => {
+                record.market_data_batches = report.market_data_batches;
+                record.orders = report.orders;
+                record.executions = report.executions;
+                record.clock = report.clock;
+                record.equity = report.last_actual.map(|actual| actual.0.total_equity);
+            }
+            Err(e) => {
+                warn!("Sweep run {} failed: {:#}", run, e);
+                record.error = Some(format!("{:#}", e));
+            }
+        }
+        record
+    }
+}
+
+/// Runs a backtest per point of a grid on a pool of threads.
+///
+/// Workers pull the next point from a shared cursor, so a slow run never holds up
+/// the others and every core stays busy until the grid is exhausted. Only the runs
+/// in flight are in memory: each one is built on its worker, run, summarized as
+/// one JSON line and dropped. Data is shared by what `build` captures, typically
+/// an `Arc<TickStore>` mapping a tick file once for every run.
+pub struct Sweep {
+    grid: ParameterGrid,
+    threads: usize,
+}
+
+impl Sweep {
+    /// Creates a sweep using every available core.
+    pub fn new(grid: ParameterGrid) -> Self {
+        let threads = std::thread::available_parallelism().map_or(1, |n| n.get());
+        Self { grid, threads }
+    }
+
+    /// Sets the number of worker threads.
+    pub fn with_threads(mut self, threads: usize) -> Self {
+        self.threads = threads.max(1);
+        self
+    }
+
+    /// Runs every point and streams one JSON line per run into `summary`.
+    ///
+    /// Lines are written as runs complete, so their order varies between sweeps;
+    /// `run` is the index of the point in the grid.
+    ///
+    /// # Arguments
+    ///
+    /// * `build` - Builds the backtest of one point.
+    /// * `summary` - Where run records are written.
+    ///
+    /// # Returns
+    ///
+    /// * `Ok(SweepSummary)` once every run is done; failed and panicking runs are
+    ///   recorded with their error, they do not stop the sweep.
+    /// * `Err` if writing the summary fails.
+    pub fn run<F, W>(&self, build: F, summary: W) -> Result<SweepSummary>
+    where
+        F: Fn(&ParameterSet<'_>) -> Result<Backtest> + Sync,
+        W: Write + Send,
+    {
+        let total = self.grid.len();
+        let cursor = AtomicUsize::new(0);
+        let failed = AtomicUsize::new(0);
+        let summary = Mutex::new(summary);
+        let workers = self.threads.min(total.max(1));
+        info!("Sweeping {} runs on {} threads", total, workers);
+
+        std::thread::scope(|scope| -> Result<()> {
+            let handles: Vec<_> = (0..workers)
+                .map(|_| {
+                    scope.spawn(|| -> Result<()> {
+                        let mut line = Vec::new();
+                        loop {
+                            let run = cursor.fetch_add(1, Ordering::Relaxed);
+                            if run >= total {
+                                return Ok(());
+                            }
+                            let params = self.grid.point(run);
+                            let record = RunRecord::of(run, &params, &build);
+                            if record.error.is_some() {
+                                failed.fetch_add(1, Ordering::Relaxed);
+                            }
+                            // Serialize outside the lock, hold it only to write.
+                            line.clear();
+                            serde_json::to_writer(&mut line, &record)?;
+                            line.push(b'\n');
+                            summary.lock().unwrap().write_all(&line)?;
+                        }
+                    })
+                })
+                .collect();
+            for handle in handles {
+                handle.join().expect("sweep worker panicked")?;
+            }
+            Ok(())
+        })?;
+        summary.into_inner().unwrap().flush()?;
+
+        Ok(SweepSummary {
+            runs: total,
+            failed: failed.into_inner(),
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::component::{Component, ComponentRegistry};
+    use crate::layout_from_json;
+    use std::collections::VecDeque;
+    use trading::model::market_data::{MarketDataBatch, PriceUpdate};
+    use trading::traits::data_feed::DataFeed;
+
+    struct Ticks(VecDeque<MarketDataBatch>);
+
+    impl DataFeed for Ticks {
+        fn get_market_data(&mut self) -> Option<MarketDataBatch> {
+            self.0.pop_front()
+        }
+    }
+
+    #[test]
+    fn test_every_point_runs_once() {
+        let grid = ParameterGrid::new()
+            .axis("batches", [1, 2, 3])
+            .axis("kelly_fraction", [0.25, 0.5]);
+        assert_eq!(grid.len(), 6);
+        assert_eq!(
+            grid.point(3).iter().collect::<Vec<_>>(),
+            vec![("batches", "2"), ("kelly_fraction", "0.5")]
+        );
+
+        let layout = layout_from_json(
+            r#"{ "layouts": { "sweep": { "id": "sweep", "edges": [], "nodes": [
+                { "id": "feed", "name": "Feed", "service": "ticks", "status": "" }
+            ] } } }"#,
+            "sweep",
+        )
+        .unwrap();
+        let build = |params: &ParameterSet<'_>| {
+            let batches = params.get_f64("batches")? as u64;
+            if params.get_f64("kelly_fraction")? > 0.4 && batches == 3 {
+                bail!("diverged");
+            }
+            if params.get_f64("kelly_fraction")? > 0.4 && batches == 1 {
+                panic!("blew up");
+            }
+            let mut registry = ComponentRegistry::new();
+            registry.register("ticks", move |_| {
+                Ok(Component::Feed(Box::new(Ticks(
+                    (1..=batches)
+                        .map(|t| MarketDataBatch::new(vec![PriceUpdate::new(1, 1.0, 1.0, 1.0, t)]))
+                        .collect(),
+                ))))
+            });
+            Backtest::from_layout(&layout, &registry)
+        };
+
+        let mut out = Vec::new();
+        let summary = Sweep::new(grid)
+            .with_threads(4)
+            .run(build, &mut out)
+            .unwrap();
+        assert_eq!(summary, SweepSummary { runs: 6, failed: 2 });
+
+        let mut records: Vec<serde_json::Value> = std::str::from_utf8(&out)
+            .unwrap()
+            .lines()
+            .map(|line| serde_json::from_str(line).unwrap())
+            .collect();
+        records.sort_by_key(|record| record["run"].as_u64());
+        let batches: Vec<_> = records
+            .iter()
+            .map(|record| record["market_data_batches"].as_u64().unwrap())
+            .collect();
+        assert_eq!(batches, vec![1, 0, 2, 2, 3, 0]);
+        assert_eq!(records[1]["error"], "panicked: blew up");
+        assert_eq!(records[5]["error"], "diverged");
+    }
+}
@@ -0,0 +1,95 @@
+#!/bin/bash
+# Tick-to-trade benchmark of the multi-process pipeline.
+#
+# Deploys bench_pipeline_layout.json (dummy-feed -> strategy-lab -> multiplexer ->
+# portfolio-manager -> execution-engine -> broker-gateway), lets it run, then reads
+# the latency metrics of every service through the orchestrator and prints them
+# as JSON lines, like the `cargo bench` targets (see trading_core::bench).
+#
+# BENCH_DURATION (seconds, default 30), BENCH_OUTPUT, BENCH_BASELINE and
+# BENCH_TOLERANCE are honoured as by the `cargo bench` targets.
+set -e
+
+DURATION=${BENCH_DURATION:-30}
+METRICS=target/bench/pipeline_metrics.json
+
+cleanup() {
+    echo "Cleaning up..." >&2
+    if [ ! -z "$ORCH_PID" ]; then
+        kill $ORCH_PID || true
+    fi
+    pkill -f "dummy-feed" || true
+    pkill -f "strategy-lab" || true
+    pkill -f "multiplexer" || true
+    pkill -f "portfolio-manager" || true
+    pkill -f "execution-engine" || true
+    pkill -f "broker-gateway" || true
+}
+trap cleanup EXIT
+
+echo "Building project (release)..." >&2
+cargo build --release -p system-orchestrator -p controller -p dummy-feed -p strategy-lab -p multiplexer -p portfolio-manager -p execution-engine -p broker-gateway >&2
+
+echo "Starting System Orchestrator..." >&2
+RUST_LOG=warn ./target/release/system-orchestrator --service-dir ./target/release > orchestrator_bench.log 2>&1 &
+ORCH_PID=$!
+sleep 10
+
+echo "Deploying bench layout, running for ${DURATION}s..." >&2
+./target/release/controller deploy --file bench_pipeline_layout.json >&2
+sleep "$DURATION"
+
+mkdir -p target/bench
+./target/release/controller metrics --json > "$METRICS"
+
+python3 - "$METRICS" <<'EOF'
+import json
+import os
+import sys
+
+services = json.load(open(sys.argv[1]))
+results = []
+for service in services:
+    for runner in service["metrics"]["runners"]:
+        for stage in ("queue_wait", "callback", "since_origin"):
+            histogram = runner[stage]
+            if histogram["count"] == 0:
+                continue
+            results.append({
+                "group": "pipeline",
+                "name": f'{service["id"]}/{runner["name"]}/{stage}',
+                "samples": histogram["count"],
+                "p50_ns": histogram["p50_ns"],
+                "p99_ns": histogram["p99_ns"],
+                "p999_ns": histogram["p999_ns"],
+                "max_ns": histogram["max_ns"],
+            })
+# Orders reaching the broker, timed from the feeder tick they react to.
+for result in list(results):
+    if result["name"] == "broker/orders/since_origin":
+        results.append(dict(result, name="tick_to_trade"))
+if not any(result["name"] == "tick_to_trade" for result in results):
+    sys.exit("No order reached the broker, see orchestrator_bench.log")
+
+baseline = {}
+if os.environ.get("BENCH_BASELINE"):
+    for line in open(os.environ["BENCH_BASELINE"]):
+        if line.strip():
+            entry = json.loads(line)
+            baseline[f'{entry["group"]}/{entry["name"]}'] = entry["p50_ns"]
+tolerance = float(os.environ.get("BENCH_TOLERANCE", "1.25"))
+
+output = open(os.environ["BENCH_OUTPUT"], "a") if os.environ.get("BENCH_OUTPUT") else None
+regressions = []
+for result in results:
+    line = json.dumps(result)
+    print(line)
+    if output:
+        output.write(line + "\n")
+    key = f'{result["group"]}/{result["name"]}'
+    if key in baseline and result["p50_ns"] > baseline[key] * tolerance:
+        regressions.append(f'{key}: p50 {result["p50_ns"]}ns, baseline {baseline[key]}ns')
+
+if regressions:
+    sys.exit(f"{len(regressions)} case(s) regressed beyond {tolerance}x:\n" + "\n".join(regressions))
+EOF
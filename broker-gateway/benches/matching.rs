@@ -0,0 +1,99 @@
+//! Order matching of `PaperBroker` against the quote stream.
+
+use anyhow::Result;
+use broker_gateway::matching::{MatchingConfig, MatchingEngine};
+use broker_gateway::paper::PaperBroker;
+use std::time::Duration;
+use trading::model::market_data::{MarketDataBatch, PriceUpdate};
+use trading::model::order::{Order, OrderSide, OrderType};
+use trading::model::order_batch::OrderBatch;
+use trading::Broker;
+use trading_core::bench::Bench;
+
+const INSTRUMENTS: usize = 256;
+const BATCH: usize = 1024;
+const RESTING: usize = 1024;
+
+fn quotes(timestamp: u64) -> MarketDataBatch {
+    MarketDataBatch::new(
+        (0..INSTRUMENTS)
+            .map(|id| PriceUpdate::new(id, 99.0, 101.0, 100.0, timestamp))
+            .collect(),
+    )
+}
+
+fn market_order(id: u64) -> Order {
+    let side = if id % 2 == 0 {
+        OrderSide::buy()
+    } else {
+        OrderSide::sell()
+    };
+    let instrument = id as usize % INSTRUMENTS;
+    Order::new(id, instrument, side, OrderType::market(), 0.0, 1.0, 0)
+}
+
+fn main() -> Result<()> {
+    let mut bench = Bench::new("broker_gateway")?;
+    let quotes = quotes(1);
+
+    let mut engine = MatchingEngine::new(MatchingConfig::default());
+    let mut fills = Vec::with_capacity(BATCH);
+    for update in quotes.iter() {
+        engine.on_quote(
+            update.instrument_id,
+            update.bid,
+            update.ask,
+            update.last,
+            update.timestamp,
+            &mut fills,
+        );
+    }
+    let mut id = 0;
+    bench.run("market_order", || {
+        id += 1;
+        engine.submit(market_order(id), &mut fills);
+        fills.clear();
+    })?;
+
+    // A limit order joins the book, then the next quote trades through it.
+    bench.run("limit_order_fill", || {
+        id += 1;
+        let order = Order::new(id, 0, OrderSide::buy(), OrderType::limit(), 99.0, 1.0, 0);
+        engine.submit(order, &mut fills);
+        engine.on_quote(0, 98.0, 100.0, 98.5, 2, &mut fills);
+        engine.on_quote(0, 99.0, 101.0, 100.0, 3, &mut fills);
+        fills.clear();
+    })?;
+
+    // Quotes that reach none of the orders resting on the book.
+    if bench.selected("quote_out_of_reach") {
+        for resting in 0..RESTING {
+            let price = 90.0 - (resting % 64) as f64 * 0.01;
+            let order = Order::new(
+                resting as u64,
+                0,
+                OrderSide::buy(),
+                OrderType::limit(),
+                price,
+                1.0,
+                0,
+            );
+            engine.submit(order, &mut fills);
+        }
+        bench.run("quote_out_of_reach", || {
+            engine.on_quote(0, 99.0, 101.0, 100.0, 4, &mut fills);
+        })?;
+    }
+
+    let mut broker = PaperBroker::new(1e12).with_snapshot_interval(Duration::ZERO);
+    broker.on_market_data(quotes.view());
+    let orders: Vec<Order> = (0..BATCH as u64).map(market_order).collect();
+    bench.run(&format!("paper_orders/{}", BATCH), || {
+        broker.on_orders(OrderBatch::new(orders.clone()))
+    })?;
+    bench.run(&format!("paper_quotes/{}", INSTRUMENTS), || {
+        broker.on_market_data(quotes.view())
+    })?;
+
+    bench.finish()
+}
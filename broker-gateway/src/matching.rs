@@ -0,0 +1,415 @@
+//! Order matching of the paper broker against the quote stream.
+//!
+//! The feed carries the top of the book (bid, ask, last) without sizes, so the book
+//! of an instrument holds the paper orders resting on it, matched against its quote:
+//! - market orders take the touch (the ask to buy, the bid to sell);
+//! - limit orders take the touch when marketable, and otherwise rest until the
+//!   quote crosses their price or the last price trades through it. An order joining
+//!   a price the market already bids (or offers) is queued behind it: updates that
+//!   print at the order's price go to the queue ahead first (`queue_prints`);
+//! - stop orders turn into market orders once the last price reaches their trigger.
+//!
+//! Orders reach the book `latency` after they were received, in market data time,
+//! and are matched against the quotes from then on. Fills are complete: without
+//! sizes, the touch is assumed deep enough for any paper order.
+//!
+//! Books live in dense slots, one per instrument seen, and each side is a `Vec`
+//! sorted best price first, so a quote only touches memory from the best price
+//! until the first order it cannot reach.
+
+use std::collections::{HashMap, VecDeque};
+use trading::model::instrument::InstrumentId;
+use trading::model::order::{Order, OrderSide, OrderType};
+
+/// How the venue is simulated.
+#[derive(Debug, Clone, Copy, Default)]
+pub struct MatchingConfig {
+    /// Delay between receiving an order and it reaching the book, in the unit of
+    /// market data timestamps.
+    pub latency: u64,
+    /// Prints at its price an order joining an existing level waits out before
+    /// being filled by one.
+    pub queue_prints: u32,
+}
+
+/// One complete fill of an order.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct Fill {
+    pub order: Order,
+    pub price: f64,
+    /// Market data time of the fill, or the order's own time without a quote.
+    pub timestamp: u64,
+}
+
+/// An order resting on a book.
+#[derive(Debug, Clone, Copy)]
+struct Resting {
+    order: Order,
+    /// Limit price, or trigger price of a stop.
+    price: f64,
+    /// Prints at `price` still going to the queue ahead.
+    queue: u32,
+}
+
+/// What a quote does to a resting limit order.
+#[derive(PartialEq)]
+enum Reach {
+    /// Crossed or traded through: filled.
+    Fill,
+    /// Printed at its price: served in queue order.
+    Print,
+    /// Out of reach, as is every order behind it.
+    None,
+}
+
+#[derive(Default)]
+struct Book {
+    bid: f64,
+    ask: f64,
+    last: f64,
+    timestamp: u64,
+    quoted: bool,
+    /// Buy limits, highest price first, in time priority within a price.
+    bids: Vec<Resting>,
+    /// Sell limits, lowest price first, in time priority within a price.
+    asks: Vec<Resting>,
+    stops: Vec<Resting>,
+    /// Orders on their way to the book with their arrival time, in arrival order.
+    in_flight: VecDeque<(u64, Order)>,
+}
+
+impl Book {
+    /// Matches an order reaching the book, or rests it.
+    fn accept(&mut self, order: Order, queue_prints: u32, fills: &mut Vec<Fill>) {
+        let price = order.get_price();
+        if !self.quoted {
+            // Without market data (e.g. no `market_data` edge), a priced order fills
+            // at its price; an unpriced one waits for the first quote.
+            if price > 0.0 {
+                fills.push(Fill {
+                    order,
+                    price,
+                    timestamp: order.get_timestamp(),
+                });
+            } else {
+                self.in_flight.push_back((0, order));
+            }
+            return;
+        }
+
+        let buy = order.get_side() == OrderSide::buy();
+        let order_type = order.get_type();
+        if order_type == OrderType::limit() {
+            let (marketable, joins) = if buy {
+                (self.ask > 0.0 && self.ask <= price, price <= self.bid)
+            } else {
+                (
+                    self.bid > 0.0 && self.bid >= price,
+                    self.ask > 0.0 && price >= self.ask,
+                )
+            };
+            if marketable {
+                self.fill_at_touch(order, fills);
+                return;
+            }
+            let resting = Resting {
+                order,
+                price,
+                queue: if joins { queue_prints } else { 0 },
+            };
+            if buy {
+                let index = self.bids.partition_point(|r| r.price >= price);
+                self.bids.insert(index, resting);
+            } else {
+                let index = self.asks.partition_point(|r| r.price <= price);
+                self.asks.insert(index, resting);
+            }
+        } else if order_type == OrderType::stop() && !self.triggers(buy, price) {
+            self.stops.push(Resting {
+                order,
+                price,
+                queue: 0,
+            });
+        } else {
+            self.fill_at_touch(order, fills);
+        }
+    }
+
+    /// Matches the resting orders against the current quote.
+    fn on_quote(&mut self, fills: &mut Vec<Fill>) {
+        let (bid, ask, last, timestamp) = (self.bid, self.ask, self.last, self.timestamp);
+        let traded = last > 0.0;
+        match_side(&mut self.bids, timestamp, fills, |price| {
+            if (ask > 0.0 && ask <= price) || (traded && last < price) {
+                Reach::Fill
+            } else if last == price {
+                Reach::Print
+            } else {
+                Reach::None
+            }
+        });
+        match_side(&mut self.asks, timestamp, fills, |price| {
+            if (bid > 0.0 && bid >= price) || (traded && last > price) {
+                Reach::Fill
+            } else if last == price {
+                Reach::Print
+            } else {
+                Reach::None
+            }
+        });
+
+        if !self.stops.is_empty() {
+            let mut stops = std::mem::take(&mut self.stops);
+            stops.retain(|stop| {
+                let buy = stop.order.get_side() == OrderSide::buy();
+                if !self.triggers(buy, stop.price) {
+                    return true;
+                }
+                self.fill_at_touch(stop.order, fills);
+                false
+            });
+            self.stops = stops;
+        }
+    }
+
+    /// Whether the market reached the trigger of a stop.
+    fn triggers(&self, buy: bool, trigger: f64) -> bool {
+        let reference = match (self.last > 0.0, buy) {
+            (true, _) => self.last,
+            (false, true) => self.ask,
+            (false, false) => self.bid,
+        };
+        if buy {
+            reference >= trigger
+        } else {
+            reference > 0.0 && reference <= trigger
+        }
+    }
+
+    fn fill_at_touch(&self, order: Order, fills: &mut Vec<Fill>) {
+        let touch = if order.get_side() == OrderSide::buy() {
+            self.ask
+        } else {
+            self.bid
+        };
+        // A one-sided quote leaves the last price as the only reference.
+        let price = if touch > 0.0 { touch } else { self.last };
+        fills.push(Fill {
+            order,
+            price,
+            timestamp: self.timestamp,
+        });
+    }
+}
+
+/// Fills the orders of one side the quote reaches, keeping the others in place.
+fn match_side(
+    orders: &mut Vec<Resting>,
+    timestamp: u64,
+    fills: &mut Vec<Fill>,
+    reach: impl Fn(f64) -> Reach,
+) {
+    let end = orders
+        .iter()
+        .position(|resting| reach(resting.price) == Reach::None)
+        .unwrap_or(orders.len());
+    let mut kept = 0;
+    for index in 0..end {
+        let mut resting = orders[index];
+        if reach(resting.price) == Reach::Print && resting.queue > 0 {
+            resting.queue -= 1;
+            orders[kept] = resting;
+            kept += 1;
+            continue;
+        }
+        fills.push(Fill {
+            order: resting.order,
+            price: resting.price,
+            timestamp,
+        });
+    }
+    orders.drain(kept..end);
+}
+
+/// The books of every instrument the paper broker trades.
+pub struct MatchingEngine {
+    config: MatchingConfig,
+    slots: HashMap<InstrumentId, usize>,
+    books: Vec<Book>,
+    /// Latest market data time, from which order latency runs.
+    clock: u64,
+}
+
+impl MatchingEngine {
+    pub fn new(config: MatchingConfig) -> Self {
+        Self {
+            config,
+            slots: HashMap::new(),
+            books: Vec::new(),
+            clock: 0,
+        }
+    }
+
+    /// Returns the latest market data time seen.
+    pub fn clock(&self) -> u64 {
+        self.clock
+    }
+
+    /// Returns the number of orders resting or on their way to a book.
+    pub fn open_orders(&self) -> usize {
+        self.books
+            .iter()
+            .map(|book| book.bids.len() + book.asks.len() + book.stops.len() + book.in_flight.len())
+            .sum()
+    }
+
+    /// Sends an order to the book of its instrument.
+    ///
+    /// # Arguments
+    ///
+    /// * `order` - The order, matched once its latency elapsed.
+    /// * `fills` - Receives the fills the order gets right away.
+    pub fn submit(&mut self, order: Order, fills: &mut Vec<Fill>) {
+        let slot = self.slot(order.get_instrument_id());
+        let book = &mut self.books[slot];
+        if self.config.latency == 0 {
+            book.accept(order, self.config.queue_prints, fills);
+        } else {
+            book.in_flight
+                .push_back((self.clock + self.config.latency, order));
+        }
+    }
+
+    /// Updates the quote of an instrument and matches its book against it.
+    ///
+    /// # Arguments
+    ///
+    /// * `fills` - Receives the fills the quote triggers.
+    pub fn on_quote(
+        &mut self,
+        instrument_id: InstrumentId,
+        bid: f64,
+        ask: f64,
+        last: f64,
+        timestamp: u64,
+        fills: &mut Vec<Fill>,
+    ) {
+        self.clock = self.clock.max(timestamp);
+        let slot = self.slot(instrument_id);
+        let book = &mut self.books[slot];
+        book.bid = bid;
+        book.ask = ask;
+        book.last = last;
+        book.timestamp = timestamp;
+        book.quoted = true;
+
+        // Resting orders were there first; arrivals then meet the same quote.
+        book.on_quote(fills);
+        while book
+            .in_flight
+            .front()
+            .is_some_and(|(arrival, _)| *arrival <= timestamp)
+        {
+            let (_, order) = book.in_flight.pop_front().unwrap();
+            book.accept(order, self.config.queue_prints, fills);
+        }
+    }
+
+    fn slot(&mut self, instrument_id: InstrumentId) -> usize {
+        let books = &mut self.books;
+        *self.slots.entry(instrument_id).or_insert_with(|| {
+            books.push(Book::default());
+            books.len() - 1
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn order(id: u64, side: OrderSide, order_type: OrderType, price: f64) -> Order {
+        Order::new(id, 1, side, order_type, price, 1.0, 0)
+    }
+
+    #[test]
+    fn test_orders_match_against_the_quote() {
+        let mut engine = MatchingEngine::new(MatchingConfig {
+            latency: 0,
+            queue_prints: 1,
+        });
+        let mut fills = Vec::new();
+        engine.on_quote(1, 99.0, 101.0, 100.0, 1, &mut fills);
+
+        // Market orders take the touch, marketable limits too.
+        engine.submit(
+            order(1, OrderSide::buy(), OrderType::market(), 0.0),
+            &mut fills,
+        );
+        engine.submit(
+            order(2, OrderSide::sell(), OrderType::limit(), 98.0),
+            &mut fills,
+        );
+        let prices: Vec<f64> = fills.drain(..).map(|fill| fill.price).collect();
+        assert_eq!(prices, vec![101.0, 99.0]);
+
+        // A bid joining the best bid waits for one print ahead of it; one inside
+        // the spread does not; a stop waits for its trigger.
+        engine.submit(
+            order(3, OrderSide::buy(), OrderType::limit(), 99.0),
+            &mut fills,
+        );
+        engine.submit(
+            order(4, OrderSide::buy(), OrderType::limit(), 100.0),
+            &mut fills,
+        );
+        engine.submit(
+            order(5, OrderSide::buy(), OrderType::stop(), 102.0),
+            &mut fills,
+        );
+        assert!(fills.is_empty());
+        assert_eq!(engine.open_orders(), 3);
+
+        engine.on_quote(1, 98.0, 100.5, 99.0, 2, &mut fills);
+        assert_eq!(
+            fills
+                .drain(..)
+                .map(|fill| fill.order.get_id())
+                .collect::<Vec<_>>(),
+            vec![4]
+        );
+        engine.on_quote(1, 98.0, 100.5, 99.0, 3, &mut fills);
+        assert_eq!(
+            fills
+                .drain(..)
+                .map(|fill| fill.order.get_id())
+                .collect::<Vec<_>>(),
+            vec![3]
+        );
+
+        engine.on_quote(1, 101.5, 102.5, 102.0, 4, &mut fills);
+        assert_eq!(fills.len(), 1);
+        assert_eq!((fills[0].order.get_id(), fills[0].price), (5, 102.5));
+        assert_eq!(engine.open_orders(), 0);
+    }
+
+    #[test]
+    fn test_latency_defers_matching_to_a_later_quote() {
+        let mut engine = MatchingEngine::new(MatchingConfig {
+            latency: 10,
+            queue_prints: 0,
+        });
+        let mut fills = Vec::new();
+        engine.on_quote(1, 99.0, 101.0, 100.0, 100, &mut fills);
+        engine.submit(
+            order(1, OrderSide::buy(), OrderType::market(), 0.0),
+            &mut fills,
+        );
+
+        engine.on_quote(1, 100.0, 102.0, 101.0, 105, &mut fills);
+        assert!(fills.is_empty());
+        engine.on_quote(1, 101.0, 103.0, 102.0, 110, &mut fills);
+        assert_eq!(fills.len(), 1);
+        assert_eq!((fills[0].price, fills[0].timestamp), (103.0, 110));
+    }
+}
@@ -1,89 +1,301 @@
+//! The paper broker: a simulated venue (see `matching`) and the wallet its fills
+//! settle into.
+
+use crate::matching::{Fill, MatchingConfig, MatchingEngine};
+use std::time::{Duration, Instant};
 use trading::model::{
     execution::{ExecutionResult, ExecutionStatus},
+    execution_batch::ExecutionBatch,
+    market_data::MarketDataBatchView,
     order::{Order, OrderSide},
-    portfolio::{Actual, Portfolio},
+    order_batch::OrderBatch,
+    portfolio::{Actual, CurrencyId, Portfolio},
 };
 use trading::traits::broker::Broker;
 
+/// Minimum time between two portfolio snapshots, unless set with `with_snapshot_interval`.
+const DEFAULT_SNAPSHOT_INTERVAL: Duration = Duration::from_millis(50);
+
+/// The currency of the paper wallet.
+const CURRENCY: CurrencyId = match CurrencyId::new("USD") {
+    Some(currency) => currency,
+    None => panic!("Invalid currency code"),
+};
+
+/// What the snapshot interval is measured against, and when the last snapshot went out.
+enum SnapshotClock {
+    /// Wall-clock time, for live trading.
+    Wall {
+        interval: Duration,
+        last: Option<Instant>,
+    },
+    /// Market data time, for backtests.
+    MarketData { interval: u64, last: Option<u64> },
+}
+
 pub struct PaperBroker {
     portfolio: Portfolio,
+    /// Cash of the wallet, written to `portfolio` when a snapshot is taken.
+    cash: f64,
+    matching: MatchingEngine,
+    /// Reused across calls, so matching does not allocate.
+    fills: Vec<Fill>,
+    snapshot_clock: SnapshotClock,
+    /// Whether fills happened since the last published snapshot.
+    dirty: bool,
 }
 
 impl PaperBroker {
     pub fn new(initial_cash: f64) -> Self {
         let mut p = Portfolio::new();
-        p.set_cash("USD", initial_cash);
+        p.set_cash_by_id(CURRENCY, initial_cash);
         Self {
             portfolio: p.with_equity(initial_cash),
+            cash: initial_cash,
+            matching: MatchingEngine::new(MatchingConfig::default()),
+            fills: Vec::new(),
+            snapshot_clock: SnapshotClock::Wall {
+                interval: DEFAULT_SNAPSHOT_INTERVAL,
+                last: None,
+            },
+            dirty: false,
+        }
+    }
+
+    /// Sets the minimum time between two portfolio snapshots.
+    ///
+    /// Fills inside the interval are coalesced: the snapshot that reflects them goes
+    /// out with the first batch processed once the interval has elapsed, or from
+    /// `flush` if the flow went quiet meanwhile.
+    pub fn with_snapshot_interval(mut self, interval: Duration) -> Self {
+        self.snapshot_clock = SnapshotClock::Wall {
+            interval,
+            last: None,
+        };
+        self
+    }
+
+    /// Measures the snapshot interval in market data time instead of wall-clock time.
+    ///
+    /// Snapshots then only depend on the quotes and orders received, not on how
+    /// fast they are processed, which keeps backtests deterministic.
+    ///
+    /// # Arguments
+    ///
+    /// * `interval` - Minimum time between two snapshots, in the unit of market
+    ///   data timestamps.
+    pub fn with_market_data_snapshot_interval(mut self, interval: u64) -> Self {
+        self.snapshot_clock = SnapshotClock::MarketData {
+            interval,
+            last: None,
+        };
+        self
+    }
+
+    /// Sets the latency and queue model of the simulated venue.
+    pub fn with_matching(mut self, config: MatchingConfig) -> Self {
+        self.matching = MatchingEngine::new(config);
+        self
+    }
+
+    /// Settles the pending fills into the wallet and reports them.
+    fn settle(&mut self, executions: &mut Vec<ExecutionResult>) {
+        executions.reserve(self.fills.len());
+        for fill in self.fills.drain(..) {
+            let order = &fill.order;
+            let qty = order.get_quantity();
+            let instrument_id = order.get_instrument_id();
+
+            // --- Wallet Logic (Simplified) ---
+            let cost = qty * fill.price;
+            let side = order.get_side();
+            match side {
+                s if s == OrderSide::buy() => {
+                    self.cash -= cost;
+                    self.portfolio.positions.add(instrument_id, qty);
+                }
+                s if s == OrderSide::sell() => {
+                    self.cash += cost;
+                    self.portfolio.positions.add(instrument_id, -qty);
+                }
+                _ => {}
+            }
+            self.dirty = true;
+
+            executions.push(
+                ExecutionResult::new(
+                    order.get_id(),
+                    instrument_id,
+                    ExecutionStatus::Filled,
+                    fill.timestamp,
+                )
+                .with_fill(qty, fill.price, qty, fill.price),
+            );
+        }
+    }
+
+    /// Returns a snapshot if fills are pending and the snapshot interval has elapsed.
+    fn snapshot(&mut self) -> Option<Actual> {
+        if !self.dirty {
+            return None;
+        }
+        let due = match &mut self.snapshot_clock {
+            SnapshotClock::Wall { interval, last } => {
+                let now = Instant::now();
+                let due = last.map_or(true, |last| now.duration_since(last) >= *interval);
+                if due {
+                    *last = Some(now);
+                }
+                due
+            }
+            SnapshotClock::MarketData { interval, last } => {
+                let now = self.matching.clock();
+                let due = last.map_or(true, |last| now.saturating_sub(last) >= *interval);
+                if due {
+                    *last = Some(now);
+                }
+                due
+            }
+        };
+        if !due {
+            return None;
         }
+        self.dirty = false;
+        self.portfolio.set_cash_by_id(CURRENCY, self.cash);
+        Some(Actual(self.portfolio.clone()))
     }
 }
 
 impl Broker for PaperBroker {
     fn on_order(&mut self, order: Order) -> (Vec<ExecutionResult>, Option<Actual>) {
-        let fill_price = order.get_price();
-        let effective_price = if fill_price > 0.0 { fill_price } else { 100.0 };
-
-        let qty = order.get_quantity();
-        // ID handling? Assume parsable
-        let instrument_id = order.get_instrument_id().parse::<usize>().unwrap_or(0);
-
-        // --- Wallet Logic (Simplified) ---
-        let cost = qty * effective_price;
-        let currency = "USD";
-        let mut cash_balance = self
-            .portfolio
-            .get_cash(currency)
-            .cloned()
-            .unwrap_or_else(|| trading::model::portfolio::CashBalance::new(currency, 0.0, 0.0));
-
-        let side = order.get_side();
-        match side {
-            s if s == OrderSide::buy() => {
-                cash_balance.amount -= cost;
-                cash_balance.available -= cost;
-                let current_pos_qty = self
-                    .portfolio
-                    .positions
-                    .get(&instrument_id)
-                    .map(|p| p.get_quantity())
-                    .unwrap_or(0.0);
-                self.portfolio
-                    .update_position(instrument_id, current_pos_qty + qty);
-            }
-            s if s == OrderSide::sell() => {
-                cash_balance.amount += cost;
-                cash_balance.available += cost;
-                let current_pos_qty = self
-                    .portfolio
-                    .positions
-                    .get(&instrument_id)
-                    .map(|p| p.get_quantity())
-                    .unwrap_or(0.0);
-                self.portfolio
-                    .update_position(instrument_id, current_pos_qty - qty);
-            }
-            _ => {}
+        self.matching.submit(order, &mut self.fills);
+        let mut executions = Vec::new();
+        self.settle(&mut executions);
+        (executions, self.snapshot())
+    }
+
+    fn on_orders(&mut self, batch: OrderBatch) -> (ExecutionBatch, Option<Actual>) {
+        for order in batch {
+            self.matching.submit(order, &mut self.fills);
+        }
+        let mut executions = Vec::new();
+        self.settle(&mut executions);
+        (ExecutionBatch::new(executions), self.snapshot())
+    }
+
+    fn flush(&mut self) -> Option<Actual> {
+        self.snapshot()
+    }
+
+    fn on_market_data(&mut self, md: MarketDataBatchView<'_>) -> (ExecutionBatch, Option<Actual>) {
+        let (ids, bids, asks, lasts, timestamps) = (
+            md.get_instrument_ids(),
+            md.get_bid_prices(),
+            md.get_ask_prices(),
+            md.get_last_prices(),
+            md.get_timestamps(),
+        );
+        for i in 0..md.get_count() {
+            self.matching.on_quote(
+                ids[i],
+                bids[i],
+                asks[i],
+                lasts[i],
+                timestamps[i],
+                &mut self.fills,
+            );
         }
-        self.portfolio
-            .cash
-            .insert(currency.to_string(), cash_balance);
-
-        let result = ExecutionResult {
-            order_id: order.get_id().to_string(),
-            instrument_id: order.get_instrument_id().to_string(),
-            status: ExecutionStatus::Filled,
-
-            // Correct fields for accumulated execution
-            last_filled_quantity: qty,
-            last_filled_price: effective_price,
-            cumulative_fill_quantity: qty,
-            average_price: effective_price,
-
-            timestamp: order.get_timestamp() as u128,
-            message: None,
+        let mut executions = Vec::new();
+        self.settle(&mut executions);
+        (ExecutionBatch::new(executions), self.snapshot())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use trading::model::market_data::{MarketDataBatch, PriceUpdate};
+    use trading::model::order::OrderType;
+
+    fn order(id: u64, qty: f64) -> Order {
+        Order::new(id, 1, OrderSide::buy(), OrderType::market(), 10.0, qty, 0)
+    }
+
+    #[test]
+    fn test_batch_yields_one_coalesced_snapshot() {
+        let mut broker =
+            PaperBroker::new(1_000.0).with_snapshot_interval(Duration::from_secs(3600));
+
+        let (executions, snapshot) =
+            broker.on_orders(OrderBatch::new(vec![order(1, 1.0), order(2, 2.0)]));
+        assert_eq!(executions.len(), 2);
+        let snapshot = snapshot.expect("first batch publishes a snapshot");
+        assert_eq!(snapshot.0.positions.quantity(1), 3.0);
+
+        // Inside the interval the next fills are held back.
+        let (_, snapshot) = broker.on_orders(OrderBatch::new(vec![order(3, 1.0)]));
+        assert!(snapshot.is_none());
+    }
+
+    #[test]
+    fn test_held_back_snapshot_is_flushed_without_input() {
+        let mut broker =
+            PaperBroker::new(1_000.0).with_snapshot_interval(Duration::from_millis(20));
+        let (_, snapshot) = broker.on_orders(OrderBatch::new(vec![order(1, 1.0)]));
+        assert!(snapshot.is_some());
+        let (_, snapshot) = broker.on_orders(OrderBatch::new(vec![order(2, 1.0)]));
+        assert!(snapshot.is_none());
+        assert!(broker.flush().is_none());
+
+        // Once the interval is over, the gateway's next tick publishes the fill.
+        std::thread::sleep(Duration::from_millis(25));
+        let snapshot = broker.flush().expect("the held-back fill is flushed");
+        assert_eq!(snapshot.0.positions.quantity(1), 2.0);
+        assert!(broker.flush().is_none());
+    }
+
+    #[test]
+    fn test_market_data_clock_paces_snapshots() {
+        let mut broker = PaperBroker::new(1_000.0).with_market_data_snapshot_interval(100);
+        let quote =
+            |timestamp| MarketDataBatch::new(vec![PriceUpdate::new(1, 9.0, 11.0, 10.0, timestamp)]);
+        broker.on_market_data(quote(1_000).view());
+        let (_, snapshot) = broker.on_orders(OrderBatch::new(vec![order(1, 1.0)]));
+        assert!(snapshot.is_some());
+
+        // However long it takes, the fill is held back until market data time moves on.
+        let (_, snapshot) = broker.on_orders(OrderBatch::new(vec![order(2, 1.0)]));
+        assert!(snapshot.is_none());
+        broker.on_market_data(quote(1_050).view());
+        assert!(broker.flush().is_none());
+        let (_, snapshot) = broker.on_market_data(quote(1_100).view());
+        assert_eq!(snapshot.unwrap().0.positions.quantity(1), 2.0);
+    }
+
+    #[test]
+    fn test_market_orders_fill_at_the_quote() {
+        let mut broker = PaperBroker::new(1_000.0).with_snapshot_interval(Duration::ZERO);
+        let price = |executions: &ExecutionBatch| {
+            executions
+                .iter()
+                .map(|execution| execution.last_filled_price)
+                .collect::<Vec<_>>()
         };
 
-        (vec![result], Some(Actual(self.portfolio.clone())))
+        // Without a quote, an unpriced market order waits for one.
+        let unpriced = Order::new(1, 1, OrderSide::buy(), OrderType::market(), 0.0, 2.0, 0);
+        let (executions, _) = broker.on_orders(OrderBatch::new(vec![unpriced]));
+        assert!(executions.is_empty());
+
+        let quote = MarketDataBatch::new(vec![PriceUpdate::new(1, 9.0, 11.0, 10.0, 5)]);
+        let (executions, snapshot) = broker.on_market_data(quote.view());
+        assert_eq!(price(&executions), vec![11.0]);
+        let snapshot = snapshot.expect("the fill publishes a snapshot");
+        assert_eq!(snapshot.0.positions.quantity(1), 2.0);
+        assert_eq!(snapshot.0.get_cash("USD").unwrap().amount, 978.0);
+
+        // Order prices are no longer used once the instrument is quoted.
+        let (executions, _) = broker.on_orders(OrderBatch::new(vec![order(2, 1.0)]));
+        assert_eq!(price(&executions), vec![11.0]);
     }
 }
@@ -35,6 +35,12 @@ enum Commands {
         #[arg(short, long)]
         layout: String,
     },
+    /// Show the latency metrics of the running services
+    Metrics {
+        /// Print the raw metrics as JSON
+        #[arg(long)]
+        json: bool,
+    },
     /// Shutdown the daemon
     Shutdown,
 }
@@ -72,6 +78,17 @@ async fn main() -> Result<()> {
         Commands::Wallet { layout: _ } => {
             eprintln!("Wallet command not yet implemented in client library.");
         }
+        Commands::Metrics { json } => match client.metrics().await {
+            Ok(metrics) if json => println!("{}", serde_json::to_string(&metrics)?),
+            Ok(metrics) => {
+                print_response(OrchestratorResponse::Metrics(metrics));
+                match client.supervisor_metrics().await {
+                    Ok(metrics) => print_response(OrchestratorResponse::SupervisorMetrics(metrics)),
+                    Err(e) => eprintln!("ERROR: {}", e),
+                }
+            }
+            Err(e) => eprintln!("ERROR: {}", e),
+        },
         Commands::Shutdown => {
             eprintln!("Shutdown command not yet implemented in client library.");
         }
@@ -99,6 +116,55 @@ fn print_response(resp: OrchestratorResponse) {
                 println!("- {} (v{}): {}", s.service, s.version, s.description);
             }
         }
+        OrchestratorResponse::Metrics(services) => {
+            println!(
+                "{:<24} | {:<16} | {:>10} | {:>6} | {:>12} | {:>12} | {:>12}",
+                "SERVICE", "PORT", "MESSAGES", "GAPS", "WAIT P99 NS", "CALL P99 NS", "ORIG P99 NS"
+            );
+            for service in services {
+                for runner in service.metrics.runners {
+                    println!(
+                        "{:<24} | {:<16} | {:>10} | {:>6} | {:>12} | {:>12} | {:>12}",
+                        service.id,
+                        runner.name,
+                        runner.messages,
+                        runner.gaps,
+                        runner.queue_wait.p99_ns,
+                        runner.callback.p99_ns,
+                        runner.since_origin.p99_ns
+                    );
+                }
+                for named in service.metrics.histograms {
+                    println!(
+                        "{:<24} | {:<16} | {:>10} | {:>6} | {:>12} | {:>12} | {:>12}",
+                        service.id,
+                        named.name,
+                        named.histogram.count,
+                        "",
+                        "",
+                        named.histogram.p99_ns,
+                        ""
+                    );
+                }
+            }
+        }
+        OrchestratorResponse::SupervisorMetrics(metrics) => {
+            println!();
+            println!(
+                "{:<24} | {:>10} | {:>12} | {:>12}",
+                "SUPERVISOR", "COUNT", "P50 MS", "MAX MS"
+            );
+            for (name, histogram) in [("deploy", metrics.deploy), ("recovery", metrics.recovery)] {
+                println!(
+                    "{:<24} | {:>10} | {:>12.1} | {:>12.1}",
+                    name,
+                    histogram.count,
+                    histogram.p50_ns as f64 / 1e6,
+                    histogram.max_ns as f64 / 1e6
+                );
+            }
+            println!("{:<24} | {:>10} |", "restarts", metrics.restarts);
+        }
         OrchestratorResponse::Error(e) => eprintln!("ERROR: {}", e),
     }
 }
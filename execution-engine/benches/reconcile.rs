@@ -0,0 +1,58 @@
+//! Target reconciliation of `Engine` against synthetic books.
+
+use anyhow::Result;
+use execution_engine::engine::Engine;
+use trading::model::execution::{ExecutionResult, ExecutionStatus};
+use trading::model::portfolio::{Portfolio, Target};
+use trading::traits::executor::Executor;
+use trading_core::bench::Bench;
+
+const UNIVERSES: [usize; 3] = [16, 256, 4096];
+
+fn target(universe: usize, quantity: f64) -> Target {
+    let mut portfolio = Portfolio::new();
+    for id in 0..universe {
+        portfolio.update_position(id, quantity + id as f64);
+    }
+    Target::new(portfolio)
+}
+
+fn main() -> Result<()> {
+    let mut bench = Bench::new("execution_engine")?;
+    let mut orders = Vec::new();
+    let mut follow_ups = Vec::new();
+
+    for universe in UNIVERSES {
+        // Alternating targets move every instrument; filling every order keeps the
+        // book of open orders from growing across iterations.
+        let targets = [target(universe, 1.0), target(universe, 2.0)];
+        let mut engine = Engine::new();
+        let mut next = 0;
+        bench.run(&format!("reconcile_and_fill/{}", universe), || {
+            orders.clear();
+            engine.on_target_into(targets[next].clone(), &mut orders);
+            next ^= 1;
+            for order in orders.drain(..) {
+                let quantity = order.get_quantity();
+                let fill = ExecutionResult::new(
+                    order.get_id(),
+                    order.get_instrument_id(),
+                    ExecutionStatus::Filled,
+                    0,
+                )
+                .with_fill(quantity, 100.0, quantity, 100.0);
+                engine.on_execution_into(fill, &mut follow_ups);
+            }
+        })?;
+
+        // A target that moves nothing: the cost of the dirty-set fast path.
+        let target = targets[0].clone();
+        bench.run(&format!("reconcile_unchanged/{}", universe), || {
+            orders.clear();
+            engine.on_target_into(target.clone(), &mut orders);
+            orders.len()
+        })?;
+    }
+
+    bench.finish()
+}
@@ -1,111 +1,249 @@
-use log::info;
-use std::collections::HashSet;
+mod order_id;
+
+pub use order_id::OrderIdGenerator;
+
+use log::{debug, warn};
+use std::collections::{HashMap, HashSet};
 use trading::model::{
-    execution::ExecutionResult,
+    execution::{ExecutionResult, ExecutionStatus},
     instrument::InstrumentId,
-    order::{Order, OrderSide, OrderType},
+    order::{unix_nanos, Order, OrderSide, OrderType},
     portfolio::{Actual, Target},
 };
 use trading::traits::executor::Executor;
-use uuid::Uuid;
+
+/// Quantity below which a difference is treated as dust and not traded.
+const DUST: f64 = 1e-6;
+
+/// An order sent but not yet in a terminal state.
+struct OpenOrder {
+    instrument_id: InstrumentId,
+    /// Quantity still expected to fill, signed (positive = buy).
+    remaining: f64,
+}
 
 pub struct Engine {
     /// The current "Actual" portfolio state (what we own).
     actual: Actual,
+    /// Target quantity per instrument, as of the last target received.
+    targets: HashMap<InstrumentId, f64>,
+    /// Signed quantity of in-flight orders per instrument.
+    in_flight: HashMap<InstrumentId, f64>,
+    /// In-flight orders by ID, to attribute fills.
+    open_orders: HashMap<u64, OpenOrder>,
+    /// Instruments whose target or actual changed since the last reconciliation.
+    dirty: HashSet<InstrumentId>,
+    order_ids: OrderIdGenerator,
 }
 
 impl Engine {
     pub fn new() -> Self {
         Self {
             actual: Actual(trading::model::portfolio::Portfolio::new()),
+            targets: HashMap::new(),
+            in_flight: HashMap::new(),
+            open_orders: HashMap::new(),
+            dirty: HashSet::new(),
+            order_ids: OrderIdGenerator::new(),
         }
     }
 
-    /// Helper to generate orders to move from Actual -> Target
-    fn reconcile(&self, target: &Target) -> Vec<Order> {
-        let mut orders = Vec::new();
-
-        // We only look at Positions in the Target (Quantity-based).
+    /// Records the new target and marks the instruments whose target quantity changed.
+    fn apply_target(&mut self, target: &Target) {
+        let positions = &target.0.positions;
+        let dirty = &mut self.dirty;
 
-        let target_portfolio = &target.0;
-        let actual_portfolio = &self.actual.0;
+        // Instruments dropped from the target go back to zero.
+        self.targets.retain(|inst_id, _| {
+            let kept = positions.contains(*inst_id);
+            if !kept {
+                dirty.insert(*inst_id);
+            }
+            kept
+        });
+        for position in positions {
+            let inst_id = position.get_instrument_id();
+            let qty = position.get_quantity();
+            if self.targets.insert(inst_id, qty) != Some(qty) {
+                dirty.insert(inst_id);
+            }
+        }
+    }
 
-        let mut all_ids: HashSet<InstrumentId> = HashSet::new();
-        all_ids.extend(target_portfolio.positions.keys());
-        all_ids.extend(actual_portfolio.positions.keys());
+    /// Emits orders moving Actual (plus in-flight orders) to Target, for dirty instruments only.
+    ///
+    /// # Arguments
+    ///
+    /// * `orders` - Buffer the new orders are appended to.
+    fn reconcile(&mut self, orders: &mut Vec<Order>) {
+        if self.dirty.is_empty() {
+            return;
+        }
+        // One clock read per pass, not per order.
+        let timestamp = unix_nanos();
 
-        for inst_id in all_ids {
-            let target_qty = target_portfolio
-                .positions
-                .get(&inst_id)
-                .map(|p| p.get_quantity())
-                .unwrap_or(0.0);
-            let actual_qty = actual_portfolio
-                .positions
-                .get(&inst_id)
-                .map(|p| p.get_quantity())
-                .unwrap_or(0.0);
+        for inst_id in self.dirty.drain() {
+            let target_qty = self.targets.get(&inst_id).copied().unwrap_or(0.0);
+            let actual_qty = self.actual.0.positions.quantity(inst_id);
+            let pending_qty = self.in_flight.get(&inst_id).copied().unwrap_or(0.0);
 
-            let diff = target_qty - actual_qty;
+            let diff = target_qty - actual_qty - pending_qty;
 
             // Simple threshold to avoid dust orders
-            if diff.abs() > 1e-6 {
+            if diff.abs() > DUST {
                 let side = if diff > 0.0 {
                     OrderSide::buy()
                 } else {
                     OrderSide::sell()
                 };
+                let order_id = self.order_ids.next_id();
 
-                let order = Order::new(
-                    Uuid::new_v4().to_string(), // id
-                    inst_id.to_string(),        // instrument_id (as string)
+                orders.push(Order::new(
+                    order_id,
+                    inst_id,
                     side,
-                    OrderType::market(),                   // order_type
-                    0.0,                                   // price
-                    diff.abs(),                            // quantity
-                    chrono::Utc::now().timestamp_millis(), // timestamp
+                    OrderType::market(),
+                    0.0,
+                    diff.abs(),
+                    timestamp,
+                ));
+
+                *self.in_flight.entry(inst_id).or_insert(0.0) += diff;
+                self.open_orders.insert(
+                    order_id,
+                    OpenOrder {
+                        instrument_id: inst_id,
+                        remaining: diff,
+                    },
                 );
-
-                orders.push(order);
             }
         }
+    }
+
+    /// Applies a fill to Actual and releases the order once it is terminal.
+    fn apply_execution(&mut self, execution: &ExecutionResult) {
+        let order_id = execution.order_id;
+        let Some(open) = self.open_orders.get_mut(&order_id) else {
+            warn!("Execution for unknown order {}", order_id);
+            return;
+        };
+        let inst_id = open.instrument_id;
+
+        let fill = execution
+            .last_filled_quantity
+            .abs()
+            .min(open.remaining.abs())
+            * open.remaining.signum();
+        open.remaining -= fill;
+        let terminal = !matches!(
+            execution.status,
+            ExecutionStatus::New | ExecutionStatus::Pending | ExecutionStatus::PartiallyFilled
+        );
+        // Whatever is left of a terminal order will never fill.
+        let released = if terminal {
+            fill + open.remaining
+        } else {
+            fill
+        };
+        if terminal {
+            self.open_orders.remove(&order_id);
+        }
 
-        orders
+        if fill != 0.0 {
+            self.actual.0.positions.add(inst_id, fill);
+        }
+        if released != 0.0 {
+            let pending = self.in_flight.entry(inst_id).or_insert(0.0);
+            *pending -= released;
+            if pending.abs() <= DUST {
+                self.in_flight.remove(&inst_id);
+            }
+            self.dirty.insert(inst_id);
+        }
     }
 }
 
 impl Executor for Engine {
     fn on_target(&mut self, target: Target) -> (Vec<Order>, Option<Actual>) {
-        info!("Received Target Portfolio");
+        let mut orders = Vec::new();
+        let actual = self.on_target_into(target, &mut orders);
+        (orders, actual)
+    }
+
+    fn on_execution(&mut self, execution: ExecutionResult) -> (Vec<Order>, Option<Actual>) {
+        let mut orders = Vec::new();
+        let actual = self.on_execution_into(execution, &mut orders);
+        (orders, actual)
+    }
 
-        // Reconcile Target vs Actual
-        let orders = self.reconcile(&target);
+    fn on_target_into(&mut self, target: Target, orders: &mut Vec<Order>) -> Option<Actual> {
+        debug!("Received Target Portfolio");
+
+        // Only instruments whose target moved, or that saw fills since the last
+        // pass, are reconciled.
+        self.apply_target(&target);
+        self.reconcile(orders);
 
         // We don't update Actual here; we wait for Fills.
+        None
+    }
 
-        (orders, None)
+    fn on_execution_into(
+        &mut self,
+        execution: ExecutionResult,
+        _orders: &mut Vec<Order>,
+    ) -> Option<Actual> {
+        // Track the fill; the affected instrument is re-checked on the next target.
+        self.apply_execution(&execution);
+        None
     }
+}
 
-    fn on_execution(&mut self, execution: ExecutionResult) -> (Vec<Order>, Option<Actual>) {
-        // info!("Received Execution for Order: {}", execution.order_id);
-
-        // Update Local Actual from Fill
-        let inst_id_str = execution.instrument_id;
-        let inst_id = inst_id_str.parse::<usize>().unwrap_or(0);
-
-        if inst_id > 0 {
-            let _current_qty = self
-                .actual
-                .0
-                .positions
-                .get(&inst_id)
-                .map(|p| p.get_quantity())
-                .unwrap_or(0.0);
-            // Logic to update position would go here.
-            // For "Dumb Clean Engine", we trust the next Target/Actual loop or
-            // Broker updates.
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use trading::model::portfolio::Portfolio;
+
+    fn target(positions: &[(InstrumentId, f64)]) -> Target {
+        let mut portfolio = Portfolio::new();
+        for &(inst_id, qty) in positions {
+            portfolio.update_position(inst_id, qty);
         }
+        Target::new(portfolio)
+    }
+
+    #[test]
+    fn test_only_changed_instruments_are_reconciled() {
+        let mut engine = Engine::new();
+        engine.order_ids = OrderIdGenerator::starting_at(1);
+        let mut orders = Vec::new();
 
-        (vec![], None)
+        engine.on_target_into(target(&[(1, 10.0), (2, 5.0)]), &mut orders);
+        assert_eq!(orders.len(), 2);
+        let first = orders.iter().find(|o| o.get_instrument_id() == 1).unwrap();
+        let first_id = first.get_id();
+
+        // Same target while the orders are in flight: nothing to send.
+        orders.clear();
+        engine.on_target_into(target(&[(1, 10.0), (2, 5.0)]), &mut orders);
+        assert!(orders.is_empty());
+
+        // Instrument 1 partially fills then the rest is cancelled:
+        // only the unfilled remainder is re-sent.
+        let fill = ExecutionResult::new(first_id, 1, ExecutionStatus::Cancelled, 0)
+            .with_fill(4.0, 100.0, 4.0, 100.0);
+        engine.on_execution_into(fill, &mut orders);
+        engine.on_target_into(target(&[(1, 10.0), (2, 5.0)]), &mut orders);
+        assert_eq!(orders.len(), 1);
+        assert_eq!(orders[0].get_instrument_id(), 1);
+        assert!((orders[0].get_quantity() - 6.0).abs() < DUST);
+        assert_eq!(orders[0].get_id(), 3);
+
+        // Dropping instrument 2 from the target unwinds its in-flight buy.
+        orders.clear();
+        engine.on_target_into(target(&[(1, 10.0)]), &mut orders);
+        assert_eq!(orders.len(), 1);
+        assert_eq!(orders[0].get_instrument_id(), 2);
+        assert_eq!(orders[0].get_side(), OrderSide::sell());
     }
 }
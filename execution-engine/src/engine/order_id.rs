@@ -0,0 +1,31 @@
+/// Hands out monotonic integer order IDs without allocating.
+///
+/// IDs start at the wall-clock time in nanoseconds when the generator is built, so a
+/// restarted engine never reuses the IDs of its previous run.
+pub struct OrderIdGenerator {
+    next: u64,
+}
+
+impl OrderIdGenerator {
+    pub fn new() -> Self {
+        Self::starting_at(trading::model::order::unix_nanos())
+    }
+
+    /// Creates a generator whose first ID is `first`.
+    pub fn starting_at(first: u64) -> Self {
+        Self { next: first }
+    }
+
+    /// Returns the next ID.
+    pub fn next_id(&mut self) -> u64 {
+        let id = self.next;
+        self.next += 1;
+        id
+    }
+}
+
+impl Default for OrderIdGenerator {
+    fn default() -> Self {
+        Self::new()
+    }
+}
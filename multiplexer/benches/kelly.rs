@@ -0,0 +1,54 @@
+//! Aggregation of strategy allocations by `KellyMultiplexer`.
+
+use anyhow::Result;
+use multiplexer::kelly_multiplexer::{KellyMultiplexer, MultiplexerConfig};
+use trading::model::allocation::Allocation;
+use trading::model::allocation_batch::AllocationBatch;
+use trading::Multiplexist;
+use trading_core::bench::Bench;
+
+const UNIVERSES: [usize; 3] = [16, 256, 4096];
+const CLIENTS: usize = 16;
+
+fn allocation(universe: usize, quantity: f64) -> Allocation {
+    let mut allocation = Allocation::new();
+    for id in 0..universe {
+        allocation.update_position(id, quantity + id as f64);
+    }
+    allocation
+}
+
+fn main() -> Result<()> {
+    let mut bench = Bench::new("multiplexer")?;
+
+    for universe in UNIVERSES {
+        let mut mux = KellyMultiplexer::new(
+            MultiplexerConfig {
+                kelly_fraction: 1.0,
+            },
+            0,
+        );
+        for client in 0..CLIENTS {
+            mux.add_client(client, 0.05, 0.2);
+            mux.on_allocation_batch(
+                client,
+                AllocationBatch::new(vec![allocation(universe, client as f64)]),
+            );
+        }
+
+        bench.run(&format!("recalculate/{}", universe), || mux.recalculate())?;
+
+        // Includes the copy of the incoming batch, which the trait takes by value.
+        let updates = [
+            AllocationBatch::new(vec![allocation(universe, 1.0)]),
+            AllocationBatch::new(vec![allocation(universe, 2.0)]),
+        ];
+        let mut next = 0;
+        bench.run(&format!("on_allocation_batch/{}", universe), || {
+            next ^= 1;
+            mux.on_allocation_batch(0, updates[next].clone())
+        })?;
+    }
+
+    bench.finish()
+}
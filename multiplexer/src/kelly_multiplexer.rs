@@ -2,10 +2,14 @@ use log::info;
 use std::collections::HashMap;
 use trading::model::{
     allocation::Allocation, allocation_batch::AllocationBatch, identity::Identity,
+    instrument::InstrumentId, positions::Positions,
 };
 use trading::Multiplexist;
 use trading_core::args::CommonArgs;
 
+/// Aggregate weights smaller than this are float residue from cancelling updates.
+const RESIDUE: f64 = 1e-12;
+
 #[derive(Debug, Clone)]
 pub struct MultiplexerConfig {
     pub kelly_fraction: f64,
@@ -15,6 +19,8 @@ pub struct MultiplexerConfig {
 pub struct Client {
     id: usize,
     strategy_params: StrategyParams,
+    /// Kelly scale applied to this client's allocation, derived from its params.
+    scalar: f64,
     portfolio: Allocation,
 }
 
@@ -28,6 +34,8 @@ pub struct KellyMultiplexer {
     identity: Identity,
     config: MultiplexerConfig,
     clients: HashMap<usize, Client>,
+    /// Sum of every client's scaled allocation, kept up to date as clients change.
+    aggregate: Positions,
 }
 
 impl KellyMultiplexer {
@@ -36,18 +44,36 @@ impl KellyMultiplexer {
             identity: Identity::new("kelly_multiplexer", "1.0.0", id),
             config,
             clients: HashMap::new(),
+            aggregate: Positions::new(),
         }
     }
 
     pub fn add_client(&mut self, id: usize, mu: f64, sigma: f64) {
-        self.clients.insert(
-            id,
-            Client {
-                id,
-                strategy_params: StrategyParams { mu, sigma },
-                portfolio: Allocation::new(),
-            },
-        );
+        let strategy_params = StrategyParams { mu, sigma };
+        let scalar = self.kelly_scalar(&strategy_params);
+        match self.clients.get_mut(&id) {
+            Some(client) => {
+                // Rescale the existing contribution to the new params.
+                apply(
+                    &mut self.aggregate,
+                    client.portfolio.get_positions(),
+                    scalar - client.scalar,
+                );
+                client.strategy_params = strategy_params;
+                client.scalar = scalar;
+            }
+            None => {
+                self.clients.insert(
+                    id,
+                    Client {
+                        id,
+                        strategy_params,
+                        scalar,
+                        portfolio: Allocation::new(),
+                    },
+                );
+            }
+        }
         info!(
             "[KellyMux] Added/Updated client {} (Mu={}, Sigma={})",
             id, mu, sigma
@@ -55,67 +81,125 @@ impl KellyMultiplexer {
     }
 
     pub fn remove_client(&mut self, id: usize) {
-        self.clients.remove(&id);
+        if let Some(client) = self.clients.remove(&id) {
+            apply(
+                &mut self.aggregate,
+                client.portfolio.get_positions(),
+                -client.scalar,
+            );
+        }
         info!("[KellyMux] Removed client {}", id);
     }
 
-    pub fn recalculate(&mut self) -> Option<Allocation> {
+    /// Returns the current aggregate allocation.
+    ///
+    /// # Returns
+    ///
+    /// `None` if no client is registered.
+    pub fn recalculate(&self) -> Option<Allocation> {
         if self.clients.is_empty() {
             return None;
         }
+        Some(Allocation::from_positions(self.aggregate.clone()))
+    }
 
-        let mut allocation = Allocation::new();
-
-        for (_client_id, client) in &self.clients {
-            let params = &client.strategy_params;
-
-            // Kelly Formula: f = (mu - r) / sigma^2
-            // Assuming r = 0 for simplicity or embedded in mu (excess return)
-            let raw_kelly = if params.sigma > 1e-6 {
-                params.mu / (params.sigma * params.sigma)
-            } else {
-                0.0
-            };
-
-            let mut scalar = self.config.kelly_fraction * raw_kelly;
-
-            // Safety clamp
-            if scalar > 2.0 {
-                scalar = 2.0;
-            }
-            if scalar < -2.0 {
-                scalar = -2.0;
-            }
-
-            for (instrument_id, position) in client.portfolio.get_positions() {
-                let final_weight = position.get_quantity() * scalar;
-                allocation.update_position(*instrument_id, final_weight);
-            }
+    /// Replaces a client's allocation, updating the aggregate by the difference only.
+    fn update_client(&mut self, id: usize, allocation: Allocation) {
+        if !self.clients.contains_key(&id) {
+            self.add_client(id, 0.05, 0.2);
         }
+        let client = self.clients.get_mut(&id).unwrap();
+        apply(
+            &mut self.aggregate,
+            client.portfolio.get_positions(),
+            -client.scalar,
+        );
+        apply(
+            &mut self.aggregate,
+            allocation.get_positions(),
+            client.scalar,
+        );
+        client.portfolio = allocation;
+    }
 
-        Some(allocation)
+    fn kelly_scalar(&self, params: &StrategyParams) -> f64 {
+        // Kelly Formula: f = (mu - r) / sigma^2
+        // Assuming r = 0 for simplicity or embedded in mu (excess return)
+        let raw_kelly = if params.sigma > 1e-6 {
+            params.mu / (params.sigma * params.sigma)
+        } else {
+            0.0
+        };
+
+        // Safety clamp
+        (self.config.kelly_fraction * raw_kelly).clamp(-2.0, 2.0)
+    }
+}
+
+/// Adds `scale` times `positions` to `aggregate`.
+fn apply(aggregate: &mut Positions, positions: &Positions, scale: f64) {
+    if scale == 0.0 {
+        return;
+    }
+    for position in positions {
+        let id = position.get_instrument_id();
+        let weight = aggregate.quantity(id) + position.get_quantity() * scale;
+        aggregate.set(id, if weight.abs() < RESIDUE { 0.0 } else { weight });
     }
 }
 
 impl Multiplexist for KellyMultiplexer {
     fn on_allocation_batch(&mut self, source_id: usize, batch: AllocationBatch) -> AllocationBatch {
-        let mut results = Vec::new();
-
-        for allocation in batch.iter() {
-            // Note: In real system, source_id from args would distinguish clients.
-            // For now, we trust the param.
-            if let Some(client) = self.clients.get_mut(&source_id) {
-                client.portfolio = allocation.clone();
-            } else {
-                self.add_client(source_id, 0.05, 0.2);
-                if let Some(client) = self.clients.get_mut(&source_id) {
-                    client.portfolio = allocation.clone();
-                }
-            }
-            if let Some(recalc) = self.recalculate() {
-                results.push(recalc);
-            }
+        // Note: In real system, source_id from args would distinguish clients.
+        // For now, we trust the param.
+        // Each allocation replaces the previous one of its source, so only the
+        // last one of the batch contributes to the aggregate.
+        let Some(allocation) = batch.into_iter().last() else {
+            return AllocationBatch::new(Vec::new());
+        };
+        self.update_client(source_id, allocation);
+
+        AllocationBatch::new(self.recalculate().into_iter().collect())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn allocation(positions: &[(InstrumentId, f64)]) -> Allocation {
+        let mut allocation = Allocation::new();
+        for &(id, qty) in positions {
+            allocation.update_position(id, qty);
         }
-        AllocationBatch::new(results)
+        allocation
+    }
+
+    #[test]
+    fn test_aggregate_follows_client_updates() {
+        let mut mux = KellyMultiplexer::new(
+            MultiplexerConfig {
+                kelly_fraction: 1.0,
+            },
+            0,
+        );
+        // Default params: 0.05 / 0.2^2 = 1.25
+        let out = mux.on_allocation_batch(
+            1,
+            AllocationBatch::new(vec![allocation(&[(1, 1.0)]), allocation(&[(1, 2.0)])]),
+        );
+        assert_eq!(out.len(), 1);
+        mux.on_allocation_batch(
+            2,
+            AllocationBatch::new(vec![allocation(&[(1, 1.0), (2, 4.0)])]),
+        );
+
+        let aggregate = mux.recalculate().unwrap();
+        assert!((aggregate.get_position(1).unwrap().get_quantity() - 3.75).abs() < 1e-9);
+        assert!((aggregate.get_position(2).unwrap().get_quantity() - 5.0).abs() < 1e-9);
+
+        mux.remove_client(2);
+        mux.on_allocation_batch(1, AllocationBatch::new(vec![allocation(&[])]));
+        assert!(mux.recalculate().unwrap().get_positions().is_empty());
     }
 }
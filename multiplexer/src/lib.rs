@@ -0,0 +1 @@
+pub mod kelly_multiplexer;
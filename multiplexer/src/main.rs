@@ -1,7 +1,5 @@
-mod kelly_multiplexer;
-
 use anyhow::Result;
-use kelly_multiplexer::{KellyMultiplexer, MultiplexerConfig};
+use multiplexer::kelly_multiplexer::{KellyMultiplexer, MultiplexerConfig};
 use trading_core::microservice::{
     configuration::{multiplexer::Multiplexer, Configuration},
     Microservice,
@@ -1,5 +1,5 @@
 use crate::messages::{OrchestratorCommand, OrchestratorResponse};
-use crate::model::Layout;
+use crate::model::{Layout, ServiceMetrics, SupervisorMetrics};
 use anyhow::{Context, Result};
 use trading_core::comms::transport::TransportDuplex;
 use trading_core::comms::transports::zmq::ZmqClientDuplex;
@@ -32,6 +32,27 @@ impl OrchestratorClient {
         }
     }
 
+    /// Collects the latency metrics of every running service.
+    pub async fn metrics(&mut self) -> Result<Vec<ServiceMetrics>> {
+        match self.send_command(OrchestratorCommand::GetMetrics).await? {
+            OrchestratorResponse::Metrics(metrics) => Ok(metrics),
+            OrchestratorResponse::Error(e) => anyhow::bail!("Orchestrator Error: {}", e),
+            _ => anyhow::bail!("Unexpected response type"),
+        }
+    }
+
+    /// Collects the deploy and recovery times of the orchestrator itself.
+    pub async fn supervisor_metrics(&mut self) -> Result<SupervisorMetrics> {
+        match self
+            .send_command(OrchestratorCommand::GetSupervisorMetrics)
+            .await?
+        {
+            OrchestratorResponse::SupervisorMetrics(metrics) => Ok(metrics),
+            OrchestratorResponse::Error(e) => anyhow::bail!("Orchestrator Error: {}", e),
+            _ => anyhow::bail!("Unexpected response type"),
+        }
+    }
+
     async fn send_command(&mut self, cmd: OrchestratorCommand) -> Result<OrchestratorResponse> {
         let req_bytes = bincode::serialize(&cmd).context("Failed to serialize command")?;
         self.transport.send_bytes(&req_bytes).await?;
@@ -5,5 +5,5 @@ pub mod server;
 
 pub use client::OrchestratorClient;
 pub use messages::{OrchestratorCommand, OrchestratorResponse};
-pub use model::{Layout, ProcessInfo, RunMode};
+pub use model::{Layout, ProcessInfo, RunMode, ServiceMetrics, SupervisorMetrics};
 pub use server::OrchestratorServer;
@@ -1,4 +1,4 @@
-use crate::model::{Layout, ProcessInfo, RunMode};
+use crate::model::{Layout, ProcessInfo, RunMode, ServiceMetrics, SupervisorMetrics};
 use serde::{Deserialize, Serialize};
 
 #[derive(Serialize, Deserialize, Debug)]
@@ -9,6 +9,8 @@ pub enum OrchestratorCommand {
     GetWallet { layout_id: String },
     Shutdown,
     GetServices,
+    GetMetrics,
+    GetSupervisorMetrics,
 }
 
 #[derive(Serialize, Deserialize, Debug)]
@@ -17,5 +19,7 @@ pub enum OrchestratorResponse {
     StatusInfo(Vec<ProcessInfo>),
     WalletInfo(serde_json::Value),
     ServicesList(Vec<crate::model::ServiceDescriptor>),
+    Metrics(Vec<ServiceMetrics>),
+    SupervisorMetrics(SupervisorMetrics),
     Error(String),
 }
@@ -1,4 +1,7 @@
 use serde::{Deserialize, Serialize};
+use trading_core::framework::Placement;
+use trading_core::metrics::{HistogramSnapshot, MetricsSnapshot};
+use trading_core::model::instrument::InstrumentId;
 
 #[derive(Serialize, Deserialize, Clone, Debug, Default)]
 pub struct Layout {
@@ -43,6 +46,13 @@ pub struct Node {
     name: String,
     service: String,
     status: String,
+    /// CPU placement hints for the service's threads (cores, NUMA node, RT priority).
+    #[serde(default)]
+    placement: Placement,
+    /// Instruments the service trades. Its market data inputs subscribe only to the
+    /// partitions covering them; empty means the whole feed.
+    #[serde(default, skip_serializing_if = "Vec::is_empty")]
+    universe: Vec<InstrumentId>,
 }
 
 impl Node {
@@ -52,9 +62,23 @@ impl Node {
             name,
             service,
             status,
+            placement: Placement::default(),
+            universe: Vec::new(),
         }
     }
 
+    /// Sets the CPU placement hints of this node.
+    pub fn with_placement(mut self, placement: Placement) -> Self {
+        self.placement = placement;
+        self
+    }
+
+    /// Sets the instrument universe of this node.
+    pub fn with_universe(mut self, universe: Vec<InstrumentId>) -> Self {
+        self.universe = universe;
+        self
+    }
+
     pub fn id(&self) -> &str {
         &self.id
     }
@@ -68,11 +92,29 @@ impl Node {
         &self.status
     }
 
+    pub fn placement(&self) -> &Placement {
+        &self.placement
+    }
+
+    pub fn universe(&self) -> &[InstrumentId] {
+        &self.universe
+    }
+
     pub fn set_status(&mut self, status: String) {
         self.status = status;
     }
 }
 
+/// Transport used to carry the messages of an edge.
+#[derive(Serialize, Deserialize, Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum EdgeTransport {
+    /// ZMQ over TCP. Works across hosts.
+    #[default]
+    Zmq,
+    /// Shared-memory ring. Source and target must run on the same host.
+    Shm,
+}
+
 #[derive(Serialize, Deserialize, Debug, Clone)]
 pub struct Edge {
     id: String,
@@ -80,6 +122,8 @@ pub struct Edge {
     source_port: String, // Output Port Name
     target: String,      // Node ID
     target_port: String, // Input Port Name
+    #[serde(default)]
+    transport: EdgeTransport,
 }
 
 impl Edge {
@@ -96,9 +140,16 @@ impl Edge {
             source_port,
             target,
             target_port,
+            transport: EdgeTransport::default(),
         }
     }
 
+    /// Sets the transport carrying this edge.
+    pub fn with_transport(mut self, transport: EdgeTransport) -> Self {
+        self.transport = transport;
+        self
+    }
+
     pub fn id(&self) -> &str {
         &self.id
     }
@@ -116,6 +167,10 @@ impl Edge {
     pub fn target_port(&self) -> &str {
         &self.target_port
     }
+
+    pub fn transport(&self) -> EdgeTransport {
+        self.transport
+    }
 }
 
 #[derive(Serialize, Deserialize, Debug, Clone)]
@@ -134,6 +189,24 @@ pub struct ProcessInfo {
     pub memory_usage: u64,
 }
 
+/// Latency metrics reported by one running service.
+#[derive(Serialize, Deserialize, Debug, Clone)]
+pub struct ServiceMetrics {
+    pub id: String,
+    pub metrics: MetricsSnapshot,
+}
+
+/// What the orchestrator records about its own deployments.
+#[derive(Serialize, Deserialize, Debug, Clone, Default)]
+pub struct SupervisorMetrics {
+    /// From a deploy request to every service of the layout being started.
+    pub deploy: HistogramSnapshot,
+    /// From a service crash to its replacement being started.
+    pub recovery: HistogramSnapshot,
+    /// Services restarted after a crash or a failed start.
+    pub restarts: u64,
+}
+
 /// Represents a discovered service available for deployment.
 #[derive(Serialize, Deserialize, Debug, Clone)]
 pub struct ServiceDescriptor {
@@ -0,0 +1,61 @@
+//! Risk checks of `RiskGuard` against synthetic books.
+
+use anyhow::Result;
+use portfolio_manager::model::config::{AllocationConfig, StrategyConfig};
+use portfolio_manager::model::consolidated::ConsolidatedPortfolio;
+use portfolio_manager::model::ids::MultiplexerId;
+use portfolio_manager::risk_guard::max_allocation::MaxAllocationPolicy;
+use portfolio_manager::risk_guard::max_position_size::MaxPositionSizePolicy;
+use portfolio_manager::risk_guard::{Exposure, RiskContext, RiskDecision, RiskGuard};
+use std::collections::HashMap;
+use trading::model::portfolio::Portfolio;
+use trading_core::bench::Bench;
+
+const UNIVERSES: [usize; 3] = [16, 256, 4096];
+
+fn main() -> Result<()> {
+    let mut bench = Bench::new("portfolio_manager")?;
+
+    let mut guard = RiskGuard::new();
+    guard.add_policy(Box::new(MaxAllocationPolicy));
+    guard.add_policy(Box::new(MaxPositionSizePolicy { max_percent: 0.10 }));
+    let id = MultiplexerId::new("Global");
+    let mut config = AllocationConfig::default();
+    config.insert(id.clone(), StrategyConfig::new(1.0, 0.20, 0.0));
+    let consolidated = ConsolidatedPortfolio {
+        total_equity: 1e12,
+        ..Default::default()
+    };
+
+    for universe in UNIVERSES {
+        // A book holding the whole universe, with a proposal moving a tenth of it;
+        // equity is large enough for every proposal to be approved.
+        let prices: HashMap<_, _> = (0..universe).map(|id| (id, 100.0)).collect();
+        let mut current = Portfolio::new();
+        for id in 0..universe {
+            current.update_position(id, 1.0);
+        }
+        let exposure = Exposure::from_positions(&current.positions, &prices);
+        let changes: Vec<_> = (0..universe).step_by(10).map(|id| (id, 2.0)).collect();
+        let actual = Portfolio::new().with_equity(1e12);
+        let ctx = RiskContext {
+            portfolio: &actual,
+            prices: &prices,
+            exposure: &exposure,
+            total_equity: actual.total_equity,
+            allocation_config: &config,
+            consolidated: &consolidated,
+            multiplexer_id: &id,
+        };
+        assert_eq!(
+            guard.check_changes(&current.positions, &changes, &prices, &exposure, &ctx),
+            RiskDecision::Approved
+        );
+
+        bench.run(&format!("check/{}", universe), || {
+            guard.check_changes(&current.positions, &changes, &prices, &exposure, &ctx)
+        })?;
+    }
+
+    bench.finish()
+}
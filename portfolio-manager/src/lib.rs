@@ -1,6 +1,6 @@
-use log::{info, warn};
+use log::{debug, info, warn};
 use std::collections::HashMap;
-use std::sync::{Arc, Mutex};
+use std::sync::Arc;
 
 use trading::model::{
     allocation_batch::AllocationBatch,
@@ -13,16 +13,21 @@ use trading::Manager;
 use crate::model::{
     config::AllocationConfig, consolidated::ConsolidatedPortfolio, ids::MultiplexerId,
 };
-use crate::risk_guard::{RiskContext, RiskDecision, RiskGuard};
+use crate::risk_guard::{Exposure, RiskContext, RiskDecision, RiskGuard};
 
 pub mod model;
 pub mod risk_guard;
 
 pub struct PortfolioManager {
     // State
-    target_portfolio: Portfolio, // The specific target for this manager
+    // The specific target for this manager, shared with the last published Target.
+    target_portfolio: Arc<Portfolio>,
     actual_portfolio: Portfolio, // The last known actual state
     prices: HashMap<InstrumentId, f64>,
+    // Notional of the target, maintained incrementally for the risk checks.
+    exposure: Exposure,
+    // Proposed quantity per instrument of the batch being checked (reused buffer).
+    changes: Vec<(InstrumentId, f64)>,
 
     // Config & Logic
     config: AllocationConfig,
@@ -40,9 +45,11 @@ pub struct PortfolioManager {
 impl PortfolioManager {
     pub fn new(config: AllocationConfig, risk_guard: RiskGuard) -> Self {
         Self {
-            target_portfolio: Portfolio::new(),
+            target_portfolio: Arc::new(Portfolio::new()),
             actual_portfolio: Portfolio::new(),
             prices: HashMap::new(),
+            exposure: Exposure::default(),
+            changes: Vec::new(),
             config,
             risk_guard,
             consolidated: ConsolidatedPortfolio::default(),
@@ -50,15 +57,65 @@ impl PortfolioManager {
         }
     }
 
+    /// Creates the manager the service runs: the default risk policies, and the
+    /// aggregated Kelly multiplexer seeded at a 100% allocation.
+    ///
+    /// # Arguments
+    ///
+    /// * `risk_guard` - The guard to add the default policies to.
+    pub fn with_default_policies(mut risk_guard: RiskGuard) -> Self {
+        risk_guard.add_policy(Box::new(risk_guard::max_allocation::MaxAllocationPolicy));
+        risk_guard.add_policy(Box::new(
+            risk_guard::max_position_size::MaxPositionSizePolicy {
+                max_percent: 0.10, // 10% max pos size
+            },
+        ));
+
+        // Seed default config for testing/dummy support
+        let mut seeded_config = AllocationConfig::default();
+        seeded_config.insert(
+            MultiplexerId::new("KellyMux_Aggregated"),
+            model::config::StrategyConfig::new(1.0, 0.20, 0.0), // 100% alloc
+        );
+
+        Self::new(seeded_config, risk_guard)
+    }
+
     fn update_prices(&mut self, update: &PriceUpdate) {
-        self.prices
-            .insert(update.get_instrument_id(), update.get_last());
+        let instrument_id = update.get_instrument_id();
+        self.prices.insert(instrument_id, update.get_last());
+        let quantity = self.target_portfolio.positions.quantity(instrument_id);
+        if quantity != 0.0 {
+            self.exposure
+                .update(instrument_id, quantity, Some(update.get_last()));
+        }
+    }
+
+    /// Collects the positions of a batch that differ from the current target.
+    ///
+    /// A later allocation overrides an earlier one for the same instrument.
+    fn collect_changes(&mut self, batch: &AllocationBatch) {
+        self.changes.clear();
+        for allocation in batch.iter() {
+            for pos in allocation.get_positions() {
+                self.changes
+                    .push((pos.get_instrument_id(), pos.get_quantity()));
+            }
+        }
+        // Keep the last entry per instrument: reverse, stable sort, keep the first.
+        self.changes.reverse();
+        self.changes.sort_by_key(|(id, _)| *id);
+        self.changes.dedup_by_key(|(id, _)| *id);
+        let current = &self.target_portfolio.positions;
+        self.changes
+            .retain(|(id, quantity)| current.quantity(*id) != *quantity);
     }
 
     fn build_context(&self) -> RiskContext {
         RiskContext {
             portfolio: &self.actual_portfolio, // Risk checks often compare new Target vs Actual (Nav limits)
             prices: &self.prices,
+            exposure: &self.exposure,
             total_equity: self.actual_portfolio.total_equity, // Use actual equity
             allocation_config: &self.config,
             consolidated: &self.consolidated,
@@ -72,43 +129,43 @@ impl Manager for PortfolioManager {
         info!("Received batch with {} allocations", batch.len());
 
         // 1. Construct Proposed Target
-        // Start with current, apply updates.
-        // Assuming Allocation in batch OVERWRITES positions?
-        // Or is it a delta?
-        // Usually Allocation = "Desired State".
-        // If multiple allocations in batch, do they stack?
-        // Let's assume they are merged.
-
-        let mut proposed_target = self.target_portfolio.clone();
-
-        for allocation in batch.iter() {
-            for (inst_id, pos) in allocation.get_positions() {
-                // Determine logic: Overwrite?
-                // "Allocation" struct usually implies "This is what I want to hold".
-                // If Multiplexer aggregates, it sends the "Net Desired Position".
-                proposed_target.update_position(*inst_id, pos.get_quantity());
-            }
+        // "Allocation" struct usually implies "This is what I want to hold".
+        // If Multiplexer aggregates, it sends the "Net Desired Position".
+        // Positions absent from the batch keep their current target; only the
+        // instruments whose quantity changes make up the proposal.
+        self.collect_changes(&batch);
+        if self.changes.is_empty() {
+            debug!("Batch leaves the target unchanged");
+            return None;
         }
 
         // 2. Risk Check
-        // We check the 'proposed_target' as a single Allocation (conceptually).
-        // Adapt: RiskGuard::check expects `Allocation`.
-        // We can convert proposed_target (Portfolio) -> Allocation.
-        let mut check_alloc = trading::model::Allocation::new();
-        for (inst, pos) in &proposed_target.positions {
-            check_alloc.update_position(*inst, pos.get_quantity());
-        }
-
+        // Policies see the changed instruments against the cached exposure of the
+        // current target, so neither the target nor the batch is copied.
         let ctx = self.build_context();
-        match self.risk_guard.check(&check_alloc, &ctx) {
+        let decision = self.risk_guard.check_changes(
+            &self.target_portfolio.positions,
+            &self.changes,
+            &self.prices,
+            &self.exposure,
+            &ctx,
+        );
+        match decision {
             RiskDecision::Approved => {
                 info!("Risk Check Passed. Updating Target.");
-                self.target_portfolio = proposed_target;
+                // Copy-on-write: the portfolio is only copied if the previous
+                // Target snapshot is still held downstream.
+                let target = Arc::make_mut(&mut self.target_portfolio);
+                for &(inst_id, quantity) in &self.changes {
+                    target.update_position(inst_id, quantity);
+                    self.exposure
+                        .update(inst_id, quantity, self.prices.get(&inst_id).copied());
+                }
                 // Update Consolidated (Approximation)
                 // In this dummy, Consolidated = Local Target (Simplification)
                 // Actually Consolidated should track *actuals*.
                 // But for Risk Context next time, we use actuals.
-                Some(Target(self.target_portfolio.clone()))
+                Some(Target(Arc::clone(&self.target_portfolio)))
             }
             RiskDecision::Rejected(reason) => {
                 warn!("Risk Check REJECTED: {}", reason);
@@ -121,7 +178,7 @@ impl Manager for PortfolioManager {
 
     fn on_portfolio(&mut self, portfolio: Actual) -> Option<Target> {
         // Update Actual State
-        self.actual_portfolio = portfolio.0.clone();
+        self.actual_portfolio = portfolio.0;
         self.consolidated.total_equity = self.actual_portfolio.total_equity; // Sync simple
 
         // Check if we need to re-balance or cut risk?
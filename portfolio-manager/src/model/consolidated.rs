@@ -1,7 +1,10 @@
 use super::ids::MultiplexerId;
 use serde::{Deserialize, Serialize};
 use std::collections::HashMap;
-use trading::model::{instrument::InstrumentId, portfolio::Portfolio};
+use trading::model::{
+    instrument::InstrumentId,
+    portfolio::{CurrencyId, Portfolio},
+};
 
 /// Represents the aggregated state of the entire firm.
 #[derive(Debug, Clone, Default, Serialize, Deserialize)]
@@ -13,7 +16,7 @@ pub struct ConsolidatedPortfolio {
     pub total_equity: f64,
 
     /// Total Cash by currency (Sum of all strategy cash).
-    pub total_cash: HashMap<String, f64>,
+    pub total_cash: HashMap<CurrencyId, f64>,
 }
 
 impl ConsolidatedPortfolio {
@@ -24,13 +27,13 @@ impl ConsolidatedPortfolio {
 
         for portfolio in portfolios.values() {
             // Aggregate Positions
-            for (instrument_id, pos) in &portfolio.positions {
-                *net_positions.entry(*instrument_id).or_insert(0.0) += pos.get_quantity();
+            for pos in &portfolio.positions {
+                *net_positions.entry(pos.get_instrument_id()).or_insert(0.0) += pos.get_quantity();
             }
 
             // Aggregate Cash
-            for (currency, account) in &portfolio.cash {
-                *total_cash.entry(currency.clone()).or_insert(0.0) += account.amount;
+            for account in &portfolio.cash {
+                *total_cash.entry(account.currency).or_insert(0.0) += account.amount;
             }
 
             // Aggregate Equity
@@ -0,0 +1,65 @@
+use std::collections::HashMap;
+use trading::model::{instrument::InstrumentId, positions::Positions};
+
+/// Notional exposure of the current target, kept up to date as target quantities
+/// and prices change so that checks never re-walk the whole book.
+#[derive(Debug, Clone, Default)]
+pub struct Exposure {
+    /// Signed `quantity * price` per priced instrument of the target.
+    notional: HashMap<InstrumentId, f64>,
+    /// Sum of the absolute notionals.
+    gross: f64,
+    /// Sum of the signed notionals.
+    net: f64,
+}
+
+impl Exposure {
+    /// Builds the exposure of a target from scratch.
+    ///
+    /// # Arguments
+    ///
+    /// * `positions` - The target positions.
+    /// * `prices` - Last price per instrument; unpriced instruments count as zero.
+    pub fn from_positions(positions: &Positions, prices: &HashMap<InstrumentId, f64>) -> Self {
+        let mut exposure = Self::default();
+        for position in positions {
+            let id = position.get_instrument_id();
+            exposure.update(id, position.get_quantity(), prices.get(&id).copied());
+        }
+        exposure
+    }
+
+    /// Returns the signed notional currently held in an instrument.
+    pub fn notional(&self, instrument_id: InstrumentId) -> f64 {
+        self.notional.get(&instrument_id).copied().unwrap_or(0.0)
+    }
+
+    /// Returns the gross notional of the target.
+    pub fn gross(&self) -> f64 {
+        self.gross
+    }
+
+    /// Returns the net notional of the target.
+    pub fn net(&self) -> f64 {
+        self.net
+    }
+
+    /// Records a new quantity or price for one instrument.
+    ///
+    /// # Arguments
+    ///
+    /// * `instrument_id` - The instrument that changed.
+    /// * `quantity` - Its target quantity.
+    /// * `price` - Its last price, if known.
+    pub fn update(&mut self, instrument_id: InstrumentId, quantity: f64, price: Option<f64>) {
+        let notional = price.map_or(0.0, |price| quantity * price);
+        let previous = if notional == 0.0 {
+            self.notional.remove(&instrument_id)
+        } else {
+            self.notional.insert(instrument_id, notional)
+        }
+        .unwrap_or(0.0);
+        self.gross += notional.abs() - previous.abs();
+        self.net += notional - previous;
+    }
+}
@@ -1,5 +1,4 @@
-use super::{Policy, RiskContext, RiskDecision};
-use trading::model::allocation::Allocation;
+use super::{Policy, Proposal, RiskContext, RiskDecision};
 
 /// Enforces that the total value of the portfolio does not exceed limits.
 pub struct MaxAllocationPolicy;
@@ -9,7 +8,7 @@ impl Policy for MaxAllocationPolicy {
         "MaxAllocation"
     }
 
-    fn check(&self, target: &Allocation, ctx: &RiskContext) -> RiskDecision {
+    fn check(&self, proposal: &Proposal, ctx: &RiskContext) -> RiskDecision {
         // 1. Get Allowed Allocation
         let allowed_fraction = match ctx.allocation_config.get(ctx.multiplexer_id) {
             Some(config) => config.allocation_fraction(),
@@ -44,18 +43,11 @@ impl Policy for MaxAllocationPolicy {
         // But here we are checking a specific Allocation request.
 
         // Impl: Calculate Gross Exposure of Target.
-        let mut gross_exposure = 0.0;
-
-        for (instrument_id, pos) in target.get_positions() {
-            if let Some(price) = ctx.prices.get(instrument_id) {
-                gross_exposure += pos.get_quantity().abs() * price;
-            } else {
-                return RiskDecision::Rejected(format!(
-                    "No price for Instrument {}",
-                    instrument_id
-                ));
-            }
+        // The proposal projects it once per check from the cached exposure.
+        if let Some(instrument_id) = proposal.unpriced() {
+            return RiskDecision::Rejected(format!("No price for Instrument {}", instrument_id));
         }
+        let gross_exposure = proposal.gross_exposure();
 
         // If we assume standard 1.0 leverage, Exposure <= Equity.
         // And Equity is limited by configuration.
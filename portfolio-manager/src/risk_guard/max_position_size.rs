@@ -1,5 +1,4 @@
-use super::{Policy, RiskContext, RiskDecision};
-use trading::model::allocation::Allocation;
+use super::{Policy, Proposal, RiskContext, RiskDecision};
 
 /// Enforces that no single position exceeds a specific percentage of Total Equity.
 pub struct MaxPositionSizePolicy {
@@ -11,7 +10,7 @@ impl Policy for MaxPositionSizePolicy {
         "MaxPositionSize"
     }
 
-    fn check(&self, target: &Allocation, ctx: &RiskContext) -> RiskDecision {
+    fn check(&self, proposal: &Proposal, ctx: &RiskContext) -> RiskDecision {
         let equity = ctx.portfolio.total_equity;
         if equity <= 0.0 {
             // Can't optimize if no equity.
@@ -23,9 +22,11 @@ impl Policy for MaxPositionSizePolicy {
 
         let limit = equity * self.max_percent;
 
-        for (instrument_id, pos) in target.get_positions() {
-            if let Some(price) = ctx.prices.get(instrument_id) {
-                let position_value = pos.get_quantity().abs() * price;
+        // Unchanged positions were checked when they were approved.
+        for change in proposal.changes() {
+            let instrument_id = change.instrument_id;
+            if let Some(notional) = change.notional {
+                let position_value = notional.abs();
                 if position_value > limit {
                     return RiskDecision::Rejected(format!(
                         "Position {} Value {:.2} exceeds limit {:.2} ({:.1}% of Equity {:.2})",
@@ -0,0 +1,61 @@
+use serde::Serialize;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::time::Duration;
+use trading_core::metrics::HistogramSnapshot;
+
+/// Counters kept for every policy of a `RiskGuard`.
+#[derive(Default)]
+pub(crate) struct PolicyStats {
+    calls: AtomicU64,
+    rejections: AtomicU64,
+    total_ns: AtomicU64,
+}
+
+impl PolicyStats {
+    pub(crate) fn record(&self, elapsed: Duration, rejected: bool) {
+        self.calls.fetch_add(1, Ordering::Relaxed);
+        self.total_ns
+            .fetch_add(elapsed.as_nanos() as u64, Ordering::Relaxed);
+        if rejected {
+            self.rejections.fetch_add(1, Ordering::Relaxed);
+        }
+    }
+
+    /// Expected cost of running the policy per rejection it produces.
+    ///
+    /// Running policies by increasing rank reaches a rejection as cheaply as
+    /// possible. The rejection rate is smoothed so unseen policies still rank.
+    pub(crate) fn rank(&self) -> f64 {
+        let calls = self.calls.load(Ordering::Relaxed) as f64;
+        let rejections = self.rejections.load(Ordering::Relaxed) as f64;
+        let avg_ns = self.total_ns.load(Ordering::Relaxed) as f64 / calls.max(1.0);
+        (avg_ns + 1.0) * (calls + 2.0) / (rejections + 1.0)
+    }
+
+    pub(crate) fn snapshot(&self, name: &str) -> PolicyMetrics {
+        let calls = self.calls.load(Ordering::Relaxed);
+        PolicyMetrics {
+            name: name.to_string(),
+            calls,
+            rejections: self.rejections.load(Ordering::Relaxed),
+            avg_ns: self.total_ns.load(Ordering::Relaxed) / calls.max(1),
+        }
+    }
+}
+
+/// Per-policy view of `RiskMetrics`.
+#[derive(Debug, Clone, Serialize)]
+pub struct PolicyMetrics {
+    pub name: String,
+    pub calls: u64,
+    pub rejections: u64,
+    pub avg_ns: u64,
+}
+
+/// Latency and outcome of the risk checks run so far.
+#[derive(Debug, Clone, Serialize)]
+pub struct RiskMetrics {
+    pub latency: HistogramSnapshot,
+    /// Policies in their current evaluation order.
+    pub policies: Vec<PolicyMetrics>,
+}
@@ -2,10 +2,28 @@ use crate::model::{
     config::AllocationConfig, consolidated::ConsolidatedPortfolio, ids::MultiplexerId,
 };
 use std::collections::HashMap;
-use trading::model::{allocation::Allocation, instrument::InstrumentId, portfolio::Portfolio};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex, OnceLock};
+use std::time::Instant;
+use trading::model::{instrument::InstrumentId, portfolio::Portfolio, positions::Positions};
+use trading_core::metrics::{self as service_metrics, LatencyHistogram};
 
+pub mod exposure;
 pub mod max_allocation;
 pub mod max_position_size;
+pub mod metrics;
+mod pool;
+pub mod proposal;
+
+pub use exposure::Exposure;
+pub use metrics::RiskMetrics;
+pub use proposal::{Proposal, ProposedChange};
+
+use metrics::PolicyStats;
+use pool::PolicyPool;
+
+/// Checks between two reorderings of the policies.
+const REORDER_INTERVAL: u64 = 256;
 
 #[derive(Debug, PartialEq)]
 pub enum RiskDecision {
@@ -17,6 +35,8 @@ pub enum RiskDecision {
 pub struct RiskContext<'a> {
     pub portfolio: &'a Portfolio,
     pub prices: &'a HashMap<InstrumentId, f64>,
+    /// Exposure of the current target.
+    pub exposure: &'a Exposure,
     pub total_equity: f64,
     pub allocation_config: &'a AllocationConfig,
     pub consolidated: &'a ConsolidatedPortfolio,
@@ -25,11 +45,38 @@ pub struct RiskContext<'a> {
 
 pub trait Policy: Send + Sync {
     fn name(&self) -> &str;
-    fn check(&self, target_allocation: &Allocation, ctx: &RiskContext) -> RiskDecision;
+    fn check(&self, proposal: &Proposal, ctx: &RiskContext) -> RiskDecision;
+
+    /// Whether the policy is costly enough to be worth a thread of its own.
+    ///
+    /// Expensive policies run after the cheap ones and, if the guard is parallel,
+    /// concurrently with each other. They must not depend on each other's outcome.
+    fn is_expensive(&self) -> bool {
+        false
+    }
+}
+
+struct PolicyEntry {
+    policy: Box<dyn Policy>,
+    stats: PolicyStats,
 }
 
+/// Runs the policies of a proposal and reports their latency.
+///
+/// Cheap policies run first, one after the other, ordered by their observed cost
+/// per rejection so that a rejected proposal is usually rejected by the first
+/// policy. Expensive policies run only once the cheap ones passed.
 pub struct RiskGuard {
-    policies: Vec<Box<dyn Policy>>,
+    policies: Vec<PolicyEntry>,
+    /// Indices of the cheap and of the expensive policies, in evaluation order.
+    order: Mutex<(Vec<usize>, Vec<usize>)>,
+    parallel: bool,
+    /// Threads of the parallel checks, started by the first one.
+    pool: OnceLock<PolicyPool>,
+    /// Changes of the proposal being checked by `check_changes` (reused buffer).
+    proposal: Mutex<Vec<ProposedChange>>,
+    latency: Arc<LatencyHistogram>,
+    checks: AtomicU64,
 }
 
 impl Default for RiskGuard {
@@ -42,20 +89,269 @@ impl RiskGuard {
     pub fn new() -> Self {
         Self {
             policies: Vec::new(),
+            order: Mutex::new((Vec::new(), Vec::new())),
+            parallel: false,
+            pool: OnceLock::new(),
+            proposal: Mutex::new(Vec::new()),
+            latency: Arc::default(),
+            checks: AtomicU64::new(0),
         }
     }
 
+    /// Records the latency of the checks into the service metrics, under `name`,
+    /// so that it is served by the admin `Metrics` command.
+    pub fn with_metrics(mut self, name: &str) -> Self {
+        self.latency = service_metrics::histogram(name);
+        self
+    }
+
+    /// Runs the expensive policies of a check concurrently, on threads kept for the
+    /// lifetime of the guard.
+    ///
+    /// Only pays off when each of them takes well over the cost of a thread wakeup.
+    pub fn with_parallelism(mut self, parallel: bool) -> Self {
+        self.parallel = parallel;
+        self
+    }
+
     pub fn add_policy(&mut self, policy: Box<dyn Policy>) {
-        self.policies.push(policy);
+        let index = self.policies.len();
+        let order = self.order.get_mut().unwrap();
+        if policy.is_expensive() {
+            order.1.push(index);
+        } else {
+            order.0.push(index);
+        }
+        self.policies.push(PolicyEntry {
+            policy,
+            stats: PolicyStats::default(),
+        });
+    }
+
+    /// Checks the proposal of `changes`, built in a buffer reused across checks.
+    ///
+    /// # Arguments
+    ///
+    /// * `current` - The current target positions.
+    /// * `changes` - New quantity per changed instrument, one entry per instrument.
+    /// * `prices` - Last price per instrument.
+    /// * `exposure` - Exposure of the current target.
+    /// * `ctx` - What the policies decide against.
+    pub fn check_changes(
+        &self,
+        current: &Positions,
+        changes: &[(InstrumentId, f64)],
+        prices: &HashMap<InstrumentId, f64>,
+        exposure: &Exposure,
+        ctx: &RiskContext,
+    ) -> RiskDecision {
+        let mut buffer = self.proposal.lock().unwrap();
+        let proposal = Proposal::build(&mut buffer, current, changes, prices, exposure);
+        self.check(&proposal, ctx)
+    }
+
+    pub fn check(&self, proposal: &Proposal, ctx: &RiskContext) -> RiskDecision {
+        let started = Instant::now();
+        let decision = self.evaluate(proposal, ctx);
+        let elapsed = started.elapsed();
+        self.latency.record(elapsed);
+        log::debug!("Risk check took {:?}", elapsed);
+
+        if self.checks.fetch_add(1, Ordering::Relaxed) % REORDER_INTERVAL == REORDER_INTERVAL - 1 {
+            self.reorder();
+        }
+        decision
+    }
+
+    /// Returns the latency and outcome of the checks run so far.
+    pub fn metrics(&self) -> RiskMetrics {
+        let order = self.order.lock().unwrap();
+        RiskMetrics {
+            latency: self.latency.snapshot(),
+            policies: order
+                .0
+                .iter()
+                .chain(order.1.iter())
+                .map(|&i| {
+                    let entry = &self.policies[i];
+                    entry.stats.snapshot(entry.policy.name())
+                })
+                .collect(),
+        }
+    }
+
+    fn evaluate(&self, proposal: &Proposal, ctx: &RiskContext) -> RiskDecision {
+        let order = self.order.lock().unwrap();
+        let (cheap, expensive) = (&order.0, &order.1);
+
+        for &i in cheap {
+            let decision = self.run(i, proposal, ctx);
+            if decision != RiskDecision::Approved {
+                return decision;
+            }
+        }
+
+        if !self.parallel || expensive.len() < 2 {
+            for &i in expensive {
+                let decision = self.run(i, proposal, ctx);
+                if decision != RiskDecision::Approved {
+                    return decision;
+                }
+            }
+            return RiskDecision::Approved;
+        }
+
+        let pool = self
+            .pool
+            .get_or_init(|| PolicyPool::new(expensive.len() - 1));
+        let (first, rest) = pool.run(
+            expensive[1..]
+                .iter()
+                .map(|&i| move || self.run(i, proposal, ctx)),
+            || self.run(expensive[0], proposal, ctx),
+        );
+        // Report the first rejection in evaluation order.
+        std::iter::once(first)
+            .chain(rest.into_iter().map(|decision| {
+                decision.unwrap_or_else(|| RiskDecision::Rejected("Policy panicked".to_string()))
+            }))
+            .fold(RiskDecision::Approved, |decision, next| match decision {
+                RiskDecision::Approved => next,
+                rejected => rejected,
+            })
+    }
+
+    fn run(&self, index: usize, proposal: &Proposal, ctx: &RiskContext) -> RiskDecision {
+        let entry = &self.policies[index];
+        let started = Instant::now();
+        let decision = entry.policy.check(proposal, ctx);
+        let rejected = decision != RiskDecision::Approved;
+        entry.stats.record(started.elapsed(), rejected);
+        match decision {
+            RiskDecision::Rejected(reason) => {
+                log::warn!("Allocation rejected by {}: {}", entry.policy.name(), reason);
+                RiskDecision::Rejected(format!("{}: {}", entry.policy.name(), reason))
+            }
+            approved => approved,
+        }
+    }
+
+    fn reorder(&self) {
+        let mut order = self.order.lock().unwrap();
+        let (cheap, expensive) = &mut *order;
+        let policies = &self.policies;
+        for group in [cheap, expensive] {
+            group.sort_by(|&a, &b| {
+                policies[a]
+                    .stats
+                    .rank()
+                    .total_cmp(&policies[b].stats.rank())
+            });
+        }
     }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::collections::HashSet;
+    use std::thread::ThreadId;
 
-    pub fn check(&self, target: &Allocation, ctx: &RiskContext) -> RiskDecision {
-        for policy in &self.policies {
-            if let RiskDecision::Rejected(reason) = policy.check(target, ctx) {
-                log::warn!("Allocation rejected by {}: {}", policy.name(), reason);
-                return RiskDecision::Rejected(format!("{}: {}", policy.name(), reason));
+    struct Fixed(&'static str, bool);
+
+    impl Policy for Fixed {
+        fn name(&self) -> &str {
+            self.0
+        }
+
+        fn check(&self, _proposal: &Proposal, _ctx: &RiskContext) -> RiskDecision {
+            if self.1 {
+                RiskDecision::Rejected("no".to_string())
+            } else {
+                RiskDecision::Approved
             }
         }
-        RiskDecision::Approved
+    }
+
+    /// An expensive policy recording the threads it runs on.
+    struct Recording(Arc<Mutex<HashSet<ThreadId>>>, bool);
+
+    impl Policy for Recording {
+        fn name(&self) -> &str {
+            "recording"
+        }
+
+        fn check(&self, _proposal: &Proposal, _ctx: &RiskContext) -> RiskDecision {
+            self.0.lock().unwrap().insert(std::thread::current().id());
+            if self.1 {
+                RiskDecision::Rejected("no".to_string())
+            } else {
+                RiskDecision::Approved
+            }
+        }
+
+        fn is_expensive(&self) -> bool {
+            true
+        }
+    }
+
+    fn with_context<R>(f: impl FnOnce(&RiskContext) -> R) -> R {
+        let prices = HashMap::new();
+        let exposure = Exposure::default();
+        let portfolio = Portfolio::new();
+        let config = AllocationConfig::default();
+        let consolidated = ConsolidatedPortfolio::default();
+        let id = MultiplexerId::new("test");
+        f(&RiskContext {
+            portfolio: &portfolio,
+            prices: &prices,
+            exposure: &exposure,
+            total_equity: 0.0,
+            allocation_config: &config,
+            consolidated: &consolidated,
+            multiplexer_id: &id,
+        })
+    }
+
+    #[test]
+    fn test_parallel_checks_reuse_their_threads() {
+        let threads = Arc::new(Mutex::new(HashSet::new()));
+        let mut guard = RiskGuard::new().with_parallelism(true);
+        guard.add_policy(Box::new(Recording(threads.clone(), false)));
+        guard.add_policy(Box::new(Recording(threads.clone(), false)));
+        guard.add_policy(Box::new(Recording(threads.clone(), true)));
+
+        let positions = Positions::new();
+        with_context(|ctx| {
+            for _ in 0..32 {
+                let decision = guard.check_changes(&positions, &[], ctx.prices, ctx.exposure, ctx);
+                assert!(matches!(decision, RiskDecision::Rejected(_)));
+            }
+        });
+        // The calling thread and the two threads of the pool.
+        assert!(threads.lock().unwrap().len() <= 3);
+    }
+
+    #[test]
+    fn test_rejecting_policy_moves_first() {
+        let mut guard = RiskGuard::new();
+        guard.add_policy(Box::new(Fixed("pass", false)));
+        guard.add_policy(Box::new(Fixed("reject", true)));
+
+        let positions = Positions::new();
+        with_context(|ctx| {
+            let mut buffer = Vec::new();
+            let proposal = Proposal::build(&mut buffer, &positions, &[], ctx.prices, ctx.exposure);
+
+            for _ in 0..REORDER_INTERVAL {
+                assert!(matches!(
+                    guard.check(&proposal, ctx),
+                    RiskDecision::Rejected(_)
+                ));
+            }
+        });
+        let metrics = guard.metrics();
+        assert_eq!(metrics.latency.count, REORDER_INTERVAL);
+        assert_eq!(metrics.policies[0].name, "reject");
     }
 }
@@ -0,0 +1,124 @@
+use std::panic::{catch_unwind, AssertUnwindSafe};
+use std::sync::mpsc::{self, Receiver, Sender};
+use std::sync::{Arc, Mutex};
+use std::thread::JoinHandle;
+
+type Job = Box<dyn FnOnce() + Send + 'static>;
+
+/// Persistent threads running the expensive policies of the parallel checks.
+///
+/// Spawning threads on every check costs more than the policies it parallelises,
+/// so the threads are started once and fed borrowed jobs through `run`.
+pub(crate) struct PolicyPool {
+    jobs: Option<Sender<Job>>,
+    threads: Vec<JoinHandle<()>>,
+}
+
+impl PolicyPool {
+    /// Starts `threads` threads, named `risk-<n>`.
+    pub(crate) fn new(threads: usize) -> Self {
+        let (jobs, queue) = mpsc::channel::<Job>();
+        let queue = Arc::new(Mutex::new(queue));
+        let threads = (0..threads.max(1))
+            .map(|n| {
+                let queue = queue.clone();
+                std::thread::Builder::new()
+                    .name(format!("risk-{}", n))
+                    .spawn(move || loop {
+                        let job = queue.lock().unwrap().recv();
+                        match job {
+                            Ok(job) => job(),
+                            Err(_) => break,
+                        }
+                    })
+                    .expect("Failed to spawn a risk policy thread")
+            })
+            .collect();
+        Self {
+            jobs: Some(jobs),
+            threads,
+        }
+    }
+
+    /// Runs `tasks` on the pool and `local` on the calling thread, in parallel.
+    ///
+    /// # Returns
+    ///
+    /// The result of `local`, then the results of `tasks` in order; `None` for a
+    /// task that panicked.
+    pub(crate) fn run<'a, T, F>(
+        &self,
+        tasks: impl Iterator<Item = F>,
+        local: impl FnOnce() -> T,
+    ) -> (T, Vec<Option<T>>)
+    where
+        T: Send + 'a,
+        F: FnOnce() -> T + Send + 'a,
+    {
+        let (results, done) = mpsc::channel::<(usize, Option<T>)>();
+        // Set up first: from now on, unwinding still waits for the submitted jobs.
+        let mut pending = Pending {
+            done,
+            results: Vec::new(),
+            left: 0,
+        };
+        for (index, task) in tasks.enumerate() {
+            let results = results.clone();
+            let job: Box<dyn FnOnce() + Send + 'a> = Box::new(move || {
+                let result = catch_unwind(AssertUnwindSafe(task)).ok();
+                let _ = results.send((index, result));
+            });
+            // SAFETY: the borrows of the job outlive it, since `pending` blocks this
+            // frame until every submitted job has run, even while unwinding.
+            let job: Job = unsafe { std::mem::transmute(job) };
+            pending.results.push(None);
+            self.jobs
+                .as_ref()
+                .expect("Policy pool shut down")
+                .send(job)
+                .expect("Policy pool threads exited");
+            pending.left += 1;
+        }
+        drop(results);
+
+        let local = local();
+        pending.wait();
+        (local, std::mem::take(&mut pending.results))
+    }
+}
+
+impl Drop for PolicyPool {
+    fn drop(&mut self) {
+        // Closing the queue stops the threads once they are idle.
+        self.jobs.take();
+        for thread in self.threads.drain(..) {
+            let _ = thread.join();
+        }
+    }
+}
+
+/// The jobs of a `run` still executing.
+struct Pending<T> {
+    done: Receiver<(usize, Option<T>)>,
+    results: Vec<Option<T>>,
+    left: usize,
+}
+
+impl<T> Pending<T> {
+    fn wait(&mut self) {
+        while self.left > 0 {
+            // Every job sends exactly once, panic or not.
+            let Ok((index, result)) = self.done.recv() else {
+                break;
+            };
+            self.results[index] = result;
+            self.left -= 1;
+        }
+    }
+}
+
+impl<T> Drop for Pending<T> {
+    fn drop(&mut self) {
+        self.wait();
+    }
+}
@@ -0,0 +1,105 @@
+use super::exposure::Exposure;
+use std::collections::HashMap;
+use trading::model::{instrument::InstrumentId, positions::Positions};
+
+/// One changed instrument of a proposal.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct ProposedChange {
+    pub instrument_id: InstrumentId,
+    /// Proposed target quantity.
+    pub quantity: f64,
+    /// Proposed signed notional, `None` if the instrument has no price.
+    pub notional: Option<f64>,
+    /// Signed notional currently held.
+    pub current_notional: f64,
+}
+
+/// A proposed update of the target: new quantities for a few instruments, on top
+/// of the current target.
+///
+/// The exposure of the proposal is computed once, when it is built, and shared by
+/// every policy: policies only look at the changed instruments and at the
+/// projected totals, never at the whole book. The changes live in a buffer owned
+/// by the caller (see `RiskGuard::check_changes`), reused from check to check.
+pub struct Proposal<'a> {
+    current: &'a Positions,
+    changes: &'a [ProposedChange],
+    gross: f64,
+    net: f64,
+    unpriced: Option<InstrumentId>,
+}
+
+impl<'a> Proposal<'a> {
+    /// Creates a proposal in `buffer` and projects its exposure.
+    ///
+    /// # Arguments
+    ///
+    /// * `buffer` - Holds the changes; cleared first, its capacity is kept.
+    /// * `current` - The current target positions.
+    /// * `changes` - New quantity per changed instrument, one entry per instrument.
+    /// * `prices` - Last price per instrument.
+    /// * `exposure` - Exposure of the current target.
+    pub fn build(
+        buffer: &'a mut Vec<ProposedChange>,
+        current: &'a Positions,
+        changes: &[(InstrumentId, f64)],
+        prices: &HashMap<InstrumentId, f64>,
+        exposure: &Exposure,
+    ) -> Self {
+        let mut gross = exposure.gross();
+        let mut net = exposure.net();
+        let mut unpriced = None;
+        buffer.clear();
+        buffer.extend(changes.iter().map(|&(instrument_id, quantity)| {
+            let current_notional = exposure.notional(instrument_id);
+            let notional = prices.get(&instrument_id).map(|price| quantity * price);
+            match notional {
+                Some(notional) => {
+                    gross += notional.abs() - current_notional.abs();
+                    net += notional - current_notional;
+                }
+                None => {
+                    unpriced.get_or_insert(instrument_id);
+                }
+            }
+            ProposedChange {
+                instrument_id,
+                quantity,
+                notional,
+                current_notional,
+            }
+        }));
+        Self {
+            current,
+            changes: buffer,
+            gross,
+            net,
+            unpriced,
+        }
+    }
+
+    /// Returns the changed instruments, in instrument order.
+    pub fn changes(&self) -> &[ProposedChange] {
+        self.changes
+    }
+
+    /// Returns the current target positions the changes apply to.
+    pub fn current(&self) -> &'a Positions {
+        self.current
+    }
+
+    /// Returns the gross notional of the target once the proposal is applied.
+    pub fn gross_exposure(&self) -> f64 {
+        self.gross
+    }
+
+    /// Returns the net notional of the target once the proposal is applied.
+    pub fn net_exposure(&self) -> f64 {
+        self.net
+    }
+
+    /// Returns the first changed instrument without a price, if any.
+    pub fn unpriced(&self) -> Option<InstrumentId> {
+        self.unpriced
+    }
+}
@@ -0,0 +1,63 @@
+//! Converts a processed CSV (see `data-pipeline/src/processor.py`) into a tick file.
+//!
+//! ```text
+//! tick-convert data/processed/pair_AAPL_MSFT.csv pair.ticks -i AAPL=1 -i MSFT=2
+//! ```
+//!
+//! Parquet sources are converted to CSV first (`pandas.read_parquet(..).to_csv(..)`).
+
+use anyhow::{Context, Result};
+use clap::Parser;
+use replay_feed::convert::{convert_csv, ConvertOptions};
+use std::collections::HashMap;
+use std::fs::File;
+use std::io::BufReader;
+use std::path::PathBuf;
+use trading::model::instrument::InstrumentId;
+use trading_core::fs::TickWriter;
+
+#[derive(Parser)]
+#[command(about = "Converts a processed CSV into a memory-mapped tick file")]
+struct Args {
+    /// The CSV to convert.
+    input: PathBuf,
+    /// The tick file to write.
+    output: PathBuf,
+    /// Instrument id of a symbol, as SYMBOL=ID. Defaults to every `close_` column,
+    /// numbered from 1.
+    #[arg(short, long = "instrument", value_parser = parse_instrument)]
+    instruments: Vec<(String, InstrumentId)>,
+    /// Distance of the synthetic bid and ask from the close price.
+    #[arg(long, default_value_t = 0.01)]
+    half_spread: f64,
+}
+
+fn parse_instrument(arg: &str) -> Result<(String, InstrumentId), String> {
+    let (symbol, id) = arg.split_once('=').ok_or("Expected SYMBOL=ID")?;
+    let id = id
+        .parse::<InstrumentId>()
+        .map_err(|e| format!("Invalid instrument id '{}': {}", id, e))?;
+    Ok((symbol.to_string(), id))
+}
+
+fn main() -> Result<()> {
+    let args = Args::parse();
+    let input = File::open(&args.input)
+        .with_context(|| format!("Failed to open {}", args.input.display()))?;
+    let options = ConvertOptions {
+        instruments: args.instruments.into_iter().collect::<HashMap<_, _>>(),
+        half_spread: args.half_spread,
+    };
+
+    let mut writer = TickWriter::create(&args.output)?;
+    let rows = convert_csv(BufReader::new(input), &mut writer, &options)?;
+    let frames = writer.frames();
+    writer.finish()?;
+    println!(
+        "Converted {} rows into {} frames: {}",
+        rows,
+        frames,
+        args.output.display()
+    );
+    Ok(())
+}
@@ -0,0 +1,179 @@
+//! Conversion of the data pipeline's CSV output into tick files.
+//!
+//! `data-pipeline/src/processor.py` writes one row per timestamp with a
+//! `close_<SYMBOL>` column per instrument. Every row becomes one frame holding a
+//! price update per instrument, so a replay publishes them together.
+
+use anyhow::{bail, Context, Result};
+use chrono::{DateTime, NaiveDate, NaiveDateTime};
+use std::collections::HashMap;
+use std::io::BufRead;
+use trading::model::{
+    instrument::InstrumentId,
+    market_data::{MarketDataBatch, PriceUpdate},
+};
+use trading_core::fs::TickWriter;
+
+const CLOSE_PREFIX: &str = "close_";
+
+/// How CSV columns map to instruments.
+pub struct ConvertOptions {
+    /// Instrument id per symbol. When empty, every `close_` column is converted and
+    /// numbered from 1 in column order.
+    pub instruments: HashMap<String, InstrumentId>,
+    /// Distance of the synthetic bid and ask from the close price.
+    pub half_spread: f64,
+}
+
+/// Converts a processed CSV into frames of `writer`.
+///
+/// # Arguments
+///
+/// * `input` - The CSV, with a header row and a `timestamp` column.
+/// * `writer` - The tick file being written.
+/// * `options` - The instruments to keep.
+///
+/// # Returns
+///
+/// * `Ok(rows)` - The number of CSV rows converted.
+/// * `Err` if a column is missing or a cell does not parse.
+pub fn convert_csv(
+    input: impl BufRead,
+    writer: &mut TickWriter,
+    options: &ConvertOptions,
+) -> Result<usize> {
+    let mut lines = input.lines();
+    let header = lines.next().context("CSV is empty")??;
+    let (timestamp_column, columns) = parse_header(&header, &options.instruments)?;
+
+    let mut batch = MarketDataBatch::new(Vec::with_capacity(columns.len()));
+    let mut rows = 0;
+    for (line_number, line) in lines.enumerate() {
+        let line = line?;
+        if line.trim().is_empty() {
+            continue;
+        }
+        let cells: Vec<&str> = line.split(',').map(str::trim).collect();
+        let row = || format!("CSV row {}", line_number + 2);
+        let timestamp = cells
+            .get(timestamp_column)
+            .with_context(|| format!("{} has no timestamp", row()))
+            .and_then(|cell| parse_timestamp(cell).with_context(row))?;
+
+        batch.clear();
+        for &(column, instrument_id) in &columns {
+            let cell = cells.get(column).copied().unwrap_or("");
+            if cell.is_empty() {
+                continue;
+            }
+            let close = cell
+                .parse::<f64>()
+                .with_context(|| format!("{}: bad price '{}'", row(), cell))?;
+            if close.is_nan() {
+                continue;
+            }
+            batch.add_update(PriceUpdate::new(
+                instrument_id,
+                close - options.half_spread,
+                close + options.half_spread,
+                close,
+                timestamp,
+            ));
+        }
+        if batch.get_count() > 0 {
+            writer.append(&batch)?;
+        }
+        rows += 1;
+    }
+    Ok(rows)
+}
+
+/// Locates the timestamp column and the price column of every instrument.
+fn parse_header(
+    header: &str,
+    instruments: &HashMap<String, InstrumentId>,
+) -> Result<(usize, Vec<(usize, InstrumentId)>)> {
+    let names: Vec<&str> = header.split(',').map(str::trim).collect();
+    let timestamp = names
+        .iter()
+        .position(|&name| name == "timestamp")
+        .context("CSV has no 'timestamp' column")?;
+
+    let mut columns = Vec::new();
+    for (column, name) in names.iter().enumerate() {
+        let Some(symbol) = name.strip_prefix(CLOSE_PREFIX) else {
+            continue;
+        };
+        if instruments.is_empty() {
+            columns.push((column, columns.len() + 1));
+        } else if let Some(&id) = instruments.get(symbol) {
+            columns.push((column, id));
+        }
+    }
+    for symbol in instruments.keys() {
+        if !names.contains(&format!("{}{}", CLOSE_PREFIX, symbol).as_str()) {
+            bail!("CSV has no '{}{}' column", CLOSE_PREFIX, symbol);
+        }
+    }
+    if columns.is_empty() {
+        bail!("CSV has no '{}<SYMBOL>' column", CLOSE_PREFIX);
+    }
+    Ok((timestamp, columns))
+}
+
+/// Parses a pandas-style timestamp (or Unix seconds) into Unix nanoseconds.
+///
+/// Timestamps without an offset are taken as UTC.
+fn parse_timestamp(cell: &str) -> Result<u64> {
+    let nanos = if let Ok(seconds) = cell.parse::<i64>() {
+        seconds.checked_mul(1_000_000_000)
+    } else if let Ok(time) = DateTime::parse_from_rfc3339(cell)
+        .or_else(|_| DateTime::parse_from_str(cell, "%Y-%m-%d %H:%M:%S%.f%:z"))
+    {
+        time.timestamp_nanos_opt()
+    } else if let Ok(time) = NaiveDateTime::parse_from_str(cell, "%Y-%m-%d %H:%M:%S%.f") {
+        time.and_utc().timestamp_nanos_opt()
+    } else if let Ok(date) = NaiveDate::parse_from_str(cell, "%Y-%m-%d") {
+        date.and_hms_opt(0, 0, 0)
+            .and_then(|time| time.and_utc().timestamp_nanos_opt())
+    } else {
+        bail!("Unrecognized timestamp '{}'", cell)
+    };
+    match nanos {
+        Some(nanos) if nanos >= 0 => Ok(nanos as u64),
+        _ => bail!("Timestamp '{}' is out of range", cell),
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use trading_core::fs::TickStore;
+
+    #[test]
+    fn test_processor_csv_becomes_one_frame_per_row() {
+        let csv = "timestamp,close_AAPL,close_MSFT,z_score\n\
+                   2024-01-02 14:30:00+00:00,185.5,370.0,0.5\n\
+                   2024-01-02 14:31:00+00:00,186.0,,1.2\n";
+        let path = std::env::temp_dir().join(format!("convert_{}.ticks", std::process::id()));
+        let mut writer = TickWriter::create(&path).unwrap();
+        let options = ConvertOptions {
+            instruments: HashMap::from([("MSFT".to_string(), 7)]),
+            half_spread: 0.01,
+        };
+        // Only mapped symbols are kept; the second row has no MSFT price.
+        assert_eq!(
+            convert_csv(csv.as_bytes(), &mut writer, &options).unwrap(),
+            2
+        );
+        writer.finish().unwrap();
+
+        let store = TickStore::open(&path).unwrap();
+        assert_eq!(store.len(), 1);
+        let frame = store.get(0).unwrap();
+        assert_eq!(frame.get_instrument_ids(), &[7]);
+        assert!((frame.get_bid_prices()[0] - 369.99).abs() < 1e-9);
+        assert_eq!(frame.get_timestamps(), &[1_704_205_800_000_000_000]);
+        std::fs::remove_file(&path).unwrap();
+    }
+}
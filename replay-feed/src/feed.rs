@@ -0,0 +1,137 @@
+//! A `DataFeed` replaying a tick file.
+
+use anyhow::Result;
+use log::info;
+use serde::Deserialize;
+use std::path::PathBuf;
+use std::sync::Arc;
+use std::time::Duration;
+use trading::model::market_data::MarketDataBatch;
+use trading::traits::data_feed::{DataFeed, Pacing};
+use trading_core::fs::TickStore;
+
+/// Rows coalesced into one batch when replaying at maximum speed.
+const DEFAULT_MAX_BATCH_ROWS: usize = 4096;
+
+/// How fast a tick file is replayed.
+#[derive(Debug, Clone, Copy, PartialEq, Default, Deserialize)]
+#[serde(rename_all = "snake_case")]
+pub enum ReplaySpeed {
+    /// Replay the recorded gaps as they happened.
+    #[default]
+    WallClock,
+    /// Replay the recorded gaps sped up by a factor (`2.0` is twice as fast).
+    Scaled(f64),
+    /// Publish as fast as the pipeline accepts, for backtests.
+    Max,
+}
+
+impl ReplaySpeed {
+    /// Returns the feeder pacing for this speed. Tick timestamps are Unix nanos.
+    ///
+    /// # Returns
+    ///
+    /// * `Ok(Pacing)` for a valid speed.
+    /// * `Err` if a scaled speed is not a finite, positive factor.
+    pub fn pacing(self) -> Result<Pacing> {
+        let tick = Duration::from_nanos(1);
+        match self {
+            ReplaySpeed::WallClock => Pacing::replay_clock(tick, 1.0),
+            ReplaySpeed::Scaled(speed) => Pacing::replay_clock(tick, speed),
+            ReplaySpeed::Max => Ok(Pacing::AsFastAsPossible),
+        }
+    }
+}
+
+/// Settings of the replay feed, read from `replay.json` in the config directory.
+#[derive(Debug, Clone, Deserialize)]
+pub struct ReplayConfig {
+    /// The tick file to replay.
+    pub tick_file: PathBuf,
+    #[serde(default)]
+    pub speed: ReplaySpeed,
+    /// Maximum rows per published batch at `Max` speed.
+    #[serde(default = "default_max_batch_rows")]
+    pub max_batch_rows: usize,
+}
+
+fn default_max_batch_rows() -> usize {
+    DEFAULT_MAX_BATCH_ROWS
+}
+
+/// Replays the frames of a tick file in order.
+///
+/// Paced replays publish one frame per batch so that every frame goes out at its
+/// own timestamp. At `Max` speed consecutive frames are coalesced into batches of
+/// up to `max_batch_rows` rows, which keeps the per-message cost off the hot path.
+///
+/// The store is shared: any number of feeds (e.g. the runs of a parameter sweep)
+/// replay the same mapping, each with its own cursor.
+pub struct TickReplayFeed {
+    store: Arc<TickStore>,
+    next: usize,
+    speed: ReplaySpeed,
+    pacing: Pacing,
+    max_batch_rows: usize,
+}
+
+impl TickReplayFeed {
+    /// Creates a feed starting at the first frame.
+    ///
+    /// # Arguments
+    ///
+    /// * `store` - The tick file to replay, possibly shared with other feeds.
+    /// * `speed` - The replay speed.
+    /// * `max_batch_rows` - Row budget of a coalesced batch at `Max` speed.
+    ///
+    /// # Returns
+    ///
+    /// * `Ok(TickReplayFeed)` ready to replay.
+    /// * `Err` if `speed` is invalid.
+    pub fn new(store: Arc<TickStore>, speed: ReplaySpeed, max_batch_rows: usize) -> Result<Self> {
+        Ok(Self {
+            store,
+            next: 0,
+            speed,
+            pacing: speed.pacing()?,
+            max_batch_rows: max_batch_rows.max(1),
+        })
+    }
+
+    /// Returns whether every frame has been published.
+    pub fn is_finished(&self) -> bool {
+        self.next >= self.store.len()
+    }
+
+    fn next_frame(&mut self, batch: &mut MarketDataBatch) -> bool {
+        if self.is_finished() {
+            return false;
+        }
+        match self.store.get(self.next) {
+            Ok(frame) => batch.extend_from_view(&frame),
+            Err(e) => log::warn!("Skipping tick frame {}: {}", self.next, e),
+        }
+        self.next += 1;
+        if self.is_finished() {
+            info!("Replay finished after {} frames", self.store.len());
+        }
+        true
+    }
+}
+
+impl DataFeed for TickReplayFeed {
+    fn get_market_data(&mut self) -> Option<MarketDataBatch> {
+        let mut batch = MarketDataBatch::new(Vec::new());
+        if !self.next_frame(&mut batch) {
+            return None;
+        }
+        if self.speed == ReplaySpeed::Max {
+            while batch.get_count() < self.max_batch_rows && self.next_frame(&mut batch) {}
+        }
+        Some(batch)
+    }
+
+    fn pacing(&self) -> Pacing {
+        self.pacing
+    }
+}
@@ -0,0 +1,7 @@
+//! Historical market data replay.
+//!
+//! - `convert`: turns the data pipeline's CSV output into memory-mapped tick files.
+//! - `feed`: a `DataFeed` replaying a tick file at wall-clock, scaled or maximum speed.
+
+pub mod convert;
+pub mod feed;
@@ -0,0 +1,57 @@
+//! A `DataFeed` microservice replaying a memory-mapped tick file.
+//!
+//! The feed reads `replay.json` from its config directory:
+//!
+//! ```json
+//! { "tick_file": "/data/pair_AAPL_MSFT.ticks", "speed": { "scaled": 100.0 } }
+//! ```
+//!
+//! `speed` is `"wall_clock"` (default), `{ "scaled": <factor> }` or `"max"`.
+//! Tick files are produced by the `tick-convert` binary.
+
+use anyhow::Result;
+use replay_feed::feed::{ReplayConfig, TickReplayFeed};
+use std::path::Path;
+use std::sync::Arc;
+use trading::traits::data_feed::DataFeed;
+use trading_core::fs::{PathManager, TickStore};
+use trading_core::microservice::configuration::feeder::Feeder;
+use trading_core::microservice::configuration::Configuration;
+use trading_core::microservice::Microservice;
+
+const CONFIG_FILE: &str = "replay.json";
+
+#[tokio::main]
+async fn main() -> Result<()> {
+    env_logger::init();
+
+    let initial_state = |args: &_| -> Box<dyn DataFeed + Send> {
+        let paths = PathManager::from_args(args);
+        let config: ReplayConfig = paths
+            .load_config(Path::new(CONFIG_FILE))
+            .unwrap_or_else(|e| panic!("Failed to load {}: {}", CONFIG_FILE, e));
+        let store = TickStore::open(&config.tick_file)
+            .unwrap_or_else(|e| panic!("Failed to open tick file: {:#}", e));
+        log::info!(
+            "Replaying {} frames from {} ({:?})",
+            store.len(),
+            config.tick_file.display(),
+            config.speed
+        );
+        let feed = TickReplayFeed::new(Arc::new(store), config.speed, config.max_batch_rows)
+            .unwrap_or_else(|e| panic!("Invalid {}: {:#}", CONFIG_FILE, e));
+        Box::new(feed)
+    };
+
+    let config = Configuration::new(Feeder::new());
+
+    let service = Microservice::new(
+        initial_state,
+        config,
+        env!("CARGO_PKG_VERSION").to_string(),
+        env!("CARGO_PKG_DESCRIPTION").to_string(),
+    );
+    service.run().await;
+
+    Ok(())
+}
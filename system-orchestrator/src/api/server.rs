@@ -1,21 +1,37 @@
 use crate::event_bus::{EventBus, SystemEvent};
+use crate::runtime::ServiceProvider;
+use crate::supervisor::DeployMetrics;
 use anyhow::Result;
-use log::{error, info};
+use log::{error, info, warn};
 use orchestrator_protocol::messages::{OrchestratorCommand, OrchestratorResponse};
+use orchestrator_protocol::model::ServiceMetrics;
+use std::sync::Arc;
+use trading_core::admin::command::{AdminCommand, AdminResponse};
 use trading_core::comms::transport::TransportDuplex;
 use trading_core::comms::transports::zmq::ZmqDuplex;
 
 pub struct ApiServer {
     transport: ZmqDuplex,
     event_bus: EventBus,
+    /// Used to query the running services directly (e.g. for metrics).
+    runtime: Arc<dyn ServiceProvider>,
+    /// Deploy and recovery times, recorded by the Supervisor.
+    supervisor_metrics: Arc<DeployMetrics>,
 }
 
 impl ApiServer {
-    pub fn new(bind_address: &str, event_bus: EventBus) -> Result<Self> {
+    pub fn new(
+        bind_address: &str,
+        event_bus: EventBus,
+        runtime: Arc<dyn ServiceProvider>,
+        supervisor_metrics: Arc<DeployMetrics>,
+    ) -> Result<Self> {
         let transport = ZmqDuplex::new(bind_address)?;
         Ok(Self {
             transport,
             event_bus,
+            runtime,
+            supervisor_metrics,
         })
     }
 
@@ -26,7 +42,7 @@ impl ApiServer {
                 Ok(bytes) => {
                     match bincode::deserialize::<OrchestratorCommand>(&bytes) {
                         Ok(cmd) => {
-                            let response = self.handle_command(cmd);
+                            let response = self.handle_command(cmd).await;
                             if let Err(e) = self.send_response(response).await {
                                 error!("API Server: Failed to send response: {}", e);
                             }
@@ -51,7 +67,7 @@ impl ApiServer {
         }
     }
 
-    fn handle_command(&mut self, cmd: OrchestratorCommand) -> OrchestratorResponse {
+    async fn handle_command(&mut self, cmd: OrchestratorCommand) -> OrchestratorResponse {
         info!("API Server: Received Command: {:?}", cmd);
 
         match cmd {
@@ -79,12 +95,36 @@ impl ApiServer {
             OrchestratorCommand::GetServices => {
                 OrchestratorResponse::Error("GetServices not yet implemented".into())
             }
+            OrchestratorCommand::GetMetrics => match collect_metrics(self.runtime.as_ref()).await {
+                Ok(metrics) => OrchestratorResponse::Metrics(metrics),
+                Err(e) => OrchestratorResponse::Error(format!("GetMetrics failed: {}", e)),
+            },
+            OrchestratorCommand::GetSupervisorMetrics => {
+                OrchestratorResponse::SupervisorMetrics(self.supervisor_metrics.snapshot())
+            }
         }
     }
 
-    async fn send_response(&self, resp: OrchestratorResponse) -> Result<()> {
+    async fn send_response(&mut self, resp: OrchestratorResponse) -> Result<()> {
         let bytes = bincode::serialize(&resp)?;
         self.transport.send_bytes(&bytes).await?;
         Ok(())
     }
 }
+
+/// Queries the metrics of every running service.
+/// Services that do not answer are logged and left out, so one stuck service
+/// does not hide the others.
+async fn collect_metrics(runtime: &dyn ServiceProvider) -> Result<Vec<ServiceMetrics>> {
+    let mut ids = runtime.list().await?;
+    ids.sort();
+    let mut collected = Vec::with_capacity(ids.len());
+    for id in ids {
+        match runtime.admin(&id, AdminCommand::Metrics).await {
+            Ok(AdminResponse::Metrics(metrics)) => collected.push(ServiceMetrics { id, metrics }),
+            Ok(other) => warn!("API Server: '{}' answered Metrics with {:?}", id, other),
+            Err(e) => warn!("API Server: Failed to query metrics of '{}': {}", id, e),
+        }
+    }
+    Ok(collected)
+}
@@ -38,7 +38,7 @@ pub enum SystemEvent {
     /// **API**: Use this when a User asks to deploy a layout.
     DeployRequested { layout: Layout },
 
-    /// **Supervisor**: Use this when a PID exits unexpectedly.
+    /// **Runtime**: Use this when a PID exits unexpectedly.
     ServiceCrashed {
         id: String, // e.g., "strategy-alpha"
         exit_code: Option<i32>,
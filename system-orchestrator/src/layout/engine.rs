@@ -1,9 +1,9 @@
 use crate::layout::model::{DeploymentPlan, ServiceConfig};
 use crate::registry::ServiceCatalog;
 use anyhow::{Context, Result};
-use orchestrator_protocol::model::{Layout, Node, ServiceDescriptor};
+use orchestrator_protocol::model::{EdgeTransport, Layout, Node, ServiceDescriptor};
 use std::collections::{HashMap, HashSet};
-use trading_core::manifest::{Binding, ServiceBindings, Source};
+use trading_core::manifest::{Binding, ServiceBindings, Source, Subscribers};
 
 /// The Pure Logic Core.
 pub struct LayoutEngine;
@@ -65,11 +65,75 @@ impl LayoutEngine {
             .map(|((node, port), addr)| (format!("{}:{}", node, port), addr.clone()))
             .collect();
 
-        Ok(DeploymentPlan::new(
-            layout.id().to_string(),
-            services,
-            allocation_map,
-        ))
+        Ok(
+            DeploymentPlan::new(layout.id().to_string(), services, allocation_map)
+                .with_waves(Self::waves(layout)),
+        )
+    }
+
+    /// Orders the nodes of a layout into start waves (Kahn's algorithm).
+    ///
+    /// A node is placed in the wave after the last of its upstream nodes, so
+    /// publishers (which create shared-memory rings and bind ports) are up before
+    /// their subscribers, while independent nodes share a wave. Nodes on a cycle
+    /// cannot be ordered; they are started together in a last wave.
+    ///
+    /// # Returns
+    ///
+    /// The node IDs of every wave, sorted for determinism.
+    pub fn waves(layout: &Layout) -> Vec<Vec<String>> {
+        let mut upstream: HashMap<&str, usize> =
+            layout.nodes().iter().map(|node| (node.id(), 0)).collect();
+        let mut downstream: HashMap<&str, Vec<&str>> = HashMap::new();
+        let mut seen = HashSet::new();
+        for edge in layout.edges() {
+            let (source, target) = (edge.source(), edge.target());
+            // Several ports may link the same two nodes; count the dependency once.
+            if source == target || !upstream.contains_key(source) || !seen.insert((source, target))
+            {
+                continue;
+            }
+            if let Some(count) = upstream.get_mut(target) {
+                *count += 1;
+                downstream.entry(source).or_default().push(target);
+            }
+        }
+
+        let mut waves = Vec::new();
+        let mut ready: Vec<&str> = upstream
+            .iter()
+            .filter(|(_, count)| **count == 0)
+            .map(|(id, _)| *id)
+            .collect();
+        while !ready.is_empty() {
+            ready.sort_unstable();
+            let mut next = Vec::new();
+            for id in &ready {
+                upstream.remove(id);
+                for target in downstream.get(id).into_iter().flatten() {
+                    if let Some(count) = upstream.get_mut(target) {
+                        *count -= 1;
+                        if *count == 0 {
+                            next.push(*target);
+                        }
+                    }
+                }
+            }
+            waves.push(ready.iter().map(|id| id.to_string()).collect());
+            ready = next;
+        }
+
+        if !upstream.is_empty() {
+            let mut cycle: Vec<String> = upstream.keys().map(|id| id.to_string()).collect();
+            cycle.sort();
+            log::warn!(
+                "Layout '{}' has a cycle through {:?}; starting them together",
+                layout.id(),
+                cycle
+            );
+            waves.push(cycle);
+        }
+        waves
     }
 
     /// Calculates the difference between two plans to minimize downtime.
@@ -126,6 +190,8 @@ impl LayoutEngine {
         old.binary_path() == new.binary_path()
             && old.service_type() == new.service_type()
             && old.env() == new.env()
+            // Thread placement is applied at startup only.
+            && old.placement() == new.placement()
         // Note: Args usually contain ports. If args changed, typically we need restart unless logic parses args.
         // The user said: "You can ask them to change the port... though not the ones they write to".
         // This implies we have a `UpdateAddress` command.
@@ -149,6 +215,8 @@ impl LayoutEngine {
     /// - Looks up their Descriptor.
     /// - allocates an address for EVERY output port defined.
     /// - Reuses address if found in `prev_allocations`.
+    /// - Outputs feeding at least one `EdgeTransport::Shm` edge get a shared-memory ring;
+    ///   all their subscribers then read from that ring.
     fn allocate_addresses(
         layout: &Layout,
         catalog: &ServiceCatalog,
@@ -174,10 +242,21 @@ impl LayoutEngine {
         required_outputs.sort();
         required_outputs.dedup();
 
+        let shm_outputs: HashSet<(&str, &str)> = layout
+            .edges()
+            .iter()
+            .filter(|edge| edge.transport() == EdgeTransport::Shm)
+            .map(|edge| (edge.source(), edge.source_port()))
+            .collect();
+
         // 2. Allocate
         for (node_id, port_name) in required_outputs {
             let composite_key = format!("{}:{}", node_id, port_name);
-            let address = if let Some(prev) = prev_allocations.and_then(|m| m.get(&composite_key)) {
+            let wants_shm = shm_outputs.contains(&(node_id.as_str(), port_name.as_str()));
+            let prev = prev_allocations
+                .and_then(|m| m.get(&composite_key))
+                .filter(|prev| prev.starts_with("shm:") == wants_shm);
+            let address = if let Some(prev) = prev {
                 // Reuse existing
                 // We MUST ensure `current` skips this if it was generated sequentially?
                 // Actually, if we reuse, we risk collision if we reset `current`.
@@ -186,6 +265,8 @@ impl LayoutEngine {
                 // But for now, let's assume `base_port` is stable.
                 // If `prev` exists, we use it.
                 prev.clone()
+            } else if wants_shm {
+                format!("shm:{}.{}.{}", layout.id(), node_id, port_name)
             } else {
                 // Allocate new
                 // Simplification for MVP: We just increment.
@@ -242,6 +323,23 @@ impl LayoutEngine {
         addresses
     }
 
+    /// Returns how the consumers of a market data output subscribe: to whole batches
+    /// if one of them has no universe, to partitions if one of them has.
+    fn market_data_subscribers(node: &Node, port: &str, layout: &Layout) -> Subscribers {
+        let mut subscribers = Subscribers::default();
+        for edge in layout
+            .edges()
+            .iter()
+            .filter(|e| e.source() == node.id() && e.source_port() == port)
+        {
+            match layout.nodes().iter().find(|n| n.id() == edge.target()) {
+                Some(consumer) if !consumer.universe().is_empty() => subscribers.partitioned = true,
+                _ => subscribers.whole = true,
+            }
+        }
+        subscribers
+    }
+
     fn resolve_node_config(
         node: &Node,
         layout: &Layout,
@@ -273,9 +371,17 @@ impl LayoutEngine {
                     edge.source().hash(&mut hasher);
                     let source_id = hasher.finish() as usize;
 
+                    // Market data inputs only receive the node's instruments.
+                    let universe = if port.data_type == "MarketDataBatch" {
+                        node.universe().to_vec()
+                    } else {
+                        Vec::new()
+                    };
                     let binding = Binding::Single(Source {
                         address: trading_core::comms::Address::from_str(addr).unwrap(),
                         id: source_id,
+                        universe,
+                        subscribers: None,
                     });
 
                     bindings.inputs.insert(port.name.clone(), binding);
@@ -306,9 +412,13 @@ impl LayoutEngine {
                 node.id().hash(&mut hasher);
                 let my_id = hasher.finish() as usize;
 
+                let subscribers = (port.data_type == "MarketDataBatch")
+                    .then(|| Self::market_data_subscribers(node, &port.name, layout));
                 let binding = Binding::Single(Source {
                     address: trading_core::comms::Address::from_str(addr).unwrap(),
                     id: my_id,
+                    universe: Vec::new(),
+                    subscribers,
                 });
                 bindings.outputs.insert(port.name.clone(), binding);
             }
@@ -320,6 +430,8 @@ impl LayoutEngine {
             let binding = Binding::Single(Source {
                 address: trading_core::comms::Address::from_str(admin_addr).unwrap(),
                 id: 0, // Admin doesn't track source IDs
+                universe: Vec::new(),
+                subscribers: None,
             });
             bindings.inputs.insert("admin".to_string(), binding);
         }
@@ -366,7 +478,8 @@ impl LayoutEngine {
             args,
             HashMap::new(),
             admin_addresses.get(node.id()).cloned(),
-        ))
+        )
+        .with_placement(node.placement().clone()))
     }
 }
 
@@ -475,8 +588,63 @@ mod tests {
         match output {
             Binding::Single(src) => {
                 assert_eq!(src.address.to_string(), "zmq:tcp://127.0.0.1:6001");
+                assert_eq!(src.subscribers, None);
             }
             _ => panic!("Expected Single binding"),
         }
+
+        // The feeder only publishes the forms its consumers subscribe to.
+        let feeder = Node::new(
+            "feeder_1".to_string(),
+            "Feeder".to_string(),
+            "Feeder".to_string(),
+            "Stopped".to_string(),
+        );
+        let whole = LayoutEngine::market_data_subscribers(&feeder, "ticks", &layout);
+        assert!(whole.whole && !whole.partitioned);
+        layout.add_node(node.with_universe(vec![1, 2]));
+        let partitioned = LayoutEngine::market_data_subscribers(&feeder, "ticks", &layout);
+        assert!(!partitioned.whole && partitioned.partitioned);
+    }
+
+    #[test]
+    fn test_waves_follow_edges() {
+        let mut layout = Layout::new("waves");
+        for id in ["gateway", "strategy", "risk", "portfolio", "a", "b"] {
+            layout.add_node(Node::new(
+                id.to_string(),
+                id.to_string(),
+                "Service".to_string(),
+                "Stopped".to_string(),
+            ));
+        }
+        let edges = [
+            ("gateway", "strategy"),
+            ("gateway", "risk"),
+            ("strategy", "portfolio"),
+            ("risk", "portfolio"),
+            ("gateway", "portfolio"),
+            ("a", "b"),
+            ("b", "a"),
+        ];
+        for (i, (source, target)) in edges.into_iter().enumerate() {
+            layout.add_edge(orchestrator_protocol::model::Edge::new(
+                format!("e{}", i),
+                source.to_string(),
+                "out".to_string(),
+                target.to_string(),
+                "in".to_string(),
+            ));
+        }
+
+        assert_eq!(
+            LayoutEngine::waves(&layout),
+            vec![
+                vec!["gateway".to_string()],
+                vec!["risk".to_string(), "strategy".to_string()],
+                vec!["portfolio".to_string()],
+                vec!["a".to_string(), "b".to_string()],
+            ]
+        );
     }
 }
@@ -1,5 +1,6 @@
 use serde::{Deserialize, Serialize};
 use std::collections::HashMap;
+use trading_core::framework::Placement;
 
 // --- Deployment Model (The "Output" of the Layout Engine) ---
 // This is internal to the Orchestrator.
@@ -11,6 +12,10 @@ pub struct DeploymentPlan {
     // Maps "NodeId:PortName" -> "Address"
     // We use a composite string key for JSON compatibility.
     allocations: HashMap<String, String>,
+    /// Node IDs in start order: a node comes after every node feeding it, and the
+    /// nodes of one wave may be started concurrently.
+    #[serde(default)]
+    waves: Vec<Vec<String>>,
 }
 
 impl DeploymentPlan {
@@ -23,9 +28,16 @@ impl DeploymentPlan {
             layout_id,
             services,
             allocations,
+            waves: Vec::new(),
         }
     }
 
+    /// Sets the start order of the services (see `LayoutEngine::waves`).
+    pub fn with_waves(mut self, waves: Vec<Vec<String>>) -> Self {
+        self.waves = waves;
+        self
+    }
+
     pub fn layout_id(&self) -> &str {
         &self.layout_id
     }
@@ -37,6 +49,17 @@ impl DeploymentPlan {
     pub fn allocations(&self) -> &HashMap<String, String> {
         &self.allocations
     }
+
+    /// Returns the start order of the services.
+    /// A plan without one (e.g. saved by an older version) starts all at once.
+    pub fn waves(&self) -> Vec<Vec<String>> {
+        if self.waves.is_empty() {
+            let mut ids: Vec<String> = self.services.keys().cloned().collect();
+            ids.sort();
+            return vec![ids];
+        }
+        self.waves.clone()
+    }
 }
 
 #[derive(Serialize, Deserialize, Debug, Clone, PartialEq)]
@@ -47,6 +70,9 @@ pub struct ServiceConfig {
     args: Vec<String>,
     env: HashMap<String, String>,
     admin_api: Option<String>,
+    /// CPU placement hints, handed to the process by the runtime that spawns it.
+    #[serde(default)]
+    placement: Placement,
 }
 
 impl ServiceConfig {
@@ -66,9 +92,16 @@ impl ServiceConfig {
             args,
             env,
             admin_api,
+            placement: Placement::default(),
         }
     }
 
+    /// Sets the CPU placement hints of the service.
+    pub fn with_placement(mut self, placement: Placement) -> Self {
+        self.placement = placement;
+        self
+    }
+
     pub fn node_id(&self) -> &str {
         &self.node_id
     }
@@ -92,4 +125,8 @@ impl ServiceConfig {
     pub fn admin_api(&self) -> Option<&String> {
         self.admin_api.as_ref()
     }
+
+    pub fn placement(&self) -> &Placement {
+        &self.placement
+    }
 }
@@ -55,7 +55,7 @@ async fn main() -> Result<()> {
 
     // 4. Initialize Runtime (The Hand)
     // We use the LocalServiceProvider for this node.
-    let runtime = std::sync::Arc::new(crate::runtime::LocalServiceProvider::new());
+    let runtime = std::sync::Arc::new(crate::runtime::LocalServiceProvider::new(event_bus.clone()));
 
     // 5. Initialize Registry (The Eyes)
     let disk_watcher = crate::registry::DiskWatcher::new(
@@ -73,7 +73,8 @@ async fn main() -> Result<()> {
     });
 
     // 6. Initialize Supervisor (The Brain)
-    let supervisor = crate::supervisor::Supervisor::new(event_bus.clone(), runtime);
+    let supervisor = crate::supervisor::Supervisor::new(event_bus.clone(), runtime.clone());
+    let supervisor_metrics = supervisor.metrics();
 
     // 7. Start the Supervisor (The Brain)
     // We spawn it in a background task
@@ -88,7 +89,12 @@ async fn main() -> Result<()> {
     // 8. Initialize API Server (The Mouth/Ears)
     // Listens on 0.0.0.0:5555
     // TODO: Make port configurable via args
-    let mut api_server = crate::api::ApiServer::new("tcp://0.0.0.0:5555", event_bus.clone())?;
+    let mut api_server = crate::api::ApiServer::new(
+        "tcp://0.0.0.0:5555",
+        event_bus.clone(),
+        runtime,
+        supervisor_metrics,
+    )?;
 
     info!("Starting API Server on tcp://0.0.0.0:5555 ...");
     tokio::spawn(async move {
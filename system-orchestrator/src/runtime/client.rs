@@ -3,6 +3,7 @@ use trading_core::admin::command::{AdminCommand, AdminPayload, AdminResponse};
 // Explicit full path import
 use trading_core::comms::transport::TransportDuplex;
 use trading_core::comms::transports::zmq::ZmqClientDuplex;
+use trading_core::comms::Packet;
 
 /// Helper to talk to a running microservice via its Admin Port.
 /// This is the "Voice" of the Orchestrator.
@@ -20,10 +21,11 @@ impl AdminClient {
 
     /// Sends a command and expects a response.
     pub async fn send_command(&mut self, cmd: AdminCommand) -> Result<AdminResponse> {
-        let payload = AdminPayload::new_command(cmd);
+        // Services frame admin messages as packets, like every other channel (id 0 for admin)
+        let packet = Packet::new(0, AdminPayload::new_command(cmd));
 
         // Manual Serialization (bincode)
-        let bytes = bincode::serialize(&payload).context("Failed to serialize AdminPayload")?;
+        let bytes = bincode::serialize(&packet).context("Failed to serialize AdminPayload")?;
 
         // Use TransportDuplex trait methods
         self.transport
@@ -35,10 +37,10 @@ impl AdminClient {
         let response_result: anyhow::Result<Vec<u8>> = self.transport.recv_bytes().await;
         let response_bytes = response_result.context("Failed to receive admin response")?;
 
-        let response: AdminPayload =
-            bincode::deserialize(&response_bytes).context("Failed to deserialize AdminPayload")?;
+        let response = Packet::<AdminPayload>::decode(&response_bytes)
+            .context("Failed to deserialize AdminPayload")?;
 
-        match response {
+        match response.data() {
             AdminPayload::Response(r) => Ok(r),
             AdminPayload::Command(_) => {
                 anyhow::bail!("Received Command on Client port, expected Response")
@@ -1,40 +1,117 @@
+use crate::event_bus::{EventBus, SystemEvent};
 use crate::layout::model::ServiceConfig;
 use crate::runtime::client::AdminClient;
 use crate::runtime::traits::{HealthStatus, ServiceProvider};
-use anyhow::{Context, Result};
+use anyhow::{bail, Context, Result};
 use async_trait::async_trait;
 use libc;
 use log::{info, warn};
 use std::collections::HashMap;
-use std::process::{Command, Stdio};
+use std::process::{Child, Command, ExitStatus, Stdio};
 use std::sync::{Arc, Mutex};
 use std::time::Duration;
-use trading_core::admin::command::AdminCommand; // Explicit import to be safe
+use tokio::sync::Notify;
+use trading_core::admin::command::{AdminCommand, AdminResponse}; // Explicit import to be safe
+
+/// Time a service is given to exit after the admin `Shutdown`, before it is killed.
+const GRACEFUL_SHUTDOWN: Duration = Duration::from_millis(500);
 
 /// Manages processes on the local machine using `std::process`.
+///
+/// Every child is reaped by a watcher thread, which publishes `ServiceCrashed` when
+/// it exits without being stopped, so the Supervisor restarts it right away. The
+/// watcher records the exit and reaps the child under the process map lock, so a
+/// PID found in the map without an exit still belongs to the child and can be
+/// signalled.
 pub struct LocalServiceProvider {
     /// Map NodeId -> ProcessMetadata
     processes: Arc<Mutex<HashMap<String, ProcessMetadata>>>,
+    event_bus: EventBus,
 }
 
 struct ProcessMetadata {
     pid: u32,
     admin_addr: Option<String>,
+    /// Set by the watcher once the process exited.
+    exit: Option<ExitStatus>,
+    /// Set by `stop`: the exit is expected, not a crash.
+    stopping: bool,
+    /// Notified by the watcher once `exit` is set.
+    exited: Arc<Notify>,
 }
 
 impl LocalServiceProvider {
-    pub fn new() -> Self {
+    pub fn new(event_bus: EventBus) -> Self {
         Self {
             processes: Arc::new(Mutex::new(HashMap::new())),
+            event_bus,
         }
     }
 }
 
+/// Waits until the process `pid` exited, leaving it unreaped.
+fn wait_exited(pid: u32) -> std::io::Result<()> {
+    loop {
+        let mut info: libc::siginfo_t = unsafe { std::mem::zeroed() };
+        let flags = libc::WEXITED | libc::WNOWAIT;
+        if unsafe { libc::waitid(libc::P_PID, pid as libc::id_t, &mut info, flags) } == 0 {
+            return Ok(());
+        }
+        let error = std::io::Error::last_os_error();
+        if error.kind() != std::io::ErrorKind::Interrupted {
+            return Err(error);
+        }
+    }
+}
+
+/// Waits for `child` to exit, then records it and reports the crash.
+/// Nothing is reported for processes being stopped, or removed by `stop`.
+fn watch(
+    id: String,
+    mut child: Child,
+    processes: Arc<Mutex<HashMap<String, ProcessMetadata>>>,
+    event_bus: EventBus,
+) {
+    let pid = child.id();
+    if let Err(e) = wait_exited(pid) {
+        warn!("Runtime: Failed to wait for '{}' (PID {}): {}", id, pid, e);
+        return;
+    }
+    // Reaped under the lock: until then the PID cannot be reused, so `stop`
+    // never signals another process.
+    let mut map = processes.lock().unwrap();
+    let status = match child.wait() {
+        Ok(status) => status,
+        Err(e) => {
+            warn!("Runtime: Failed to reap '{}' (PID {}): {}", id, pid, e);
+            return;
+        }
+    };
+    let crashed = match map.get_mut(&id) {
+        Some(meta) if meta.pid == pid => {
+            meta.exit = Some(status);
+            meta.exited.notify_one();
+            !meta.stopping
+        }
+        _ => false,
+    };
+    drop(map);
+    if crashed {
+        event_bus.publish(SystemEvent::ServiceCrashed {
+            id,
+            exit_code: status.code(),
+        });
+    }
+}
+
 #[async_trait]
 impl ServiceProvider for LocalServiceProvider {
     async fn spawn(&self, config: &ServiceConfig) -> Result<()> {
         let mut map = self.processes.lock().unwrap();
-        if map.contains_key(config.node_id()) {
+        if map
+            .get(config.node_id())
+            .is_some_and(|meta| meta.exit.is_none())
+        {
             info!(
                 "Runtime: Service '{}' already known running.",
                 config.node_id()
@@ -50,6 +127,8 @@ impl ServiceProvider for LocalServiceProvider {
 
         let mut cmd = Command::new(config.binary_path());
         cmd.args(config.args());
+        // Placement hints travel as CommonArgs flags; the service pins its own threads.
+        cmd.args(config.placement().to_args());
         cmd.envs(config.env());
 
         cmd.stdout(Stdio::inherit());
@@ -72,49 +151,73 @@ impl ServiceProvider for LocalServiceProvider {
 
         map.insert(
             config.node_id().to_string(),
-            ProcessMetadata { pid, admin_addr },
+            ProcessMetadata {
+                pid,
+                admin_addr,
+                exit: None,
+                stopping: false,
+                exited: Arc::new(Notify::new()),
+            },
+        );
+        drop(map);
+
+        let (id, processes, event_bus) = (
+            config.node_id().to_string(),
+            self.processes.clone(),
+            self.event_bus.clone(),
         );
+        std::thread::Builder::new()
+            .name(format!("watch-{}", id))
+            .spawn(move || watch(id, child, processes, event_bus))
+            .context("Failed to spawn process watcher")?;
 
         Ok(())
     }
 
     async fn stop(&self, id: &str) -> Result<()> {
-        let metadata_opt = { self.processes.lock().unwrap().remove(id) };
-
-        if let Some(meta) = metadata_opt {
-            let pid = meta.pid;
-
-            // 1. Try Graceful (Admin)
-            if let Some(addr) = meta.admin_addr {
-                info!(
-                    "Runtime: Attempting graceful shutdown for '{}' within 500ms at {}",
-                    id, addr
-                );
-                match AdminClient::new(&addr) {
-                    Ok(mut client) => {
-                        if let Err(e) = client.send_command(AdminCommand::Shutdown).await {
-                            warn!(
-                                "Runtime: Graceful shutdown command failed for '{}': {}",
-                                id, e
-                            );
-                        } else {
-                            // Wait 500ms for it to exit on its own
-                            tokio::time::sleep(Duration::from_millis(500)).await;
-                        }
+        // The entry stays until the end, so that the watcher records the exit.
+        let (admin_addr, exited) = {
+            let mut map = self.processes.lock().unwrap();
+            let Some(meta) = map.get_mut(id) else {
+                return Ok(());
+            };
+            if meta.exit.is_some() {
+                map.remove(id);
+                return Ok(());
+            }
+            meta.stopping = true;
+            (meta.admin_addr.clone(), meta.exited.clone())
+        };
+
+        // 1. Try Graceful (Admin)
+        if let Some(addr) = admin_addr {
+            info!(
+                "Runtime: Attempting graceful shutdown for '{}' within {:?} at {}",
+                id, GRACEFUL_SHUTDOWN, addr
+            );
+            match AdminClient::new(&addr) {
+                Ok(mut client) => {
+                    if let Err(e) = client.send_command(AdminCommand::Shutdown).await {
+                        warn!(
+                            "Runtime: Graceful shutdown command failed for '{}': {}",
+                            id, e
+                        );
+                    } else {
+                        // Wait for it to exit on its own
+                        let _ = tokio::time::timeout(GRACEFUL_SHUTDOWN, exited.notified()).await;
                     }
-                    Err(e) => warn!("Runtime: Failed to connect to admin for '{}': {}", id, e),
                 }
+                Err(e) => warn!("Runtime: Failed to connect to admin for '{}': {}", id, e),
             }
+        }
 
-            // 2. Force Kill (Safety Net)
-            // We check if it's still running using kill -0
-            let is_alive = unsafe { libc::kill(pid as i32, 0) == 0 };
-            if is_alive {
-                info!("Runtime: Force killing PID {}", pid);
-                #[cfg(unix)]
-                {
-                    let _ = Command::new("kill").arg(pid.to_string()).output();
-                }
+        // 2. Force Kill (Safety Net)
+        // Without a recorded exit the child is not reaped yet, so its PID is still its own.
+        let mut map = self.processes.lock().unwrap();
+        if let Some(meta) = map.remove(id) {
+            if meta.exit.is_none() {
+                info!("Runtime: Force killing PID {}", meta.pid);
+                unsafe { libc::kill(meta.pid as i32, libc::SIGTERM) };
             } else {
                 info!("Runtime: Service '{}' exited gracefully.", id);
             }
@@ -125,14 +228,10 @@ impl ServiceProvider for LocalServiceProvider {
     async fn probe(&self, id: &str) -> Result<HealthStatus> {
         let map = self.processes.lock().unwrap();
         if let Some(meta) = map.get(id) {
-            let pid = meta.pid;
-            let is_alive = unsafe { libc::kill(pid as i32, 0) == 0 };
-
-            if is_alive {
-                return Ok(HealthStatus::Running(pid));
-            } else {
-                return Ok(HealthStatus::Failed("PID not found".into()));
-            }
+            return Ok(match meta.exit {
+                None => HealthStatus::Running(meta.pid),
+                Some(status) => HealthStatus::Failed(format!("Exited with {}", status)),
+            });
         }
         Ok(HealthStatus::Stopped)
     }
@@ -141,4 +240,72 @@ impl ServiceProvider for LocalServiceProvider {
         let map = self.processes.lock().unwrap();
         Ok(map.keys().cloned().collect())
     }
+
+    async fn admin(&self, id: &str, command: AdminCommand) -> Result<AdminResponse> {
+        let admin_addr = {
+            let map = self.processes.lock().unwrap();
+            match map.get(id) {
+                Some(meta) => meta.admin_addr.clone(),
+                None => bail!("Unknown service '{}'", id),
+            }
+        };
+        let Some(addr) = admin_addr else {
+            bail!("Service '{}' has no admin port", id);
+        };
+        AdminClient::new(&addr)?.send_command(command).await
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn config(id: &str, binary: &str, args: &[&str]) -> ServiceConfig {
+        ServiceConfig::new(
+            id.to_string(),
+            "Test".to_string(),
+            binary.to_string(),
+            args.iter().map(|arg| arg.to_string()).collect(),
+            HashMap::new(),
+            None,
+        )
+    }
+
+    #[tokio::test]
+    async fn test_only_unexpected_exits_are_crashes() {
+        let event_bus = EventBus::new();
+        let mut events = event_bus.subscribe();
+        let runtime = LocalServiceProvider::new(event_bus);
+
+        runtime
+            .spawn(&config("sleeper", "sleep", &["30"]))
+            .await
+            .unwrap();
+        let HealthStatus::Running(pid) = runtime.probe("sleeper").await.unwrap() else {
+            panic!("sleeper is not running");
+        };
+        runtime.stop("sleeper").await.unwrap();
+        assert!(matches!(
+            runtime.probe("sleeper").await.unwrap(),
+            HealthStatus::Stopped
+        ));
+
+        runtime
+            .spawn(&config("quitter", "true", &[]))
+            .await
+            .unwrap();
+        let event = tokio::time::timeout(Duration::from_secs(5), events.recv())
+            .await
+            .unwrap()
+            .unwrap();
+        match event {
+            SystemEvent::ServiceCrashed { id, exit_code } => {
+                assert_eq!((id.as_str(), exit_code), ("quitter", Some(0)));
+            }
+            _ => panic!("unexpected event"),
+        }
+        // The stopped sleeper was killed, reaped, and never reported.
+        assert!(unsafe { libc::kill(pid as i32, 0) } != 0);
+        assert!(events.try_recv().is_err());
+    }
 }
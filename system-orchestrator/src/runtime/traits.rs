@@ -1,6 +1,7 @@
 use crate::layout::model::ServiceConfig;
-use anyhow::Result;
+use anyhow::{bail, Result};
 use async_trait::async_trait;
+use trading_core::admin::command::{AdminCommand, AdminResponse};
 
 #[derive(Debug, Clone, PartialEq)]
 pub enum HealthStatus {
@@ -32,4 +33,10 @@ pub trait ServiceProvider: Send + Sync {
     /// List all known services managed by this provider.
     /// Used for orphan detection (reconciliation).
     async fn list(&self) -> Result<Vec<String>>;
+
+    /// Sends a command to the Admin port of a service.
+    /// Fails if the service is unknown or has no Admin port.
+    async fn admin(&self, id: &str, _command: AdminCommand) -> Result<AdminResponse> {
+        bail!("Service '{}' has no admin channel in this runtime", id)
+    }
 }
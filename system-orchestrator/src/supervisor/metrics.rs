@@ -0,0 +1,27 @@
+//! Deploy and recovery times of the Supervisor, served by the API Server
+//! (`GetSupervisorMetrics`).
+
+use orchestrator_protocol::model::SupervisorMetrics;
+use std::sync::atomic::{AtomicU64, Ordering};
+use trading_core::metrics::LatencyHistogram;
+
+/// Shared between the Supervisor, which records, and the API Server, which reads.
+#[derive(Default)]
+pub struct DeployMetrics {
+    /// From a deploy request to every service of the layout being started.
+    pub deploy: LatencyHistogram,
+    /// From a service crash to its replacement being started.
+    pub recovery: LatencyHistogram,
+    /// Services restarted after a crash or a failed start.
+    pub restarts: AtomicU64,
+}
+
+impl DeployMetrics {
+    pub fn snapshot(&self) -> SupervisorMetrics {
+        SupervisorMetrics {
+            deploy: self.deploy.snapshot(),
+            recovery: self.recovery.snapshot(),
+            restarts: self.restarts.load(Ordering::Relaxed),
+        }
+    }
+}
@@ -1,3 +1,5 @@
+pub mod metrics;
 pub mod worker;
 
+pub use metrics::DeployMetrics;
 pub use worker::Supervisor;
@@ -2,11 +2,41 @@ use crate::event_bus::{EventBus, SystemEvent};
 use crate::layout::{DeploymentPlan, LayoutEngine};
 use crate::registry::ServiceCatalog;
 use crate::runtime::{HealthStatus, ServiceProvider};
+use crate::supervisor::metrics::DeployMetrics;
 use anyhow::Result;
 use log::{error, info, warn};
 use orchestrator_protocol::model::Layout;
+use std::collections::{HashMap, HashSet};
+use std::sync::atomic::Ordering;
 use std::sync::Arc;
-use tokio::time::{self, Duration};
+use tokio::sync::broadcast::error::RecvError;
+use tokio::task::JoinSet;
+use tokio::time::{self, Duration, Instant};
+
+/// Period of the reconcile loop when no event triggers it, as a safety net for
+/// changes nobody reported.
+const RECONCILE_INTERVAL: Duration = Duration::from_secs(1);
+
+/// Delay before the second restart of a service, doubled on every further one.
+/// The first restart after a crash is immediate.
+const RESTART_BACKOFF: Duration = Duration::from_millis(100);
+const MAX_RESTART_BACKOFF: Duration = Duration::from_secs(30);
+
+/// A service running this long since its last restart starts over with an
+/// immediate restart.
+const RESTART_RESET: Duration = Duration::from_secs(60);
+
+/// Restart history of a service that crashed or failed to start.
+struct Restart {
+    /// Restarts since the service was last considered healthy.
+    attempts: u32,
+    /// The service is not restarted before then.
+    not_before: Instant,
+    /// When the service was last started.
+    started: Option<Instant>,
+    /// When the crash being recovered from was noticed.
+    crashed: Option<Instant>,
+}
 
 /// The Manager that ensures Reality matches the Plan.
 ///
@@ -27,6 +57,13 @@ pub struct Supervisor<P: ServiceProvider> {
 
     // Configuration for port allocation
     base_port: u16,
+
+    // Services started by us and not known to have exited since.
+    started: HashSet<String>,
+    restarts: HashMap<String, Restart>,
+    // When the pending deploy was requested.
+    deploy_requested: Option<Instant>,
+    metrics: Arc<DeployMetrics>,
 }
 
 impl<P: ServiceProvider + 'static> Supervisor<P> {
@@ -38,49 +75,63 @@ impl<P: ServiceProvider + 'static> Supervisor<P> {
             desired_plan: None,
             current_layout: None,
             base_port: 6000,
+            started: HashSet::new(),
+            restarts: HashMap::new(),
+            deploy_requested: None,
+            metrics: Arc::new(DeployMetrics::default()),
         }
     }
 
+    /// Returns the deploy and recovery times, updated while the Supervisor runs.
+    pub fn metrics(&self) -> Arc<DeployMetrics> {
+        self.metrics.clone()
+    }
+
     /// Start the Supervisor Loop.
     /// This consumes the struct and runs forever.
+    ///
+    /// Reconciles as soon as an event changes the desired or the actual state,
+    /// when a restart backoff expires, and every `RECONCILE_INTERVAL` otherwise.
     pub async fn run(mut self) {
         info!("Supervisor: Starting Reconciliation Loop");
         let mut rx = self.event_bus.subscribe();
-        let mut ticker = time::interval(Duration::from_secs(1));
+        let mut ticker = time::interval(RECONCILE_INTERVAL);
+        ticker.set_missed_tick_behavior(time::MissedTickBehavior::Delay);
 
         loop {
-            // tokio::select! {
-            // 1. Handle Events
-            info!("DEBUG: Waiting for event...");
-            match rx.recv().await {
-                Ok(event) => {
-                    info!("DEBUG: Event received: {:?}", event);
-                    // Flush stdout
-                    self.handle_event(event);
-                    // Trigger reconcile after every event for now to simulate the loop
-                    if let Err(e) = self.reconcile().await {
-                        error!("Supervisor: Reconcile Loop Error: {:?}", e);
+            let next_restart = self.next_restart();
+            let reconcile = tokio::select! {
+                event = rx.recv() => match event {
+                    Ok(event) => self.handle_event(event),
+                    Err(RecvError::Lagged(skipped)) => {
+                        // Whatever was missed, reconciling catches up with it.
+                        warn!("Supervisor: EventBus lagged, {} events skipped", skipped);
+                        true
                     }
-                }
-                Err(e) => {
-                    warn!("Supervisor: EventBus receive error: {:?}", e);
-                }
-            }
+                    Err(RecvError::Closed) => {
+                        info!("Supervisor: EventBus closed, stopping");
+                        return;
+                    }
+                },
+                _ = ticker.tick() => true,
+                _ = sleep_until(next_restart) => true,
+            };
 
-            /*
-            _ = ticker.tick() => {
-                info!("[TRACE] Supervisor: Starting Reconcile...");
+            if reconcile {
                 if let Err(e) = self.reconcile().await {
                     error!("Supervisor: Reconcile Loop Error: {:?}", e);
                 }
-                info!("[TRACE] Supervisor: Reconcile Complete.");
+                ticker.reset();
             }
-            */
-            // }
         }
     }
 
-    fn handle_event(&mut self, event: SystemEvent) {
+    /// Applies an event to the state.
+    ///
+    /// # Returns
+    ///
+    /// Whether the event calls for a reconcile.
+    fn handle_event(&mut self, event: SystemEvent) -> bool {
         info!("[TRACE] Supervisor: Handling Event...");
         match event {
             SystemEvent::ServiceDiscovered { descriptor } => {
@@ -95,24 +146,30 @@ impl<P: ServiceProvider + 'static> Supervisor<P> {
                 if self.current_layout.is_some() {
                     info!("Supervisor: Service Discovered. Retrying pending layout resolution...");
                     self.try_resolve_layout();
+                    return true;
                 }
+                false
             }
             SystemEvent::DeployRequested { layout } => {
                 info!("Supervisor: Deploy Requested for Layout '{}'", layout.id());
                 self.current_layout = Some(layout.clone());
+                self.deploy_requested = Some(Instant::now());
                 self.try_resolve_layout();
+                true
             }
-            SystemEvent::ServiceCrashed { id, .. } => {
+            SystemEvent::ServiceCrashed { id, exit_code } => {
                 warn!(
-                    "Supervisor: Service '{}' Crashed. Will heal on next tick.",
-                    id
+                    "Supervisor: Service '{}' Crashed (exit code {:?}).",
+                    id, exit_code
                 );
+                self.crashed(&id, Instant::now());
+                true
             }
             _ => {
                 info!("[TRACE] Supervisor: Ignored Event: {:?}", event);
+                false
             }
         }
-        info!("[TRACE] Supervisor: Finished Handling Event");
     }
 
     /// Attempts to resolve the current layout into a desired plan.
@@ -145,49 +202,99 @@ impl<P: ServiceProvider + 'static> Supervisor<P> {
     }
 
     /// The Core Function: Make Reality == Plan
-    async fn reconcile(&self) -> Result<()> {
-        info!(
-            "DEBUG: Reconcile starting. Plan exists: {}",
-            self.desired_plan.is_some()
-        );
+    ///
+    /// Missing services are started wave by wave (see `LayoutEngine::waves`): the
+    /// services of a wave concurrently, each wave once the previous one is started.
+    async fn reconcile(&mut self) -> Result<()> {
         let plan = match &self.desired_plan {
-            Some(p) => p,
-            None => {
-                info!("DEBUG: Reconcile early return (no plan)");
-                return Ok(());
-            }
+            Some(plan) => plan.clone(),
+            None => return Ok(()),
         };
 
         // 1. Check Reality (Missing Services)
-        for (id, config) in plan.services() {
-            let status = self.runtime.probe(id).await?;
-            match status {
-                HealthStatus::Running(_) => {
+        let mut probes = JoinSet::new();
+        for id in plan.services().keys() {
+            let runtime = self.runtime.clone();
+            let id = id.clone();
+            probes.spawn(async move {
+                let status = runtime.probe(&id).await;
+                (id, status)
+            });
+        }
+        let mut missing = HashSet::new();
+        let now = Instant::now();
+        while let Some(probe) = probes.join_next().await {
+            match probe? {
+                (_, Ok(HealthStatus::Running(_))) => {
                     // It is running. Ideally we check if config matches (reconfiguration).
                     // For now, we assume if it exists, it is good.
                 }
-                HealthStatus::Stopped | HealthStatus::Failed(_) => {
-                    warn!("Supervisor: Service '{}' is NOT running. Spawning...", id);
-                    if let Err(e) = self.runtime.spawn(config).await {
-                        error!("Supervisor: Failed to spawn '{}': {}", id, e);
-                    } else {
-                        info!("Supervisor: Service '{}' spawned successfully.", id);
-                        // Note: We don't get the PID back from spawn() yet in the trait signature effectively,
-                        // but LocalServiceProvider tracks it.
+                (id, Ok(HealthStatus::Stopped | HealthStatus::Failed(_))) => {
+                    // Exited without the runtime reporting it.
+                    self.crashed(&id, now);
+                    missing.insert(id);
+                }
+                (id, Err(e)) => error!("Supervisor: Failed to probe '{}': {}", id, e),
+            }
+        }
+
+        // 2. Start them, upstream first
+        let mut pending = 0;
+        for wave in plan.waves() {
+            let mut spawns = JoinSet::new();
+            for id in wave.into_iter().filter(|id| missing.contains(id)) {
+                let Some(config) = plan.services().get(&id) else {
+                    continue;
+                };
+                if let Some(restart) = self.restarts.get(&id) {
+                    if restart.not_before > Instant::now() {
+                        pending += 1;
+                        continue;
+                    }
+                }
+                warn!("Supervisor: Service '{}' is NOT running. Spawning...", id);
+                let runtime = self.runtime.clone();
+                let config = config.clone();
+                spawns.spawn(async move {
+                    let result = runtime.spawn(&config).await;
+                    (id, result)
+                });
+            }
 
-                        // We could emit ServiceStarted here, but let's wait for the next probe to confirm it?
-                        // "Level Triggered" vs "Edge Triggered".
-                        // Better to emit it now.
+            while let Some(spawn) = spawns.join_next().await {
+                let (id, result) = spawn?;
+                let now = Instant::now();
+                match result {
+                    Ok(()) => {
+                        info!("Supervisor: Service '{}' spawned successfully.", id);
+                        self.spawned(&id, now);
                         self.event_bus.publish(SystemEvent::ServiceStarted {
-                            id: id.clone(),
+                            id,
                             pid: 0, // Placeholder
                         });
                     }
+                    Err(e) => {
+                        error!("Supervisor: Failed to spawn '{}': {}", id, e);
+                        self.back_off(&id, now);
+                        pending += 1;
+                    }
                 }
             }
         }
 
-        // 2. Kill Orphans (Garbage Collection)
+        if pending == 0 {
+            if let Some(requested) = self.deploy_requested.take() {
+                let elapsed = requested.elapsed();
+                self.metrics.deploy.record(elapsed);
+                info!(
+                    "Supervisor: Layout '{}' deployed in {:?}",
+                    plan.layout_id(),
+                    elapsed
+                );
+            }
+        }
+
+        // 3. Kill Orphans (Garbage Collection)
         // We list all running processes.
         let running_services = self.runtime.list().await?;
         for id in running_services {
@@ -195,11 +302,82 @@ impl<P: ServiceProvider + 'static> Supervisor<P> {
                 if let Err(e) = self.runtime.stop(&id).await {
                     error!("Supervisor: Failed to stop orphan '{}': {}", id, e);
                 }
+                self.started.remove(&id);
+                self.restarts.remove(&id);
             }
         }
 
         Ok(())
     }
+
+    /// Records that a service we started is gone, so it gets restarted.
+    /// Reported both by the runtime and by probes: only the first report counts.
+    fn crashed(&mut self, id: &str, now: Instant) {
+        if self.started.remove(id) {
+            self.back_off(id, now);
+            if let Some(restart) = self.restarts.get_mut(id) {
+                restart.crashed.get_or_insert(now);
+            }
+        }
+    }
+
+    /// Schedules the restart of a service that crashed or failed to start.
+    fn back_off(&mut self, id: &str, now: Instant) {
+        let restart = self.restarts.entry(id.to_string()).or_insert(Restart {
+            attempts: 0,
+            not_before: now,
+            started: None,
+            crashed: None,
+        });
+        if restart
+            .started
+            .is_some_and(|started| now.duration_since(started) >= RESTART_RESET)
+        {
+            restart.attempts = 0;
+        }
+        let delay = match restart.attempts {
+            0 => Duration::ZERO,
+            attempts => RESTART_BACKOFF
+                .saturating_mul(1 << (attempts - 1).min(16))
+                .min(MAX_RESTART_BACKOFF),
+        };
+        if !delay.is_zero() {
+            warn!("Supervisor: Restarting '{}' in {:?}", id, delay);
+        }
+        restart.attempts += 1;
+        restart.not_before = now + delay;
+    }
+
+    fn spawned(&mut self, id: &str, now: Instant) {
+        self.started.insert(id.to_string());
+        let Some(restart) = self.restarts.get_mut(id) else {
+            return;
+        };
+        self.metrics.restarts.fetch_add(1, Ordering::Relaxed);
+        restart.started = Some(now);
+        if let Some(crashed) = restart.crashed.take() {
+            let elapsed = now.duration_since(crashed);
+            self.metrics.recovery.record(elapsed);
+            info!("Supervisor: Service '{}' recovered in {:?}", id, elapsed);
+        }
+    }
+
+    /// Returns when the next backed-off restart is due.
+    fn next_restart(&self) -> Option<Instant> {
+        let now = Instant::now();
+        self.restarts
+            .values()
+            .map(|restart| restart.not_before)
+            .filter(|not_before| *not_before > now)
+            .min()
+    }
+}
+
+async fn sleep_until(deadline: Option<Instant>) {
+    match deadline {
+        Some(deadline) => time::sleep_until(deadline).await,
+        None => std::future::pending().await,
+    }
 }
 
 #[cfg(test)]
@@ -222,6 +400,11 @@ mod tests {
                 spawned: Arc::new(Mutex::new(Vec::new())),
             }
         }
+
+        /// Simulates the exit of a service.
+        fn kill(&self, id: &str) {
+            self.spawned.lock().unwrap().retain(|spawned| spawned != id);
+        }
     }
 
     #[async_trait]
@@ -576,7 +759,71 @@ mod tests {
                 "Portfolio not spawned: {:?}",
                 *spawned
             );
+            // Upstream nodes are started first.
+            let position = |id: &str| spawned.iter().position(|s| s == id).unwrap();
+            assert!(position("gateway-node") < position("strategy-node"));
+            assert!(position("strategy-node") < position("portfolio-node"));
         }
         s_handle.abort();
     }
+
+    /// Verification Test: Crash Recovery
+    ///
+    /// **Objective**: Verify that a `ServiceCrashed` event restarts the service right away,
+    /// without waiting for the reconcile tick, and that deploy and recovery are measured.
+    #[tokio::test]
+    async fn test_crashed_service_restarts_immediately() {
+        let _ = env_logger::builder().is_test(true).try_init();
+
+        let event_bus = EventBus::new();
+        let runtime = Arc::new(MockRuntime::new());
+        let supervisor = Supervisor::new(event_bus.clone(), runtime.clone());
+        let metrics = supervisor.metrics();
+
+        let s_handle = tokio::spawn(async move {
+            supervisor.run().await;
+        });
+        tokio::time::sleep(Duration::from_millis(100)).await;
+
+        event_bus.publish(SystemEvent::ServiceDiscovered {
+            descriptor: ServiceDescriptor {
+                service: "fake-service".to_string(),
+                description: "Test".into(),
+                version: "1.0".into(),
+                binary_path: Some("/tmp/fake-service".into()),
+                inputs: vec![],
+                outputs: vec![],
+            },
+        });
+        let mut layout = Layout::new("crash-layout");
+        layout.add_node(Node::new(
+            "node-1".to_string(),
+            "Node 1".to_string(),
+            "fake-service".to_string(),
+            "Stopped".to_string(),
+        ));
+        event_bus.publish(SystemEvent::DeployRequested { layout });
+        tokio::time::sleep(Duration::from_millis(100)).await;
+        assert_eq!(metrics.deploy.count(), 1);
+
+        // Well within the reconcile interval.
+        runtime.kill("node-1");
+        event_bus.publish(SystemEvent::ServiceCrashed {
+            id: "node-1".to_string(),
+            exit_code: Some(1),
+        });
+        tokio::time::sleep(Duration::from_millis(100)).await;
+
+        assert!(
+            runtime
+                .spawned
+                .lock()
+                .unwrap()
+                .contains(&"node-1".to_string()),
+            "Supervisor did not restart node-1"
+        );
+        assert_eq!(metrics.recovery.count(), 1);
+        assert_eq!(metrics.restarts.load(Ordering::Relaxed), 1);
+        s_handle.abort();
+    }
 }
@@ -0,0 +1,68 @@
+//! Exponentially weighted statistics.
+
+/// Exponentially weighted mean and variance.
+///
+/// Uses the recursive (`adjust=False`) form: each value moves the mean by `alpha`
+/// of its distance to it, and the variance follows with the same weight.
+#[derive(Debug, Clone)]
+pub struct Ewma {
+    alpha: f64,
+    mean: f64,
+    variance: f64,
+    initialized: bool,
+}
+
+impl Ewma {
+    /// Creates an EWMA with a smoothing factor in `(0, 1]`.
+    pub fn new(alpha: f64) -> Self {
+        assert!(alpha > 0.0 && alpha <= 1.0, "alpha must be in (0, 1]");
+        Self {
+            alpha,
+            mean: f64::NAN,
+            variance: 0.0,
+            initialized: false,
+        }
+    }
+
+    /// Creates an EWMA from its span, `alpha = 2 / (span + 1)` as in pandas.
+    pub fn with_span(span: f64) -> Self {
+        Self::new(2.0 / (span + 1.0))
+    }
+
+    /// Adds a value.
+    pub fn update(&mut self, x: f64) {
+        if !self.initialized {
+            self.mean = x;
+            self.initialized = true;
+            return;
+        }
+        let delta = x - self.mean;
+        self.mean += self.alpha * delta;
+        self.variance = (1.0 - self.alpha) * (self.variance + self.alpha * delta * delta);
+    }
+
+    /// Returns the weighted mean, `NaN` before the first value.
+    pub fn mean(&self) -> f64 {
+        self.mean
+    }
+
+    /// Returns the weighted variance.
+    pub fn variance(&self) -> f64 {
+        self.variance
+    }
+
+    pub fn std(&self) -> f64 {
+        self.variance.sqrt()
+    }
+
+    /// Returns how many weighted standard deviations `x` lies from the mean, `NaN`
+    /// while the variance is zero.
+    pub fn zscore(&self, x: f64) -> f64 {
+        let std = self.std();
+        if std > 0.0 {
+            (x - self.mean) / std
+        } else {
+            f64::NAN
+        }
+    }
+}
@@ -0,0 +1,243 @@
+//! Streaming feature kernels over the columns of market data batches.
+
+use super::{ewma::Ewma, rolling::RollingStats};
+use crate::model::instrument::InstrumentId;
+use std::collections::HashMap;
+
+/// A feature computed value by value from one series.
+pub trait Kernel: Clone {
+    /// Adds the next value of the series.
+    ///
+    /// # Returns
+    ///
+    /// The feature after the update, `NaN` while it is undefined (warm-up).
+    fn update(&mut self, x: f64) -> f64;
+}
+
+/// Rolling mean over a fixed window.
+#[derive(Debug, Clone)]
+pub struct RollingMean(pub RollingStats);
+
+/// Rolling sample standard deviation over a fixed window.
+#[derive(Debug, Clone)]
+pub struct RollingStd(pub RollingStats);
+
+/// Z-score of each value against the rolling window that includes it, as
+/// `(x - x.rolling(w).mean()) / x.rolling(w).std()` in pandas.
+#[derive(Debug, Clone)]
+pub struct RollingZScore(pub RollingStats);
+
+/// Exponentially weighted mean.
+#[derive(Debug, Clone)]
+pub struct EwmaMean(pub Ewma);
+
+/// Z-score of each value against the exponentially weighted statistics that
+/// include it.
+#[derive(Debug, Clone)]
+pub struct EwmaZScore(pub Ewma);
+
+impl RollingMean {
+    pub fn new(window: usize) -> Self {
+        Self(RollingStats::new(window))
+    }
+}
+
+impl RollingStd {
+    pub fn new(window: usize) -> Self {
+        Self(RollingStats::new(window))
+    }
+}
+
+impl RollingZScore {
+    pub fn new(window: usize) -> Self {
+        Self(RollingStats::new(window))
+    }
+}
+
+impl Kernel for RollingMean {
+    fn update(&mut self, x: f64) -> f64 {
+        self.0.update(x);
+        self.0.mean()
+    }
+}
+
+impl Kernel for RollingStd {
+    fn update(&mut self, x: f64) -> f64 {
+        self.0.update(x);
+        self.0.std()
+    }
+}
+
+impl Kernel for RollingZScore {
+    fn update(&mut self, x: f64) -> f64 {
+        self.0.update(x);
+        self.0.zscore(x)
+    }
+}
+
+impl Kernel for EwmaMean {
+    fn update(&mut self, x: f64) -> f64 {
+        self.0.update(x);
+        self.0.mean()
+    }
+}
+
+impl Kernel for EwmaZScore {
+    fn update(&mut self, x: f64) -> f64 {
+        self.0.update(x);
+        self.0.zscore(x)
+    }
+}
+
+/// One kernel per instrument, fed from the columns of a batch.
+///
+/// Takes the `instrument_ids` and a price column of a `MarketDataBatch` or of a
+/// `MarketDataBatchView`, so the same code runs on live batches and on frames read
+/// straight from a memory-mapped tick file.
+#[derive(Debug, Clone)]
+pub struct PerInstrument<K: Kernel> {
+    prototype: K,
+    slots: HashMap<InstrumentId, usize>,
+    kernels: Vec<K>,
+    /// Feature of every kernel after its last update.
+    values: Vec<f64>,
+}
+
+impl<K: Kernel> PerInstrument<K> {
+    /// Creates an empty bank; each new instrument starts from a clone of `prototype`.
+    pub fn new(prototype: K) -> Self {
+        Self {
+            prototype,
+            slots: HashMap::new(),
+            kernels: Vec::new(),
+            values: Vec::new(),
+        }
+    }
+
+    /// Feeds one column of a batch, row by row.
+    ///
+    /// # Arguments
+    ///
+    /// * `instrument_ids` - The instrument of every row.
+    /// * `values` - The input of every row (e.g. the last prices).
+    /// * `out` - Cleared, then receives the feature of every row.
+    pub fn update(&mut self, instrument_ids: &[InstrumentId], values: &[f64], out: &mut Vec<f64>) {
+        assert_eq!(instrument_ids.len(), values.len());
+        out.clear();
+        out.reserve(values.len());
+        for (&id, &x) in instrument_ids.iter().zip(values) {
+            let slot = self.slot(id);
+            let value = self.kernels[slot].update(x);
+            self.values[slot] = value;
+            out.push(value);
+        }
+    }
+
+    /// Returns the last feature of an instrument, `None` if it was never updated.
+    pub fn value(&self, instrument_id: InstrumentId) -> Option<f64> {
+        self.slots
+            .get(&instrument_id)
+            .map(|&slot| self.values[slot])
+    }
+
+    /// Returns the kernel of an instrument.
+    pub fn get(&self, instrument_id: InstrumentId) -> Option<&K> {
+        self.slots
+            .get(&instrument_id)
+            .map(|&slot| &self.kernels[slot])
+    }
+
+    fn slot(&mut self, instrument_id: InstrumentId) -> usize {
+        let next = self.kernels.len();
+        let slot = *self.slots.entry(instrument_id).or_insert(next);
+        if slot == next {
+            self.kernels.push(self.prototype.clone());
+            self.values.push(f64::NAN);
+        }
+        slot
+    }
+}
+
+/// Price ratio of two instruments, from the last price seen for each.
+#[derive(Debug, Clone)]
+pub struct PairRatio {
+    numerator: InstrumentId,
+    denominator: InstrumentId,
+    last_numerator: f64,
+    last_denominator: f64,
+}
+
+impl PairRatio {
+    pub fn new(numerator: InstrumentId, denominator: InstrumentId) -> Self {
+        Self {
+            numerator,
+            denominator,
+            last_numerator: f64::NAN,
+            last_denominator: f64::NAN,
+        }
+    }
+
+    /// Feeds one price column of a batch.
+    ///
+    /// # Returns
+    ///
+    /// The ratio after the batch, `None` if the batch has neither instrument or one
+    /// of them was never priced.
+    pub fn update(&mut self, instrument_ids: &[InstrumentId], prices: &[f64]) -> Option<f64> {
+        let mut changed = false;
+        for (&id, &price) in instrument_ids.iter().zip(prices) {
+            if id == self.numerator {
+                self.last_numerator = price;
+                changed = true;
+            } else if id == self.denominator {
+                self.last_denominator = price;
+                changed = true;
+            }
+        }
+        let ratio = self.last_numerator / self.last_denominator;
+        (changed && ratio.is_finite()).then_some(ratio)
+    }
+}
+
+/// Element-wise ratio of two aligned columns, `out[i] = a[i] / b[i]`.
+///
+/// A straight loop over slices: compiles to vector instructions.
+pub fn ratio(a: &[f64], b: &[f64], out: &mut Vec<f64>) {
+    assert_eq!(a.len(), b.len());
+    out.clear();
+    out.extend(a.iter().zip(b).map(|(x, y)| x / y));
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::model::market_data::{MarketDataBatch, PriceUpdate};
+
+    #[test]
+    fn test_pair_zscore_streams_over_batches() {
+        let mut pair = PairRatio::new(1, 2);
+        let mut zscore = RollingZScore::new(3);
+        let mut last = f64::NAN;
+        for (a, b) in [(10.0, 5.0), (12.0, 5.0), (9.0, 5.0), (15.0, 5.0)] {
+            let batch = MarketDataBatch::new(vec![
+                PriceUpdate::new(1, a, a, a, 0),
+                PriceUpdate::new(2, b, b, b, 0),
+            ]);
+            let view = batch.view();
+            let ratio = pair
+                .update(view.get_instrument_ids(), view.get_last_prices())
+                .unwrap();
+            last = zscore.update(ratio);
+        }
+        // Ratios 2.4, 1.8, 3.0: mean 2.4, sample std 0.6.
+        assert!((last - 1.0).abs() < 1e-9);
+
+        let mut means = PerInstrument::new(RollingMean::new(2));
+        let mut out = Vec::new();
+        means.update(&[1, 2, 1], &[1.0, 5.0, 3.0], &mut out);
+        assert!(out[0].is_nan() && out[1].is_nan());
+        assert_eq!(out[2], 2.0);
+        assert_eq!(means.value(1), Some(2.0));
+        assert_eq!(means.value(3), None);
+    }
+}
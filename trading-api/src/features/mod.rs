@@ -0,0 +1,21 @@
+//! Incremental feature kernels.
+//!
+//! Streaming versions of the features `data-pipeline/src/processor.py` computes
+//! with pandas (price ratio, rolling mean and standard deviation, z-score), plus
+//! exponentially weighted variants. Every update costs O(1), whatever the window.
+//!
+//! Kernels consume plain `&[f64]` columns. Live strategies feed them the columns
+//! of each `MarketDataBatch`. Backtests feed them `MarketDataBatchView`s borrowed
+//! from a memory-mapped tick file, so the same features are computed in-stream
+//! in both cases instead of being precomputed offline.
+
+pub mod ewma;
+pub mod kernels;
+pub mod rolling;
+
+pub use ewma::Ewma;
+pub use kernels::{
+    EwmaMean, EwmaZScore, Kernel, PairRatio, PerInstrument, RollingMean, RollingStd, RollingZScore,
+    ratio,
+};
+pub use rolling::RollingStats;
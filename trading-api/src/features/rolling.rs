@@ -0,0 +1,119 @@
+//! Fixed-window statistics, updated in O(1) per value.
+
+/// Mean and variance over the last `window` values.
+///
+/// Welford's update is applied in both directions: the incoming value is added and
+/// the value leaving the window removed in a single step, so the cost per value is
+/// constant whatever the window. Values live in a flat ring buffer.
+///
+/// Like a pandas `rolling(window)`, statistics are `NaN` until the window is full,
+/// and the variance is the sample variance (`ddof = 1`).
+#[derive(Debug, Clone)]
+pub struct RollingStats {
+    window: usize,
+    ring: Vec<f64>,
+    head: usize,
+    mean: f64,
+    /// Sum of squared deviations from the mean.
+    m2: f64,
+}
+
+impl RollingStats {
+    /// Creates statistics over a window of `window` values (at least 2).
+    pub fn new(window: usize) -> Self {
+        assert!(window >= 2, "a rolling window needs at least 2 values");
+        Self {
+            window,
+            ring: Vec::with_capacity(window),
+            head: 0,
+            mean: 0.0,
+            m2: 0.0,
+        }
+    }
+
+    /// Returns the window length.
+    pub fn window(&self) -> usize {
+        self.window
+    }
+
+    /// Returns whether the window is full, i.e. the statistics are defined.
+    pub fn is_ready(&self) -> bool {
+        self.ring.len() == self.window
+    }
+
+    /// Adds a value, evicting the oldest one once the window is full.
+    pub fn update(&mut self, x: f64) {
+        if !self.is_ready() {
+            self.ring.push(x);
+            let delta = x - self.mean;
+            self.mean += delta / self.ring.len() as f64;
+            self.m2 += delta * (x - self.mean);
+            return;
+        }
+        let old = std::mem::replace(&mut self.ring[self.head], x);
+        self.head = (self.head + 1) % self.window;
+        let previous_mean = self.mean;
+        self.mean += (x - old) / self.window as f64;
+        self.m2 += (x - old) * (x - self.mean + old - previous_mean);
+    }
+
+    /// Returns the mean of the window, `NaN` until it is full.
+    pub fn mean(&self) -> f64 {
+        if self.is_ready() { self.mean } else { f64::NAN }
+    }
+
+    /// Returns the sample variance of the window, `NaN` until it is full.
+    pub fn variance(&self) -> f64 {
+        if self.is_ready() {
+            // Rounding can push a constant window slightly below zero.
+            (self.m2 / (self.window - 1) as f64).max(0.0)
+        } else {
+            f64::NAN
+        }
+    }
+
+    /// Returns the sample standard deviation of the window, `NaN` until it is full.
+    pub fn std(&self) -> f64 {
+        self.variance().sqrt()
+    }
+
+    /// Returns how many standard deviations `x` lies from the mean.
+    ///
+    /// `NaN` until the window is full or while the window is constant.
+    pub fn zscore(&self, x: f64) -> f64 {
+        let std = self.std();
+        if std > 0.0 {
+            (x - self.mean) / std
+        } else {
+            f64::NAN
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_matches_a_full_recomputation() {
+        let values: Vec<f64> = (0..200)
+            .map(|i| ((i * 37) % 23) as f64 * 1.5 + 100.0)
+            .collect();
+        let window = 20;
+        let mut stats = RollingStats::new(window);
+        for (i, &x) in values.iter().enumerate() {
+            stats.update(x);
+            if i + 1 < window {
+                assert!(stats.mean().is_nan());
+                continue;
+            }
+            let slice = &values[i + 1 - window..=i];
+            let mean = slice.iter().sum::<f64>() / window as f64;
+            let variance =
+                slice.iter().map(|v| (v - mean).powi(2)).sum::<f64>() / (window - 1) as f64;
+            assert!((stats.mean() - mean).abs() < 1e-9);
+            assert!((stats.variance() - variance).abs() < 1e-6);
+            assert!((stats.zscore(x) - (x - mean) / variance.sqrt()).abs() < 1e-6);
+        }
+    }
+}
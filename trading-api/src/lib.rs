@@ -1,3 +1,4 @@
+pub mod features;
 pub mod macros;
 pub mod model;
 
@@ -23,7 +24,7 @@ pub mod prelude {
     pub use crate::export_strategy;
     pub use crate::model::allocation::Allocation;
     pub use crate::model::allocation_batch::AllocationBatch;
-    pub use crate::model::market_data::MarketDataBatch;
+    pub use crate::model::market_data::{MarketDataBatch, MarketDataBatchView};
     pub use crate::traits::broker::Broker;
     pub use crate::traits::executor::Executor;
     pub use crate::traits::initiable::Initiable;
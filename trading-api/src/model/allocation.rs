@@ -1,9 +1,9 @@
 use crate::model::instrument::InstrumentId;
+use crate::model::positions::Positions;
 use serde::{Deserialize, Serialize};
-use std::collections::HashMap;
 
 /// Represents a held position in a specific instrument.
-#[derive(Debug, Clone, PartialEq, Serialize, Deserialize)]
+#[derive(Debug, Clone, Copy, PartialEq, Serialize, Deserialize)]
 pub struct Position {
     /// The ID of the instrument.
     instrument_id: InstrumentId,
@@ -49,8 +49,8 @@ impl Position {
 pub struct Allocation {
     /// The timestamp of the allocation.
     timestamp: u128,
-    /// The positions in the allocation.
-    positions: HashMap<InstrumentId, Position>,
+    /// The positions in the allocation, sorted by instrument.
+    positions: Positions,
 }
 
 impl Allocation {
@@ -65,7 +65,19 @@ impl Allocation {
                 .duration_since(std::time::UNIX_EPOCH)
                 .unwrap()
                 .as_millis(),
-            positions: HashMap::new(),
+            positions: Positions::new(),
+        }
+    }
+
+    /// Creates an Allocation holding the given positions, tagged with current timestamp.
+    ///
+    /// # Arguments
+    ///
+    /// * `positions` - The target positions.
+    pub fn from_positions(positions: Positions) -> Self {
+        Self {
+            positions,
+            ..Self::new()
         }
     }
 
@@ -78,12 +90,7 @@ impl Allocation {
     /// * `instrument_id` - The unique identifier of the instrument.
     /// * `quantity` - The new target quantity.
     pub fn update_position(&mut self, instrument_id: InstrumentId, quantity: f64) {
-        if quantity == 0.0 {
-            self.positions.remove(&instrument_id);
-        } else {
-            let position = Position::new(instrument_id, quantity);
-            self.positions.insert(instrument_id, position);
-        }
+        self.positions.set(instrument_id, quantity);
     }
 
     /// Retrieves a specific position from the allocation.
@@ -96,13 +103,18 @@ impl Allocation {
     ///
     /// `Some(&Position)` if found, or `None` if not present.
     pub fn get_position(&self, instrument_id: InstrumentId) -> Option<&Position> {
-        self.positions.get(&instrument_id)
+        self.positions.get(instrument_id)
     }
 
-    pub fn get_positions(&self) -> &HashMap<InstrumentId, Position> {
+    pub fn get_positions(&self) -> &Positions {
         &self.positions
     }
 
+    /// Consumes the allocation, keeping its positions for reuse.
+    pub fn into_positions(self) -> Positions {
+        self.positions
+    }
+
     pub fn get_timestamp(&self) -> u128 {
         self.timestamp
     }
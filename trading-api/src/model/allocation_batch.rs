@@ -4,7 +4,7 @@ use crate::model::Allocation;
 
 /// Represents a batch of allocations (decisions) generated by a strategy.
 /// Vectorized for performance and efficiency.
-#[derive(Debug, Clone, Serialize, Deserialize)]
+#[derive(Debug, Default, Clone, Serialize, Deserialize)]
 pub struct AllocationBatch {
     allocations: Vec<Allocation>,
 }
@@ -1,3 +1,5 @@
+use crate::model::instrument::InstrumentId;
+use crate::model::order::OrderId;
 use serde::{Deserialize, Serialize};
 
 /// Status of an order execution.
@@ -19,13 +21,30 @@ pub enum ExecutionStatus {
     Expired,
 }
 
+/// Why an order was rejected.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
+pub enum RejectReason {
+    /// Not enough cash or margin for the order.
+    InsufficientFunds,
+    /// The broker does not know the instrument.
+    UnknownInstrument,
+    /// The order is malformed (quantity, price, type).
+    InvalidOrder,
+    /// The venue is not accepting orders.
+    MarketClosed,
+    /// Any other broker or exchange reason.
+    Other,
+}
+
 /// Represents the result of an execution report from the broker/exchange.
-#[derive(Debug, Clone, Serialize, Deserialize)]
+///
+/// Fixed-size and `Copy`, like `Order`.
+#[derive(Debug, Clone, Copy, PartialEq, Serialize, Deserialize)]
 pub struct ExecutionResult {
     /// The ID of the order this report corresponds to.
-    pub order_id: String,
+    pub order_id: OrderId,
     /// The instrument ID.
-    pub instrument_id: String,
+    pub instrument_id: InstrumentId,
     /// The current status of the order.
     pub status: ExecutionStatus,
     /// The quantity filled in this specific report (delta).
@@ -36,29 +55,29 @@ pub struct ExecutionResult {
     pub cumulative_fill_quantity: f64,
     /// The average price of fills so far.
     pub average_price: f64,
-    /// Timestamp of the execution report (unix millis).
-    pub timestamp: u128,
-    /// Optional rejection reason or message.
-    pub message: Option<String>,
+    /// Timestamp of the execution report (unix nanos).
+    pub timestamp: u64,
+    /// Rejection reason, for `Rejected` reports.
+    pub reject_reason: Option<RejectReason>,
 }
 
 impl ExecutionResult {
     pub fn new(
-        order_id: impl Into<String>,
-        instrument_id: impl Into<String>,
+        order_id: OrderId,
+        instrument_id: InstrumentId,
         status: ExecutionStatus,
-        timestamp: u128,
+        timestamp: u64,
     ) -> Self {
         Self {
-            order_id: order_id.into(),
-            instrument_id: instrument_id.into(),
+            order_id,
+            instrument_id,
             status,
             last_filled_quantity: 0.0,
             last_filled_price: 0.0,
             cumulative_fill_quantity: 0.0,
             average_price: 0.0,
             timestamp,
-            message: None,
+            reject_reason: None,
         }
     }
 
@@ -76,8 +95,8 @@ impl ExecutionResult {
         self
     }
 
-    pub fn with_message(mut self, msg: impl Into<String>) -> Self {
-        self.message = Some(msg.into());
+    pub fn with_reject_reason(mut self, reason: RejectReason) -> Self {
+        self.reject_reason = Some(reason);
         self
     }
 }
@@ -0,0 +1,64 @@
+use serde::{Deserialize, Serialize};
+
+use crate::model::ExecutionResult;
+
+/// Represents a batch of execution results reported by a broker.
+/// All fills produced by one order batch travel as one message.
+#[derive(Debug, Default, Clone, Serialize, Deserialize)]
+pub struct ExecutionBatch {
+    executions: Vec<ExecutionResult>,
+}
+
+impl ExecutionBatch {
+    /// Creates a new ExecutionBatch.
+    pub fn new(executions: Vec<ExecutionResult>) -> Self {
+        Self { executions }
+    }
+
+    pub fn get_executions(&self) -> &[ExecutionResult] {
+        &self.executions
+    }
+
+    pub fn len(&self) -> usize {
+        self.executions.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.executions.is_empty()
+    }
+
+    /// Gives access to the underlying vector, to fill a batch that is reused.
+    pub fn executions_mut(&mut self) -> &mut Vec<ExecutionResult> {
+        &mut self.executions
+    }
+
+    /// Empties the batch, keeping its allocation.
+    pub fn clear(&mut self) {
+        self.executions.clear();
+    }
+
+    pub fn iter(&self) -> std::slice::Iter<'_, ExecutionResult> {
+        self.executions.iter()
+    }
+}
+
+impl From<Vec<ExecutionResult>> for ExecutionBatch {
+    fn from(executions: Vec<ExecutionResult>) -> Self {
+        Self::new(executions)
+    }
+}
+
+impl Into<Vec<ExecutionResult>> for ExecutionBatch {
+    fn into(self) -> Vec<ExecutionResult> {
+        self.executions
+    }
+}
+
+impl IntoIterator for ExecutionBatch {
+    type Item = ExecutionResult;
+    type IntoIter = std::vec::IntoIter<Self::Item>;
+
+    fn into_iter(self) -> Self::IntoIter {
+        self.executions.into_iter()
+    }
+}
@@ -13,6 +13,16 @@ pub enum Instrument {
     Option(OptionContract),
 }
 
+impl Instrument {
+    /// Returns the ticker symbol, for the instrument types that have one.
+    pub fn symbol(&self) -> Option<&str> {
+        match self {
+            Instrument::Stock(stock) => Some(stock.get_symbol()),
+            Instrument::Future(_) | Instrument::Option(_) => None,
+        }
+    }
+}
+
 /// Represents a Futures contract.
 #[derive(Debug, Clone, PartialEq, Serialize, Deserialize)]
 pub struct Future {
@@ -2,21 +2,29 @@
 //!
 //! This module handles querying instruments. Persistence is handled by the runtime.
 
-use crate::model::instrument::InstrumentId;
 use crate::model::Instrument;
+use crate::model::instrument::InstrumentId;
 use std::collections::HashMap;
 
 /// A database for trading instruments.
 #[derive(Debug, Default)]
 pub struct InstrumentDB {
     instruments: HashMap<InstrumentId, Instrument>,
+    /// Symbol to the lowest id holding it.
+    symbols: HashMap<String, InstrumentId>,
 }
 
 impl InstrumentDB {
     /// Creates a new, empty InstrumentDB.
     pub fn new() -> Self {
+        Self::with_capacity(0)
+    }
+
+    /// Creates an empty InstrumentDB with room for `capacity` instruments.
+    pub fn with_capacity(capacity: usize) -> Self {
         Self {
-            instruments: HashMap::new(),
+            instruments: HashMap::with_capacity(capacity),
+            symbols: HashMap::with_capacity(capacity),
         }
     }
 
@@ -25,9 +33,51 @@ impl InstrumentDB {
         self.instruments.get(&id)
     }
 
+    /// Returns the ID of the instrument trading under `symbol`.
+    ///
+    /// # Returns
+    ///
+    /// The lowest ID holding `symbol` if several do (e.g. on different exchanges).
+    pub fn get_id(&self, symbol: &str) -> Option<InstrumentId> {
+        self.symbols.get(symbol).copied()
+    }
+
+    /// Retrieves an instrument by its ticker symbol, see `get_id`.
+    pub fn get_by_symbol(&self, symbol: &str) -> Option<&Instrument> {
+        self.get_id(symbol).and_then(|id| self.get(id))
+    }
+
     /// Adds or updates an instrument in the in-memory database.
     pub fn insert(&mut self, id: InstrumentId, instrument: Instrument) {
-        self.instruments.insert(id, instrument);
+        let replaced = self.instruments.insert(id, instrument);
+        if let Some(symbol) = replaced.as_ref().and_then(Instrument::symbol) {
+            if self.symbols.get(symbol) == Some(&id) {
+                self.symbols.remove(symbol);
+                // Another instrument may share the symbol it no longer points to.
+                let next = self
+                    .instruments
+                    .iter()
+                    .filter(|(_, other)| other.symbol() == Some(symbol))
+                    .map(|(other_id, _)| *other_id)
+                    .min();
+                if let Some(next) = next {
+                    self.symbols.insert(symbol.to_string(), next);
+                }
+            }
+        }
+        if let Some(symbol) = self.instruments[&id].symbol() {
+            let indexed = self.symbols.entry(symbol.to_string()).or_insert(id);
+            *indexed = (*indexed).min(id);
+        }
+    }
+
+    /// Returns the number of instruments.
+    pub fn len(&self) -> usize {
+        self.instruments.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.instruments.is_empty()
     }
 
     /// Returns an iterator over the instruments.
@@ -35,3 +85,51 @@ impl InstrumentDB {
         self.instruments.iter()
     }
 }
+
+/// Bulk load: reserves room for the whole batch up front.
+impl Extend<(InstrumentId, Instrument)> for InstrumentDB {
+    fn extend<I: IntoIterator<Item = (InstrumentId, Instrument)>>(&mut self, iter: I) {
+        let iter = iter.into_iter();
+        let (additional, _) = iter.size_hint();
+        self.instruments.reserve(additional);
+        self.symbols.reserve(additional);
+        for (id, instrument) in iter {
+            self.insert(id, instrument);
+        }
+    }
+}
+
+impl FromIterator<(InstrumentId, Instrument)> for InstrumentDB {
+    fn from_iter<I: IntoIterator<Item = (InstrumentId, Instrument)>>(iter: I) -> Self {
+        let mut db = Self::new();
+        db.extend(iter);
+        db
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::model::instrument::Stock;
+
+    fn stock(id: InstrumentId, symbol: &str) -> (InstrumentId, Instrument) {
+        let stock = Stock::new(id, symbol, "NASDAQ", "Tech", "Software", "USA", "USD");
+        (id, Instrument::Stock(stock))
+    }
+
+    #[test]
+    fn test_symbol_index_follows_updates() {
+        let mut db: InstrumentDB = [stock(3, "AAPL"), stock(1, "AAPL"), stock(2, "MSFT")]
+            .into_iter()
+            .collect();
+        assert_eq!(db.len(), 3);
+        assert_eq!(db.get_id("AAPL"), Some(1));
+        assert_eq!(db.get_id("MSFT"), Some(2));
+
+        let (id, renamed) = stock(1, "AMZN");
+        db.insert(id, renamed);
+        assert_eq!(db.get_id("AAPL"), Some(3));
+        assert_eq!(db.get_by_symbol("AMZN"), db.get(1));
+        assert_eq!(db.get_id("GOOG"), None);
+    }
+}
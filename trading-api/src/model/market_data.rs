@@ -1,9 +1,18 @@
 //! Market Data models.
 //!
 //! Includes `PriceUpdate` for individual ticks and `MarketDataBatch` for efficient network transmission.
+//!
+//! On binary wire formats a `MarketDataBatch` is encoded in an archived column layout
+//! (see `MarketDataBatchView`) so receivers can read the columns straight from the
+//! socket buffer instead of decoding them element by element.
 
-use crate::model::{instrument::InstrumentId, Instrument, InstrumentDB};
-use serde::{Deserialize, Serialize};
+use crate::model::{Instrument, InstrumentDB, instrument::InstrumentId};
+use serde::de::{self, Deserializer, Visitor};
+use serde::{Deserialize, Serialize, Serializer};
+use std::borrow::Cow;
+use std::cell::RefCell;
+use std::collections::HashMap;
+use std::fmt;
 
 /// Represents a single update to the price of an instrument.
 #[derive(Debug, Clone, Serialize, Deserialize)]
@@ -61,7 +70,7 @@ impl PriceUpdate {
 /// Represents a batch of market data updates sent over the network.
 /// Vectorized for performance (Structure of Arrays layout).
 /// This layout is cache-friendly and allows direct access to vectors for ML.
-#[derive(Debug, Clone, Serialize, Deserialize)]
+#[derive(Debug, Clone)]
 pub struct MarketDataBatch {
     instrument_ids: Vec<InstrumentId>,
     bid_prices: Vec<f64>,
@@ -126,6 +135,86 @@ impl MarketDataBatch {
         self.instrument_ids.len()
     }
 
+    pub fn get_instrument_ids(&self) -> &[InstrumentId] {
+        &self.instrument_ids
+    }
+
+    pub fn get_bid_prices(&self) -> &[f64] {
+        &self.bid_prices
+    }
+
+    pub fn get_ask_prices(&self) -> &[f64] {
+        &self.ask_prices
+    }
+
+    pub fn get_last_prices(&self) -> &[f64] {
+        &self.last_prices
+    }
+
+    pub fn get_timestamps(&self) -> &[u64] {
+        &self.timestamps
+    }
+
+    /// Returns a borrowed view over the columns of this batch.
+    pub fn view(&self) -> MarketDataBatchView<'_> {
+        MarketDataBatchView {
+            instrument_ids: Cow::Borrowed(&self.instrument_ids[..]),
+            bid_prices: Cow::Borrowed(&self.bid_prices[..]),
+            ask_prices: Cow::Borrowed(&self.ask_prices[..]),
+            last_prices: Cow::Borrowed(&self.last_prices[..]),
+            timestamps: Cow::Borrowed(&self.timestamps[..]),
+        }
+    }
+
+    /// Converts the batch into a view that owns its columns.
+    pub fn into_view(self) -> MarketDataBatchView<'static> {
+        MarketDataBatchView {
+            instrument_ids: Cow::Owned(self.instrument_ids),
+            bid_prices: Cow::Owned(self.bid_prices),
+            ask_prices: Cow::Owned(self.ask_prices),
+            last_prices: Cow::Owned(self.last_prices),
+            timestamps: Cow::Owned(self.timestamps),
+        }
+    }
+
+    /// Returns the size in bytes of the archived encoding of this batch.
+    pub fn archived_len(&self) -> usize {
+        archive::HEADER_LEN + archive::COLUMNS * archive::WORD * self.get_count()
+    }
+
+    /// Appends the archived column encoding of this batch to `out`.
+    ///
+    /// The layout is little-endian and every column starts on an 8-byte boundary
+    /// relative to the start of the encoding:
+    ///
+    /// | offset | content |
+    /// |--------|---------|
+    /// | 0      | magic `b"MDB\0"` |
+    /// | 4      | layout version (`u32`) |
+    /// | 8      | row count `n` (`u64`) |
+    /// | 16     | instrument ids (`[u64; n]`), then bid, ask, last (`[f64; n]`), then timestamps (`[u64; n]`) |
+    ///
+    /// # Arguments
+    ///
+    /// * `out` - Buffer the encoding is appended to.
+    pub fn archive_into(&self, out: &mut Vec<u8>) {
+        out.reserve(self.archived_len());
+        out.extend_from_slice(&archive::MAGIC);
+        out.extend_from_slice(&archive::VERSION.to_le_bytes());
+        out.extend_from_slice(&(self.get_count() as u64).to_le_bytes());
+        for id in &self.instrument_ids {
+            out.extend_from_slice(&(*id as u64).to_le_bytes());
+        }
+        for column in [&self.bid_prices, &self.ask_prices, &self.last_prices] {
+            for price in column {
+                out.extend_from_slice(&price.to_le_bytes());
+            }
+        }
+        for timestamp in &self.timestamps {
+            out.extend_from_slice(&timestamp.to_le_bytes());
+        }
+    }
+
     pub fn clear(&mut self) {
         self.instrument_ids.clear();
         self.bid_prices.clear();
@@ -142,6 +231,69 @@ impl MarketDataBatch {
         self.timestamps.push(update.timestamp);
     }
 
+    /// Appends every row of a view, column by column.
+    ///
+    /// # Arguments
+    ///
+    /// * `view` - The rows to append.
+    pub fn extend_from_view(&mut self, view: &MarketDataBatchView<'_>) {
+        self.instrument_ids
+            .extend_from_slice(view.get_instrument_ids());
+        self.bid_prices.extend_from_slice(view.get_bid_prices());
+        self.ask_prices.extend_from_slice(view.get_ask_prices());
+        self.last_prices.extend_from_slice(view.get_last_prices());
+        self.timestamps.extend_from_slice(view.get_timestamps());
+    }
+
+    /// Folds a newer batch into this one, keeping only the latest prices.
+    ///
+    /// A row of `newer` overwrites the last row of the same instrument in place, so
+    /// instruments keep their first-seen order; rows of new instruments are appended.
+    ///
+    /// # Arguments
+    ///
+    /// * `newer` - A batch received after this one.
+    pub fn merge_latest(&mut self, newer: &MarketDataBatch) {
+        self.merge_latest_indexed(newer, &mut HashMap::new());
+    }
+
+    /// Like `merge_latest`, with the row of every instrument of this batch kept in
+    /// `rows` across merges, so a merge costs the rows of `newer` only.
+    ///
+    /// # Arguments
+    ///
+    /// * `newer` - A batch received after this one.
+    /// * `rows` - The index of this batch from the previous merge, or empty to build
+    ///   it; only valid while the batch changes through these merges.
+    pub fn merge_latest_indexed(
+        &mut self,
+        newer: &MarketDataBatch,
+        rows: &mut HashMap<InstrumentId, usize>,
+    ) {
+        if rows.is_empty() {
+            rows.extend(
+                self.instrument_ids
+                    .iter()
+                    .enumerate()
+                    .map(|(row, &id)| (id, row)),
+            );
+        }
+        for update in newer.iter() {
+            match rows.get(&update.instrument_id) {
+                Some(&row) => {
+                    self.bid_prices[row] = update.bid;
+                    self.ask_prices[row] = update.ask;
+                    self.last_prices[row] = update.last;
+                    self.timestamps[row] = update.timestamp;
+                }
+                None => {
+                    rows.insert(update.instrument_id, self.get_count());
+                    self.add_update(update);
+                }
+            }
+        }
+    }
+
     pub fn get_update_at(&self, index: usize) -> PriceUpdate {
         PriceUpdate {
             instrument_id: self.instrument_ids[index],
@@ -185,3 +337,326 @@ impl<'a> Iterator for MarketDataBatchIterator<'a> {
         }
     }
 }
+
+/// A read-only view over an archived `MarketDataBatch`.
+///
+/// When decoded from an 8-byte aligned buffer on a little-endian target, every column
+/// borrows directly from that buffer: receiving a batch costs the same whatever its size.
+/// Misaligned buffers fall back to copying the affected columns.
+#[derive(Debug, Clone)]
+pub struct MarketDataBatchView<'a> {
+    instrument_ids: Cow<'a, [InstrumentId]>,
+    bid_prices: Cow<'a, [f64]>,
+    ask_prices: Cow<'a, [f64]>,
+    last_prices: Cow<'a, [f64]>,
+    timestamps: Cow<'a, [u64]>,
+}
+
+impl<'a> MarketDataBatchView<'a> {
+    /// Interprets an archived encoding produced by `MarketDataBatch::archive_into`.
+    ///
+    /// # Arguments
+    ///
+    /// * `bytes` - The archived encoding.
+    ///
+    /// # Returns
+    ///
+    /// * `Ok(MarketDataBatchView)` borrowing from `bytes` where alignment allows.
+    /// * `Err` if the magic, version or length do not match the layout.
+    pub fn from_archived(bytes: &'a [u8]) -> Result<Self, String> {
+        if bytes.len() < archive::HEADER_LEN || bytes[0..4] != archive::MAGIC {
+            return Err("Not an archived MarketDataBatch".to_string());
+        }
+        let version = u32::from_le_bytes(bytes[4..8].try_into().unwrap());
+        if version != archive::VERSION {
+            return Err(format!(
+                "Unsupported MarketDataBatch layout version {} (expected {})",
+                version,
+                archive::VERSION
+            ));
+        }
+        let count = u64::from_le_bytes(bytes[8..16].try_into().unwrap()) as usize;
+        let column_len = count
+            .checked_mul(archive::WORD)
+            .filter(|len| archive::HEADER_LEN + archive::COLUMNS * len == bytes.len())
+            .ok_or_else(|| {
+                format!(
+                    "Archived MarketDataBatch of {} rows has a bad length",
+                    count
+                )
+            })?;
+
+        let column = |index: usize| {
+            let start = archive::HEADER_LEN + index * column_len;
+            &bytes[start..start + column_len]
+        };
+        Ok(Self {
+            instrument_ids: archive::cast(column(0)),
+            bid_prices: archive::cast(column(1)),
+            ask_prices: archive::cast(column(2)),
+            last_prices: archive::cast(column(3)),
+            timestamps: archive::cast(column(4)),
+        })
+    }
+
+    pub fn get_count(&self) -> usize {
+        self.instrument_ids.len()
+    }
+
+    pub fn get_instrument_ids(&self) -> &[InstrumentId] {
+        &self.instrument_ids
+    }
+
+    pub fn get_bid_prices(&self) -> &[f64] {
+        &self.bid_prices
+    }
+
+    pub fn get_ask_prices(&self) -> &[f64] {
+        &self.ask_prices
+    }
+
+    pub fn get_last_prices(&self) -> &[f64] {
+        &self.last_prices
+    }
+
+    pub fn get_timestamps(&self) -> &[u64] {
+        &self.timestamps
+    }
+
+    pub fn get_update_at(&self, index: usize) -> PriceUpdate {
+        PriceUpdate {
+            instrument_id: self.instrument_ids[index],
+            bid: self.bid_prices[index],
+            ask: self.ask_prices[index],
+            last: self.last_prices[index],
+            timestamp: self.timestamps[index],
+        }
+    }
+
+    /// Copies the view into an owned `MarketDataBatch`.
+    pub fn into_owned(self) -> MarketDataBatch {
+        MarketDataBatch {
+            instrument_ids: self.instrument_ids.into_owned(),
+            bid_prices: self.bid_prices.into_owned(),
+            ask_prices: self.ask_prices.into_owned(),
+            last_prices: self.last_prices.into_owned(),
+            timestamps: self.timestamps.into_owned(),
+        }
+    }
+}
+
+/// Helpers for the archived column layout.
+mod archive {
+    use std::borrow::Cow;
+
+    pub const MAGIC: [u8; 4] = *b"MDB\0";
+    pub const VERSION: u32 = 1;
+    pub const HEADER_LEN: usize = 16;
+    pub const COLUMNS: usize = 5;
+    pub const WORD: usize = 8;
+
+    /// A plain 8-byte column element, valid for every bit pattern.
+    pub trait Word: Copy {
+        fn from_le_bytes(bytes: [u8; 8]) -> Self;
+    }
+
+    impl Word for u64 {
+        fn from_le_bytes(bytes: [u8; 8]) -> Self {
+            u64::from_le_bytes(bytes)
+        }
+    }
+
+    impl Word for f64 {
+        fn from_le_bytes(bytes: [u8; 8]) -> Self {
+            f64::from_le_bytes(bytes)
+        }
+    }
+
+    impl Word for usize {
+        fn from_le_bytes(bytes: [u8; 8]) -> Self {
+            u64::from_le_bytes(bytes) as usize
+        }
+    }
+
+    /// Reinterprets a column in place when possible, copying it otherwise.
+    pub fn cast<T: Word>(bytes: &[u8]) -> Cow<'_, [T]> {
+        if cfg!(target_endian = "little") && std::mem::size_of::<T>() == WORD {
+            // SAFETY: `T` is a plain 8-byte integer or float, valid for any bit pattern,
+            // and `align_to` only yields the middle slice for correctly aligned memory.
+            let (prefix, words, suffix) = unsafe { bytes.align_to::<T>() };
+            if prefix.is_empty() && suffix.is_empty() {
+                return Cow::Borrowed(words);
+            }
+        }
+        Cow::Owned(
+            bytes
+                .chunks_exact(WORD)
+                .map(|chunk| T::from_le_bytes(chunk.try_into().unwrap()))
+                .collect(),
+        )
+    }
+}
+
+thread_local! {
+    /// Scratch buffer reused by every archived serialization on this thread.
+    static ARCHIVE_SCRATCH: RefCell<Vec<u8>> = RefCell::new(Vec::new());
+}
+
+/// Field-by-field representation used for human-readable formats (JSON, ...).
+#[derive(Serialize)]
+struct ColumnsRef<'a> {
+    instrument_ids: &'a [InstrumentId],
+    bid_prices: &'a [f64],
+    ask_prices: &'a [f64],
+    last_prices: &'a [f64],
+    timestamps: &'a [u64],
+}
+
+#[derive(Deserialize)]
+struct ColumnsOwned {
+    instrument_ids: Vec<InstrumentId>,
+    bid_prices: Vec<f64>,
+    ask_prices: Vec<f64>,
+    last_prices: Vec<f64>,
+    timestamps: Vec<u64>,
+}
+
+impl Serialize for MarketDataBatch {
+    fn serialize<S: Serializer>(&self, serializer: S) -> Result<S::Ok, S::Error> {
+        if serializer.is_human_readable() {
+            return ColumnsRef {
+                instrument_ids: &self.instrument_ids,
+                bid_prices: &self.bid_prices,
+                ask_prices: &self.ask_prices,
+                last_prices: &self.last_prices,
+                timestamps: &self.timestamps,
+            }
+            .serialize(serializer);
+        }
+        ARCHIVE_SCRATCH.with(|scratch| {
+            // A nested serialization on the same thread gets a fresh buffer instead.
+            match scratch.try_borrow_mut() {
+                Ok(mut buf) => {
+                    buf.clear();
+                    self.archive_into(&mut buf);
+                    serializer.serialize_bytes(&buf)
+                }
+                Err(_) => {
+                    let mut buf = Vec::new();
+                    self.archive_into(&mut buf);
+                    serializer.serialize_bytes(&buf)
+                }
+            }
+        })
+    }
+}
+
+impl<'de> Deserialize<'de> for MarketDataBatch {
+    fn deserialize<D: Deserializer<'de>>(deserializer: D) -> Result<Self, D::Error> {
+        if deserializer.is_human_readable() {
+            let columns = ColumnsOwned::deserialize(deserializer)?;
+            let count = columns.instrument_ids.len();
+            if [
+                columns.bid_prices.len(),
+                columns.ask_prices.len(),
+                columns.last_prices.len(),
+                columns.timestamps.len(),
+            ]
+            .iter()
+            .any(|len| *len != count)
+            {
+                return Err(de::Error::custom(
+                    "MarketDataBatch columns differ in length",
+                ));
+            }
+            return Ok(Self {
+                instrument_ids: columns.instrument_ids,
+                bid_prices: columns.bid_prices,
+                ask_prices: columns.ask_prices,
+                last_prices: columns.last_prices,
+                timestamps: columns.timestamps,
+            });
+        }
+        MarketDataBatchView::deserialize(deserializer).map(MarketDataBatchView::into_owned)
+    }
+}
+
+impl<'de> Deserialize<'de> for MarketDataBatchView<'de> {
+    fn deserialize<D: Deserializer<'de>>(deserializer: D) -> Result<Self, D::Error> {
+        struct ArchivedVisitor;
+
+        impl<'de> Visitor<'de> for ArchivedVisitor {
+            type Value = MarketDataBatchView<'de>;
+
+            fn expecting(&self, f: &mut fmt::Formatter) -> fmt::Result {
+                f.write_str("an archived MarketDataBatch")
+            }
+
+            fn visit_borrowed_bytes<E: de::Error>(
+                self,
+                bytes: &'de [u8],
+            ) -> Result<Self::Value, E> {
+                MarketDataBatchView::from_archived(bytes).map_err(E::custom)
+            }
+
+            fn visit_bytes<E: de::Error>(self, bytes: &[u8]) -> Result<Self::Value, E> {
+                // Transient buffer: the view cannot borrow from it, so take a copy.
+                MarketDataBatchView::from_archived(bytes)
+                    .map(|view| view.into_owned().into_view())
+                    .map_err(E::custom)
+            }
+        }
+
+        if deserializer.is_human_readable() {
+            return MarketDataBatch::deserialize(deserializer).map(MarketDataBatch::into_view);
+        }
+        deserializer.deserialize_bytes(ArchivedVisitor)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_archived_round_trip_borrows_aligned_columns() {
+        let batch = MarketDataBatch::new(vec![
+            PriceUpdate::new(1, 99.5, 100.5, 100.0, 10),
+            PriceUpdate::new(7, 49.0, 51.0, 50.0, 11),
+        ]);
+
+        // Vec<u64> guarantees an 8-byte aligned backing buffer.
+        let mut words = vec![0u64; batch.archived_len() / 8];
+        let mut bytes = Vec::new();
+        batch.archive_into(&mut bytes);
+        assert_eq!(bytes.len(), batch.archived_len());
+        for (word, chunk) in words.iter_mut().zip(bytes.chunks_exact(8)) {
+            *word = u64::from_ne_bytes(chunk.try_into().unwrap());
+        }
+        let aligned: &[u8] =
+            unsafe { std::slice::from_raw_parts(words.as_ptr() as *const u8, bytes.len()) };
+
+        let view = MarketDataBatchView::from_archived(aligned).unwrap();
+        assert_eq!(view.get_count(), 2);
+        assert_eq!(view.get_instrument_ids(), &[1, 7]);
+        assert_eq!(view.get_bid_prices(), &[99.5, 49.0]);
+        assert_eq!(view.get_timestamps(), &[10, 11]);
+        if cfg!(target_endian = "little") {
+            assert!(matches!(view.bid_prices, Cow::Borrowed(_)));
+        }
+
+        // Misaligned input still decodes, by copying.
+        let mut shifted = vec![0u8];
+        shifted.extend_from_slice(aligned);
+        let copy = MarketDataBatchView::from_archived(&shifted[1..]).unwrap();
+        assert_eq!(copy.get_last_prices(), &[100.0, 50.0]);
+    }
+
+    #[test]
+    fn test_archived_rejects_truncated_input() {
+        let batch = MarketDataBatch::new(vec![PriceUpdate::new(1, 1.0, 2.0, 1.5, 0)]);
+        let mut bytes = Vec::new();
+        batch.archive_into(&mut bytes);
+        assert!(MarketDataBatchView::from_archived(&bytes[..bytes.len() - 1]).is_err());
+    }
+}
@@ -1,21 +1,27 @@
 pub mod allocation;
 pub mod allocation_batch;
 pub mod execution;
+pub mod execution_batch;
 pub mod identity;
 pub mod instrument;
 pub mod instrument_db;
 pub mod market_data;
 pub mod order;
+pub mod order_batch;
 pub mod policy;
 pub mod portfolio;
+pub mod positions;
 
 pub use allocation::Allocation;
-pub use execution::{ExecutionResult, ExecutionStatus};
+pub use execution::{ExecutionResult, ExecutionStatus, RejectReason};
+pub use execution_batch::ExecutionBatch;
 pub use identity::Identity;
 pub use instrument::Instrument;
 pub use instrument::InstrumentId;
 pub use instrument_db::InstrumentDB;
 pub use market_data::PriceUpdate;
-pub use order::{Order, OrderSide, OrderType};
+pub use order::{Order, OrderId, OrderSide, OrderType};
+pub use order_batch::OrderBatch;
 pub use policy::Policy;
-pub use portfolio::{Actual, Portfolio, Target};
+pub use portfolio::{Actual, CurrencyId, Portfolio, Target};
+pub use positions::Positions;
@@ -2,8 +2,21 @@
 //!
 //! Defines the structure of orders and their associated types (Side, Type).
 
+use crate::model::instrument::InstrumentId;
 use serde::{Deserialize, Serialize};
 
+/// Unique identifier of an order, assigned by the execution engine.
+pub type OrderId = u64;
+
+/// Returns the current wall-clock time in nanoseconds since the Unix epoch, the unit
+/// of order and execution timestamps.
+pub fn unix_nanos() -> u64 {
+    std::time::SystemTime::now()
+        .duration_since(std::time::UNIX_EPOCH)
+        .unwrap_or_default()
+        .as_nanos() as u64
+}
+
 /// Internal representation of the side of an order.
 #[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
 enum OrderSideInternal {
@@ -100,12 +113,14 @@ impl OrderType {
 }
 
 /// Represents a trading order to buy or sell an instrument.
-#[derive(Debug, Clone, PartialEq, Serialize, Deserialize)]
+///
+/// Fixed-size and `Copy`: orders move through the hot path without allocating.
+#[derive(Debug, Clone, Copy, PartialEq, Serialize, Deserialize)]
 pub struct Order {
     /// Unique identifier for the order.
-    id: String,
+    id: OrderId,
     /// Identifier for the instrument being traded.
-    instrument_id: String,
+    instrument_id: InstrumentId,
     /// Side of the order (Buy/Sell).
     side: OrderSide,
     /// Type of the order (Limit/Market/Stop).
@@ -114,8 +129,8 @@ pub struct Order {
     price: f64,
     /// Quantity to trade.
     quantity: f64,
-    /// Timestamp when the order was created (Unix timestamp).
-    timestamp: i64,
+    /// Timestamp when the order was created (unix nanos).
+    timestamp: u64,
 }
 
 impl Order {
@@ -129,23 +144,23 @@ impl Order {
     /// * `order_type` - Type of order (`Limit`, `Market`, etc.).
     /// * `price` - execution price (ignored for Market orders).
     /// * `quantity` - Quantity to trade.
-    /// * `timestamp` - Creation timestamp.
+    /// * `timestamp` - Creation timestamp (unix nanos).
     ///
     /// # Returns
     ///
     /// A new `Order` instance.
     pub fn new(
-        id: impl Into<String>,
-        instrument_id: impl Into<String>,
+        id: OrderId,
+        instrument_id: InstrumentId,
         side: OrderSide,
         order_type: OrderType,
         price: f64,
         quantity: f64,
-        timestamp: i64,
+        timestamp: u64,
     ) -> Self {
         Self {
-            id: id.into(),
-            instrument_id: instrument_id.into(),
+            id,
+            instrument_id,
             side,
             order_type,
             price,
@@ -154,12 +169,12 @@ impl Order {
         }
     }
 
-    pub fn get_id(&self) -> &str {
-        &self.id
+    pub fn get_id(&self) -> OrderId {
+        self.id
     }
 
-    pub fn get_instrument_id(&self) -> &str {
-        &self.instrument_id
+    pub fn get_instrument_id(&self) -> InstrumentId {
+        self.instrument_id
     }
 
     pub fn get_side(&self) -> OrderSide {
@@ -178,7 +193,7 @@ impl Order {
         self.quantity
     }
 
-    pub fn get_timestamp(&self) -> i64 {
+    pub fn get_timestamp(&self) -> u64 {
         self.timestamp
     }
 
@@ -0,0 +1,64 @@
+use serde::{Deserialize, Serialize};
+
+use crate::model::Order;
+
+/// Represents a batch of orders sent by the execution engine to a broker.
+/// A whole rebalance travels as one message instead of one per instrument.
+#[derive(Debug, Default, Clone, Serialize, Deserialize)]
+pub struct OrderBatch {
+    orders: Vec<Order>,
+}
+
+impl OrderBatch {
+    /// Creates a new OrderBatch.
+    pub fn new(orders: Vec<Order>) -> Self {
+        Self { orders }
+    }
+
+    pub fn get_orders(&self) -> &[Order] {
+        &self.orders
+    }
+
+    pub fn len(&self) -> usize {
+        self.orders.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.orders.is_empty()
+    }
+
+    /// Gives access to the underlying vector, to fill a batch that is reused.
+    pub fn orders_mut(&mut self) -> &mut Vec<Order> {
+        &mut self.orders
+    }
+
+    /// Empties the batch, keeping its allocation.
+    pub fn clear(&mut self) {
+        self.orders.clear();
+    }
+
+    pub fn iter(&self) -> std::slice::Iter<'_, Order> {
+        self.orders.iter()
+    }
+}
+
+impl From<Vec<Order>> for OrderBatch {
+    fn from(orders: Vec<Order>) -> Self {
+        Self::new(orders)
+    }
+}
+
+impl Into<Vec<Order>> for OrderBatch {
+    fn into(self) -> Vec<Order> {
+        self.orders
+    }
+}
+
+impl IntoIterator for OrderBatch {
+    type Item = Order;
+    type IntoIter = std::vec::IntoIter<Self::Item>;
+
+    fn into_iter(self) -> Self::IntoIter {
+        self.orders.into_iter()
+    }
+}
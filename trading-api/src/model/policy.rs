@@ -39,11 +39,11 @@ pub struct MaxQuantityPolicy {
 
 impl Policy for MaxQuantityPolicy {
     fn check(&self, portfolio: &Portfolio) -> Result<(), PolicyError> {
-        for (id, position) in &portfolio.positions {
+        for position in &portfolio.positions {
             if position.get_quantity().abs() > self.max_quantity {
                 return Err(PolicyError::ExposureViolation(format!(
                     "Position {} quantity {} exceeds limit {}",
-                    id,
+                    position.get_instrument_id(),
                     position.get_quantity(),
                     self.max_quantity
                 )));
@@ -1,13 +1,61 @@
 use crate::model::allocation::Position;
 use crate::model::instrument::InstrumentId;
+use crate::model::positions::Positions;
+use anyhow::{Result, bail};
 use serde::{Deserialize, Serialize};
-use std::collections::HashMap;
+use std::fmt;
+use std::sync::Arc;
+
+/// An interned currency code (e.g., "USD", "EUR", "USDT").
+///
+/// The ASCII code is packed into an integer, so ids are `Copy`, compare in one
+/// instruction, and mean the same thing in every process without a shared table.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, PartialOrd, Ord, Hash, Serialize, Deserialize)]
+pub struct CurrencyId(u64);
+
+impl CurrencyId {
+    /// Interns a currency code.
+    ///
+    /// # Arguments
+    ///
+    /// * `code` - The currency code, at most 8 ASCII bytes.
+    ///
+    /// # Returns
+    ///
+    /// `None` if `code` is longer than 8 bytes.
+    pub const fn new(code: &str) -> Option<Self> {
+        let bytes = code.as_bytes();
+        if bytes.len() > 8 {
+            return None;
+        }
+        let mut packed = [0u8; 8];
+        let mut i = 0;
+        while i < bytes.len() {
+            packed[i] = bytes[i];
+            i += 1;
+        }
+        Some(Self(u64::from_be_bytes(packed)))
+    }
+
+    /// Returns the currency code.
+    pub fn code(&self) -> String {
+        let packed = self.0.to_be_bytes();
+        let len = packed.iter().position(|b| *b == 0).unwrap_or(packed.len());
+        String::from_utf8_lossy(&packed[..len]).into_owned()
+    }
+}
+
+impl fmt::Display for CurrencyId {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.write_str(&self.code())
+    }
+}
 
 /// Represents a cash balance in a specific currency.
 #[derive(Debug, Clone, Serialize, Deserialize, PartialEq)]
 pub struct CashBalance {
-    /// The currency code (e.g., "USD", "EUR").
-    pub currency: String,
+    /// The currency of the balance.
+    pub currency: CurrencyId,
     /// The total amount of cash held.
     pub amount: f64,
     /// The amount of cash available for trading (after margin requirements, open orders, etc.).
@@ -15,9 +63,9 @@ pub struct CashBalance {
 }
 
 impl CashBalance {
-    pub fn new(currency: &str, amount: f64, available: f64) -> Self {
+    pub fn new(currency: CurrencyId, amount: f64, available: f64) -> Self {
         Self {
-            currency: currency.to_string(),
+            currency,
             amount,
             available,
         }
@@ -31,10 +79,10 @@ impl CashBalance {
 pub struct Portfolio {
     /// Timestamp of the portfolio state (unix millis).
     pub timestamp: u128,
-    /// Cash balances keyed by currency code.
-    pub cash: HashMap<String, CashBalance>,
-    /// Positions keyed by InstrumentId.
-    pub positions: HashMap<InstrumentId, Position>,
+    /// Cash balances, one per currency.
+    pub cash: Vec<CashBalance>,
+    /// Positions, sorted by InstrumentId.
+    pub positions: Positions,
     /// Total Net Asset Value (Equity) estimation in the base currency.
     pub total_equity: f64,
 }
@@ -46,8 +94,8 @@ impl Portfolio {
                 .duration_since(std::time::UNIX_EPOCH)
                 .unwrap_or_default()
                 .as_millis(),
-            cash: HashMap::new(),
-            positions: HashMap::new(),
+            cash: Vec::new(),
+            positions: Positions::new(),
             total_equity: 0.0,
         }
     }
@@ -57,28 +105,53 @@ impl Portfolio {
         self
     }
 
-    pub fn set_cash(&mut self, currency: &str, amount: f64) {
-        self.cash.insert(
-            currency.to_string(),
-            CashBalance::new(currency, amount, amount),
-        );
+    /// Sets the cash held in a currency, all of it available.
+    ///
+    /// # Returns
+    ///
+    /// * `Err` if `currency` is not a valid currency code.
+    pub fn set_cash(&mut self, currency: &str, amount: f64) -> Result<()> {
+        let Some(currency) = CurrencyId::new(currency) else {
+            bail!("Currency code '{}' is longer than 8 bytes", currency);
+        };
+        self.set_cash_by_id(currency, amount);
+        Ok(())
     }
 
-    pub fn update_position(&mut self, instrument_id: InstrumentId, quantity: f64) {
-        if quantity == 0.0 {
-            self.positions.remove(&instrument_id);
-        } else {
-            self.positions
-                .insert(instrument_id, Position::new(instrument_id, quantity));
+    /// Sets the cash held in a currency, all of it available.
+    pub fn set_cash_by_id(&mut self, currency: CurrencyId, amount: f64) {
+        self.set_cash_balance(CashBalance::new(currency, amount, amount));
+    }
+
+    /// Stores a cash balance, replacing the previous balance in the same currency.
+    pub fn set_cash_balance(&mut self, balance: CashBalance) {
+        match self
+            .cash
+            .iter_mut()
+            .find(|c| c.currency == balance.currency)
+        {
+            Some(existing) => *existing = balance,
+            None => self.cash.push(balance),
         }
     }
 
+    pub fn update_position(&mut self, instrument_id: InstrumentId, quantity: f64) {
+        self.positions.set(instrument_id, quantity);
+    }
+
     pub fn get_position(&self, instrument_id: &InstrumentId) -> Option<&Position> {
-        self.positions.get(instrument_id)
+        self.positions.get(*instrument_id)
     }
 
+    /// Returns the balance in a currency, `None` if there is none or `currency` is
+    /// not a valid currency code.
     pub fn get_cash(&self, currency: &str) -> Option<&CashBalance> {
-        self.cash.get(currency)
+        self.get_cash_by_id(CurrencyId::new(currency)?)
+    }
+
+    pub fn get_cash_by_id(&self, currency: CurrencyId) -> Option<&CashBalance> {
+        // A portfolio holds a handful of currencies; a scan beats hashing.
+        self.cash.iter().find(|c| c.currency == currency)
     }
 }
 
@@ -89,5 +162,32 @@ pub struct Actual(pub Portfolio);
 
 /// NewType wrapper representing the TARGET state of the portfolio.
 /// This is generated by the Portfolio Manager (Policy Checks/Optimization).
+///
+/// The portfolio is shared, so the manager can publish its current target without
+/// copying it; it is serialized as a plain `Portfolio`.
 #[derive(Debug, Clone, Serialize, Deserialize)]
-pub struct Target(pub Portfolio);
+pub struct Target(pub Arc<Portfolio>);
+
+impl Target {
+    pub fn new(portfolio: Portfolio) -> Self {
+        Self(Arc::new(portfolio))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_invalid_currency_codes_are_rejected() {
+        let mut portfolio = Portfolio::new();
+        portfolio.set_cash("USD", 100.0).unwrap();
+        assert_eq!(portfolio.get_cash("USD").unwrap().amount, 100.0);
+        assert_eq!(CurrencyId::new("USD").unwrap().code(), "USD");
+
+        assert!(CurrencyId::new("SOMELONGCODE").is_none());
+        assert!(portfolio.get_cash("SOMELONGCODE").is_none());
+        assert!(portfolio.set_cash("SOMELONGCODE", 1.0).is_err());
+        assert_eq!(portfolio.cash.len(), 1);
+    }
+}
@@ -0,0 +1,201 @@
+//! Compact storage for the positions of a `Portfolio` or an `Allocation`.
+//!
+//! Positions are kept in a vector sorted by `InstrumentId`, without the hashing and
+//! per-bucket overhead of a map. Lookups are a binary search, iteration is a linear
+//! scan in instrument order, and two position sets can be walked side by side. On the
+//! wire the set is a plain sequence, so a target over hundreds of instruments costs
+//! 16 bytes per position.
+
+use crate::model::allocation::Position;
+use crate::model::instrument::InstrumentId;
+use serde::{Deserialize, Deserializer, Serialize, Serializer};
+
+/// A set of non-zero positions, sorted by instrument.
+#[derive(Debug, Default, Clone, PartialEq)]
+pub struct Positions {
+    entries: Vec<Position>,
+}
+
+impl Positions {
+    /// Creates an empty position set.
+    pub fn new() -> Self {
+        Self {
+            entries: Vec::new(),
+        }
+    }
+
+    /// Creates an empty position set with room for `capacity` instruments.
+    pub fn with_capacity(capacity: usize) -> Self {
+        Self {
+            entries: Vec::with_capacity(capacity),
+        }
+    }
+
+    /// Returns the number of instruments held.
+    pub fn len(&self) -> usize {
+        self.entries.len()
+    }
+
+    /// Returns whether no instrument is held.
+    pub fn is_empty(&self) -> bool {
+        self.entries.is_empty()
+    }
+
+    /// Removes every position, keeping the allocated storage.
+    pub fn clear(&mut self) {
+        self.entries.clear();
+    }
+
+    /// Retrieves the position in an instrument.
+    ///
+    /// # Arguments
+    ///
+    /// * `instrument_id` - The unique identifier of the instrument.
+    ///
+    /// # Returns
+    ///
+    /// `Some(&Position)` if held, or `None` if not present.
+    pub fn get(&self, instrument_id: InstrumentId) -> Option<&Position> {
+        self.find(instrument_id).ok().map(|i| &self.entries[i])
+    }
+
+    /// Returns the quantity held in an instrument, `0.0` if not present.
+    pub fn quantity(&self, instrument_id: InstrumentId) -> f64 {
+        self.get(instrument_id).map_or(0.0, |p| p.get_quantity())
+    }
+
+    /// Returns whether the instrument is held.
+    pub fn contains(&self, instrument_id: InstrumentId) -> bool {
+        self.find(instrument_id).is_ok()
+    }
+
+    /// Sets the quantity held in an instrument.
+    ///
+    /// If the quantity is 0.0, the position is removed. Setting instruments in
+    /// increasing id order only ever appends.
+    ///
+    /// # Arguments
+    ///
+    /// * `instrument_id` - The unique identifier of the instrument.
+    /// * `quantity` - The new quantity.
+    pub fn set(&mut self, instrument_id: InstrumentId, quantity: f64) {
+        match (self.find(instrument_id), quantity == 0.0) {
+            (Ok(i), true) => {
+                self.entries.remove(i);
+            }
+            (Ok(i), false) => self.entries[i].set_quantity(quantity),
+            (Err(_), true) => {}
+            (Err(i), false) => self
+                .entries
+                .insert(i, Position::new(instrument_id, quantity)),
+        }
+    }
+
+    /// Adds `delta` to the quantity held in an instrument.
+    ///
+    /// # Returns
+    ///
+    /// The new quantity.
+    pub fn add(&mut self, instrument_id: InstrumentId, delta: f64) -> f64 {
+        let quantity = self.quantity(instrument_id) + delta;
+        self.set(instrument_id, quantity);
+        quantity
+    }
+
+    /// Keeps only the positions for which `keep` returns true.
+    pub fn retain(&mut self, keep: impl FnMut(&Position) -> bool) {
+        self.entries.retain(keep);
+    }
+
+    /// Returns an iterator over the positions, in instrument order.
+    pub fn iter(&self) -> std::slice::Iter<'_, Position> {
+        self.entries.iter()
+    }
+
+    /// Returns the positions as a slice sorted by instrument.
+    pub fn as_slice(&self) -> &[Position] {
+        &self.entries
+    }
+
+    fn find(&self, instrument_id: InstrumentId) -> Result<usize, usize> {
+        // Appending in id order is the common case; skip the search for it.
+        match self.entries.last() {
+            None => Err(0),
+            Some(last) if last.get_instrument_id() < instrument_id => Err(self.entries.len()),
+            _ => self
+                .entries
+                .binary_search_by_key(&instrument_id, |p| p.get_instrument_id()),
+        }
+    }
+}
+
+impl<'a> IntoIterator for &'a Positions {
+    type Item = &'a Position;
+    type IntoIter = std::slice::Iter<'a, Position>;
+
+    fn into_iter(self) -> Self::IntoIter {
+        self.entries.iter()
+    }
+}
+
+impl From<Vec<Position>> for Positions {
+    /// Builds a set from positions in any order; a later duplicate wins.
+    fn from(mut entries: Vec<Position>) -> Self {
+        entries.reverse();
+        entries.sort_by_key(|p| p.get_instrument_id());
+        entries.dedup_by_key(|p| p.get_instrument_id());
+        entries.retain(|p| p.get_quantity() != 0.0);
+        Self { entries }
+    }
+}
+
+impl Serialize for Positions {
+    fn serialize<S: Serializer>(&self, serializer: S) -> Result<S::Ok, S::Error> {
+        self.entries.serialize(serializer)
+    }
+}
+
+impl<'de> Deserialize<'de> for Positions {
+    fn deserialize<D: Deserializer<'de>>(deserializer: D) -> Result<Self, D::Error> {
+        let entries = Vec::<Position>::deserialize(deserializer)?;
+        // Peers always send sorted sets; only repair the order if one did not.
+        if entries
+            .windows(2)
+            .all(|w| w[0].get_instrument_id() < w[1].get_instrument_id())
+        {
+            Ok(Self { entries })
+        } else {
+            Ok(Self::from(entries))
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_positions_stay_sorted() {
+        let mut positions = Positions::new();
+        positions.set(7, 1.0);
+        positions.set(2, 3.0);
+        positions.set(5, -2.0);
+        positions.add(2, 1.0);
+        positions.set(7, 0.0);
+
+        let ids: Vec<InstrumentId> = positions.iter().map(|p| p.get_instrument_id()).collect();
+        assert_eq!(ids, vec![2, 5]);
+        assert_eq!(positions.quantity(2), 4.0);
+        assert_eq!(positions.quantity(7), 0.0);
+
+        let unsorted = Positions::from(vec![
+            Position::new(3, 1.0),
+            Position::new(1, 2.0),
+            Position::new(3, 5.0),
+        ]);
+        assert_eq!(
+            unsorted.as_slice(),
+            &[Position::new(1, 2.0), Position::new(3, 5.0)]
+        );
+    }
+}
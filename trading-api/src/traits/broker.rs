@@ -1,4 +1,7 @@
-use crate::model::{execution::ExecutionResult, order::Order, portfolio::Actual};
+use crate::model::{
+    execution::ExecutionResult, execution_batch::ExecutionBatch, market_data::MarketDataBatchView,
+    order::Order, order_batch::OrderBatch, portfolio::Actual,
+};
 
 pub trait Broker: Send {
     /// Called when the Broker Gateway receives an order.
@@ -11,10 +14,77 @@ pub trait Broker: Send {
     ///
     /// * `(Vec<ExecutionResult>, Option<Actual>)` - A list of execution results and an optional portfolio update to publish.
     fn on_order(&mut self, order: Order) -> (Vec<ExecutionResult>, Option<Actual>);
+
+    /// Called when the Broker Gateway receives a batch of orders.
+    ///
+    /// The default forwards each order to `on_order` and keeps only the last
+    /// portfolio update, so a batch yields at most one snapshot.
+    ///
+    /// # Arguments
+    ///
+    /// * `batch` - The orders to process.
+    ///
+    /// # Returns
+    ///
+    /// * `(ExecutionBatch, Option<Actual>)` - The execution results of the whole batch and an optional portfolio update to publish.
+    fn on_orders(&mut self, batch: OrderBatch) -> (ExecutionBatch, Option<Actual>) {
+        let mut executions = Vec::with_capacity(batch.len());
+        let mut portfolio_update = None;
+        for order in batch {
+            let (results, update) = self.on_order(order);
+            executions.extend(results);
+            if update.is_some() {
+                portfolio_update = update;
+            }
+        }
+        (ExecutionBatch::new(executions), portfolio_update)
+    }
+
+    /// Called when the Broker Gateway receives market data, for brokers that
+    /// simulate matching (e.g. a paper broker filling resting orders).
+    ///
+    /// The default ignores it.
+    ///
+    /// # Arguments
+    ///
+    /// * `md` - The quotes of the batch.
+    ///
+    /// # Returns
+    ///
+    /// * `(ExecutionBatch, Option<Actual>)` - The fills the quotes triggered and an optional portfolio update to publish.
+    fn on_market_data(&mut self, md: MarketDataBatchView<'_>) -> (ExecutionBatch, Option<Actual>) {
+        let _ = md;
+        (ExecutionBatch::new(Vec::new()), None)
+    }
+
+    /// Called periodically by the Broker Gateway, input or not, so that a portfolio
+    /// update held back (e.g. by a snapshot rate limit) still goes out once the
+    /// flow goes quiet.
+    ///
+    /// The default has nothing to flush.
+    ///
+    /// # Returns
+    ///
+    /// * `Option<Actual>` - A portfolio update to publish.
+    fn flush(&mut self) -> Option<Actual> {
+        None
+    }
 }
 
 impl Broker for Box<dyn Broker> {
     fn on_order(&mut self, order: Order) -> (Vec<ExecutionResult>, Option<Actual>) {
         (**self).on_order(order)
     }
+
+    fn on_orders(&mut self, batch: OrderBatch) -> (ExecutionBatch, Option<Actual>) {
+        (**self).on_orders(batch)
+    }
+
+    fn on_market_data(&mut self, md: MarketDataBatchView<'_>) -> (ExecutionBatch, Option<Actual>) {
+        (**self).on_market_data(md)
+    }
+
+    fn flush(&mut self) -> Option<Actual> {
+        (**self).flush()
+    }
 }
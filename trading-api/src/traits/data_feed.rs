@@ -6,12 +6,130 @@
 //! of `MarketDataBatch` to downstream strategies.
 
 use crate::model::market_data::MarketDataBatch;
+use anyhow::{Result, bail};
+use std::sync::Arc;
+use std::time::Duration;
+
+/// How the feeder paces its calls to `DataFeed::get_market_data` in poll mode.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum Pacing {
+    /// Poll again as soon as a batch is published, for backtests at full throughput.
+    ///
+    /// When the feed returns `None` the feeder backs off for a millisecond.
+    AsFastAsPossible,
+
+    /// Poll once per interval.
+    FixedRate(Duration),
+
+    /// Publish each batch when its timestamp comes due, replaying the recorded gaps.
+    ReplayClock {
+        /// Wall-clock length of one timestamp unit (e.g. 1s for Unix seconds).
+        tick: Duration,
+        /// Replay speed multiplier (`2.0` replays twice as fast as recorded).
+        speed: f64,
+    },
+}
+
+impl Pacing {
+    /// Creates a `ReplayClock` pacing.
+    ///
+    /// # Arguments
+    ///
+    /// * `tick` - Wall-clock length of one timestamp unit.
+    /// * `speed` - Replay speed multiplier.
+    ///
+    /// # Returns
+    ///
+    /// * `Ok(Pacing)` for a finite, positive speed.
+    /// * `Err` otherwise.
+    pub fn replay_clock(tick: Duration, speed: f64) -> Result<Self> {
+        if !speed.is_finite() || speed <= 0.0 {
+            bail!(
+                "Replay speed must be a finite, positive factor, got {}",
+                speed
+            );
+        }
+        Ok(Pacing::ReplayClock { tick, speed })
+    }
+}
+
+impl Default for Pacing {
+    fn default() -> Self {
+        Pacing::FixedRate(Duration::from_millis(50))
+    }
+}
+
+/// What the feeder does with a batch pushed while its queue is full.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum Overflow {
+    /// Block the pushing thread until the publisher makes room: no batch is lost.
+    #[default]
+    Block,
+
+    /// Fold the oldest queued batch into the next one, keeping the latest price of
+    /// every instrument: the feed never waits, intermediate ticks are lost.
+    ConflateOldest,
+}
+
+/// How the feeder queues the batches of a push-mode feed until they are published.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct PushQueue {
+    /// Batches queued at most, at least 1.
+    pub capacity: usize,
+    /// What to do with a batch pushed while `capacity` batches are queued.
+    pub overflow: Overflow,
+}
+
+impl Default for PushQueue {
+    fn default() -> Self {
+        Self {
+            capacity: 1024,
+            overflow: Overflow::Block,
+        }
+    }
+}
+
+/// Handle through which a push-mode feed publishes batches the moment they arrive.
+///
+/// The sink is cheap to clone and may be moved to the adapter's own threads.
+#[derive(Clone)]
+pub struct MarketDataSink {
+    push: Arc<dyn Fn(MarketDataBatch) -> bool + Send + Sync>,
+}
+
+impl MarketDataSink {
+    /// Creates a sink from the function that forwards batches to the publisher.
+    ///
+    /// # Arguments
+    ///
+    /// * `push` - Forwards one batch, returning `false` once the receiving side is gone.
+    pub fn new(push: impl Fn(MarketDataBatch) -> bool + Send + Sync + 'static) -> Self {
+        Self {
+            push: Arc::new(push),
+        }
+    }
+
+    /// Publishes a batch.
+    ///
+    /// # Returns
+    ///
+    /// * `true` if the batch was queued for publication.
+    /// * `false` if the feeder has stopped: the feed should stop pushing.
+    ///
+    /// With `Overflow::Block`, waits while the queue of the feeder is full.
+    pub fn push(&self, batch: MarketDataBatch) -> bool {
+        (self.push)(batch)
+    }
+}
 
 /// A trait for components that produce market data.
 ///
 /// Implementors of this trait are responsible for fetching, parsing, and normalizing
 /// market data updates into the standard `MarketDataBatch` format.
 ///
+/// A feed is either polled (`get_market_data`, paced by `pacing`) or, when
+/// `start_push` accepts the sink, pushes batches itself as they arrive.
+///
 /// # Examples
 ///
 /// ```
@@ -38,4 +156,35 @@ pub trait DataFeed {
     ///
     /// * `Option<MarketDataBatch>` - A batch of market updates, or None.
     fn get_market_data(&mut self) -> Option<MarketDataBatch>;
+
+    /// Returns how the feeder should pace `get_market_data` calls in poll mode.
+    ///
+    /// Defaults to polling every 50ms.
+    fn pacing(&self) -> Pacing {
+        Pacing::default()
+    }
+
+    /// Offers the feed a sink to push batches into, instead of being polled.
+    ///
+    /// Called once when the feeder starts. A live adapter keeps the sink (typically
+    /// moving it to its receive thread) and returns `true`; the feeder then never
+    /// calls `get_market_data`.
+    ///
+    /// # Arguments
+    ///
+    /// * `sink` - Publishes a batch immediately.
+    ///
+    /// # Returns
+    ///
+    /// * `true` if the feed will push, `false` (the default) to be polled.
+    fn start_push(&mut self, _sink: MarketDataSink) -> bool {
+        false
+    }
+
+    /// Returns how the feeder queues pushed batches, in push mode.
+    ///
+    /// Defaults to 1024 batches, blocking the pushing thread when full.
+    fn push_queue(&self) -> PushQueue {
+        PushQueue::default()
+    }
 }
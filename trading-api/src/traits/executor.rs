@@ -1,5 +1,6 @@
 use crate::model::{
     execution::ExecutionResult,
+    execution_batch::ExecutionBatch,
     order::Order,
     portfolio::{Actual, Target},
 };
@@ -26,6 +27,72 @@ pub trait Executor: Send {
     ///
     /// * `(Vec<Order>, Option<Actual>)` - A list of orders to execute and an optional portfolio update to publish.
     fn on_execution(&mut self, execution: ExecutionResult) -> (Vec<Order>, Option<Actual>);
+
+    /// Like `on_target`, but appends the orders to a buffer owned by the caller.
+    ///
+    /// Executors on the hot path override this so the buffer is reused across
+    /// targets; the default forwards to `on_target`.
+    ///
+    /// # Arguments
+    ///
+    /// * `target` - The target portfolio.
+    /// * `orders` - Buffer the orders to execute are appended to.
+    ///
+    /// # Returns
+    ///
+    /// * `Option<Actual>` - An optional portfolio update to publish.
+    fn on_target_into(&mut self, target: Target, orders: &mut Vec<Order>) -> Option<Actual> {
+        let (new_orders, actual) = self.on_target(target);
+        orders.extend(new_orders);
+        actual
+    }
+
+    /// Like `on_execution`, but appends the orders to a buffer owned by the caller.
+    ///
+    /// # Arguments
+    ///
+    /// * `execution` - The execution result.
+    /// * `orders` - Buffer the orders to execute are appended to.
+    ///
+    /// # Returns
+    ///
+    /// * `Option<Actual>` - An optional portfolio update to publish.
+    fn on_execution_into(
+        &mut self,
+        execution: ExecutionResult,
+        orders: &mut Vec<Order>,
+    ) -> Option<Actual> {
+        let (new_orders, actual) = self.on_execution(execution);
+        orders.extend(new_orders);
+        actual
+    }
+
+    /// Called when the Execution Engine receives a batch of execution results.
+    ///
+    /// The default forwards each result to `on_execution_into` and keeps only the
+    /// last portfolio update.
+    ///
+    /// # Arguments
+    ///
+    /// * `batch` - The execution results.
+    /// * `orders` - Buffer the orders to execute are appended to.
+    ///
+    /// # Returns
+    ///
+    /// * `Option<Actual>` - An optional portfolio update to publish.
+    fn on_executions_into(
+        &mut self,
+        batch: ExecutionBatch,
+        orders: &mut Vec<Order>,
+    ) -> Option<Actual> {
+        let mut portfolio_update = None;
+        for execution in batch {
+            if let Some(update) = self.on_execution_into(execution, orders) {
+                portfolio_update = Some(update);
+            }
+        }
+        portfolio_update
+    }
 }
 
 impl Executor for Box<dyn Executor> {
@@ -36,4 +103,24 @@ impl Executor for Box<dyn Executor> {
     fn on_execution(&mut self, execution: ExecutionResult) -> (Vec<Order>, Option<Actual>) {
         (**self).on_execution(execution)
     }
+
+    fn on_target_into(&mut self, target: Target, orders: &mut Vec<Order>) -> Option<Actual> {
+        (**self).on_target_into(target, orders)
+    }
+
+    fn on_execution_into(
+        &mut self,
+        execution: ExecutionResult,
+        orders: &mut Vec<Order>,
+    ) -> Option<Actual> {
+        (**self).on_execution_into(execution, orders)
+    }
+
+    fn on_executions_into(
+        &mut self,
+        batch: ExecutionBatch,
+        orders: &mut Vec<Order>,
+    ) -> Option<Actual> {
+        (**self).on_executions_into(batch, orders)
+    }
 }
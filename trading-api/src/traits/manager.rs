@@ -1,6 +1,6 @@
 use crate::model::{
     allocation_batch::AllocationBatch,
-    market_data::PriceUpdate,
+    market_data::{MarketDataBatch, PriceUpdate},
     portfolio::{Actual, Target},
 };
 
@@ -37,6 +37,25 @@ pub trait Manager: Send {
     ///
     /// * `Option<Target>` - An optional target portfolio to publish.
     fn on_market_data(&mut self, market_data: PriceUpdate) -> Option<Target>;
+
+    /// Called when the Portfolio Manager receives a market data batch.
+    ///
+    /// Every target is a full snapshot, so by default each update goes through
+    /// `on_market_data` and only the last target produced is kept.
+    ///
+    /// # Arguments
+    ///
+    /// * `batch` - The price updates, possibly conflated to the latest per instrument.
+    ///
+    /// # Returns
+    ///
+    /// * `Option<Target>` - An optional target portfolio to publish.
+    fn on_market_data_batch(&mut self, batch: MarketDataBatch) -> Option<Target> {
+        batch
+            .iter()
+            .filter_map(|update| self.on_market_data(update))
+            .last()
+    }
 }
 
 impl Manager for Box<dyn Manager> {
@@ -51,4 +70,8 @@ impl Manager for Box<dyn Manager> {
     fn on_market_data(&mut self, market_data: PriceUpdate) -> Option<Target> {
         (**self).on_market_data(market_data)
     }
+
+    fn on_market_data_batch(&mut self, batch: MarketDataBatch) -> Option<Target> {
+        (**self).on_market_data_batch(batch)
+    }
 }
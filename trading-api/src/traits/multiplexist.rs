@@ -10,7 +10,8 @@ pub trait Multiplexist: Send {
     ///
     /// # Returns
     ///
-    /// * `AllocationBatch` - The aggregated allocation batch.
+    /// * `AllocationBatch` - The aggregated allocation batch. It reflects every source
+    ///   seen so far and supersedes any batch returned before it.
     fn on_allocation_batch(&mut self, source_id: Id, batch: AllocationBatch) -> AllocationBatch;
 }
 
@@ -1,4 +1,7 @@
-use crate::model::{allocation_batch::AllocationBatch, market_data::MarketDataBatch};
+use crate::model::{
+    allocation_batch::AllocationBatch,
+    market_data::{MarketDataBatch, MarketDataBatchView},
+};
 
 pub trait Strategist: Send {
     /// Called when the Strategy receives a batch of market data updates.
@@ -11,10 +14,46 @@ pub trait Strategist: Send {
     ///
     /// * `AllocationBatch` - The batch of allocations.
     fn on_market_data(&mut self, md: MarketDataBatch) -> AllocationBatch;
+
+    /// Called with a batch read in place from the receive buffer.
+    ///
+    /// Override this to work on the borrowed `&[f64]` columns directly; the default
+    /// copies the view into an owned batch and calls `on_market_data`.
+    ///
+    /// # Arguments
+    ///
+    /// * `md` - A view over the batch of updates.
+    ///
+    /// # Returns
+    ///
+    /// * `AllocationBatch` - The batch of allocations.
+    fn on_market_data_view(&mut self, md: MarketDataBatchView<'_>) -> AllocationBatch {
+        self.on_market_data(md.into_owned())
+    }
+
+    /// Hands back a batch returned by `on_market_data_view` once it is published.
+    ///
+    /// Override this to keep the batch and refill its buffers on the next call; the
+    /// default drops it.
+    ///
+    /// # Arguments
+    ///
+    /// * `batch` - The published batch of allocations.
+    fn recycle(&mut self, batch: AllocationBatch) {
+        let _ = batch;
+    }
 }
 
 impl Strategist for Box<dyn Strategist> {
     fn on_market_data(&mut self, md: MarketDataBatch) -> AllocationBatch {
         (**self).on_market_data(md)
     }
+
+    fn on_market_data_view(&mut self, md: MarketDataBatchView<'_>) -> AllocationBatch {
+        (**self).on_market_data_view(md)
+    }
+
+    fn recycle(&mut self, batch: AllocationBatch) {
+        (**self).recycle(batch)
+    }
 }
@@ -0,0 +1,90 @@
+//! Encoding and decoding of the hot-path packets at varying universe sizes.
+
+use anyhow::Result;
+use trading::model::allocation::Allocation;
+use trading::model::allocation_batch::AllocationBatch;
+use trading::model::market_data::{MarketDataBatch, MarketDataBatchView, PriceUpdate};
+use trading::model::portfolio::{Portfolio, Target};
+use trading_core::bench::Bench;
+use trading_core::comms::Packet;
+
+const UNIVERSES: [usize; 3] = [16, 256, 4096];
+
+fn market_data(universe: usize) -> MarketDataBatch {
+    MarketDataBatch::new(
+        (0..universe)
+            .map(|id| {
+                let price = 100.0 + id as f64;
+                PriceUpdate::new(id, price, price - 0.01, price + 0.01, id as u64)
+            })
+            .collect(),
+    )
+}
+
+/// One allocation per strategy of 16, each holding the whole universe.
+fn allocations(universe: usize) -> AllocationBatch {
+    AllocationBatch::new(
+        (0..16)
+            .map(|strategy| {
+                let mut allocation = Allocation::new();
+                for id in 0..universe {
+                    allocation.update_position(id, (strategy + id) as f64 + 1.0);
+                }
+                allocation
+            })
+            .collect(),
+    )
+}
+
+fn target(universe: usize) -> Target {
+    let mut portfolio = Portfolio::new();
+    for id in 0..universe {
+        portfolio.update_position(id, id as f64 + 1.0);
+    }
+    Target::new(portfolio)
+}
+
+fn main() -> Result<()> {
+    let mut bench = Bench::new("codec")?;
+    let mut buffer = Vec::new();
+
+    for universe in UNIVERSES {
+        let batch = market_data(universe);
+        bench.run(&format!("market_data/encode/{}", universe), || {
+            buffer.clear();
+            bincode::serialize_into(&mut buffer, &Packet::new(1, &batch)).unwrap();
+        })?;
+        let frame = bincode::serialize(&Packet::new(1, &batch))?;
+        bench.run(&format!("market_data/decode/{}", universe), || {
+            Packet::<MarketDataBatch>::decode(&frame).unwrap()
+        })?;
+        bench.run(&format!("market_data/decode_view/{}", universe), || {
+            Packet::<MarketDataBatchView<'_>>::decode(&frame)
+                .unwrap()
+                .data()
+                .get_count()
+        })?;
+
+        let batch = allocations(universe);
+        bench.run(&format!("allocation_batch/encode/{}", universe), || {
+            buffer.clear();
+            bincode::serialize_into(&mut buffer, &Packet::new(1, &batch)).unwrap();
+        })?;
+        let frame = bincode::serialize(&Packet::new(1, &batch))?;
+        bench.run(&format!("allocation_batch/decode/{}", universe), || {
+            Packet::<AllocationBatch>::decode(&frame).unwrap()
+        })?;
+
+        let target = target(universe);
+        bench.run(&format!("target/encode/{}", universe), || {
+            buffer.clear();
+            bincode::serialize_into(&mut buffer, &Packet::new(1, &target)).unwrap();
+        })?;
+        let frame = bincode::serialize(&Packet::new(1, &target))?;
+        bench.run(&format!("target/decode/{}", universe), || {
+            Packet::<Target>::decode(&frame).unwrap()
+        })?;
+    }
+
+    bench.finish()
+}
@@ -0,0 +1,108 @@
+//! Send-to-receive hops of typed sockets over every transport.
+//!
+//! Each iteration sends one batch and receives it on the same thread, so a case
+//! measures encode, transport and decode of one hop with no queueing.
+
+use anyhow::{bail, Result};
+use std::time::{Duration, Instant};
+use tokio::runtime::Runtime;
+use tokio::sync::mpsc;
+use trading::model::market_data::{MarketDataBatch, PriceUpdate};
+use trading_core::bench::Bench;
+use trading_core::comms::transports::memory::{MemoryTransportInput, MemoryTransportOutput};
+use trading_core::comms::{
+    build_publisher, build_subscriber, Address, ReceiverSocket, SenderSocket,
+};
+
+const UNIVERSES: [usize; 2] = [16, 4096];
+
+fn market_data(universe: usize) -> MarketDataBatch {
+    MarketDataBatch::new(
+        (0..universe)
+            .map(|id| PriceUpdate::new(id, 100.0, 99.99, 100.01, id as u64))
+            .collect(),
+    )
+}
+
+/// Sends until the receiver gets a message, then drains the probes in flight.
+///
+/// Subscribers may join a publisher late and miss the first messages.
+async fn handshake(
+    sender: &mut SenderSocket<MarketDataBatch>,
+    receiver: &mut ReceiverSocket<MarketDataBatch>,
+) -> Result<()> {
+    let probe = market_data(1);
+    let started = Instant::now();
+    loop {
+        sender.send_ref(&probe).await?;
+        tokio::time::sleep(Duration::from_millis(1)).await;
+        if receiver.try_recv().await.is_ok() {
+            break;
+        }
+        if started.elapsed() > Duration::from_secs(5) {
+            bail!("No message went through after 5s");
+        }
+    }
+    tokio::time::sleep(Duration::from_millis(10)).await;
+    while receiver.try_recv().await.is_ok() {}
+    Ok(())
+}
+
+fn sockets(
+    runtime: &Runtime,
+    transport: &str,
+    case: usize,
+) -> Result<(
+    SenderSocket<MarketDataBatch>,
+    ReceiverSocket<MarketDataBatch>,
+)> {
+    let pid = std::process::id();
+    let address = match transport {
+        "memory" => {
+            let (tx, rx) = mpsc::channel(1024);
+            return Ok((
+                SenderSocket::new(Box::new(MemoryTransportOutput::new(tx)), 1),
+                ReceiverSocket::new(Box::new(MemoryTransportInput::new(rx))),
+            ));
+        }
+        "shm" => Address::shm(&format!("bench-{}-{}", pid, case)),
+        "zmq_inproc" => Address::Zmq(format!("inproc://bench-{}", case)),
+        "zmq_ipc" => Address::Zmq(format!("ipc:///tmp/bench-{}-{}.ipc", pid, case)),
+        "zmq_tcp" => Address::zmq_tcp("127.0.0.1", 47100 + case as u16),
+        _ => bail!("Unknown transport {}", transport),
+    };
+    // Bound/created before the subscriber joins.
+    let mut sender = build_publisher(&address, 1)?;
+    let mut receiver = build_subscriber(&address)?;
+    runtime.block_on(handshake(&mut sender, &mut receiver))?;
+    Ok((sender, receiver))
+}
+
+fn main() -> Result<()> {
+    let mut bench = Bench::new("sockets")?;
+    let runtime = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()?;
+
+    let transports = ["memory", "shm", "zmq_inproc", "zmq_ipc", "zmq_tcp"];
+    let mut case = 0;
+    for transport in transports {
+        for universe in UNIVERSES {
+            case += 1;
+            let name = format!("{}/hop/{}", transport, universe);
+            if !bench.selected(&name) {
+                continue;
+            }
+            let (mut sender, mut receiver) = sockets(&runtime, transport, case)?;
+            let batch = market_data(universe);
+            bench.run(&name, || {
+                runtime.block_on(async {
+                    sender.send_ref(&batch).await.unwrap();
+                    receiver.recv().await.unwrap().data().get_count()
+                })
+            })?;
+        }
+    }
+
+    bench.finish()
+}
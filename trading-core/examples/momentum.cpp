@@ -0,0 +1,37 @@
+// A C++ strategy on top of trading_core.hpp: targets one unit of every
+// instrument whose last price is above its mid.
+//
+//     cmake -S trading-core -B build && cmake --build build
+//
+// The binary takes the command line of any Strategy service.
+
+#include <trading_core.hpp>
+
+#include <vector>
+
+struct Momentum {
+    std::vector<trading_core::InstrumentId> ids;
+    std::vector<double> quantities;
+
+    void on_market_data(const trading_core::MarketData& md,
+                        trading_core::AllocationWriter& allocation) {
+        ids.clear();
+        quantities.clear();
+        auto instruments = md.instrument_ids();
+        auto bids = md.bid_prices();
+        auto asks = md.ask_prices();
+        auto lasts = md.last_prices();
+        for (std::size_t i = 0; i < md.size(); ++i) {
+            if (lasts[i] > (bids[i] + asks[i]) / 2) {
+                ids.push_back(instruments[i]);
+                quantities.push_back(1.0);
+            }
+        }
+        allocation.set(ids, quantities);
+    }
+};
+
+int main() {
+    Momentum strategy;
+    return trading_core::run_strategy(strategy, "1.0.0", "Momentum");
+}
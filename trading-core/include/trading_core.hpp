@@ -0,0 +1,134 @@
+// C++ API of trading-core.
+//
+// A C++ strategy runs as a regular Strategy service: the Rust runner owns the
+// bindings, transports and admin port, and calls back into C++ with the columns
+// of every market data batch. The columns are borrowed for the duration of the
+// call, and targets are written into the runner's own, pre-sized allocation.
+//
+//     struct Momentum {
+//         std::vector<std::size_t> ids;
+//         std::vector<double> quantities;
+//
+//         void on_market_data(const trading_core::MarketData& md,
+//                             trading_core::AllocationWriter& allocation) {
+//             ...
+//             allocation.set(ids, quantities);
+//         }
+//     };
+//
+//     int main() {
+//         Momentum strategy;
+//         return trading_core::run_strategy(strategy, "1.0.0", "Momentum");
+//     }
+//
+// `on_market_data` is called from the runner thread, one batch at a time.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+extern "C" {
+
+struct TradingCoreMarketDataColumns {
+    std::size_t len;
+    const std::size_t* instrument_ids;
+    const double* bid_prices;
+    const double* ask_prices;
+    const double* last_prices;
+    const std::uint64_t* timestamps;
+};
+
+struct AllocationWriter;
+
+typedef void (*TradingCoreMarketDataCallback)(void* user_data,
+                                              const TradingCoreMarketDataColumns* md,
+                                              AllocationWriter* allocation);
+
+void trading_core_allocation_set(AllocationWriter* allocation, std::size_t instrument_id,
+                                 double quantity);
+
+void trading_core_allocation_set_many(AllocationWriter* allocation,
+                                      const std::size_t* instrument_ids,
+                                      const double* quantities, std::size_t len);
+
+int trading_core_run_strategy(TradingCoreMarketDataCallback callback, void* user_data,
+                              const char* version, const char* description);
+}
+
+namespace trading_core {
+
+using InstrumentId = std::size_t;
+
+/// A market data batch, as columns borrowed from the runner.
+class MarketData {
+public:
+    explicit MarketData(const TradingCoreMarketDataColumns& columns) : columns_(columns) {}
+
+    std::size_t size() const { return columns_.len; }
+    bool empty() const { return columns_.len == 0; }
+
+    std::span<const InstrumentId> instrument_ids() const {
+        return {columns_.instrument_ids, columns_.len};
+    }
+    std::span<const double> bid_prices() const { return {columns_.bid_prices, columns_.len}; }
+    std::span<const double> ask_prices() const { return {columns_.ask_prices, columns_.len}; }
+    std::span<const double> last_prices() const { return {columns_.last_prices, columns_.len}; }
+    std::span<const std::uint64_t> timestamps() const {
+        return {columns_.timestamps, columns_.len};
+    }
+
+private:
+    const TradingCoreMarketDataColumns& columns_;
+};
+
+/// The target allocation of the current batch. Left untouched, no allocation is
+/// published.
+class AllocationWriter {
+public:
+    explicit AllocationWriter(::AllocationWriter* writer) : writer_(writer) {}
+
+    /// Sets the target quantity of one instrument; 0 removes it.
+    void set(InstrumentId instrument_id, double quantity) {
+        trading_core_allocation_set(writer_, instrument_id, quantity);
+    }
+
+    /// Sets many targets at once; ids sorted ascending are appended without shifting.
+    void set(std::span<const InstrumentId> instrument_ids, std::span<const double> quantities) {
+        std::size_t len = instrument_ids.size() < quantities.size() ? instrument_ids.size()
+                                                                    : quantities.size();
+        trading_core_allocation_set_many(writer_, instrument_ids.data(), quantities.data(), len);
+    }
+
+private:
+    ::AllocationWriter* writer_;
+};
+
+namespace detail {
+
+template <typename Strategy>
+void on_market_data(void* user_data, const TradingCoreMarketDataColumns* md,
+                    ::AllocationWriter* allocation) noexcept {
+    try {
+        MarketData data(*md);
+        AllocationWriter writer(allocation);
+        static_cast<Strategy*>(user_data)->on_market_data(data, writer);
+    } catch (...) {
+        // Nothing may unwind into the runner; what was written so far stands.
+    }
+}
+
+}  // namespace detail
+
+/// Runs `strategy` as a Strategy service until it is shut down; arguments are read
+/// from the command line. Returns 0 once stopped, 1 if the service failed.
+///
+/// `Strategy` provides `void on_market_data(const MarketData&, AllocationWriter&)`.
+template <typename Strategy>
+int run_strategy(Strategy& strategy, const char* version, const char* description) {
+    return trading_core_run_strategy(&detail::on_market_data<Strategy>, &strategy, version,
+                                     description);
+}
+
+}  // namespace trading_core
@@ -1,6 +1,6 @@
 use serde::{Deserialize, Serialize};
 
-use crate::{comms::Address, manifest::ServiceBindings};
+use crate::{comms::Address, manifest::ServiceBindings, metrics::MetricsSnapshot};
 
 #[derive(Debug, Clone, Serialize, Deserialize)]
 pub enum AdminPayload {
@@ -59,6 +59,9 @@ pub enum AdminCommand {
     /// Update serivce configuration
     UpdateBindings { config: ServiceBindings },
 
+    /// Request for the latency metrics of the runners and outputs
+    Metrics,
+
     /// Catch-all for forward compatibility (optional).
     /// If an unknown command is received, it falls here (if using serde_json).
     #[serde(other)]
@@ -90,4 +93,7 @@ pub enum AdminResponse {
 
     /// Pong response to a Ping command.
     Pong,
+
+    /// Latency metrics, in reply to a Metrics command.
+    Metrics(MetricsSnapshot),
 }
@@ -11,6 +11,7 @@ use serde::{Deserialize, Serialize};
 use std::cell::RefCell;
 use std::path::PathBuf;
 
+use crate::framework::placement::{parse_core_list, Placement};
 use crate::manifest::ServiceBindings;
 
 #[derive(Parser, Debug, Clone, Serialize, Deserialize)]
@@ -100,6 +101,35 @@ pub struct CommonArgs {
     /// Path to the data directory (for state saving)
     #[arg(long)]
     data_dir: PathBuf,
+
+    /// Number of ZMQ IO threads shared by every socket of the service
+    #[arg(long, default_value_t = 1)]
+    #[serde(default = "default_zmq_io_threads")]
+    zmq_io_threads: i32,
+
+    /// Number of worker threads shared by every runner of the service (0 = one per core)
+    #[arg(long, default_value_t = 0)]
+    #[serde(default)]
+    runner_threads: usize,
+
+    /// Cores to pin runner threads to, e.g. "2,3" or "4-7"
+    #[arg(long)]
+    #[serde(default)]
+    cpu_cores: Option<String>,
+
+    /// NUMA node to keep runner threads on when no cores are given
+    #[arg(long)]
+    #[serde(default)]
+    numa_node: Option<usize>,
+
+    /// SCHED_FIFO priority (1-99) for runner threads
+    #[arg(long)]
+    #[serde(default)]
+    rt_priority: Option<i32>,
+}
+
+fn default_zmq_io_threads() -> i32 {
+    1
 }
 
 impl CommonArgs {
@@ -136,6 +166,34 @@ impl CommonArgs {
         self.service_id
     }
 
+    /// Returns the number of IO threads of the process-wide ZMQ context.
+    pub fn get_zmq_io_threads(&self) -> i32 {
+        self.zmq_io_threads
+    }
+
+    /// Returns the number of worker threads of the shared runner executor (0 = one per core).
+    pub fn get_runner_threads(&self) -> usize {
+        self.runner_threads
+    }
+
+    /// Returns the CPU placement hints for the runner threads.
+    ///
+    /// # Returns
+    ///
+    /// * `Ok(Placement)`, empty if no hint was given.
+    /// * `Err` if `--cpu-cores` is not a valid CPU list or names a core that is not online.
+    pub fn get_placement(&self) -> anyhow::Result<Placement> {
+        let cores = match &self.cpu_cores {
+            Some(list) => parse_core_list(list)?,
+            None => Vec::new(),
+        };
+        Ok(Placement {
+            cores,
+            numa_node: self.numa_node,
+            rt_priority: self.rt_priority,
+        })
+    }
+
     /// Creates a default Configuration for testing.
     pub fn default_for_test() -> Self {
         Self {
@@ -144,6 +202,11 @@ impl CommonArgs {
             bindings: "".to_string(),
             config_dir: PathBuf::from("./test_config"),
             data_dir: PathBuf::from("./test_data"),
+            zmq_io_threads: default_zmq_io_threads(),
+            runner_threads: 0,
+            cpu_cores: None,
+            numa_node: None,
+            rt_priority: None,
         }
     }
 }
@@ -0,0 +1,251 @@
+//! Minimal benchmark harness for the `benches/` targets of the workspace.
+//!
+//! Bench targets are plain binaries (`harness = false`) driving a `Bench`: every case
+//! is calibrated so one sample lasts about `SAMPLE_TARGET`, timed over a number of
+//! samples, and reported as one JSON line (see `BenchResult`), so runs can be
+//! collected per commit and compared by machines.
+//!
+//! Settings are read from the environment:
+//! - `BENCH_SAMPLES`: samples per case (default 100).
+//! - `BENCH_OUTPUT`: a file the JSON lines are appended to, besides stdout.
+//! - `BENCH_BASELINE`: the output of a previous run; a case whose median grew by
+//!   more than `BENCH_TOLERANCE` (a ratio, default 1.25) fails `Bench::finish`.
+//!
+//! A command-line argument filters the cases by substring, as in
+//! `cargo bench --bench codec -- market_data`.
+
+use crate::metrics::LatencyHistogram;
+use anyhow::{bail, Context, Result};
+use serde::{Deserialize, Serialize};
+use std::collections::HashMap;
+use std::fs::{File, OpenOptions};
+use std::io::{BufRead, BufReader, Write};
+use std::time::{Duration, Instant};
+
+/// Time a sample is calibrated to last.
+const SAMPLE_TARGET: Duration = Duration::from_millis(1);
+const DEFAULT_SAMPLES: usize = 100;
+const DEFAULT_TOLERANCE: f64 = 1.25;
+
+/// Timings of one case, per iteration.
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct BenchResult {
+    pub group: String,
+    pub name: String,
+    pub samples: usize,
+    pub iterations: u64,
+    pub mean_ns: f64,
+    pub p50_ns: u64,
+    pub p99_ns: u64,
+    pub max_ns: u64,
+}
+
+/// The fields of a result compared against a baseline.
+///
+/// Results of other harnesses (e.g. `bench_pipeline.sh`) only carry these.
+#[derive(Deserialize)]
+struct BaselineEntry {
+    group: String,
+    name: String,
+    p50_ns: u64,
+}
+
+/// Runs and reports the cases of one bench target.
+pub struct Bench {
+    group: String,
+    filter: Option<String>,
+    samples: usize,
+    output: Option<File>,
+    /// Median of every baseline case, by `group/name`.
+    baseline: HashMap<String, u64>,
+    tolerance: f64,
+    regressions: Vec<String>,
+}
+
+impl Bench {
+    /// Creates the harness of a bench target, configured from the environment.
+    ///
+    /// # Arguments
+    ///
+    /// * `group` - Reported with every case, usually the name of the target.
+    ///
+    /// # Returns
+    ///
+    /// * `Err` if `BENCH_OUTPUT` cannot be opened or `BENCH_BASELINE` read.
+    pub fn new(group: &str) -> Result<Self> {
+        let filter = std::env::args().skip(1).find(|arg| !arg.starts_with("--"));
+        let samples = env_parse("BENCH_SAMPLES")?
+            .unwrap_or(DEFAULT_SAMPLES)
+            .max(1);
+        let tolerance = env_parse("BENCH_TOLERANCE")?.unwrap_or(DEFAULT_TOLERANCE);
+        let output = match std::env::var_os("BENCH_OUTPUT") {
+            Some(path) => Some(
+                OpenOptions::new()
+                    .create(true)
+                    .append(true)
+                    .open(&path)
+                    .with_context(|| format!("Failed to open BENCH_OUTPUT {:?}", path))?,
+            ),
+            None => None,
+        };
+        let baseline = match std::env::var_os("BENCH_BASELINE") {
+            Some(path) => read_baseline(
+                File::open(&path)
+                    .with_context(|| format!("Failed to open BENCH_BASELINE {:?}", path))?,
+            )?,
+            None => HashMap::new(),
+        };
+        Ok(Self {
+            group: group.to_string(),
+            filter,
+            samples,
+            output,
+            baseline,
+            tolerance,
+            regressions: Vec::new(),
+        })
+    }
+
+    /// Returns whether the case `name` passes the command-line filter, so targets can
+    /// skip the setup of the cases `run` would skip.
+    pub fn selected(&self, name: &str) -> bool {
+        self.filter
+            .as_ref()
+            .is_none_or(|filter| name.contains(filter.as_str()))
+    }
+
+    /// Times `f` and reports it as the case `name`.
+    ///
+    /// # Arguments
+    ///
+    /// * `name` - The case, unique within the group.
+    /// * `f` - One iteration; its result is kept from being optimized away.
+    ///
+    /// # Returns
+    ///
+    /// * `Err` if the result cannot be written to `BENCH_OUTPUT`.
+    pub fn run<R>(&mut self, name: &str, mut f: impl FnMut() -> R) -> Result<()> {
+        if !self.selected(name) {
+            return Ok(());
+        }
+
+        // Double the batch until a sample lasts long enough for the clock to be
+        // negligible; this also warms the caches and the allocator up.
+        let mut iterations: u64 = 1;
+        while time(&mut f, iterations) < SAMPLE_TARGET && iterations < 1 << 30 {
+            iterations *= 2;
+        }
+
+        let histogram = LatencyHistogram::default();
+        let mut total = Duration::ZERO;
+        for _ in 0..self.samples {
+            let elapsed = time(&mut f, iterations);
+            total += elapsed;
+            histogram.record_ns((elapsed.as_nanos() / iterations as u128) as u64);
+        }
+        let runs = iterations * self.samples as u64;
+        let result = BenchResult {
+            group: self.group.clone(),
+            name: name.to_string(),
+            samples: self.samples,
+            iterations: runs,
+            mean_ns: total.as_nanos() as f64 / runs as f64,
+            p50_ns: histogram.percentile_ns(0.5),
+            p99_ns: histogram.percentile_ns(0.99),
+            max_ns: histogram.max_ns(),
+        };
+        self.report(result)
+    }
+
+    /// Reports a result measured outside of `run` (e.g. from service metrics).
+    ///
+    /// # Returns
+    ///
+    /// * `Err` if the result cannot be written to `BENCH_OUTPUT`.
+    pub fn report(&mut self, result: BenchResult) -> Result<()> {
+        let key = format!("{}/{}", result.group, result.name);
+        if let Some(&baseline) = self.baseline.get(&key) {
+            if result.p50_ns as f64 > baseline as f64 * self.tolerance {
+                self.regressions.push(format!(
+                    "{}: p50 {}ns, baseline {}ns",
+                    key, result.p50_ns, baseline
+                ));
+            }
+        }
+        let line = serde_json::to_string(&result)?;
+        println!("{}", line);
+        if let Some(output) = self.output.as_mut() {
+            writeln!(output, "{}", line)?;
+        }
+        Ok(())
+    }
+
+    /// Ends the run.
+    ///
+    /// # Returns
+    ///
+    /// * `Err` listing the cases that regressed against `BENCH_BASELINE`.
+    pub fn finish(self) -> Result<()> {
+        if !self.regressions.is_empty() {
+            bail!(
+                "{} case(s) regressed beyond {}x:\n{}",
+                self.regressions.len(),
+                self.tolerance,
+                self.regressions.join("\n")
+            );
+        }
+        Ok(())
+    }
+}
+
+fn time<R>(f: &mut impl FnMut() -> R, iterations: u64) -> Duration {
+    let started = Instant::now();
+    for _ in 0..iterations {
+        std::hint::black_box(f());
+    }
+    started.elapsed()
+}
+
+fn env_parse<T: std::str::FromStr>(name: &str) -> Result<Option<T>> {
+    match std::env::var(name) {
+        Ok(value) => match value.parse() {
+            Ok(parsed) => Ok(Some(parsed)),
+            Err(_) => bail!("Invalid {}: '{}'", name, value),
+        },
+        Err(_) => Ok(None),
+    }
+}
+
+fn read_baseline(file: impl std::io::Read) -> Result<HashMap<String, u64>> {
+    let mut baseline = HashMap::new();
+    for line in BufReader::new(file).lines() {
+        let line = line?;
+        if line.trim().is_empty() {
+            continue;
+        }
+        let entry: BaselineEntry = serde_json::from_str(&line)
+            .with_context(|| format!("Invalid baseline line: {}", line))?;
+        baseline.insert(format!("{}/{}", entry.group, entry.name), entry.p50_ns);
+    }
+    Ok(baseline)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_read_baseline_accepts_partial_results() {
+        let file = concat!(
+            r#"{"group":"codec","name":"a","samples":1,"iterations":1,"#,
+            r#""mean_ns":1.0,"p50_ns":10,"p99_ns":10,"max_ns":10}"#,
+            "\n\n",
+            r#"{"group":"pipeline","name":"tick_to_trade","p50_ns":20}"#,
+            "\n",
+        );
+        let baseline = read_baseline(file.as_bytes()).unwrap();
+        assert_eq!(baseline.len(), 2);
+        assert_eq!(baseline["codec/a"], 10);
+        assert_eq!(baseline["pipeline/tick_to_trade"], 20);
+    }
+}
@@ -1,6 +1,6 @@
 //! Address models for network configuration.
 //!
-//! Defines the `Address` enum for abstracting over different transport protocols (ZMQ, Memory).
+//! Defines the `Address` enum for abstracting over different transport protocols (ZMQ, Memory, Shm).
 
 use serde::{Deserialize, Serialize};
 use std::fmt;
@@ -19,6 +19,10 @@ pub enum Address {
     /// Format: "channel_name"
     Memory(String),
 
+    /// Shared-memory ring (Inter-Process, same host)
+    /// Format: "ring_name" (placed in /dev/shm) or an absolute file path
+    Shm(String),
+
     /// No connection (used for dynamic Multiplexers starting empty)
     Empty,
 }
@@ -50,6 +54,19 @@ impl Address {
     pub fn memory(name: &str) -> Self {
         Address::Memory(name.to_string())
     }
+
+    /// Creates a new shared-memory ring address.
+    ///
+    /// # Arguments
+    ///
+    /// * `name` - The unique name of the ring on this host.
+    ///
+    /// # Returns
+    ///
+    /// A `Address::Shm` variant.
+    pub fn shm(name: &str) -> Self {
+        Address::Shm(name.to_string())
+    }
 }
 
 impl fmt::Display for Address {
@@ -57,6 +74,7 @@ impl fmt::Display for Address {
         match self {
             Address::Zmq(addr) => write!(f, "zmq:{}", addr),
             Address::Memory(name) => write!(f, "mem:{}", name),
+            Address::Shm(name) => write!(f, "shm:{}", name),
             Address::Empty => write!(f, "empty"),
         }
     }
@@ -76,6 +94,8 @@ impl FromStr for Address {
             Ok(Address::Zmq(stripped.to_string()))
         } else if let Some(stripped) = s.strip_prefix("mem:") {
             Ok(Address::Memory(stripped.to_string()))
+        } else if let Some(stripped) = s.strip_prefix("shm:") {
+            Ok(Address::Shm(stripped.to_string()))
         } else if s == "empty" {
             Ok(Address::Empty)
         } else if s.starts_with("tcp://") || s.starts_with("ipc://") {
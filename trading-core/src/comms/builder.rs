@@ -4,6 +4,8 @@
 
 use super::address::Address;
 use super::socket::{ReceiverSocket, SenderSocket};
+use super::transports::fan_in::FanInSubscriber;
+use super::transports::shm::{self, ShmPublisher, ShmSubscriber};
 use super::transports::zmq::{ZmqPublisher, ZmqSubscriber};
 use crate::comms::socket::ReplySocket;
 use crate::comms::transport::{TransportDuplex, TransportInput, TransportOutput};
@@ -31,6 +33,7 @@ where
             let p = ZmqPublisher::new(addr_str)?;
             Box::new(p)
         }
+        Address::Shm(name) => Box::new(ShmPublisher::new(name, shm::DEFAULT_CAPACITY)?),
         Address::Memory(_) => {
             bail!("Memory channels not yet implemented for Publisher");
         }
@@ -60,6 +63,7 @@ where
             let s = ZmqSubscriber::new(addr_str)?;
             Box::new(s)
         }
+        Address::Shm(name) => Box::new(ShmSubscriber::new(name)?),
         Address::Memory(_) => {
             bail!("Memory channels not yet implemented for Subscriber");
         }
@@ -70,6 +74,8 @@ where
 
 /// Factory to create an empty Subscriber endpoint (no initial connection).
 ///
+/// Sources are added later with `connect` and may mix ZMQ and shared-memory addresses.
+///
 /// # Returns
 ///
 /// * `Ok(ReceiverSocket)` if successful.
@@ -77,8 +83,7 @@ pub fn build_empty_subscriber<T>() -> Result<ReceiverSocket<T>>
 where
     T: DeserializeOwned + Send + Sync + 'static,
 {
-    // Zmq implementation
-    let transport: Box<dyn TransportInput> = Box::new(ZmqSubscriber::new_empty()?);
+    let transport: Box<dyn TransportInput> = Box::new(FanInSubscriber::new_empty()?);
     Ok(ReceiverSocket::new(transport))
 }
 
@@ -91,8 +96,8 @@ where
             let s = ZmqDuplex::new(addr_str)?;
             Box::new(s)
         }
-        Address::Memory(_) => {
-            bail!("Memory channels not yet implemented for Subscriber");
+        Address::Memory(_) | Address::Shm(_) => {
+            bail!("Only ZMQ addresses are supported for Repliers");
         }
         Address::Empty => bail!("Cannot build a replier with an empty address"),
     };
@@ -0,0 +1,198 @@
+//! Futex waits on words shared with other threads or processes.
+//!
+//! A reader of shm rings parks on the `notify_seq` word of every ring it follows
+//! and on the word of its `Wakeup` at once (`FUTEX_WAITV`), so a reader of several
+//! rings, or one that must stay interruptible, sleeps in a single blocking call
+//! until something happens instead of polling.
+
+use std::sync::atomic::AtomicU32;
+use std::time::{Duration, Instant};
+
+/// A word to park on, and the value it must still hold for the wait to block.
+pub(crate) struct Wait<'a> {
+    pub word: &'a AtomicU32,
+    pub expected: u32,
+    /// Only woken from this process, which lets the kernel skip the shared lookup.
+    pub private: bool,
+}
+
+/// Longest a wait on several words parks at once on kernels without `FUTEX_WAITV`
+/// (before Linux 5.16), where only one of them can be waited on.
+#[cfg(target_os = "linux")]
+const FALLBACK_SLICE: Duration = Duration::from_millis(1);
+
+/// Most words a single `FUTEX_WAITV` accepts.
+#[cfg(target_os = "linux")]
+const WAITV_MAX: usize = 128;
+
+/// Blocks until a word of `waits` is woken or no longer holds its expected value,
+/// or until `deadline`.
+///
+/// Returns early on signals and spurious wakeups: callers re-check their condition.
+///
+/// # Arguments
+///
+/// * `waits` - The words to park on.
+/// * `deadline` - When to give up, `None` to wait for a wakeup only.
+#[cfg(target_os = "linux")]
+pub(crate) fn wait_any(waits: &[Wait<'_>], deadline: Option<Instant>) {
+    use std::sync::atomic::{AtomicBool, Ordering};
+    static NO_WAITV: AtomicBool = AtomicBool::new(false);
+
+    let remaining = deadline.map(|deadline| deadline.saturating_duration_since(Instant::now()));
+    if remaining == Some(Duration::ZERO) {
+        return;
+    }
+    match waits {
+        [] => std::thread::sleep(remaining.unwrap_or(FALLBACK_SLICE)),
+        [wait] => wait_one(wait, remaining),
+        _ if waits.len() <= WAITV_MAX && !NO_WAITV.load(Ordering::Relaxed) => {
+            if waitv(waits, remaining) == Err(libc::ENOSYS) {
+                NO_WAITV.store(true, Ordering::Relaxed);
+            }
+        }
+        // No way to park on all of them: park on the first for a bounded slice.
+        _ => {
+            let slice = remaining.map_or(FALLBACK_SLICE, |remaining| remaining.min(FALLBACK_SLICE));
+            wait_one(&waits[0], Some(slice));
+        }
+    }
+}
+
+#[cfg(target_os = "linux")]
+fn wait_one(wait: &Wait<'_>, timeout: Option<Duration>) {
+    let ts = timeout.map(|timeout| libc::timespec {
+        tv_sec: timeout.as_secs() as libc::time_t,
+        tv_nsec: timeout.subsec_nanos() as libc::c_long,
+    });
+    let op = match wait.private {
+        true => libc::FUTEX_WAIT | libc::FUTEX_PRIVATE_FLAG,
+        false => libc::FUTEX_WAIT,
+    };
+    // SAFETY: `word` outlives the call; a relative timeout, or none.
+    unsafe {
+        libc::syscall(
+            libc::SYS_futex,
+            wait.word.as_ptr(),
+            op,
+            wait.expected,
+            ts.as_ref()
+                .map_or(std::ptr::null(), |ts| ts as *const libc::timespec),
+            std::ptr::null::<u32>(),
+            0,
+        );
+    }
+}
+
+/// `struct futex_waitv` of the kernel ABI.
+#[cfg(target_os = "linux")]
+#[repr(C)]
+struct FutexWaitv {
+    val: u64,
+    uaddr: u64,
+    flags: u32,
+    reserved: u32,
+}
+
+#[cfg(target_os = "linux")]
+fn waitv(waits: &[Wait<'_>], timeout: Option<Duration>) -> Result<(), i32> {
+    const FUTEX2_SIZE_U32: u32 = 0x02;
+    const FUTEX2_PRIVATE: u32 = 128;
+
+    let mut vector = [const {
+        FutexWaitv {
+            val: 0,
+            uaddr: 0,
+            flags: 0,
+            reserved: 0,
+        }
+    }; WAITV_MAX];
+    for (slot, wait) in vector.iter_mut().zip(waits) {
+        slot.val = wait.expected as u64;
+        slot.uaddr = wait.word.as_ptr() as u64;
+        slot.flags = match wait.private {
+            true => FUTEX2_SIZE_U32 | FUTEX2_PRIVATE,
+            false => FUTEX2_SIZE_U32,
+        };
+    }
+    // The timeout of FUTEX_WAITV is absolute, on the monotonic clock.
+    let deadline = timeout.map(|timeout| {
+        let mut now = libc::timespec {
+            tv_sec: 0,
+            tv_nsec: 0,
+        };
+        // SAFETY: writes the current time into `now`.
+        unsafe { libc::clock_gettime(libc::CLOCK_MONOTONIC, &mut now) };
+        let nanos = now.tv_nsec as u64 + timeout.subsec_nanos() as u64;
+        libc::timespec {
+            tv_sec: now.tv_sec
+                + timeout.as_secs() as libc::time_t
+                + (nanos / 1_000_000_000) as libc::time_t,
+            tv_nsec: (nanos % 1_000_000_000) as libc::c_long,
+        }
+    });
+    // SAFETY: the vector and the words it points to outlive the call.
+    let result = unsafe {
+        libc::syscall(
+            libc::SYS_futex_waitv,
+            vector.as_ptr(),
+            waits.len() as libc::c_uint,
+            0 as libc::c_uint,
+            deadline
+                .as_ref()
+                .map_or(std::ptr::null(), |ts| ts as *const libc::timespec),
+            libc::CLOCK_MONOTONIC,
+        )
+    };
+    match result {
+        -1 => Err(std::io::Error::last_os_error().raw_os_error().unwrap_or(0)),
+        _ => Ok(()),
+    }
+}
+
+/// Wakes every thread parked on `word`.
+///
+/// # Arguments
+///
+/// * `word` - The word parked on.
+/// * `private` - Whether the waiters park on it as a private word.
+#[cfg(target_os = "linux")]
+pub(crate) fn wake_all(word: &AtomicU32, private: bool) {
+    let op = match private {
+        true => libc::FUTEX_WAKE | libc::FUTEX_PRIVATE_FLAG,
+        false => libc::FUTEX_WAKE,
+    };
+    // SAFETY: waking is harmless whatever the word holds.
+    unsafe {
+        libc::syscall(
+            libc::SYS_futex,
+            word.as_ptr(),
+            op,
+            i32::MAX,
+            std::ptr::null::<libc::timespec>(),
+            std::ptr::null::<u32>(),
+            0,
+        );
+    }
+}
+
+#[cfg(not(target_os = "linux"))]
+pub(crate) fn wait_any(waits: &[Wait<'_>], deadline: Option<Instant>) {
+    use std::sync::atomic::Ordering;
+    // No futexes: fall back to short sleeps.
+    let slice = Duration::from_micros(50);
+    let slice = deadline.map_or(slice, |deadline| {
+        deadline
+            .saturating_duration_since(Instant::now())
+            .min(slice)
+    });
+    if waits
+        .iter()
+        .all(|wait| wait.word.load(Ordering::SeqCst) == wait.expected)
+    {
+        std::thread::sleep(slice);
+    }
+}
+
+#[cfg(not(target_os = "linux"))]
+pub(crate) fn wake_all(_word: &AtomicU32, _private: bool) {}
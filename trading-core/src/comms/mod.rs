@@ -1,11 +1,17 @@
 pub mod address;
 pub mod builder;
+mod futex;
 mod packet;
 pub mod socket;
+pub mod topic;
+pub mod trace;
 pub mod transport;
 pub mod transports;
+pub mod wakeup;
 
 pub use address::Address;
 pub use builder::{build_publisher, build_subscriber};
 pub use packet::Packet;
 pub use socket::{ReceiverSocket, SenderSocket};
+pub use trace::Trace;
+pub use wakeup::Wakeup;
@@ -1,27 +1,85 @@
-use serde::{de::DeserializeOwned, Deserialize, Serialize};
+use anyhow::{bail, Result};
+use serde::{Deserialize, Serialize};
 
+use super::trace::Trace;
 use crate::model::identity::Id;
 
+/// Version of the packet wire format.
+///
+/// Bumped whenever the framing or a payload encoding changes (v2: archived
+/// `MarketDataBatch` columns; v3: sorted position sets, order and execution
+/// batches; v4: numeric order ids and nanosecond order timestamps; v5: trace
+/// header; v6: per-topic trace sequences), so mismatched peers fail loudly instead of misreading.
+pub const WIRE_VERSION: u64 = 6;
+
+/// A message on the wire: sender id, format/version tag, trace header and payload.
+///
+/// The header is five 8-byte words so that, with bincode's fixed-width encoding,
+/// byte-blob payloads (such as archived market data) stay 8-byte aligned within the frame.
 #[derive(Debug, Clone, Serialize, Deserialize)]
-#[serde(bound(serialize = "T: Serialize", deserialize = "T: DeserializeOwned"))]
 pub struct Packet<T> {
     id: Id,
+    version: u64,
+    trace: Trace,
     data: T,
 }
 
-impl<T> Packet<T>
-where
-    T: DeserializeOwned + Serialize,
-{
+impl<T> Packet<T> {
     pub fn new(id: Id, data: T) -> Self {
-        Self { id, data }
+        Self {
+            id,
+            version: WIRE_VERSION,
+            trace: Trace::default(),
+            data,
+        }
+    }
+
+    /// Sets the trace header, see `SenderSocket` for how it is stamped.
+    pub fn with_trace(mut self, trace: Trace) -> Self {
+        self.trace = trace;
+        self
     }
 
     pub fn id(&self) -> Id {
         self.id
     }
 
+    pub fn version(&self) -> u64 {
+        self.version
+    }
+
+    pub fn trace(&self) -> Trace {
+        self.trace
+    }
+
     pub fn data(self) -> T {
         self.data
     }
 }
+
+impl<'a, T> Packet<T>
+where
+    T: Deserialize<'a>,
+{
+    /// Decodes a packet from a received frame, borrowing from it where `T` allows.
+    ///
+    /// # Arguments
+    ///
+    /// * `frame` - The raw bytes received from the transport.
+    ///
+    /// # Returns
+    ///
+    /// * `Ok(Packet<T>)` on success.
+    /// * `Err` if the frame is malformed or was produced by another wire version.
+    pub fn decode(frame: &'a [u8]) -> Result<Self> {
+        let packet: Packet<T> = bincode::deserialize(frame)?;
+        if packet.version != WIRE_VERSION {
+            bail!(
+                "Packet wire version {} does not match ours ({})",
+                packet.version,
+                WIRE_VERSION
+            );
+        }
+        Ok(packet)
+    }
+}
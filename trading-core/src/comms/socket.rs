@@ -3,11 +3,19 @@
 //! Provides `ReceiverSocket` and `SenderSocket` which handle serialization/deserialization automatically.
 
 use crate::comms::packet::Packet;
+use crate::comms::topic::{self, Topic};
+use crate::comms::trace::{self, Trace};
 use crate::comms::transport::{TransportDuplex, TransportInput, TransportOutput};
+use crate::metrics::OutputMetrics;
 use crate::model::identity::Id;
+use crate::model::order::unix_nanos;
 use anyhow::Result;
 use serde::{de::DeserializeOwned, Serialize};
+use std::collections::HashMap;
 use std::marker::PhantomData;
+use std::sync::atomic::Ordering;
+use std::sync::Arc;
+use std::time::Instant;
 
 /// A strongly-typed input socket.
 pub struct ReceiverSocket<C> {
@@ -40,9 +48,9 @@ where
     /// * `Ok(Packet<C>)` containing the deserialized message with sender info.
     /// * `Err` if transport fails or deserialization error occurs.
     pub async fn recv(&mut self) -> Result<Packet<C>> {
-        let bytes = self.transport.recv_bytes().await?;
-        let packet: Packet<C> = bincode::deserialize(&bytes)?;
-        Ok(packet)
+        // Decode straight from the transport's receive buffer, no intermediate copy
+        let frame = self.transport.recv_frame().await?;
+        Packet::decode(frame)
     }
 
     /// Receives the next message and deserializes it (Non-blocking attempt).
@@ -52,9 +60,40 @@ where
     /// * `Ok(Packet<C>)` if a message is immediately available.
     /// * `Err` if no message is available (`EAGAIN` equivalent) or other error.
     pub async fn try_recv(&mut self) -> Result<Packet<C>> {
-        let bytes = self.transport.try_recv().await?;
-        let packet: Packet<C> = bincode::deserialize(&bytes)?;
-        Ok(packet)
+        let frame = self.transport.try_recv_frame().await?;
+        Packet::decode(frame)
+    }
+
+    /// Receives the next raw frame without decoding it (Non-blocking attempt).
+    ///
+    /// The frame borrows the transport's receive buffer and can be decoded in place
+    /// with `Packet::decode` into a borrowing type such as `MarketDataBatchView`.
+    ///
+    /// # Returns
+    ///
+    /// * `Ok(&[u8])` if a message is immediately available.
+    /// * `Err` if no message is available (`EAGAIN` equivalent) or other error.
+    pub async fn try_recv_frame(&mut self) -> Result<&[u8]> {
+        self.transport.try_recv_frame().await
+    }
+
+    /// Parks until a message is ready, `wakeup` is signalled, or `timeout` elapses.
+    ///
+    /// # Arguments
+    ///
+    /// * `wakeup` - Signal used to interrupt the wait from another thread.
+    /// * `timeout` - Upper bound on the wait, `None` to wait indefinitely.
+    ///
+    /// # Returns
+    ///
+    /// * `Ok(true)` if a message can be read with `try_recv`.
+    /// * `Ok(false)` if the wait was interrupted or timed out.
+    pub async fn wait_readable(
+        &mut self,
+        wakeup: &crate::comms::wakeup::Wakeup,
+        timeout: Option<std::time::Duration>,
+    ) -> Result<bool> {
+        self.transport.wait_readable(wakeup, timeout).await
     }
 
     /// Connects to a new publisher/source dynamically.
@@ -74,12 +113,30 @@ where
     pub async fn disconnect(&mut self, address: &crate::comms::address::Address) -> Result<()> {
         self.transport.disconnect(address).await
     }
+
+    /// Restricts the socket to messages published on `topics`.
+    ///
+    /// # Arguments
+    ///
+    /// * `topics` - The topics to receive, empty for `topic::ALL`.
+    pub fn subscribe(&mut self, topics: &[Topic]) -> Result<()> {
+        self.transport.subscribe(topics)
+    }
 }
 
 /// A strongly-typed output socket.
+///
+/// Every packet sent is stamped with a trace header (see `comms::trace`).
 pub struct SenderSocket<C> {
     transport: Box<dyn TransportOutput>,
     id: Id,
+    /// Serialization buffer reused across sends.
+    buffer: Vec<u8>,
+    /// Sequence number of the last packet sent on every topic.
+    seqs: HashMap<Topic, u64>,
+    metrics: Option<Arc<OutputMetrics>>,
+    /// Message built in place by the handler, see `staged`.
+    staged: Option<C>,
     _marker: PhantomData<C>,
 }
 
@@ -96,10 +153,20 @@ where
         Self {
             transport,
             id,
+            buffer: Vec::new(),
+            seqs: HashMap::new(),
+            metrics: None,
+            staged: None,
             _marker: PhantomData,
         }
     }
 
+    /// Records the sends of this socket into `metrics`.
+    pub fn with_metrics(mut self, metrics: Arc<OutputMetrics>) -> Self {
+        self.metrics = Some(metrics);
+        self
+    }
+
     /// Serializes and sends the message.
     ///
     /// # Arguments
@@ -110,15 +177,108 @@ where
     ///
     /// * `Ok(())` on success.
     /// * `Err` if serialization or transport fails.
-    pub async fn send(&self, data: C) -> Result<()> {
-        let packet = Packet::new(self.id, data);
-        let bytes = bincode::serialize(&packet)?;
-        self.transport.send_bytes(&bytes).await
+    pub async fn send(&mut self, data: C) -> Result<()> {
+        self.encode(&data, &topic::ALL)?;
+        self.transport.send_bytes(&self.buffer).await
+    }
+
+    /// Serializes and sends a borrowed message.
+    ///
+    /// The bytes on the wire are the same as for `send`; the caller keeps the
+    /// message, and so its allocations, for reuse.
+    ///
+    /// # Arguments
+    ///
+    /// * `data` - The strongly-typed message to send.
+    ///
+    /// # Returns
+    ///
+    /// * `Ok(())` on success.
+    /// * `Err` if serialization or transport fails.
+    pub async fn send_ref(&mut self, data: &C) -> Result<()> {
+        self.encode(data, &topic::ALL)?;
+        self.transport.send_bytes(&self.buffer).await
+    }
+
+    /// Returns the message kept by the socket for handlers that build their output
+    /// in place, so its allocations are reused by every pass instead of living in
+    /// the handler (or a thread-local).
+    ///
+    /// It keeps its content across sends: callers reset it once it is sent.
+    pub fn staged(&mut self) -> &mut C
+    where
+        C: Default,
+    {
+        self.staged.get_or_insert_with(C::default)
+    }
+
+    /// Serializes and sends the `staged` message, which the socket keeps.
+    ///
+    /// # Returns
+    ///
+    /// * `Ok(())` on success, or if nothing was staged.
+    /// * `Err` if serialization or transport fails.
+    pub async fn send_staged(&mut self) -> Result<()> {
+        let Some(staged) = self.staged.take() else {
+            return Ok(());
+        };
+        let encoded = self.encode(&staged, &topic::ALL);
+        self.staged = Some(staged);
+        encoded?;
+        self.transport.send_bytes(&self.buffer).await
+    }
+
+    /// Returns whether subscribers can filter on the topic of `send_topic`.
+    pub fn supports_topics(&self) -> bool {
+        self.transport.supports_topics()
+    }
+
+    /// Serializes and sends a borrowed message on a topic.
+    ///
+    /// # Arguments
+    ///
+    /// * `topic` - The topic subscribers filter on.
+    /// * `data` - The strongly-typed message to send.
+    ///
+    /// # Returns
+    ///
+    /// * `Ok(())` on success.
+    /// * `Err` if serialization or transport fails.
+    pub async fn send_topic(&mut self, topic: &Topic, data: &C) -> Result<()> {
+        self.encode(data, topic)?;
+        self.transport.send_topic(topic, &self.buffer).await
+    }
+
+    /// Serializes the next packet of `topic` into the retained buffer, so its
+    /// capacity is reused by the next send.
+    fn encode(&mut self, data: &C, topic: &Topic) -> Result<()> {
+        let started = Instant::now();
+        let seq = self.seqs.entry(*topic).or_insert(0);
+        *seq += 1;
+        let seq = *seq;
+        let sent_ns = unix_nanos();
+        let origin_ns = match trace::current_origin() {
+            0 => sent_ns,
+            origin_ns => origin_ns,
+        };
+        let packet = Packet::new(self.id, data).with_trace(Trace {
+            seq,
+            topic: *topic,
+            origin_ns,
+            sent_ns,
+        });
+        self.buffer.clear();
+        bincode::serialize_into(&mut self.buffer, &packet)?;
+        if let Some(metrics) = &self.metrics {
+            metrics.messages.fetch_add(1, Ordering::Relaxed);
+            metrics.serialization.record(started.elapsed());
+        }
+        Ok(())
     }
 }
 
 pub(crate) struct ResponseHandle<'a, C> {
-    transport: &'a Box<dyn TransportDuplex>,
+    transport: &'a mut Box<dyn TransportDuplex>,
     id: Id,
     _marker: PhantomData<C>,
 }
@@ -174,7 +334,7 @@ where
     /// ```
     pub(crate) async fn recv<'a>(&'a mut self) -> Result<(Packet<C>, ResponseHandle<'a, C>)> {
         let bytes = self.transport.recv_bytes().await?;
-        let packet: Packet<C> = match bincode::deserialize(&bytes) {
+        let packet: Packet<C> = match Packet::decode(&bytes) {
             Ok(p) => p,
             Err(e) => {
                 // If deserialization fails, the REP socket is still in SEND state.
@@ -182,12 +342,12 @@ where
                 // We send an empty frame which will likely cause a deserialization error on the other side,
                 // but that's better than deadlocking the service.
                 let _ = self.transport.send_bytes(b"").await;
-                return Err(e.into());
+                return Err(e);
             }
         };
 
         let response_handle = ResponseHandle {
-            transport: &self.transport,
+            transport: &mut self.transport,
             id: self.id,
             _marker: PhantomData,
         };
@@ -210,7 +370,7 @@ mod tests {
         let input_transport = MemoryTransportInput::new(rx);
 
         // 2. Wrap in Typed Sockets
-        let output: SenderSocket<MarketDataBatch> =
+        let mut output: SenderSocket<MarketDataBatch> =
             SenderSocket::new(Box::new(output_transport), Id::from(10usize));
         let mut input: ReceiverSocket<MarketDataBatch> =
             ReceiverSocket::new(Box::new(input_transport));
@@ -233,6 +393,19 @@ mod tests {
         assert_eq!(received_data.get_count(), 1);
         assert_eq!(received_data.get_update_at(0).last, 150.0);
 
+        // A staged message is sent as is and kept, allocations included.
+        let (tx, rx) = mpsc::channel(100);
+        let mut output: SenderSocket<Vec<u64>> =
+            SenderSocket::new(Box::new(MemoryTransportOutput::new(tx)), Id::from(10usize));
+        let mut input: ReceiverSocket<Vec<u64>> =
+            ReceiverSocket::new(Box::new(MemoryTransportInput::new(rx)));
+        output.staged().extend([1, 2, 3]);
+        let staged = output.staged().as_ptr();
+        output.send_staged().await?;
+        assert_eq!(input.recv().await?.data(), &[1, 2, 3]);
+        output.staged().clear();
+        assert_eq!(output.staged().as_ptr(), staged);
+
         Ok(())
     }
 }
@@ -0,0 +1,133 @@
+//! Topic partitioning of market data.
+//!
+//! Transports that filter on the publisher side (ZMQ PUB/SUB) prefix each message
+//! with a topic frame, and a subscriber then only receives the topics it
+//! subscribed to. Market data is partitioned by instrument: next to every whole
+//! batch, published on `ALL`, the Feeder publishes one batch per non-empty
+//! partition. A consumer that declares its instrument universe subscribes to the
+//! partitions covering it, so its network bytes and decode work scale with its
+//! universe rather than with the whole feed; any other consumer subscribes to `ALL`
+//! and receives one cross-sectional batch per tick.
+
+use crate::model::instrument::InstrumentId;
+use crate::model::market_data::MarketDataBatch;
+
+/// Number of market data partitions. Publishers and subscribers must agree on it.
+pub const PARTITIONS: usize = 64;
+
+/// Length of a topic frame.
+pub const TOPIC_LEN: usize = 4;
+
+/// A topic frame: the big-endian partition number.
+///
+/// Fixed width, so that no topic is a prefix of another under ZMQ's prefix matching.
+pub type Topic = [u8; TOPIC_LEN];
+
+/// The catch-all topic: whole messages, for subscribers without a universe.
+///
+/// Above any partition number, so it never matches a partition topic.
+pub const ALL: Topic = [0xFF; TOPIC_LEN];
+
+/// Returns the partition carrying the updates of an instrument.
+pub fn partition_of(instrument_id: InstrumentId) -> usize {
+    instrument_id % PARTITIONS
+}
+
+/// Returns the topic frame of a partition.
+pub fn topic(partition: usize) -> Topic {
+    (partition as u32).to_be_bytes()
+}
+
+/// Returns the topics to subscribe to for an instrument universe.
+///
+/// # Arguments
+///
+/// * `universe` - The instruments the consumer trades.
+///
+/// # Returns
+///
+/// The sorted, deduplicated topics of the partitions covering `universe`; empty if
+/// `universe` is empty, which subscribers take as `ALL`.
+pub fn universe_topics(universe: &[InstrumentId]) -> Vec<Topic> {
+    let mut partitions: Vec<usize> = universe.iter().map(|&id| partition_of(id)).collect();
+    partitions.sort_unstable();
+    partitions.dedup();
+    partitions.into_iter().map(topic).collect()
+}
+
+/// Splits batches into one batch per partition.
+///
+/// The per-partition batches are kept between calls so their column allocations
+/// are reused by every split.
+pub struct Partitioner {
+    parts: Vec<MarketDataBatch>,
+}
+
+impl Partitioner {
+    pub fn new() -> Self {
+        Self {
+            parts: (0..PARTITIONS)
+                .map(|_| MarketDataBatch::new(Vec::new()))
+                .collect(),
+        }
+    }
+
+    /// Splits a batch by partition, preserving the row order within each partition.
+    ///
+    /// # Returns
+    ///
+    /// The topic and rows of every non-empty partition, valid until the next split.
+    pub fn split(
+        &mut self,
+        batch: &MarketDataBatch,
+    ) -> impl Iterator<Item = (Topic, &MarketDataBatch)> {
+        for part in &mut self.parts {
+            part.clear();
+        }
+        for update in batch.iter() {
+            self.parts[partition_of(update.get_instrument_id())].add_update(update);
+        }
+        self.parts
+            .iter()
+            .enumerate()
+            .filter(|(_, part)| part.get_count() > 0)
+            .map(|(partition, part)| (topic(partition), part))
+    }
+}
+
+impl Default for Partitioner {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::model::market_data::PriceUpdate;
+
+    #[test]
+    fn test_split_covers_universe_topics() {
+        let batch = MarketDataBatch::new(vec![
+            PriceUpdate::new(1, 1.0, 1.0, 1.0, 0),
+            PriceUpdate::new(1 + PARTITIONS, 2.0, 2.0, 2.0, 0),
+            PriceUpdate::new(2, 3.0, 3.0, 3.0, 0),
+        ]);
+        let mut partitioner = Partitioner::new();
+        let parts: Vec<_> = partitioner
+            .split(&batch)
+            .map(|(topic, part)| (topic, part.get_instrument_ids().to_vec()))
+            .collect();
+        assert_eq!(
+            parts,
+            vec![(topic(1), vec![1, 1 + PARTITIONS]), (topic(2), vec![2])]
+        );
+
+        assert_eq!(
+            universe_topics(&[2, 1 + PARTITIONS, 1]),
+            vec![topic(1), topic(2)]
+        );
+        assert!(universe_topics(&[]).is_empty());
+        assert!(!(0..PARTITIONS).map(topic).any(|topic| topic == ALL));
+    }
+}
@@ -0,0 +1,76 @@
+//! Trace header of packets, for end-to-end latency measurement.
+//!
+//! Every `SenderSocket` stamps the packets it sends with their topic, a sequence
+//! number counted per topic (so a subscriber to some topics still sees a gapless
+//! sequence on each) and its send time, and carries forward the origin time of the message
+//! being handled. A runner sets that origin (see `with_origin`) while its handler
+//! runs, so an order sent in reaction to a tick keeps the tick's origin and the
+//! last hop of the chain sees the whole tick-to-trade latency.
+//!
+//! Timestamps are Unix nanoseconds: the services of a deployment share the host
+//! clock, which keeps hops comparable across processes.
+
+use super::packet::WIRE_VERSION;
+use super::topic::Topic;
+use crate::model::identity::Id;
+use serde::{Deserialize, Serialize};
+use std::cell::Cell;
+
+/// Trace header of a packet. A zero field means "not traced".
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq, Serialize, Deserialize)]
+pub struct Trace {
+    /// Position of the packet in the stream of its socket and topic, from 1.
+    pub seq: u64,
+    /// The topic the packet was published on.
+    pub topic: Topic,
+    /// Unix nanos of the event at the origin of the chain (e.g. the feeder tick).
+    pub origin_ns: u64,
+    /// Unix nanos at which this hop was sent.
+    pub sent_ns: u64,
+}
+
+/// The packet fields ahead of the payload.
+#[derive(Deserialize)]
+struct Header {
+    id: Id,
+    version: u64,
+    trace: Trace,
+}
+
+impl Trace {
+    /// Reads the sender and trace of a raw frame without decoding its payload.
+    ///
+    /// # Returns
+    ///
+    /// `None` if the frame is too short or from another wire version.
+    pub fn peek(frame: &[u8]) -> Option<(Id, Trace)> {
+        let header: Header = bincode::deserialize(frame).ok()?;
+        (header.version == WIRE_VERSION).then_some((header.id, header.trace))
+    }
+}
+
+thread_local! {
+    static ORIGIN: Cell<u64> = const { Cell::new(0) };
+}
+
+/// Runs `f` with `origin_ns` as the origin of the packets it sends.
+///
+/// # Arguments
+///
+/// * `origin_ns` - The origin of the message being handled, 0 if unknown; sends
+///   then start a new chain.
+pub fn with_origin<R>(origin_ns: u64, f: impl FnOnce() -> R) -> R {
+    struct Restore(u64);
+    impl Drop for Restore {
+        fn drop(&mut self) {
+            ORIGIN.with(|origin| origin.set(self.0));
+        }
+    }
+    let _restore = Restore(ORIGIN.with(|origin| origin.replace(origin_ns)));
+    f()
+}
+
+/// Returns the origin set by the enclosing `with_origin`, 0 outside of one.
+pub fn current_origin() -> u64 {
+    ORIGIN.with(|origin| origin.get())
+}
@@ -1,11 +1,16 @@
 use crate::comms::address::Address;
+use crate::comms::topic::Topic;
+use crate::comms::wakeup::Wakeup;
 use anyhow::Result;
 use async_trait::async_trait;
+use std::time::Duration;
 
 /// Abstraction for the incoming transport layer (reading raw bytes).
 /// Implementation details (ZMQ, TCP, Memory) are hidden behind this trait.
+///
+/// Transports are owned by a single runner and are not required to be `Sync`.
 #[async_trait]
-pub trait TransportInput: Send + Sync {
+pub trait TransportInput: Send {
     /// Receive the next full frame/message as bytes.
     async fn recv_bytes(&mut self) -> Result<Vec<u8>>;
 
@@ -13,6 +18,31 @@ pub trait TransportInput: Send + Sync {
     /// If no message is available, returns an error.
     async fn try_recv(&mut self) -> Result<Vec<u8>>;
 
+    /// Receive the next full frame into a transport-owned buffer and lend it out.
+    ///
+    /// The buffer is recycled by the next receive call, so no per-message copy or
+    /// allocation is made on the Rust side.
+    async fn recv_frame(&mut self) -> Result<&[u8]>;
+
+    /// Non-blocking variant of `recv_frame`.
+    /// If no message is available, returns an error.
+    async fn try_recv_frame(&mut self) -> Result<&[u8]>;
+
+    /// Parks until a frame is ready to be read, `wakeup` is signalled, or `timeout` elapses.
+    ///
+    /// This never consumes a frame; callers follow up with `try_recv`.
+    ///
+    /// # Arguments
+    ///
+    /// * `wakeup` - Signal used by the controlling thread to interrupt the wait.
+    /// * `timeout` - Upper bound on the wait, `None` to wait indefinitely.
+    ///
+    /// # Returns
+    ///
+    /// * `Ok(true)` if a frame is ready to be read.
+    /// * `Ok(false)` if the wait ended because of `wakeup` or `timeout`.
+    async fn wait_readable(&mut self, wakeup: &Wakeup, timeout: Option<Duration>) -> Result<bool>;
+
     /// Connects to a new publisher/source dynamically.
     /// This allows a single input to aggregate multiple sources (Multiplexing).
     ///
@@ -27,13 +57,40 @@ pub trait TransportInput: Send + Sync {
     ///
     /// * `address` - The address to disconnect from.
     async fn disconnect(&mut self, address: &Address) -> Result<()>;
+
+    /// Restricts the input to messages published on `topics`.
+    ///
+    /// Transports without publisher-side filtering deliver every message regardless,
+    /// which is the default.
+    ///
+    /// # Arguments
+    ///
+    /// * `topics` - The topics to receive, empty for `topic::ALL`.
+    fn subscribe(&mut self, topics: &[Topic]) -> Result<()> {
+        let _ = topics;
+        Ok(())
+    }
 }
 
 /// Abstraction for the outgoing transport layer (sending raw bytes).
 #[async_trait]
-pub trait TransportOutput: Send + Sync {
+pub trait TransportOutput: Send {
     /// Send a full frame/message.
-    async fn send_bytes(&self, data: &[u8]) -> Result<()>;
+    async fn send_bytes(&mut self, data: &[u8]) -> Result<()>;
+
+    /// Returns whether subscribers can filter on the topic of `send_topic`.
+    fn supports_topics(&self) -> bool {
+        false
+    }
+
+    /// Send a full frame/message on a topic.
+    ///
+    /// Without topic support the topic is dropped and `data` is sent as with
+    /// `send_bytes`, which is the default.
+    async fn send_topic(&mut self, topic: &Topic, data: &[u8]) -> Result<()> {
+        let _ = topic;
+        self.send_bytes(data).await
+    }
 }
 
 /// Abstraction for the duplex transport layer (reading and writing raw bytes).
@@ -41,9 +98,9 @@ pub trait TransportOutput: Send + Sync {
 /// This is a trait that extends both `TransportInput` and `TransportOutput`,
 /// providing a unified interface for bidirectional communication.
 #[async_trait]
-pub trait TransportDuplex: Send + Sync {
+pub trait TransportDuplex: Send {
     /// Receive the next full frame/message as bytes.
     async fn recv_bytes(&mut self) -> Result<Vec<u8>>;
     /// Send a full frame/message.
-    async fn send_bytes(&self, data: &[u8]) -> Result<()>;
+    async fn send_bytes(&mut self, data: &[u8]) -> Result<()>;
 }
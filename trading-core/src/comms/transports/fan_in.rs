@@ -0,0 +1,135 @@
+//! Mixed-transport input for variadic runners.
+//!
+//! A runner that starts empty (e.g. a Multiplexer) learns its sources one at a time
+//! through `connect`, and each edge of a layout may use a different transport. The
+//! `FanInSubscriber` routes every address to the matching backend and merges them
+//! into a single input.
+
+use crate::comms::address::Address;
+use crate::comms::topic::Topic;
+use crate::comms::transport::TransportInput;
+use crate::comms::transports::shm::ShmSubscriber;
+use crate::comms::transports::zmq::ZmqSubscriber;
+use crate::comms::wakeup::Wakeup;
+use anyhow::{bail, Result};
+use async_trait::async_trait;
+use std::time::{Duration, Instant};
+
+/// Longest a wait on one backend may block while the other one also has sources.
+const WAIT_SLICE: Duration = Duration::from_millis(1);
+
+pub(crate) struct FanInSubscriber {
+    zmq: ZmqSubscriber,
+    /// Number of endpoints currently connected on `zmq`.
+    zmq_endpoints: usize,
+    shm: ShmSubscriber,
+    /// Which backend served the last frame, so the next poll starts with the other one.
+    shm_first: bool,
+}
+
+impl FanInSubscriber {
+    pub fn new_empty() -> Result<Self> {
+        Ok(Self {
+            zmq: ZmqSubscriber::new_empty()?,
+            zmq_endpoints: 0,
+            shm: ShmSubscriber::new_empty(),
+            shm_first: true,
+        })
+    }
+}
+
+#[async_trait]
+impl TransportInput for FanInSubscriber {
+    async fn recv_bytes(&mut self) -> Result<Vec<u8>> {
+        Ok(self.recv_frame().await?.to_vec())
+    }
+
+    async fn try_recv(&mut self) -> Result<Vec<u8>> {
+        Ok(self.try_recv_frame().await?.to_vec())
+    }
+
+    async fn recv_frame(&mut self) -> Result<&[u8]> {
+        if self.shm.is_empty() {
+            return self.zmq.recv_frame().await;
+        }
+        if self.zmq_endpoints == 0 {
+            return self.shm.recv_frame().await;
+        }
+        let wakeup = Wakeup::new()?;
+        while !self.wait_readable(&wakeup, None).await? {}
+        self.try_recv_frame().await
+    }
+
+    async fn try_recv_frame(&mut self) -> Result<&[u8]> {
+        // Alternate the starting backend so neither can starve the other.
+        self.shm_first = !self.shm_first;
+        let shm_ready = !self.shm.is_empty() && self.shm.has_data();
+        if self.shm_first && shm_ready {
+            return self.shm.try_recv_frame().await;
+        }
+        if self.zmq_endpoints > 0 && self.zmq.try_recv_frame().await.is_ok() {
+            return self.zmq.last_frame();
+        }
+        if !self.shm.is_empty() {
+            return self.shm.try_recv_frame().await;
+        }
+        bail!("No message available")
+    }
+
+    async fn wait_readable(&mut self, wakeup: &Wakeup, timeout: Option<Duration>) -> Result<bool> {
+        if self.shm.is_empty() {
+            return self.zmq.wait_readable(wakeup, timeout).await;
+        }
+        if self.zmq_endpoints == 0 {
+            return self.shm.wait_readable(wakeup, timeout).await;
+        }
+        // Sources on both backends: alternate bounded waits on each.
+        let deadline = timeout.map(|t| Instant::now() + t);
+        loop {
+            if self.shm.has_data() {
+                return Ok(true);
+            }
+            let slice = match deadline {
+                Some(deadline) => deadline
+                    .saturating_duration_since(Instant::now())
+                    .min(WAIT_SLICE),
+                None => WAIT_SLICE,
+            };
+            if self.zmq.wait_readable(wakeup, Some(slice)).await? {
+                return Ok(true);
+            }
+            if wakeup.is_pending() || deadline.is_some_and(|d| Instant::now() >= d) {
+                return Ok(self.shm.has_data());
+            }
+        }
+    }
+
+    async fn connect(&mut self, address: &Address) -> Result<()> {
+        match address {
+            Address::Zmq(_) => {
+                self.zmq.connect(address).await?;
+                self.zmq_endpoints += 1;
+                Ok(())
+            }
+            Address::Shm(_) => self.shm.connect(address).await,
+            _ => bail!("FanInSubscriber cannot connect to {}", address),
+        }
+    }
+
+    async fn disconnect(&mut self, address: &Address) -> Result<()> {
+        match address {
+            Address::Zmq(_) => {
+                self.zmq.disconnect(address).await?;
+                self.zmq_endpoints = self.zmq_endpoints.saturating_sub(1);
+                Ok(())
+            }
+            Address::Shm(_) => self.shm.disconnect(address).await,
+            _ => bail!("FanInSubscriber cannot disconnect from {}", address),
+        }
+    }
+
+    fn subscribe(&mut self, topics: &[Topic]) -> Result<()> {
+        // Shared-memory rings carry every message; only ZMQ filters.
+        self.zmq.subscribe(topics)
+    }
+}
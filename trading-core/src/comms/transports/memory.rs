@@ -1,14 +1,20 @@
 use crate::comms::transport::{TransportInput, TransportOutput};
+use crate::comms::wakeup::Wakeup;
 use anyhow::Result;
 use async_trait::async_trait;
+use std::time::Duration;
 use tokio::sync::mpsc;
 
 /// Internal memory transport for testing/threading.
 ///
 /// Implements `TransportInput` using Tokio's MPSC channels.
 #[allow(dead_code)]
-pub(crate) struct MemoryTransportInput {
+pub struct MemoryTransportInput {
     receiver: mpsc::Receiver<Vec<u8>>,
+    /// Frame pulled off the channel by `wait_readable`, handed out by the next receive.
+    pending: Option<Vec<u8>>,
+    /// Frame currently lent out by `recv_frame`.
+    frame: Vec<u8>,
 }
 
 impl MemoryTransportInput {
@@ -19,13 +25,20 @@ impl MemoryTransportInput {
     /// * `receiver` - The receiving end of a channel.
     #[allow(dead_code)]
     pub fn new(receiver: mpsc::Receiver<Vec<u8>>) -> Self {
-        Self { receiver }
+        Self {
+            receiver,
+            pending: None,
+            frame: Vec::new(),
+        }
     }
 }
 
 #[async_trait]
 impl TransportInput for MemoryTransportInput {
     async fn recv_bytes(&mut self) -> Result<Vec<u8>> {
+        if let Some(frame) = self.pending.take() {
+            return Ok(frame);
+        }
         self.receiver
             .recv()
             .await
@@ -33,12 +46,50 @@ impl TransportInput for MemoryTransportInput {
     }
 
     async fn try_recv(&mut self) -> Result<Vec<u8>> {
+        if let Some(frame) = self.pending.take() {
+            return Ok(frame);
+        }
         self.receiver.try_recv().map_err(|err| match err {
             mpsc::error::TryRecvError::Empty => anyhow::anyhow!("Memory channel empty"),
             _ => anyhow::anyhow!("Memory channel closed"),
         })
     }
 
+    async fn recv_frame(&mut self) -> Result<&[u8]> {
+        // The channel already hands over ownership of the sender's buffer, keep it as-is.
+        self.frame = self.recv_bytes().await?;
+        Ok(&self.frame)
+    }
+
+    async fn try_recv_frame(&mut self) -> Result<&[u8]> {
+        self.frame = self.try_recv().await?;
+        Ok(&self.frame)
+    }
+
+    async fn wait_readable(&mut self, wakeup: &Wakeup, timeout: Option<Duration>) -> Result<bool> {
+        if self.pending.is_some() {
+            return Ok(true);
+        }
+        // Channels have no descriptor to poll, so race the receive against the wakeup.
+        let sleep = async {
+            match timeout {
+                Some(t) => tokio::time::sleep(t).await,
+                None => std::future::pending().await,
+            }
+        };
+        tokio::select! {
+            frame = self.receiver.recv() => match frame {
+                Some(frame) => {
+                    self.pending = Some(frame);
+                    Ok(true)
+                }
+                None => anyhow::bail!("Memory channel closed"),
+            },
+            _ = wakeup.notified() => Ok(false),
+            _ = sleep => Ok(false),
+        }
+    }
+
     async fn connect(&mut self, _address: &crate::comms::address::Address) -> Result<()> {
         anyhow::bail!("MemoryTransportInput does not support dynamic connection yet")
     }
@@ -52,7 +103,7 @@ impl TransportInput for MemoryTransportInput {
 ///
 /// Implements `TransportOutput` using Tokio's MPSC channels.
 #[allow(dead_code)]
-pub(crate) struct MemoryTransportOutput {
+pub struct MemoryTransportOutput {
     sender: mpsc::Sender<Vec<u8>>,
 }
 
@@ -70,7 +121,7 @@ impl MemoryTransportOutput {
 
 #[async_trait]
 impl TransportOutput for MemoryTransportOutput {
-    async fn send_bytes(&self, data: &[u8]) -> Result<()> {
+    async fn send_bytes(&mut self, data: &[u8]) -> Result<()> {
         self.sender
             .send(data.to_vec())
             .await
@@ -1,2 +1,8 @@
+pub mod fan_in;
+// Public for the sockets bench only.
+#[cfg(feature = "bench")]
 pub mod memory;
+#[cfg(not(feature = "bench"))]
+pub(crate) mod memory;
+pub mod shm;
 pub mod zmq;
@@ -0,0 +1,720 @@
+//! Shared-memory ring transport for co-located services.
+//!
+//! A publisher owns a single-producer broadcast ring in a memory-mapped file. Any
+//! number of subscribers map the same file and follow the writer with their own
+//! private cursor, so fan-out costs nothing on the write side and the writer never
+//! waits for slow readers. A reader that falls a full ring behind skips ahead to
+//! the live position (the same drop-on-overflow behaviour as a ZMQ PUB socket).
+//!
+//! Records are `[len: u32][reserved: u32][payload][padding to 8 bytes]`. A record
+//! never wraps: when it does not fit before the end of the ring a wrap marker is
+//! written and the record starts again at offset 0. Readers copy a record out and
+//! then validate, seqlock-style, that the writer has not reserved past the point
+//! where it would have overwritten those bytes. Both sides access records with
+//! relaxed atomic word loads and stores, as the copy races with the writer.
+//!
+//! The protocol assumes a single writer per ring: a publisher holds an exclusive
+//! `flock` on the ring file, so a second one fails to open it. The lock goes with
+//! the process, so a successor can resume the ring of a crashed publisher.
+//!
+//! Idle readers park on the `notify_seq` futex of every ring they follow, and on
+//! the one of their `Wakeup`, in a single wait (see `futex::wait_any`).
+
+use crate::comms::address::Address;
+use crate::comms::futex::{self, Wait};
+use crate::comms::transport::{TransportInput, TransportOutput};
+use crate::comms::wakeup::Wakeup;
+use anyhow::{bail, Context, Result};
+use async_trait::async_trait;
+use std::fs::{File, OpenOptions};
+use std::path::PathBuf;
+use std::sync::atomic::{fence, AtomicU32, AtomicU64, Ordering};
+use std::time::{Duration, Instant};
+use tokio::runtime::RuntimeFlavor;
+
+const MAGIC: u64 = u64::from_le_bytes(*b"TLABRING");
+const VERSION: u32 = 1;
+/// Default size of the data region of a ring (4 MiB).
+pub const DEFAULT_CAPACITY: usize = 1 << 22;
+const RECORD_HEADER: usize = 8;
+const WRAP_MARKER: u32 = u32::MAX;
+/// How often a subscriber retries attaching to rings whose publisher is not up yet.
+const ATTACH_RETRY: Duration = Duration::from_millis(100);
+
+/// Header at the start of the mapped file. Hot fields live on their own cache lines.
+#[repr(C, align(64))]
+struct RingHeader {
+    /// Written last (release) once the rest of the header is initialised.
+    magic: AtomicU64,
+    version: u32,
+    _reserved: u32,
+    capacity: u64,
+    _pad0: [u8; 40],
+    /// End of the byte range the writer may currently be writing to.
+    reserve_pos: AtomicU64,
+    _pad1: [u8; 56],
+    /// End of the last fully written record.
+    write_pos: AtomicU64,
+    _pad2: [u8; 56],
+    /// Bumped after every publish; readers park on it with a futex.
+    notify_seq: AtomicU32,
+    /// Number of readers currently parked on `notify_seq`.
+    waiters: AtomicU32,
+    _pad3: [u8; 56],
+}
+
+const HEADER_LEN: usize = std::mem::size_of::<RingHeader>();
+
+/// Resolves a ring name to its backing file.
+///
+/// Absolute names are used as-is, others are placed in `/dev/shm` when available
+/// (falling back to the temporary directory).
+pub fn ring_path(name: &str) -> PathBuf {
+    if name.starts_with('/') {
+        return PathBuf::from(name);
+    }
+    let dir = PathBuf::from("/dev/shm");
+    let dir = if dir.is_dir() {
+        dir
+    } else {
+        std::env::temp_dir()
+    };
+    dir.join(format!("trading-lab.{}", name))
+}
+
+/// A shared mapping of a ring file.
+struct Mapping {
+    ptr: *mut u8,
+    len: usize,
+}
+
+// SAFETY: the mapping is plain shared memory; all cross-thread access to it goes
+// through the atomics in `RingHeader` or is validated by the seqlock protocol.
+unsafe impl Send for Mapping {}
+unsafe impl Sync for Mapping {}
+
+impl Mapping {
+    fn map(file: &File, len: usize) -> Result<Self> {
+        use std::os::unix::io::AsRawFd;
+        // SAFETY: mapping a regular file we hold open, with the length it was sized to.
+        let ptr = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                len,
+                libc::PROT_READ | libc::PROT_WRITE,
+                libc::MAP_SHARED,
+                file.as_raw_fd(),
+                0,
+            )
+        };
+        if ptr == libc::MAP_FAILED {
+            return Err(std::io::Error::last_os_error()).context("Failed to mmap ring file");
+        }
+        Ok(Self {
+            ptr: ptr as *mut u8,
+            len,
+        })
+    }
+
+    fn header(&self) -> &RingHeader {
+        // SAFETY: the mapping is page aligned and at least HEADER_LEN long.
+        unsafe { &*(self.ptr as *const RingHeader) }
+    }
+
+    fn data(&self) -> *mut u8 {
+        // SAFETY: the data region directly follows the header inside the mapping.
+        unsafe { self.ptr.add(HEADER_LEN) }
+    }
+}
+
+impl Drop for Mapping {
+    fn drop(&mut self) {
+        // SAFETY: unmapping exactly the region returned by mmap.
+        unsafe {
+            libc::munmap(self.ptr as *mut libc::c_void, self.len);
+        }
+    }
+}
+
+fn padded_len(len: usize) -> usize {
+    RECORD_HEADER + ((len + 7) & !7)
+}
+
+fn max_payload(capacity: usize) -> usize {
+    capacity / 4
+}
+
+/// Returns the 32-bit word at `ptr`, inside the data region of a mapping.
+///
+/// # Safety
+///
+/// `ptr` must be 4-aligned and inside a live mapping.
+unsafe fn word32<'a>(ptr: *mut u8) -> &'a AtomicU32 {
+    AtomicU32::from_ptr(ptr as *mut u32)
+}
+
+/// Returns the 64-bit word at `ptr`, inside the data region of a mapping.
+///
+/// # Safety
+///
+/// `ptr` must be 8-aligned and inside a live mapping.
+unsafe fn word64<'a>(ptr: *mut u8) -> &'a AtomicU64 {
+    AtomicU64::from_ptr(ptr as *mut u64)
+}
+
+/// Publisher side of a shared-memory ring (single producer).
+pub(crate) struct ShmPublisher {
+    map: Mapping,
+    capacity: usize,
+    /// Holds the writer lock of the ring.
+    _file: File,
+}
+
+impl ShmPublisher {
+    /// Creates (or re-attaches to) the ring named `name`.
+    ///
+    /// A valid ring left behind by a previous instance is resumed from its write
+    /// position so that already attached readers keep following it.
+    ///
+    /// # Arguments
+    ///
+    /// * `name` - Ring name, see `ring_path`.
+    /// * `capacity` - Size of the data region, rounded up to a power of two.
+    pub fn new(name: &str, capacity: usize) -> Result<Self> {
+        let capacity = capacity.max(4096).next_power_of_two();
+        let path = ring_path(name);
+        let file = OpenOptions::new()
+            .read(true)
+            .write(true)
+            .create(true)
+            .open(&path)
+            .with_context(|| format!("Failed to open ring file {:?}", path))?;
+        lock_writer(&file).with_context(|| format!("Ring {:?} already has a publisher", path))?;
+        let len = HEADER_LEN + capacity;
+        let reuse = file.metadata()?.len() == len as u64;
+        if !reuse {
+            file.set_len(len as u64)?;
+        }
+        let map = Mapping::map(&file, len)?;
+
+        let raw = map.ptr as *mut RingHeader;
+        // SAFETY: the header is inside the mapping; `magic` is only accessed atomically.
+        let valid = reuse
+            && unsafe {
+                (*raw).magic.load(Ordering::Acquire) == MAGIC
+                    && (*raw).version == VERSION
+                    && (*raw).capacity == capacity as u64
+            };
+        if !valid {
+            // SAFETY: we are the only producer, and readers ignore the header until
+            // `magic` is published with release ordering below.
+            unsafe {
+                (*raw).magic.store(0, Ordering::Release);
+                (*raw).version = VERSION;
+                (*raw).capacity = capacity as u64;
+                (*raw).reserve_pos.store(0, Ordering::Relaxed);
+                (*raw).write_pos.store(0, Ordering::Relaxed);
+                (*raw).magic.store(MAGIC, Ordering::Release);
+            }
+        } else {
+            // A previous writer may have died mid-record: roll the reservation back.
+            let header = map.header();
+            let committed = header.write_pos.load(Ordering::Acquire);
+            header.reserve_pos.store(committed, Ordering::Release);
+        }
+
+        Ok(Self {
+            map,
+            capacity,
+            _file: file,
+        })
+    }
+
+    fn publish(&mut self, data: &[u8]) -> Result<()> {
+        if data.len() > max_payload(self.capacity) {
+            bail!(
+                "Message of {} bytes exceeds the ring limit of {} bytes",
+                data.len(),
+                max_payload(self.capacity)
+            );
+        }
+        let header = self.map.header();
+        let mask = (self.capacity - 1) as u64;
+        let need = padded_len(data.len()) as u64;
+        let mut pos = header.write_pos.load(Ordering::Relaxed);
+
+        let offset = pos & mask;
+        if offset + need > self.capacity as u64 {
+            // Not enough room before the end: mark the tail as skipped and wrap.
+            let skip = self.capacity as u64 - offset;
+            header.reserve_pos.store(pos + skip, Ordering::Relaxed);
+            fence(Ordering::Release);
+            // SAFETY: offset is 8-aligned and at least 8 bytes remain before the end.
+            unsafe { word32(self.map.data().add(offset as usize)) }
+                .store(WRAP_MARKER, Ordering::Relaxed);
+            pos += skip;
+        }
+
+        header.reserve_pos.store(pos + need, Ordering::Relaxed);
+        fence(Ordering::Release);
+        let offset = (pos & mask) as usize;
+        // SAFETY: [offset, offset + need) lies inside the data region (checked above),
+        // and offset is 8-aligned.
+        unsafe {
+            let record = self.map.data().add(offset);
+            word32(record).store(data.len() as u32, Ordering::Relaxed);
+            word32(record.add(4)).store(0, Ordering::Relaxed);
+            let payload = record.add(RECORD_HEADER);
+            let mut words = data.chunks_exact(8);
+            for (index, word) in words.by_ref().enumerate() {
+                let word = u64::from_ne_bytes(word.try_into().unwrap());
+                word64(payload.add(index * 8)).store(word, Ordering::Relaxed);
+            }
+            let tail = words.remainder();
+            if !tail.is_empty() {
+                let mut word = [0u8; 8];
+                word[..tail.len()].copy_from_slice(tail);
+                word64(payload.add(data.len() & !7))
+                    .store(u64::from_ne_bytes(word), Ordering::Relaxed);
+            }
+        }
+        header.write_pos.store(pos + need, Ordering::Release);
+
+        header.notify_seq.fetch_add(1, Ordering::SeqCst);
+        if header.waiters.load(Ordering::SeqCst) > 0 {
+            futex::wake_all(&header.notify_seq, false);
+        }
+        Ok(())
+    }
+}
+
+/// Takes the exclusive writer lock of a ring file, without waiting.
+fn lock_writer(file: &File) -> Result<()> {
+    use std::os::unix::io::AsRawFd;
+    // SAFETY: locking a descriptor we hold open.
+    if unsafe { libc::flock(file.as_raw_fd(), libc::LOCK_EX | libc::LOCK_NB) } != 0 {
+        return Err(std::io::Error::last_os_error().into());
+    }
+    Ok(())
+}
+
+#[async_trait]
+impl TransportOutput for ShmPublisher {
+    async fn send_bytes(&mut self, data: &[u8]) -> Result<()> {
+        self.publish(data)
+    }
+}
+
+/// One attached ring and this reader's position in it.
+struct RingReader {
+    name: String,
+    map: Mapping,
+    capacity: usize,
+    cursor: u64,
+    dropped: u64,
+}
+
+impl RingReader {
+    /// Maps an existing ring, returning `Ok(None)` while its publisher is not up yet.
+    fn attach(name: &str) -> Result<Option<Self>> {
+        let path = ring_path(name);
+        let file = match OpenOptions::new().read(true).write(true).open(&path) {
+            Ok(file) => file,
+            Err(e) if e.kind() == std::io::ErrorKind::NotFound => return Ok(None),
+            Err(e) => return Err(e).with_context(|| format!("Failed to open ring {:?}", path)),
+        };
+        let len = file.metadata()?.len() as usize;
+        if len <= HEADER_LEN {
+            return Ok(None);
+        }
+        let map = Mapping::map(&file, len)?;
+        let header = map.header();
+        if header.magic.load(Ordering::Acquire) != MAGIC || header.version != VERSION {
+            return Ok(None);
+        }
+        let capacity = header.capacity as usize;
+        if !capacity.is_power_of_two() || HEADER_LEN + capacity != len {
+            bail!("Ring {:?} has an inconsistent header", path);
+        }
+        // Like a ZMQ subscriber, only messages published after joining are seen.
+        let cursor = header.write_pos.load(Ordering::Acquire);
+        Ok(Some(Self {
+            name: name.to_string(),
+            map,
+            capacity,
+            cursor,
+            dropped: 0,
+        }))
+    }
+
+    fn has_data(&self) -> bool {
+        self.map.header().write_pos.load(Ordering::Acquire) != self.cursor
+    }
+
+    /// Copies the next record into `out`. Returns `false` if the ring is empty.
+    fn read_into(&mut self, out: &mut Vec<u8>) -> bool {
+        let header = self.map.header();
+        let capacity = self.capacity as u64;
+        let mask = capacity - 1;
+        loop {
+            let write_pos = header.write_pos.load(Ordering::Acquire);
+            if write_pos < self.cursor {
+                // The publisher re-initialised the ring: resynchronise.
+                self.cursor = write_pos;
+            }
+            if write_pos == self.cursor {
+                return false;
+            }
+            if write_pos - self.cursor > capacity {
+                // Lapped by the writer: everything up to the live position is gone.
+                self.dropped += 1;
+                self.cursor = write_pos;
+                return false;
+            }
+
+            let offset = self.cursor & mask;
+            // SAFETY: offset is 8-aligned and inside the data region.
+            let record = unsafe { self.map.data().add(offset as usize) };
+            let len = unsafe { word32(record) }.load(Ordering::Relaxed);
+            if len == WRAP_MARKER {
+                self.cursor += capacity - offset;
+                continue;
+            }
+            let len = len as usize;
+            let need = padded_len(len) as u64;
+            if len > max_payload(self.capacity) || offset + need > capacity {
+                // Torn header: the writer is overwriting this slot.
+                self.dropped += 1;
+                self.cursor = header.write_pos.load(Ordering::Acquire);
+                continue;
+            }
+
+            out.clear();
+            let words = len.div_ceil(8);
+            out.reserve(words * 8);
+            // SAFETY: the padded record is inside the data region and 8-aligned, and
+            // `out` has room for its words. The copy may race with the writer; the
+            // check below discards it.
+            unsafe {
+                let payload = record.add(RECORD_HEADER);
+                let dst = out.as_mut_ptr();
+                for index in 0..words {
+                    let word = word64(payload.add(index * 8)).load(Ordering::Relaxed);
+                    (dst.add(index * 8) as *mut u64).write_unaligned(word);
+                }
+                out.set_len(len);
+            }
+            fence(Ordering::Acquire);
+            if header.reserve_pos.load(Ordering::Relaxed) > self.cursor + capacity {
+                // Overwritten while copying.
+                self.dropped += 1;
+                self.cursor = header.write_pos.load(Ordering::Acquire);
+                continue;
+            }
+            self.cursor += need;
+            return true;
+        }
+    }
+}
+
+/// Subscriber side of one or more shared-memory rings.
+pub(crate) struct ShmSubscriber {
+    rings: Vec<RingReader>,
+    /// Rings whose publisher has not created them yet.
+    pending: Vec<String>,
+    last_attach: Option<Instant>,
+    /// Round-robin start index so one busy ring cannot starve the others.
+    next: usize,
+    /// Receive buffer lent out by `recv_frame`, reused for every message.
+    frame: Vec<u8>,
+}
+
+impl ShmSubscriber {
+    pub fn new(name: &str) -> Result<Self> {
+        let mut subscriber = Self::new_empty();
+        subscriber.add(name)?;
+        Ok(subscriber)
+    }
+
+    pub fn new_empty() -> Self {
+        Self {
+            rings: Vec::new(),
+            pending: Vec::new(),
+            last_attach: None,
+            next: 0,
+            frame: Vec::new(),
+        }
+    }
+
+    /// Returns whether this subscriber follows (or waits for) any ring.
+    pub fn is_empty(&self) -> bool {
+        self.rings.is_empty() && self.pending.is_empty()
+    }
+
+    /// Number of messages lost because this reader was lapped by a writer.
+    pub fn dropped(&self) -> u64 {
+        self.rings.iter().map(|ring| ring.dropped).sum()
+    }
+
+    fn add(&mut self, name: &str) -> Result<()> {
+        if self.rings.iter().any(|r| r.name == name) || self.pending.iter().any(|n| n == name) {
+            return Ok(());
+        }
+        match RingReader::attach(name)? {
+            Some(ring) => self.rings.push(ring),
+            None => self.pending.push(name.to_string()),
+        }
+        Ok(())
+    }
+
+    fn remove(&mut self, name: &str) {
+        self.rings.retain(|r| r.name != name);
+        self.pending.retain(|n| n != name);
+    }
+
+    fn attach_pending(&mut self) {
+        if self.pending.is_empty() {
+            return;
+        }
+        if matches!(self.last_attach, Some(t) if t.elapsed() < ATTACH_RETRY) {
+            return;
+        }
+        self.last_attach = Some(Instant::now());
+        let mut still_pending = Vec::new();
+        for name in std::mem::take(&mut self.pending) {
+            match RingReader::attach(&name) {
+                Ok(Some(ring)) => self.rings.push(ring),
+                Ok(None) => still_pending.push(name),
+                Err(e) => {
+                    log::error!("Failed to attach shm ring '{}': {}", name, e);
+                    still_pending.push(name);
+                }
+            }
+        }
+        self.pending = still_pending;
+    }
+
+    /// Reads the next record from any ring into `self.frame`.
+    fn poll_frame(&mut self) -> bool {
+        self.attach_pending();
+        let count = self.rings.len();
+        for i in 0..count {
+            let index = (self.next + i) % count;
+            if self.rings[index].read_into(&mut self.frame) {
+                self.next = (index + 1) % count;
+                return true;
+            }
+        }
+        false
+    }
+
+    /// Returns whether any attached ring has an unread record.
+    pub fn has_data(&self) -> bool {
+        self.rings.iter().any(RingReader::has_data)
+    }
+
+    /// Blocks the calling thread until a ring is written to, `wakeup` fires or
+    /// `deadline` passes; may return early.
+    ///
+    /// While some rings are not up yet, parks until their next attach retry at most.
+    pub fn park(&mut self, wakeup: Option<&Wakeup>, deadline: Option<Instant>) {
+        self.attach_pending();
+        let deadline = match self.pending.is_empty() {
+            true => deadline,
+            false => {
+                let retry = Instant::now() + ATTACH_RETRY;
+                Some(deadline.map_or(retry, |deadline| deadline.min(retry)))
+            }
+        };
+        let mut waits = Vec::with_capacity(self.rings.len() + 1);
+        if let Some(wakeup) = wakeup {
+            let word = wakeup.futex_word();
+            let expected = word.load(Ordering::SeqCst);
+            if wakeup.is_pending() {
+                return;
+            }
+            waits.push(Wait {
+                word,
+                expected,
+                private: true,
+            });
+        }
+        for ring in &self.rings {
+            let header = ring.map.header();
+            header.waiters.fetch_add(1, Ordering::SeqCst);
+            waits.push(Wait {
+                word: &header.notify_seq,
+                expected: header.notify_seq.load(Ordering::SeqCst),
+                private: false,
+            });
+        }
+        if !self.has_data() {
+            futex::wait_any(&waits, deadline);
+        }
+        for ring in &self.rings {
+            ring.map.header().waiters.fetch_sub(1, Ordering::SeqCst);
+        }
+    }
+}
+
+/// Runs a futex park without stalling the other tasks of a multi-threaded runtime.
+fn park_blocking(park: impl FnOnce()) {
+    match tokio::runtime::Handle::try_current() {
+        Ok(handle) if handle.runtime_flavor() == RuntimeFlavor::MultiThread => {
+            crate::framework::executor::block_in_place(park)
+        }
+        _ => park(),
+    }
+}
+
+#[async_trait]
+impl TransportInput for ShmSubscriber {
+    async fn recv_bytes(&mut self) -> Result<Vec<u8>> {
+        Ok(self.recv_frame().await?.to_vec())
+    }
+
+    async fn try_recv(&mut self) -> Result<Vec<u8>> {
+        Ok(self.try_recv_frame().await?.to_vec())
+    }
+
+    async fn recv_frame(&mut self) -> Result<&[u8]> {
+        while !self.poll_frame() {
+            park_blocking(|| self.park(None, None));
+        }
+        Ok(&self.frame)
+    }
+
+    async fn try_recv_frame(&mut self) -> Result<&[u8]> {
+        if self.poll_frame() {
+            Ok(&self.frame)
+        } else {
+            bail!("Shm ring empty")
+        }
+    }
+
+    async fn wait_readable(&mut self, wakeup: &Wakeup, timeout: Option<Duration>) -> Result<bool> {
+        let deadline = timeout.map(|t| Instant::now() + t);
+        loop {
+            if self.has_data() {
+                return Ok(true);
+            }
+            if wakeup.is_pending() || deadline.is_some_and(|d| Instant::now() >= d) {
+                return Ok(false);
+            }
+            park_blocking(|| self.park(Some(wakeup), deadline));
+        }
+    }
+
+    async fn connect(&mut self, address: &Address) -> Result<()> {
+        match address {
+            Address::Shm(name) => self.add(name),
+            _ => bail!("ShmSubscriber only supports Shm addresses"),
+        }
+    }
+
+    async fn disconnect(&mut self, address: &Address) -> Result<()> {
+        match address {
+            Address::Shm(name) => {
+                self.remove(name);
+                Ok(())
+            }
+            _ => bail!("ShmSubscriber only supports Shm addresses"),
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn unique_name(tag: &str) -> String {
+        format!("test-{}-{}", tag, std::process::id())
+    }
+
+    #[tokio::test]
+    async fn test_fan_out_to_two_readers() {
+        let name = unique_name("fanout");
+        let mut publisher = ShmPublisher::new(&name, 4096).unwrap();
+        // A ring has a single writer.
+        assert!(ShmPublisher::new(&name, 4096).is_err());
+        let mut first = ShmSubscriber::new(&name).unwrap();
+        let mut second = ShmSubscriber::new(&name).unwrap();
+
+        // Enough traffic to wrap the ring several times.
+        for i in 0..1000u32 {
+            publisher.send_bytes(&i.to_le_bytes()).await.unwrap();
+            assert_eq!(first.try_recv_frame().await.unwrap(), &i.to_le_bytes());
+        }
+        // The second reader lagged further than the ring holds: it skips to the live edge.
+        assert!(second.try_recv_frame().await.is_err());
+        assert_eq!(second.dropped(), 1);
+        publisher.send_bytes(b"live").await.unwrap();
+        assert_eq!(second.try_recv_frame().await.unwrap(), b"live");
+        assert_eq!(first.try_recv_frame().await.unwrap(), b"live");
+
+        let _ = std::fs::remove_file(ring_path(&name));
+    }
+
+    #[tokio::test]
+    async fn test_subscriber_attaches_once_publisher_appears() {
+        let name = unique_name("late");
+        let _ = std::fs::remove_file(ring_path(&name));
+        let mut subscriber = ShmSubscriber::new(&name).unwrap();
+        assert!(subscriber.try_recv_frame().await.is_err());
+
+        let mut publisher = ShmPublisher::new(&name, 4096).unwrap();
+        subscriber.last_attach = None;
+        assert!(subscriber.try_recv_frame().await.is_err());
+        publisher.send_bytes(b"hello").await.unwrap();
+        assert_eq!(subscriber.try_recv_frame().await.unwrap(), b"hello");
+
+        let _ = std::fs::remove_file(ring_path(&name));
+    }
+
+    #[test]
+    fn test_park_wakes_on_any_ring_and_on_wakeup() {
+        let names = [unique_name("park-a"), unique_name("park-b")];
+        let mut publishers: Vec<_> = names
+            .iter()
+            .map(|name| ShmPublisher::new(name, 4096).unwrap())
+            .collect();
+        let mut subscriber = ShmSubscriber::new(&names[0]).unwrap();
+        subscriber.add(&names[1]).unwrap();
+        let wakeup = Wakeup::new().unwrap();
+        let park = |subscriber: &mut ShmSubscriber, done: &dyn Fn(&ShmSubscriber) -> bool| {
+            let started = Instant::now();
+            while !done(subscriber) {
+                subscriber.park(Some(&wakeup), Some(started + Duration::from_secs(10)));
+            }
+            started.elapsed()
+        };
+
+        // A write to the second ring ends the wait.
+        let writer = std::thread::spawn(move || {
+            std::thread::sleep(Duration::from_millis(20));
+            publishers[1].publish(b"b").unwrap();
+            publishers
+        });
+        assert!(
+            park(&mut subscriber, &|subscriber| subscriber.has_data()) < Duration::from_secs(5)
+        );
+        let _publishers = writer.join().unwrap();
+        assert!(subscriber.poll_frame());
+        assert_eq!(subscriber.frame, b"b");
+
+        // So does the wakeup.
+        let notifier = {
+            let wakeup = wakeup.clone();
+            std::thread::spawn(move || {
+                std::thread::sleep(Duration::from_millis(20));
+                wakeup.notify();
+            })
+        };
+        assert!(park(&mut subscriber, &|_| wakeup.is_pending()) < Duration::from_secs(5));
+        notifier.join().unwrap();
+
+        for name in &names {
+            let _ = std::fs::remove_file(ring_path(name));
+        }
+    }
+}
@@ -1,92 +1,252 @@
 use crate::comms::address::Address;
+use crate::comms::topic::{self, Topic};
 use crate::comms::transport::{TransportDuplex, TransportInput, TransportOutput};
-use anyhow::{Context, Result};
+use crate::comms::wakeup::Wakeup;
+use anyhow::{bail, Context, Result};
 use async_trait::async_trait;
-use std::sync::Mutex;
-use zmq::{Context as ZmqContext, Socket, SocketType};
+use std::os::unix::io::{AsRawFd, RawFd};
+use std::sync::atomic::{AtomicI32, Ordering};
+use std::sync::OnceLock;
+use std::time::Duration;
+use tokio::io::unix::AsyncFd;
+use tokio::io::Interest;
+use zmq::{Context as ZmqContext, PollEvents, Socket, SocketType};
 
-/// A thread-safe ZMQ Publisher wrapper.
+/// IO threads the shared context is created with (see `set_io_threads`).
+static IO_THREADS: AtomicI32 = AtomicI32::new(1);
+static CONTEXT: OnceLock<ZmqContext> = OnceLock::new();
+
+/// Returns the process-wide context shared by every ZMQ socket of this crate.
+fn context() -> &'static ZmqContext {
+    CONTEXT.get_or_init(|| {
+        let context = ZmqContext::new();
+        if let Err(e) = context.set_io_threads(IO_THREADS.load(Ordering::Relaxed)) {
+            log::warn!("Failed to set ZMQ IO threads: {}", e);
+        }
+        context
+    })
+}
+
+/// Sets the number of IO threads of the shared ZMQ context.
+///
+/// # Arguments
+///
+/// * `threads` - Number of IO threads, at least 1.
+///
+/// # Returns
+///
+/// * `Ok(())` if the setting will be applied.
+/// * `Err` if `threads` is invalid or a socket has already been created.
+pub fn set_io_threads(threads: i32) -> Result<()> {
+    if threads < 1 {
+        bail!("ZMQ needs at least one IO thread (got {})", threads);
+    }
+    if CONTEXT.get().is_some() {
+        bail!("ZMQ context already started, IO threads can no longer change");
+    }
+    IO_THREADS.store(threads, Ordering::Relaxed);
+    Ok(())
+}
+
+/// The `ZMQ_FD` of a socket, as registered with the tokio reactor.
+struct ZmqFd(RawFd);
+
+impl AsRawFd for ZmqFd {
+    fn as_raw_fd(&self) -> RawFd {
+        self.0
+    }
+}
+
+/// A ZMQ socket owned by a single task and driven by the tokio reactor.
 ///
-/// Implements `TransportOutput` by wrapping a synchronous `zmq::Socket` in a Mutex.
+/// Operations are always issued with `DONTWAIT`; on `EAGAIN` the task parks on the
+/// socket's `ZMQ_FD` instead of blocking its worker thread.
+struct AsyncSocket {
+    socket: Socket,
+    /// Registered lazily, on the runtime of the first task that has to wait.
+    fd: Option<AsyncFd<ZmqFd>>,
+}
+
+impl AsyncSocket {
+    fn new(socket_type: SocketType) -> Result<Self> {
+        Ok(Self {
+            socket: context().socket(socket_type)?,
+            fd: None,
+        })
+    }
+
+    /// Waits until the socket reports any of `events`.
+    async fn ready(&mut self, events: PollEvents) -> Result<()> {
+        if self.fd.is_none() {
+            let fd = ZmqFd(self.socket.get_fd()?);
+            self.fd = Some(AsyncFd::with_interest(fd, Interest::READABLE)?);
+        }
+        let fd = self.fd.as_ref().unwrap();
+        loop {
+            // ZMQ_FD is edge-triggered and only says that ZMQ_EVENTS must be read again.
+            if self.socket.get_events()?.contains(events) {
+                return Ok(());
+            }
+            fd.readable().await?.clear_ready();
+        }
+    }
+
+    async fn send(&mut self, data: &[u8]) -> Result<()> {
+        loop {
+            match self.socket.send(data, zmq::DONTWAIT) {
+                Ok(()) => return Ok(()),
+                Err(zmq::Error::EAGAIN) => self.ready(zmq::POLLOUT).await?,
+                Err(e) => return Err(e).context("Failed to send ZMQ message (Transport)"),
+            }
+        }
+    }
+
+    async fn recv(&mut self, frame: &mut zmq::Message) -> Result<()> {
+        loop {
+            match self.socket.recv(frame, zmq::DONTWAIT) {
+                Ok(()) => return Ok(()),
+                Err(zmq::Error::EAGAIN) => self.ready(zmq::POLLIN).await?,
+                Err(e) => return Err(e).context("Failed to receive data payload"),
+            }
+        }
+    }
+}
+
+/// A ZMQ Publisher.
+///
+/// Implements `TransportOutput` on a socket of the shared context. A PUB socket
+/// drops messages at its high-water mark instead of blocking, so sends never wait.
 pub(crate) struct ZmqPublisher {
-    socket: Mutex<Socket>,
+    socket: Socket,
 }
 
 impl ZmqPublisher {
     pub fn new(address: &str) -> Result<Self> {
-        let context = ZmqContext::new();
-        let socket = context.socket(SocketType::PUB)?;
+        let socket = context().socket(SocketType::PUB)?;
         socket.bind(address)?;
-        Ok(Self {
-            socket: Mutex::new(socket),
-        })
+        Ok(Self { socket })
     }
 }
 
 #[async_trait]
 impl TransportOutput for ZmqPublisher {
-    async fn send_bytes(&self, data: &[u8]) -> Result<()> {
-        let socket = self.socket.lock().unwrap();
-        // ZMQ is fast enough that we can use the blocking call inside the lock
-        socket
-            .send(data, 0)
+    async fn send_bytes(&mut self, data: &[u8]) -> Result<()> {
+        // Untopiced messages go to `ALL`, where every subscriber without a
+        // universe listens.
+        self.send_topic(&topic::ALL, data).await
+    }
+
+    fn supports_topics(&self) -> bool {
+        true
+    }
+
+    async fn send_topic(&mut self, topic: &Topic, data: &[u8]) -> Result<()> {
+        // Multipart messages are queued (or dropped at the high-water mark) whole.
+        self.socket
+            .send(&topic[..], zmq::SNDMORE | zmq::DONTWAIT)
+            .context("Failed to send ZMQ topic (Transport)")?;
+        self.socket
+            .send(data, zmq::DONTWAIT)
             .context("Failed to send ZMQ message (Transport)")
     }
 }
 
-/// A thread-safe ZMQ Subscriber wrapper.
+/// A ZMQ Subscriber.
+///
+/// Receives the `[topic, payload]` multipart messages of `ZmqPublisher`, on `ALL`
+/// unless subscribed to other topics; the topic frame is only used for filtering
+/// and never lent out.
 pub(crate) struct ZmqSubscriber {
-    socket: Mutex<Socket>,
+    socket: AsyncSocket,
+    /// Receive buffer lent out by `recv_frame`, reused for every message.
+    frame: zmq::Message,
+    /// Active subscription prefixes.
+    subscriptions: Vec<Vec<u8>>,
 }
 
 impl ZmqSubscriber {
     pub fn new(address: &str) -> Result<Self> {
-        let context = ZmqContext::new();
-        let socket = context.socket(SocketType::SUB)?;
-        socket.connect(address)?;
-        // Subscribe to everything
-        socket.set_subscribe(b"")?;
-        Ok(Self {
-            socket: Mutex::new(socket),
-        })
+        let subscriber = Self::new_empty()?;
+        subscriber.socket.socket.connect(address)?;
+        Ok(subscriber)
     }
 
     pub fn new_empty() -> Result<Self> {
-        let context = ZmqContext::new();
-        let socket = context.socket(SocketType::SUB)?;
-        // Subscribe to everything
-        socket.set_subscribe(b"")?;
+        let socket = AsyncSocket::new(SocketType::SUB)?;
+        // Whole messages only, until subscribed to partitions.
+        socket.socket.set_subscribe(&topic::ALL)?;
         Ok(Self {
-            socket: Mutex::new(socket),
+            socket,
+            frame: zmq::Message::new(),
+            subscriptions: vec![topic::ALL.to_vec()],
         })
     }
+
+    /// Returns the frame filled by the last successful `recv_frame`/`try_recv_frame`.
+    pub fn last_frame(&self) -> Result<&[u8]> {
+        Ok(&self.frame[..])
+    }
+
+    /// Replaces a topic frame just received by the payload that follows it.
+    ///
+    /// The parts of a multipart message are delivered together, so the payload is
+    /// already queued and the non-blocking receive cannot miss it.
+    fn skip_topic(&mut self) -> Result<()> {
+        while self.frame.get_more() {
+            self.socket
+                .socket
+                .recv(&mut self.frame, zmq::DONTWAIT)
+                .context("Failed to receive data payload")?;
+        }
+        Ok(())
+    }
 }
 
 #[async_trait]
 impl TransportInput for ZmqSubscriber {
     async fn recv_bytes(&mut self) -> Result<Vec<u8>> {
-        let socket = self.socket.lock().unwrap();
-        // Just read the data frame
-        let data = socket
-            .recv_bytes(0)
-            .context("Failed to receive data payload")?;
-        Ok(data)
+        Ok(self.recv_frame().await?.to_vec())
     }
 
     async fn try_recv(&mut self) -> Result<Vec<u8>> {
-        let socket = self.socket.lock().unwrap();
-        // Just read the data frame
-        let data = socket
-            .recv_bytes(zmq::DONTWAIT)
+        Ok(self.try_recv_frame().await?.to_vec())
+    }
+
+    async fn recv_frame(&mut self) -> Result<&[u8]> {
+        self.socket.recv(&mut self.frame).await?;
+        self.skip_topic()?;
+        Ok(&self.frame[..])
+    }
+
+    async fn try_recv_frame(&mut self) -> Result<&[u8]> {
+        self.socket
+            .socket
+            .recv(&mut self.frame, zmq::DONTWAIT)
             .context("Failed to receive data payload")?;
-        Ok(data)
+        self.skip_topic()?;
+        Ok(&self.frame[..])
+    }
+
+    async fn wait_readable(&mut self, wakeup: &Wakeup, timeout: Option<Duration>) -> Result<bool> {
+        // Wait on the reactor for either the data socket or the control wakeup, so
+        // the worker thread stays free while the runner is idle.
+        let deadline = async {
+            match timeout {
+                Some(timeout) => tokio::time::sleep(timeout).await,
+                None => std::future::pending().await,
+            }
+        };
+        tokio::select! {
+            ready = self.socket.ready(zmq::POLLIN) => ready.map(|_| true),
+            _ = wakeup.notified() => Ok(false),
+            _ = deadline => Ok(false),
+        }
     }
 
     async fn connect(&mut self, address: &Address) -> Result<()> {
-        let socket = self.socket.lock().unwrap();
         match address {
             Address::Zmq(endpoint) => {
-                socket.connect(endpoint)?;
+                self.socket.socket.connect(endpoint)?;
                 Ok(())
             }
             _ => anyhow::bail!("ZmqSubscriber only supports Zmq addresses"),
@@ -94,82 +254,91 @@ impl TransportInput for ZmqSubscriber {
     }
 
     async fn disconnect(&mut self, address: &Address) -> Result<()> {
-        let socket = self.socket.lock().unwrap();
         match address {
             Address::Zmq(endpoint) => {
-                socket.disconnect(endpoint)?;
+                self.socket.socket.disconnect(endpoint)?;
                 Ok(())
             }
             _ => anyhow::bail!("ZmqSubscriber only supports Zmq addresses"),
         }
     }
+
+    fn subscribe(&mut self, topics: &[Topic]) -> Result<()> {
+        let wanted: Vec<Vec<u8>> = if topics.is_empty() {
+            vec![topic::ALL.to_vec()]
+        } else {
+            topics.iter().map(|topic| topic.to_vec()).collect()
+        };
+        // Subscribe first so there is no window subscribed to nothing.
+        for prefix in &wanted {
+            if !self.subscriptions.contains(prefix) {
+                self.socket.socket.set_subscribe(prefix)?;
+            }
+        }
+        for prefix in &self.subscriptions {
+            if !wanted.contains(prefix) {
+                self.socket.socket.set_unsubscribe(prefix)?;
+            }
+        }
+        self.subscriptions = wanted;
+        Ok(())
+    }
 }
 
+/// A ZMQ Reply wrapper (Server).
 pub struct ZmqDuplex {
-    socket: Mutex<Socket>,
+    socket: AsyncSocket,
+    frame: zmq::Message,
 }
 
 impl ZmqDuplex {
     pub fn new(address: &str) -> Result<Self> {
-        let context = ZmqContext::new();
-        let socket = context.socket(SocketType::REP)?;
-        socket.bind(address)?;
+        let socket = AsyncSocket::new(SocketType::REP)?;
+        socket.socket.bind(address)?;
         Ok(Self {
-            socket: Mutex::new(socket),
+            socket,
+            frame: zmq::Message::new(),
         })
     }
 }
 
 #[async_trait]
 impl TransportDuplex for ZmqDuplex {
-    async fn send_bytes(&self, data: &[u8]) -> Result<()> {
-        let socket = self.socket.lock().unwrap();
-        // ZMQ is fast enough that we can use the blocking call inside the lock
-        socket
-            .send(data, 0)
-            .context("Failed to send ZMQ message (Transport)")
+    async fn send_bytes(&mut self, data: &[u8]) -> Result<()> {
+        self.socket.send(data).await
     }
 
     async fn recv_bytes(&mut self) -> Result<Vec<u8>> {
-        let socket = self.socket.lock().unwrap();
-        // Just read the data frame
-        let data = socket
-            .recv_bytes(0)
-            .context("Failed to receive data payload")?;
-        Ok(data)
+        self.socket.recv(&mut self.frame).await?;
+        Ok(self.frame.to_vec())
     }
 }
 
-/// A thread-safe ZMQ Request wrapper (Client).
+/// A ZMQ Request wrapper (Client).
 pub struct ZmqClientDuplex {
-    socket: Mutex<Socket>,
+    socket: AsyncSocket,
+    frame: zmq::Message,
 }
 
 impl ZmqClientDuplex {
     pub fn new(address: &str) -> Result<Self> {
-        let context = ZmqContext::new();
-        let socket = context.socket(SocketType::REQ)?;
-        socket.connect(address)?;
+        let socket = AsyncSocket::new(SocketType::REQ)?;
+        socket.socket.connect(address)?;
         Ok(Self {
-            socket: Mutex::new(socket),
+            socket,
+            frame: zmq::Message::new(),
         })
     }
 }
 
 #[async_trait]
 impl TransportDuplex for ZmqClientDuplex {
-    async fn send_bytes(&self, data: &[u8]) -> Result<()> {
-        let socket = self.socket.lock().unwrap();
-        socket
-            .send(data, 0)
-            .context("Failed to send ZMQ message (Transport)")
+    async fn send_bytes(&mut self, data: &[u8]) -> Result<()> {
+        self.socket.send(data).await
     }
 
     async fn recv_bytes(&mut self) -> Result<Vec<u8>> {
-        let socket = self.socket.lock().unwrap();
-        let data = socket
-            .recv_bytes(0)
-            .context("Failed to receive data payload")?;
-        Ok(data)
+        self.socket.recv(&mut self.frame).await?;
+        Ok(self.frame.to_vec())
     }
 }
@@ -0,0 +1,124 @@
+//! Cross-thread wakeup signal for blocking input waits.
+//!
+//! A `Wakeup` lets a controlling thread interrupt a runner that is parked inside
+//! `TransportInput::wait_readable`. It exposes a pollable file descriptor (so it can
+//! sit next to a ZMQ socket in a single `zmq::poll` call), a futex word (so shm
+//! readers park on it next to their rings) as well as an async notification for
+//! in-process transports that have neither.
+
+use anyhow::{Context, Result};
+use std::io::ErrorKind;
+use std::os::unix::io::{AsRawFd, RawFd};
+use std::os::unix::net::UnixDatagram;
+use std::sync::atomic::{AtomicBool, AtomicU32, Ordering};
+use std::sync::Arc;
+use tokio::sync::Notify;
+
+struct Inner {
+    tx: UnixDatagram,
+    rx: UnixDatagram,
+    notify: Notify,
+    pending: AtomicBool,
+    /// Bumped by every `notify`.
+    futex: AtomicU32,
+}
+
+/// A cloneable, level-triggered wakeup signal.
+///
+/// Every clone refers to the same underlying signal: `notify` on one clone wakes
+/// whoever is waiting on another.
+#[derive(Clone)]
+pub struct Wakeup {
+    inner: Arc<Inner>,
+}
+
+impl Wakeup {
+    /// Creates a new wakeup signal backed by a non-blocking datagram socket pair.
+    ///
+    /// # Returns
+    ///
+    /// * `Ok(Wakeup)` if the socket pair could be created.
+    /// * `Err` if the OS refused to allocate the descriptors.
+    pub fn new() -> Result<Self> {
+        let (tx, rx) = UnixDatagram::pair().context("Failed to create wakeup socket pair")?;
+        tx.set_nonblocking(true)?;
+        rx.set_nonblocking(true)?;
+        Ok(Self {
+            inner: Arc::new(Inner {
+                tx,
+                rx,
+                notify: Notify::new(),
+                pending: AtomicBool::new(false),
+                futex: AtomicU32::new(0),
+            }),
+        })
+    }
+
+    /// Signals the waiting side.
+    ///
+    /// The signal stays pending until `drain` is called, so a notification sent
+    /// before the waiter parks is never lost.
+    pub fn notify(&self) {
+        self.inner.pending.store(true, Ordering::SeqCst);
+        // A full socket buffer already means "pending", so WouldBlock is fine to ignore.
+        let _ = self.inner.tx.send(&[1]);
+        self.inner.futex.fetch_add(1, Ordering::SeqCst);
+        super::futex::wake_all(&self.inner.futex, true);
+        self.inner.notify.notify_one();
+    }
+
+    /// Clears every pending signal.
+    pub fn drain(&self) {
+        self.inner.pending.store(false, Ordering::Release);
+        let mut buf = [0u8; 64];
+        loop {
+            match self.inner.rx.recv(&mut buf) {
+                Ok(_) => continue,
+                Err(e) if e.kind() == ErrorKind::Interrupted => continue,
+                Err(_) => break,
+            }
+        }
+    }
+
+    /// Returns whether a signal is pending, without clearing it.
+    pub fn is_pending(&self) -> bool {
+        self.inner.pending.load(Ordering::SeqCst)
+    }
+
+    /// Returns the private futex word bumped by `notify`.
+    ///
+    /// A waiter loads it before checking `is_pending`, then parks on it with the
+    /// loaded value: a signal sent in between fails the park instead of being missed.
+    pub(crate) fn futex_word(&self) -> &AtomicU32 {
+        &self.inner.futex
+    }
+
+    /// Completes once `notify` has been called (for transports without a descriptor).
+    pub async fn notified(&self) {
+        self.inner.notify.notified().await
+    }
+}
+
+impl AsRawFd for Wakeup {
+    /// The descriptor becomes readable whenever a signal is pending.
+    fn as_raw_fd(&self) -> RawFd {
+        self.inner.rx.as_raw_fd()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::time::Duration;
+
+    #[tokio::test]
+    async fn test_notify_before_wait_is_not_lost() {
+        let wakeup = Wakeup::new().unwrap();
+        wakeup.clone().notify();
+
+        tokio::time::timeout(Duration::from_millis(100), wakeup.notified())
+            .await
+            .expect("pending notification should complete immediately");
+        wakeup.drain();
+    }
+}
@@ -0,0 +1,260 @@
+//! C-compatible bindings for C++ integration.
+//!
+//! A C++ strategy links `libtrading_core.a` and hands its market data callback to
+//! `trading_core_run_strategy`, which runs the same Strategy service as a Rust
+//! strategy: bindings, runners, transports and admin port included. The callback
+//! gets the columns of every `MarketDataBatch` in place (borrowed from the receive
+//! buffer where the archived layout allows it) and writes its allocation through
+//! an `AllocationWriter`, so no extra serialization hop is involved.
+//!
+//! `include/trading_core.hpp` declares this ABI and wraps it in `std::span`s.
+
+use crate::framework::boot_strategy;
+use std::ffi::{c_char, c_void, CStr};
+use std::panic::{catch_unwind, AssertUnwindSafe};
+use trading::model::allocation::Allocation;
+use trading::model::allocation_batch::AllocationBatch;
+use trading::model::instrument::InstrumentId;
+use trading::model::market_data::{MarketDataBatch, MarketDataBatchView};
+use trading::model::positions::Positions;
+use trading::traits::strategist::Strategist;
+
+/// The columns of a market data batch, valid for the duration of the callback.
+#[repr(C)]
+pub struct MarketDataColumns {
+    pub len: usize,
+    pub instrument_ids: *const InstrumentId,
+    pub bid_prices: *const f64,
+    pub ask_prices: *const f64,
+    pub last_prices: *const f64,
+    pub timestamps: *const u64,
+}
+
+/// The allocation a callback is building; opaque to C++.
+pub struct AllocationWriter {
+    positions: Positions,
+    written: bool,
+}
+
+/// Called with every market data batch.
+///
+/// `user_data` is the pointer given to `trading_core_run_strategy`. The callback
+/// must not unwind: C++ exceptions have to be caught before returning.
+pub type MarketDataCallback = unsafe extern "C" fn(
+    user_data: *mut c_void,
+    md: *const MarketDataColumns,
+    allocation: *mut AllocationWriter,
+);
+
+/// A strategy implemented behind the C ABI.
+struct ForeignStrategy {
+    callback: MarketDataCallback,
+    user_data: *mut c_void,
+    /// The batch last published, handed back by the runner: the next callback
+    /// writes into its positions, so the steady state allocates nothing.
+    spare: AllocationBatch,
+}
+
+// The runner calls the strategy from its own thread, one batch at a time under the
+// state lock; the C++ side is told so in the header.
+unsafe impl Send for ForeignStrategy {}
+
+impl ForeignStrategy {
+    fn new(callback: MarketDataCallback, user_data: *mut c_void) -> Self {
+        Self {
+            callback,
+            user_data,
+            spare: AllocationBatch::default(),
+        }
+    }
+}
+
+impl Strategist for ForeignStrategy {
+    fn on_market_data(&mut self, md: MarketDataBatch) -> AllocationBatch {
+        self.on_market_data_view(md.view())
+    }
+
+    fn on_market_data_view(&mut self, md: MarketDataBatchView<'_>) -> AllocationBatch {
+        let columns = MarketDataColumns {
+            len: md.get_count(),
+            instrument_ids: md.get_instrument_ids().as_ptr(),
+            bid_prices: md.get_bid_prices().as_ptr(),
+            ask_prices: md.get_ask_prices().as_ptr(),
+            last_prices: md.get_last_prices().as_ptr(),
+            timestamps: md.get_timestamps().as_ptr(),
+        };
+        let mut allocations: Vec<Allocation> = std::mem::take(&mut self.spare).into();
+        let mut positions = allocations
+            .pop()
+            .map(Allocation::into_positions)
+            .unwrap_or_default();
+        positions.clear();
+        allocations.clear();
+        let mut writer = AllocationWriter {
+            positions,
+            written: false,
+        };
+        unsafe { (self.callback)(self.user_data, &columns, &mut writer) };
+
+        allocations.push(Allocation::from_positions(writer.positions));
+        let batch = AllocationBatch::new(allocations);
+        if !writer.written {
+            // Nothing to publish: the buffers wait for the next batch.
+            self.spare = batch;
+            return AllocationBatch::default();
+        }
+        batch
+    }
+
+    fn recycle(&mut self, batch: AllocationBatch) {
+        self.spare = batch;
+    }
+}
+
+/// Sets the target quantity of one instrument; 0 removes it.
+///
+/// # Safety
+///
+/// `allocation` must be the writer passed to the running callback.
+#[no_mangle]
+pub unsafe extern "C" fn trading_core_allocation_set(
+    allocation: *mut AllocationWriter,
+    instrument_id: InstrumentId,
+    quantity: f64,
+) {
+    let writer = &mut *allocation;
+    writer.positions.set(instrument_id, quantity);
+    writer.written = true;
+}
+
+/// Sets the target quantities of many instruments from caller-owned buffers.
+/// Buffers sorted by instrument id are appended without any shifting.
+///
+/// # Safety
+///
+/// `allocation` must be the writer passed to the running callback, and both
+/// buffers must hold `len` elements.
+#[no_mangle]
+pub unsafe extern "C" fn trading_core_allocation_set_many(
+    allocation: *mut AllocationWriter,
+    instrument_ids: *const InstrumentId,
+    quantities: *const f64,
+    len: usize,
+) {
+    let writer = &mut *allocation;
+    if len > 0 {
+        let ids = std::slice::from_raw_parts(instrument_ids, len);
+        let quantities = std::slice::from_raw_parts(quantities, len);
+        for (&id, &quantity) in ids.iter().zip(quantities) {
+            writer.positions.set(id, quantity);
+        }
+    }
+    writer.written = true;
+}
+
+/// Runs a Strategy service around `callback`, until the service is shut down.
+///
+/// Arguments are read from the command line of the process, as for any service.
+///
+/// # Safety
+///
+/// `version` and `description` must be NUL-terminated strings, and `user_data`
+/// must stay valid for the lifetime of the service.
+///
+/// # Returns
+///
+/// 0 once the service stopped, 1 if it failed.
+#[no_mangle]
+pub unsafe extern "C" fn trading_core_run_strategy(
+    callback: MarketDataCallback,
+    user_data: *mut c_void,
+    version: *const c_char,
+    description: *const c_char,
+) -> i32 {
+    let version = CStr::from_ptr(version).to_string_lossy().into_owned();
+    let description = CStr::from_ptr(description).to_string_lossy().into_owned();
+    let strategy = ForeignStrategy::new(callback, user_data);
+    // A panic must not unwind into the C++ caller.
+    match catch_unwind(AssertUnwindSafe(|| {
+        boot_strategy(Box::new(strategy), &version, &description)
+    })) {
+        Ok(()) => 0,
+        Err(_) => {
+            log::error!("Strategy service '{}' panicked", description);
+            1
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use trading::model::market_data::PriceUpdate;
+
+    /// Targets the instruments whose bid is above 10, sized by their ask; writes
+    /// nothing if there are none.
+    unsafe extern "C" fn select(
+        user_data: *mut c_void,
+        md: *const MarketDataColumns,
+        allocation: *mut AllocationWriter,
+    ) {
+        let md = &*md;
+        *(user_data as *mut *const f64) = md.bid_prices;
+        let ids = std::slice::from_raw_parts(md.instrument_ids, md.len);
+        let bids = std::slice::from_raw_parts(md.bid_prices, md.len);
+        let asks = std::slice::from_raw_parts(md.ask_prices, md.len);
+        let (mut out_ids, mut out_quantities) = (Vec::new(), Vec::new());
+        for i in 0..md.len {
+            if bids[i] > 10.0 {
+                out_ids.push(ids[i]);
+                out_quantities.push(asks[i]);
+            }
+        }
+        if out_ids.is_empty() {
+            return;
+        }
+        trading_core_allocation_set_many(
+            allocation,
+            out_ids.as_ptr(),
+            out_quantities.as_ptr(),
+            out_ids.len(),
+        );
+    }
+
+    #[test]
+    fn test_callback_reads_columns_in_place() {
+        let mut seen: *const f64 = std::ptr::null();
+        let mut strategy =
+            ForeignStrategy::new(select, &mut seen as *mut *const f64 as *mut c_void);
+        let batch = MarketDataBatch::new(vec![
+            PriceUpdate::new(1, 9.0, 9.5, 9.2, 0),
+            PriceUpdate::new(2, 11.0, 11.5, 11.2, 0),
+            PriceUpdate::new(3, 12.0, 12.5, 12.2, 0),
+        ]);
+
+        let view = batch.view();
+        let allocations = strategy.on_market_data_view(view);
+        assert_eq!(seen, batch.get_bid_prices().as_ptr());
+
+        let allocation = &allocations.get_allocations()[0];
+        assert!(allocation.get_position(1).is_none());
+        assert_eq!(allocation.get_position(2).unwrap().get_quantity(), 11.5);
+        assert_eq!(allocation.get_position(3).unwrap().get_quantity(), 12.5);
+
+        // A recycled batch is refilled in place.
+        let buffer = allocation.get_positions().as_slice().as_ptr();
+        strategy.recycle(allocations);
+        let allocations = strategy.on_market_data_view(batch.view());
+        let positions = allocations.get_allocations()[0].get_positions();
+        assert_eq!(positions.as_slice().as_ptr(), buffer);
+        assert_eq!(positions.len(), 2);
+
+        // Nothing written, nothing to publish.
+        strategy.recycle(allocations);
+        let quiet = MarketDataBatch::new(vec![PriceUpdate::new(1, 9.0, 9.5, 9.2, 0)]);
+        assert!(strategy.on_market_data_view(quiet.view()).is_empty());
+        let allocations = strategy.on_market_data_view(batch.view());
+        let positions = allocations.get_allocations()[0].get_positions();
+        assert_eq!(positions.as_slice().as_ptr(), buffer);
+    }
+}
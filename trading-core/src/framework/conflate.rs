@@ -0,0 +1,192 @@
+//! Latest-value conflation of input streams.
+//!
+//! A consumer that falls behind would otherwise work through every stale snapshot
+//! queued on its socket, and its latency would keep growing with the backlog. A
+//! conflating runner drains the backlog first and folds it down to the latest value
+//! per stream, so each pass costs one handler call per stream whatever the burst.
+
+use crate::model::identity::Id;
+use crate::model::instrument::InstrumentId;
+use crate::model::market_data::{MarketDataBatch, PriceUpdate};
+use crate::model::portfolio::Actual;
+use std::collections::hash_map::{Entry, HashMap};
+use std::hash::Hash;
+
+/// A message whose backlog can be collapsed to its latest state.
+///
+/// Messages from the same sender with the same `key` belong to one stream; a
+/// conflating runner keeps one pending value per stream and folds every newer
+/// message of the stream into it.
+pub trait Conflate: Sized {
+    /// Identifies the stream of a message within its sender.
+    type Key: Eq + Hash + Clone + Send;
+
+    /// What a fold learns about the pending value, kept for the next fold of the
+    /// stream and reset once the value is taken.
+    type Index: Default + Send;
+
+    /// Returns the stream this message belongs to.
+    fn key(&self) -> Self::Key;
+
+    /// Folds a newer message of the same stream into this one.
+    ///
+    /// # Arguments
+    ///
+    /// * `newer` - The newer message.
+    /// * `index` - The index of this value, default before its first fold.
+    fn conflate(&mut self, newer: Self, index: &mut Self::Index);
+
+    /// Resets an index for the next pending value, keeping its allocations.
+    fn reset(index: &mut Self::Index) {
+        *index = Self::Index::default();
+    }
+}
+
+/// Portfolio snapshots are complete: the newest one supersedes the others.
+impl Conflate for Actual {
+    type Key = ();
+    type Index = ();
+
+    fn key(&self) -> Self::Key {}
+
+    fn conflate(&mut self, newer: Self, _index: &mut ()) {
+        *self = newer;
+    }
+}
+
+/// Batches are merged, keeping the latest prices of every instrument seen. The
+/// index holds the row of every instrument of the pending batch.
+impl Conflate for MarketDataBatch {
+    type Key = ();
+    type Index = HashMap<InstrumentId, usize>;
+
+    fn key(&self) -> Self::Key {}
+
+    fn conflate(&mut self, newer: Self, rows: &mut Self::Index) {
+        self.merge_latest_indexed(&newer, rows);
+    }
+
+    fn reset(rows: &mut Self::Index) {
+        rows.clear();
+    }
+}
+
+/// One stream per instrument.
+impl Conflate for PriceUpdate {
+    type Key = InstrumentId;
+    type Index = ();
+
+    fn key(&self) -> Self::Key {
+        self.get_instrument_id()
+    }
+
+    fn conflate(&mut self, newer: Self, _index: &mut ()) {
+        *self = newer;
+    }
+}
+
+/// The pending values of a conflating runner, one per stream, type-erased so that
+/// runners need no `Conflate` bound outside of their constructor.
+pub(crate) trait Backlog<Input>: Send {
+    /// Queues a received message.
+    ///
+    /// # Returns
+    ///
+    /// `true` if it was folded into a pending value of its stream.
+    fn push(&mut self, id: Id, input: Input) -> bool;
+
+    /// Takes the pending values, in the order their streams first showed up.
+    fn drain(&mut self) -> std::vec::Drain<'_, (Id, Input)>;
+
+    fn is_empty(&self) -> bool;
+}
+
+/// `Backlog` keeping the latest value of every (sender, key) stream.
+pub(crate) struct Latest<Input: Conflate> {
+    pending: Vec<(Id, Input)>,
+    slots: HashMap<(Id, Input::Key), usize>,
+    /// The index of every pending value, by position; kept, reset, across drains.
+    indexes: Vec<Input::Index>,
+}
+
+impl<Input: Conflate> Latest<Input> {
+    pub(crate) fn new() -> Self {
+        Self {
+            pending: Vec::new(),
+            slots: HashMap::new(),
+            indexes: Vec::new(),
+        }
+    }
+}
+
+impl<Input: Conflate + Send> Backlog<Input> for Latest<Input> {
+    fn push(&mut self, id: Id, input: Input) -> bool {
+        match self.slots.entry((id, input.key())) {
+            Entry::Occupied(slot) => {
+                let position = *slot.get();
+                self.pending[position]
+                    .1
+                    .conflate(input, &mut self.indexes[position]);
+                true
+            }
+            Entry::Vacant(slot) => {
+                slot.insert(self.pending.len());
+                self.pending.push((id, input));
+                if self.indexes.len() < self.pending.len() {
+                    self.indexes.push(Input::Index::default());
+                }
+                false
+            }
+        }
+    }
+
+    fn drain(&mut self) -> std::vec::Drain<'_, (Id, Input)> {
+        self.slots.clear();
+        for index in &mut self.indexes[..self.pending.len()] {
+            Input::reset(index);
+        }
+        self.pending.drain(..)
+    }
+
+    fn is_empty(&self) -> bool {
+        self.pending.is_empty()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_latest_folds_each_stream() {
+        let mut latest = Latest::new();
+        let update = |id, last| PriceUpdate::new(id, last, last, last, 0);
+        assert!(!latest.push(1, update(7, 1.0)));
+        assert!(!latest.push(1, update(8, 2.0)));
+        assert!(latest.push(1, update(7, 3.0)));
+        assert!(!latest.push(2, update(7, 4.0)));
+
+        let drained: Vec<_> = latest
+            .drain()
+            .map(|(id, update)| (id, update.get_instrument_id(), update.get_last()))
+            .collect();
+        assert_eq!(drained, vec![(1, 7, 3.0), (1, 8, 2.0), (2, 7, 4.0),]);
+        assert!(latest.is_empty());
+
+        let mut batches = Latest::new();
+        let batch = |updates| MarketDataBatch::new(updates);
+        batches.push(1, batch(vec![update(1, 1.0), update(2, 2.0)]));
+        batches.push(1, batch(vec![update(3, 3.0), update(1, 4.0)]));
+        batches.push(1, batch(vec![update(3, 5.0)]));
+        let (_, merged) = batches.drain().next().unwrap();
+        assert_eq!(merged.get_instrument_ids(), &[1, 2, 3]);
+        assert_eq!(merged.get_last_prices(), &[4.0, 2.0, 5.0]);
+        // The row index is kept for the next batch, emptied.
+        assert!(batches.indexes[0].is_empty() && batches.indexes[0].capacity() >= 3);
+        batches.push(1, batch(vec![update(2, 6.0)]));
+        batches.push(1, batch(vec![update(2, 7.0), update(1, 8.0)]));
+        let (_, merged) = batches.drain().next().unwrap();
+        assert_eq!(merged.get_instrument_ids(), &[2, 1]);
+        assert_eq!(merged.get_last_prices(), &[7.0, 8.0]);
+    }
+}
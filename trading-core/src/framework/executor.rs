@@ -0,0 +1,233 @@
+//! Shared executor for the runners of a service.
+//!
+//! Every runner (and the feeder source loop) of the process is a task on one
+//! multi-threaded tokio runtime, instead of owning an OS thread and a runtime of
+//! its own. Thread count and memory footprint therefore stay bounded no matter how
+//! many inputs a service declares. Threads are named `runner-<n>`.
+//!
+//! The service's `Placement` hints only apply to the threads currently acting as
+//! workers. Tokio hands a worker over to a fresh thread whenever a task blocks in
+//! place, so a thread is pinned to the least loaded core when it parks or unparks
+//! as a worker (hooks blocking-pool threads never run), and unpinned again when it
+//! enters `block_in_place`. Blocking-pool threads thus keep the default scheduling.
+
+use crate::framework::placement::{current_affinity, Placement};
+use anyhow::{bail, Result};
+use std::cell::{Cell, RefCell};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex, OnceLock};
+use tokio::runtime::{Builder, Handle, Runtime};
+
+/// Worker threads the runtime is created with; 0 means one per available core.
+static WORKER_THREADS: AtomicUsize = AtomicUsize::new(0);
+static PLACEMENT: Mutex<Option<Placement>> = Mutex::new(None);
+static RUNTIME: OnceLock<Runtime> = OnceLock::new();
+
+/// Sets the number of worker threads of the shared runner runtime.
+///
+/// # Arguments
+///
+/// * `threads` - Number of worker threads, `0` for one per available core.
+///
+/// # Returns
+///
+/// * `Ok(())` if the setting will be applied.
+/// * `Err` if the runtime has already been started.
+pub fn set_worker_threads(threads: usize) -> Result<()> {
+    if RUNTIME.get().is_some() {
+        bail!("Runner runtime already started, worker threads can no longer change");
+    }
+    WORKER_THREADS.store(threads, Ordering::Relaxed);
+    Ok(())
+}
+
+/// Sets the CPU placement applied to the worker threads of the shared runner runtime.
+///
+/// When cores are listed and no worker count was set, the runtime starts one worker
+/// per listed core.
+///
+/// # Arguments
+///
+/// * `placement` - Hints applied to each thread while it acts as a worker.
+///
+/// # Returns
+///
+/// * `Ok(())` if the setting will be applied.
+/// * `Err` if the runtime has already been started.
+pub fn set_placement(placement: Placement) -> Result<()> {
+    if RUNTIME.get().is_some() {
+        bail!("Runner runtime already started, placement can no longer change");
+    }
+    *PLACEMENT.lock().unwrap() = Some(placement);
+    Ok(())
+}
+
+/// Returns a handle to the shared runner runtime, starting it on first use.
+pub fn handle() -> Handle {
+    RUNTIME
+        .get_or_init(|| {
+            let placement = PLACEMENT.lock().unwrap().take().unwrap_or_default();
+            build(WORKER_THREADS.load(Ordering::Relaxed), placement)
+                .expect("Failed to build the runner runtime")
+        })
+        .handle()
+        .clone()
+}
+
+/// Runs blocking code on a worker thread, like `tokio::task::block_in_place`,
+/// releasing the thread's core first.
+///
+/// # Arguments
+///
+/// * `f` - The blocking code.
+///
+/// # Returns
+///
+/// What `f` returns.
+pub fn block_in_place<R>(f: impl FnOnce() -> R) -> R {
+    tokio::task::block_in_place(|| {
+        // The worker has moved to another thread: this one no longer holds a core.
+        unpin_current_thread();
+        f()
+    })
+}
+
+fn build(threads: usize, placement: Placement) -> std::io::Result<Runtime> {
+    let mut builder = Builder::new_multi_thread();
+    let threads = match threads {
+        0 => placement.cores.len(),
+        threads => threads,
+    };
+    if threads > 0 {
+        builder.worker_threads(threads);
+    }
+    let names = AtomicUsize::new(0);
+    builder.thread_name_fn(move || format!("runner-{}", names.fetch_add(1, Ordering::Relaxed)));
+    if !placement.is_empty() {
+        let pinning = Arc::new(Pinning::new(placement));
+        let on_start = pinning.clone();
+        builder
+            .on_thread_start(move || on_start.attach())
+            .on_thread_park(pin_current_thread)
+            .on_thread_unpark(pin_current_thread)
+            .on_thread_stop(unpin_current_thread);
+    }
+    builder.enable_all().build()
+}
+
+/// The cores of a placement and the worker threads pinned to each of them.
+struct Pinning {
+    placement: Placement,
+    /// Cores the process may run on, restored on threads that are not workers.
+    allowed: Vec<usize>,
+    /// Pinned threads per slot: per listed core, or a single one for a NUMA node.
+    load: Mutex<Vec<usize>>,
+}
+
+thread_local! {
+    /// The placement of the runtime the thread belongs to.
+    static PINNING: RefCell<Option<Arc<Pinning>>> = const { RefCell::new(None) };
+    /// The slot the thread is pinned to, while it acts as a worker.
+    static SLOT: Cell<Option<usize>> = const { Cell::new(None) };
+}
+
+impl Pinning {
+    fn new(placement: Placement) -> Self {
+        let slots = placement.cores.len().max(1);
+        Self {
+            placement,
+            allowed: current_affinity(),
+            load: Mutex::new(vec![0; slots]),
+        }
+    }
+
+    /// Registers a new thread, which starts unpinned whatever it inherited.
+    fn attach(self: &Arc<Self>) {
+        if let Err(e) = self.placement.clear_current_thread(&self.allowed) {
+            log::warn!("Executor: {}", e);
+        }
+        PINNING.with(|pinning| *pinning.borrow_mut() = Some(self.clone()));
+    }
+}
+
+/// Pins the calling worker thread to the least loaded slot; cheap once pinned.
+fn pin_current_thread() {
+    if SLOT.get().is_some() {
+        return;
+    }
+    PINNING.with(|pinning| {
+        let Some(pinning) = pinning.borrow().clone() else {
+            return;
+        };
+        let slot = {
+            let mut load = pinning.load.lock().unwrap();
+            let slot = (0..load.len()).min_by_key(|&slot| load[slot]).unwrap_or(0);
+            load[slot] += 1;
+            slot
+        };
+        // Marked pinned even on failure, so a rejected hint is not retried on every park.
+        SLOT.set(Some(slot));
+        if let Err(e) = pinning.placement.apply_to_current_thread(slot) {
+            log::warn!("Executor: {}", e);
+        }
+    });
+}
+
+/// Releases the slot of the calling thread, if it holds one.
+fn unpin_current_thread() {
+    let Some(slot) = SLOT.take() else {
+        return;
+    };
+    PINNING.with(|pinning| {
+        let Some(pinning) = pinning.borrow().clone() else {
+            return;
+        };
+        pinning.load.lock().unwrap()[slot] -= 1;
+        if let Err(e) = pinning.placement.clear_current_thread(&pinning.allowed) {
+            log::warn!("Executor: {}", e);
+        }
+    });
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::time::Duration;
+
+    #[test]
+    fn test_blocking_threads_are_not_pinned() {
+        let placement = Placement {
+            cores: current_affinity().into_iter().take(1).collect(),
+            numa_node: None,
+            rt_priority: None,
+        };
+        let runtime = build(2, placement).unwrap();
+
+        let tasks: Vec<_> = (0..16)
+            .map(|_| {
+                runtime.spawn(async {
+                    tokio::time::sleep(Duration::from_millis(1)).await;
+                    block_in_place(|| {
+                        std::thread::sleep(Duration::from_millis(5));
+                        SLOT.get().is_none()
+                    })
+                })
+            })
+            .collect();
+        let unpinned = runtime.block_on(async {
+            let mut unpinned = true;
+            for task in tasks {
+                unpinned &= task.await.unwrap();
+            }
+            unpinned
+        });
+        assert!(unpinned);
+
+        // However many threads took over the workers, at most one per worker holds a core.
+        let pinning = runtime
+            .block_on(runtime.spawn(async { PINNING.with(|pinning| pinning.borrow().clone()) }))
+            .unwrap()
+            .unwrap();
+        assert!(pinning.load.lock().unwrap().iter().sum::<usize>() <= 2);
+    }
+}
@@ -0,0 +1,501 @@
+//! The input sockets of a runner, reconfigured make-before-break.
+//!
+//! Rebuilding the listener for a new address drops whatever is still queued on the
+//! old one, and a fresh ZMQ connection misses what is published before it completes
+//! (the "slow joiner"), so a naive swap loses messages. Instead, a new source is
+//! first received on a socket of its own, next to the current ones. Only once it has
+//! delivered a message does it replace the listener (`UpdateAddress`) or get
+//! connected to it (`AddInput`), and disconnects wait for pending joins to complete.
+//!
+//! A replacement takes over the stream at a cut, in origin time: past both its first
+//! message and the last one the listener delivered. The replaced socket is then
+//! only drained of what precedes the cut, and closed at its first message from the
+//! cut on or its first empty read; the replacement's messages ahead of the cut are
+//! dropped. Two sources of the same stream thus hand over without delivering a
+//! message twice, although their sender ids differ. Within an `AddInput`, where the listener and the joining
+//! socket reach the same sender, the copy is dropped by the runner's `Tracer`,
+//! which admits each (sender, sequence number) once.
+
+use crate::comms::socket::ReceiverSocket;
+use crate::comms::topic::Topic;
+use crate::comms::trace::Trace;
+use crate::comms::{build_subscriber, builder, Address, Packet, Wakeup};
+use crate::model::identity::Id;
+use crate::model::order::unix_nanos;
+use anyhow::{bail, Result};
+use serde::de::DeserializeOwned;
+use std::collections::HashSet;
+use std::time::{Duration, Instant};
+
+/// Longest a new source may stay silent before it is switched to regardless.
+const JOIN_TIMEOUT: Duration = Duration::from_secs(2);
+
+/// Longest a blocking runner parks on its listener while other sockets are open.
+const WAIT_SLICE: Duration = Duration::from_millis(1);
+
+/// A source being connected next to the current ones.
+struct Joining<Input> {
+    address: Address,
+    socket: ReceiverSocket<Input>,
+    /// Promoted in place of the listener (`UpdateAddress`), rather than connected
+    /// to it (`AddInput`).
+    replace: bool,
+    /// When the join started, or when the listener was connected for `AddInput`.
+    started: Instant,
+    /// Senders heard on `socket`.
+    senders: HashSet<Id>,
+    /// For a replacement, the origin from which it takes over the stream, set by
+    /// its first message.
+    cut_ns: u64,
+    /// Whether the listener was connected to `address` (`AddInput` only).
+    connected: bool,
+    /// Whether the listener itself delivered one of `senders` since it was connected.
+    live: bool,
+}
+
+/// A replaced socket, drained of the messages that precede its cut.
+struct Retiring<Input> {
+    socket: ReceiverSocket<Input>,
+    /// Unix nanos from which messages are covered by the replacement.
+    cut_ns: u64,
+}
+
+/// The listener of a runner and the sockets of its pending reconfigurations.
+pub(crate) struct Inputs<Input> {
+    listener: ReceiverSocket<Input>,
+    joining: Vec<Joining<Input>>,
+    retiring: Vec<Retiring<Input>>,
+    /// Indices of the `retiring` sockets that reached their cut, closed by `progress`.
+    spent: Vec<usize>,
+    /// Latest origin delivered by the listener.
+    delivered_ns: u64,
+    /// Origin below which the listener's messages precede its cut, 0 once past it.
+    floor_ns: u64,
+    /// Disconnects held back until no source is joining.
+    deferred: Vec<Address>,
+    /// Kept to apply the subscription to new sockets.
+    topics: Vec<Topic>,
+}
+
+impl<Input> Inputs<Input>
+where
+    Input: DeserializeOwned + Send + Sync + 'static,
+{
+    /// Starts with an empty listener, to be connected by the first binding.
+    pub(crate) fn new() -> Result<Self> {
+        Ok(Self {
+            listener: builder::build_empty_subscriber()?,
+            joining: Vec::new(),
+            retiring: Vec::new(),
+            spent: Vec::new(),
+            delivered_ns: 0,
+            floor_ns: 0,
+            deferred: Vec::new(),
+            topics: Vec::new(),
+        })
+    }
+
+    /// Returns whether a reconfiguration is in progress.
+    pub(crate) fn is_swapping(&self) -> bool {
+        !self.joining.is_empty() || !self.retiring.is_empty() || !self.deferred.is_empty()
+    }
+
+    /// Receives the next pending message of any socket, without waiting.
+    pub(crate) async fn try_recv(&mut self) -> Result<Packet<Input>> {
+        self.promote();
+        while let Ok(packet) = self.listener.try_recv().await {
+            if precedes(packet.trace().origin_ns, self.floor_ns) {
+                continue;
+            }
+            self.floor_ns = 0;
+            self.delivered_ns = self.delivered_ns.max(packet.trace().origin_ns);
+            mark_live(&mut self.joining, packet.id());
+            return Ok(packet);
+        }
+        for joining in &mut self.joining {
+            if let Ok(packet) = joining.socket.try_recv().await {
+                if joining.senders.is_empty() {
+                    joining.cut_ns = cut_at(packet.trace().origin_ns, self.delivered_ns);
+                }
+                joining.senders.insert(packet.id());
+                if !joining.replace || !precedes(packet.trace().origin_ns, joining.cut_ns) {
+                    return Ok(packet);
+                }
+            }
+        }
+        for (index, retiring) in self.retiring.iter_mut().enumerate() {
+            if self.spent.contains(&index) {
+                continue;
+            }
+            match retiring.socket.try_recv().await {
+                Ok(packet) if packet.trace().origin_ns < retiring.cut_ns => return Ok(packet),
+                _ => self.spent.push(index),
+            }
+        }
+        bail!("No message pending")
+    }
+
+    /// Receives the next pending raw frame of any socket, without waiting.
+    pub(crate) async fn try_recv_frame(&mut self) -> Result<&[u8]> {
+        self.promote();
+        // A frame ahead of the cut is dropped; the listener is read again next call.
+        if let Ok(frame) = self.listener.try_recv_frame().await {
+            match Trace::peek(frame) {
+                Some((_, trace)) if precedes(trace.origin_ns, self.floor_ns) => (),
+                Some((id, trace)) => {
+                    self.floor_ns = 0;
+                    self.delivered_ns = self.delivered_ns.max(trace.origin_ns);
+                    mark_live(&mut self.joining, id);
+                    return Ok(frame);
+                }
+                None => return Ok(frame),
+            }
+        }
+        for joining in &mut self.joining {
+            if let Ok(frame) = joining.socket.try_recv_frame().await {
+                let Some((id, trace)) = Trace::peek(frame) else {
+                    return Ok(frame);
+                };
+                if joining.senders.is_empty() {
+                    joining.cut_ns = cut_at(trace.origin_ns, self.delivered_ns);
+                }
+                joining.senders.insert(id);
+                if !joining.replace || !precedes(trace.origin_ns, joining.cut_ns) {
+                    return Ok(frame);
+                }
+            }
+        }
+        for (index, retiring) in self.retiring.iter_mut().enumerate() {
+            if self.spent.contains(&index) {
+                continue;
+            }
+            match retiring.socket.try_recv_frame().await {
+                Ok(frame) => match Trace::peek(frame) {
+                    Some((_, trace)) if trace.origin_ns >= retiring.cut_ns => {
+                        self.spent.push(index)
+                    }
+                    _ => return Ok(frame),
+                },
+                Err(_) => self.spent.push(index),
+            }
+        }
+        bail!("No message pending")
+    }
+
+    /// Parks until the listener is readable or `wakeup` fires.
+    ///
+    /// While other sockets are open, parks for a short slice only, so they are
+    /// polled too.
+    pub(crate) async fn wait_readable(&mut self, wakeup: &Wakeup) -> Result<bool> {
+        let timeout = self.is_swapping().then_some(WAIT_SLICE);
+        self.listener.wait_readable(wakeup, timeout).await
+    }
+
+    /// Starts replacing the listener with a subscriber to `address`.
+    pub(crate) fn update_address(&mut self, address: Address) {
+        // A newer swap supersedes a pending one.
+        self.joining.retain(|joining| !joining.replace);
+        if address == Address::Empty {
+            let listener = match builder::build_empty_subscriber() {
+                Ok(listener) => listener,
+                Err(e) => {
+                    log::error!("Runner failed to build an empty listener: {}", e);
+                    return;
+                }
+            };
+            self.retire(listener, self.cut_now());
+            return;
+        }
+        self.join(address, true);
+    }
+
+    /// Starts connecting the listener to `address`, next to its current sources.
+    pub(crate) fn add_input(&mut self, address: Address) {
+        self.join(address, false);
+    }
+
+    /// Disconnects the listener from `address` once no source is joining.
+    pub(crate) async fn disconnect_input(&mut self, address: Address) {
+        // Removed before its join completed: abandon it.
+        let pending = self
+            .joining
+            .iter()
+            .position(|joining| !joining.replace && joining.address == address);
+        if let Some(index) = pending {
+            let joining = self.joining.remove(index);
+            if joining.connected {
+                self.disconnect(&address).await;
+            }
+            return;
+        }
+        if self.joining.is_empty() {
+            self.disconnect(&address).await;
+        } else {
+            self.deferred.push(address);
+        }
+    }
+
+    /// Restricts every socket to some topics.
+    pub(crate) fn subscribe(&mut self, topics: Vec<Topic>) {
+        self.topics = topics;
+        let sockets = std::iter::once(&mut self.listener)
+            .chain(self.joining.iter_mut().map(|joining| &mut joining.socket))
+            .chain(
+                self.retiring
+                    .iter_mut()
+                    .map(|retiring| &mut retiring.socket),
+            );
+        for socket in sockets {
+            if let Err(e) = socket.subscribe(&self.topics) {
+                log::error!(
+                    "Runner failed to subscribe to {} topics: {}",
+                    self.topics.len(),
+                    e
+                );
+            }
+        }
+    }
+
+    /// Advances the pending reconfigurations; cheap when there are none.
+    pub(crate) async fn progress(&mut self) {
+        if !self.is_swapping() {
+            return;
+        }
+        self.promote();
+        let now = Instant::now();
+        let mut index = 0;
+        while index < self.joining.len() {
+            let joining = &mut self.joining[index];
+            let heard = !joining.senders.is_empty();
+            let timed_out = now.duration_since(joining.started) >= JOIN_TIMEOUT;
+            if !heard && timed_out && !joining.connected {
+                log::warn!(
+                    "No message from {:?} after {:?}, switching to it anyway",
+                    joining.address,
+                    JOIN_TIMEOUT
+                );
+            }
+
+            if joining.replace && timed_out {
+                let joining = self.joining.remove(index);
+                let cut_ns = self.cut_now();
+                self.retire(joining.socket, cut_ns);
+                continue;
+            }
+            if !joining.replace && !joining.connected && (heard || timed_out) {
+                // The new socket keeps delivering while the listener's own
+                // connection is being established.
+                match self.listener.connect(&joining.address).await {
+                    Ok(()) => {
+                        joining.connected = true;
+                        joining.started = now;
+                    }
+                    Err(e) => {
+                        log::error!("Runner failed to connect to {:?}: {}", joining.address, e);
+                        self.joining.remove(index);
+                        continue;
+                    }
+                }
+            } else if joining.connected && (joining.live || timed_out) {
+                let joining = self.joining.remove(index);
+                self.retiring.push(Retiring {
+                    socket: joining.socket,
+                    cut_ns: unix_nanos(),
+                });
+                continue;
+            }
+            index += 1;
+        }
+
+        self.spent.sort_unstable();
+        for index in self.spent.drain(..).rev() {
+            self.retiring.remove(index);
+        }
+        if self.joining.is_empty() {
+            for address in std::mem::take(&mut self.deferred) {
+                self.disconnect(&address).await;
+            }
+        }
+    }
+
+    fn join(&mut self, address: Address, replace: bool) {
+        let mut socket: ReceiverSocket<Input> = match build_subscriber(&address) {
+            Ok(socket) => socket,
+            Err(e) => {
+                log::error!("Runner failed to subscribe to {:?}: {}", address, e);
+                return;
+            }
+        };
+        if !self.topics.is_empty() {
+            if let Err(e) = socket.subscribe(&self.topics) {
+                log::error!("Runner failed to re-apply its subscription: {}", e);
+            }
+        }
+        self.joining.push(Joining {
+            address,
+            socket,
+            replace,
+            started: Instant::now(),
+            senders: HashSet::new(),
+            cut_ns: 0,
+            connected: false,
+            live: false,
+        });
+    }
+
+    /// Promotes the replacement of the listener once it has delivered a message.
+    fn promote(&mut self) {
+        let heard = self
+            .joining
+            .iter()
+            .position(|joining| joining.replace && !joining.senders.is_empty());
+        if let Some(index) = heard {
+            let joining = self.joining.remove(index);
+            self.retire(joining.socket, joining.cut_ns);
+        }
+    }
+
+    /// Makes `listener` the listener from `cut_ns` on, draining the previous one up
+    /// to it.
+    fn retire(&mut self, listener: ReceiverSocket<Input>, cut_ns: u64) {
+        let previous = std::mem::replace(&mut self.listener, listener);
+        self.retiring.push(Retiring {
+            socket: previous,
+            cut_ns,
+        });
+        self.floor_ns = cut_ns;
+    }
+
+    /// Returns a cut for a replacement that delivered nothing yet.
+    fn cut_now(&self) -> u64 {
+        unix_nanos().max(self.delivered_ns + 1)
+    }
+
+    async fn disconnect(&mut self, address: &Address) {
+        if let Err(e) = self.listener.disconnect(address).await {
+            log::error!("Runner failed to disconnect from {:?}: {}", address, e);
+        }
+    }
+}
+
+/// Returns the cut of a replacement whose first message has origin `origin_ns`,
+/// after the listener delivered up to `delivered_ns`.
+fn cut_at(origin_ns: u64, delivered_ns: u64) -> u64 {
+    let origin_ns = match origin_ns {
+        0 => unix_nanos(),
+        origin_ns => origin_ns,
+    };
+    origin_ns.max(delivered_ns + 1)
+}
+
+/// Returns whether a message of origin `origin_ns` lies before `cut_ns`; untraced
+/// messages lie nowhere.
+fn precedes(origin_ns: u64, cut_ns: u64) -> bool {
+    origin_ns != 0 && origin_ns < cut_ns
+}
+
+/// Records that the listener delivered `sender`, completing the joins that wait on it.
+fn mark_live<Input>(joining: &mut [Joining<Input>], sender: Id) {
+    for joining in joining {
+        if joining.connected && joining.senders.contains(&sender) {
+            joining.live = true;
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::comms::build_publisher;
+    use crate::comms::socket::SenderSocket;
+    use crate::comms::trace;
+    use crate::comms::transports::shm::ring_path;
+
+    #[tokio::test]
+    async fn test_swap_keeps_old_source_until_new_one_delivers() {
+        let name = |tag| format!("test-inputs-{}-{}", tag, std::process::id());
+        let (old_address, new_address) = (Address::Shm(name("old")), Address::Shm(name("new")));
+        let mut old = build_publisher::<u64>(&old_address, 1).unwrap();
+        let mut new = build_publisher::<u64>(&new_address, 2).unwrap();
+        let mut inputs = Inputs::<u64>::new().unwrap();
+
+        inputs.update_address(old_address);
+        old.send(1).await.unwrap();
+        assert_eq!(inputs.try_recv().await.unwrap().data(), 1);
+        inputs.progress().await;
+
+        // The new source is silent: the old one keeps delivering.
+        inputs.update_address(new_address);
+        inputs.progress().await;
+        old.send(2).await.unwrap();
+        assert_eq!(inputs.try_recv().await.unwrap().data(), 2);
+
+        // Once the new source delivered, it takes over: the old one is only drained
+        // of what was sent before, then closed.
+        old.send(3).await.unwrap();
+        new.send(4).await.unwrap();
+        let mut received = vec![
+            inputs.try_recv().await.unwrap().data(),
+            inputs.try_recv().await.unwrap().data(),
+        ];
+        received.sort();
+        assert_eq!(received, vec![3, 4]);
+        inputs.progress().await;
+        new.send(5).await.unwrap();
+        old.send(6).await.unwrap();
+        assert_eq!(inputs.try_recv().await.unwrap().data(), 5);
+        assert!(inputs.try_recv().await.is_err());
+        inputs.progress().await;
+        assert!(!inputs.is_swapping());
+
+        for tag in ["old", "new"] {
+            let _ = std::fs::remove_file(ring_path(&name(tag)));
+        }
+    }
+
+    #[tokio::test]
+    async fn test_swap_between_copies_of_a_stream_delivers_each_once() {
+        let name = |tag| format!("test-inputs-copies-{}-{}", tag, std::process::id());
+        let (old_address, new_address) = (Address::Shm(name("old")), Address::Shm(name("new")));
+        let mut old = build_publisher::<u64>(&old_address, 1).unwrap();
+        let mut new = build_publisher::<u64>(&new_address, 2).unwrap();
+        let mut inputs = Inputs::<u64>::new().unwrap();
+        // Both sources react to the same ticks, so their messages share the origin.
+        let publish = |old: &mut SenderSocket<u64>, new: &mut SenderSocket<u64>, tick: u64| {
+            let origin_ns = tick * 1000;
+            for socket in [old, new] {
+                trace::with_origin(origin_ns, || {
+                    futures::executor::block_on(socket.send(tick)).unwrap()
+                });
+            }
+        };
+        let mut received = Vec::new();
+        let mut drain = |inputs: &mut Inputs<u64>| {
+            for _ in 0..8 {
+                while let Ok(packet) = futures::executor::block_on(inputs.try_recv()) {
+                    received.push(packet.data());
+                }
+                futures::executor::block_on(inputs.progress());
+            }
+        };
+
+        inputs.update_address(old_address);
+        publish(&mut old, &mut new, 1);
+        drain(&mut inputs);
+        inputs.update_address(new_address);
+        for tick in 2..=3 {
+            publish(&mut old, &mut new, tick);
+        }
+        drain(&mut inputs);
+        for tick in 4..=5 {
+            publish(&mut old, &mut new, tick);
+        }
+        drain(&mut inputs);
+
+        assert_eq!(received, vec![1, 2, 3, 4, 5]);
+        assert!(!inputs.is_swapping());
+        for tag in ["old", "new"] {
+            let _ = std::fs::remove_file(ring_path(&name(tag)));
+        }
+    }
+}
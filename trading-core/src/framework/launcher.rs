@@ -21,9 +21,14 @@ fn run_service<State, Config>(
 {
     let _ = env_logger::try_init();
     let microservice = Microservice::new(move |_| state, config, version, description);
-    tokio::runtime::Runtime::new().unwrap().block_on(async {
-        microservice.run().await;
-    });
+    // The admin loop only needs one thread: runners live on the shared executor.
+    tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .unwrap()
+        .block_on(async {
+            microservice.run().await;
+        });
 }
 
 pub fn boot_strategy(state: Box<dyn Strategist>, version: &str, description: &str) {
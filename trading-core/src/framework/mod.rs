@@ -1,4 +1,8 @@
+pub mod conflate;
+pub mod executor;
+mod inputs;
 pub mod launcher;
+pub mod placement;
 pub mod runner;
 pub mod runner_manager;
 
@@ -7,4 +11,6 @@ pub use launcher::{
     boot_strategy,
 };
 
-pub use runner::Runner;
+pub use conflate::Conflate;
+pub use placement::Placement;
+pub use runner::{BatchCallback, BatchPolicy, FrameCallback, Runner, RunnerProfile};
@@ -1,37 +1,59 @@
-use crate::fs::{load_state, save_state, PathManager};
+use crate::fs::{load_state, save_state, InstrumentStore, PathManager};
 use anyhow::{Context, Result};
 use std::collections::HashMap;
-use std::path::PathBuf;
+use std::path::Path;
 use trading::model::instrument::{Instrument, InstrumentId};
 use trading::model::instrument_db::InstrumentDB;
 
 const INSTRUMENT_DB_FILE_NAME: &str = "instruments.json";
+/// The mapped form of `INSTRUMENT_DB_FILE_NAME`, rebuilt whenever it is older.
+const INSTRUMENT_STORE_FILE_NAME: &str = "instruments.db";
 
-/// Helper to load InstrumentDB from disk.
-pub fn load_instrument_db(path_manager: &PathManager) -> Result<InstrumentDB> {
-    let file_path = path_manager.get_common_file_path(INSTRUMENT_DB_FILE_NAME);
-    let mut db = InstrumentDB::new();
+/// Helper to map the instrument file shared by the services of a deployment.
+///
+/// If `instruments.json` is newer than the instrument file (or the latter is
+/// missing), the file is rebuilt from it first, so the universe is parsed once per
+/// edit rather than once per service start.
+///
+/// # Returns
+///
+/// `None` if neither file exists.
+pub fn open_instrument_store(path_manager: &PathManager) -> Result<Option<InstrumentStore>> {
+    let json_path = path_manager.get_common_file_path(INSTRUMENT_DB_FILE_NAME);
+    let store_path = path_manager.get_common_file_path(INSTRUMENT_STORE_FILE_NAME);
 
-    if !file_path.exists() {
-        return Ok(db);
+    if !json_path.exists() {
+        if !store_path.exists() {
+            return Ok(None);
+        }
+        return InstrumentStore::open(&store_path).map(Some);
     }
-
-    let instruments: HashMap<InstrumentId, Instrument> = load_state(&file_path)
-        .with_context(|| format!("Failed to load instruments from {:?}", file_path))?;
-
-    // We need to insert them into the DB one by one since internal fields might be private
-    // Wait, InstrumentDB fields are private?
-    // instruments field in InstrumentDB IS private.
-    // And I only exposed `insert`.
-
-    for (id, instrument) in instruments {
-        db.insert(id, instrument);
+    if !is_newer(&json_path, &store_path)? {
+        match InstrumentStore::open(&store_path) {
+            Ok(store) => return Ok(Some(store)),
+            Err(e) => log::warn!("Rebuilding {:?}: {:#}", store_path, e),
+        }
     }
 
-    Ok(db)
+    let db = load_instrument_json(&json_path)?;
+    InstrumentStore::write(&store_path, &db)
+        .with_context(|| format!("Failed to save instruments to {:?}", store_path))?;
+    InstrumentStore::open(&store_path).map(Some)
+}
+
+/// Helper to load InstrumentDB from disk.
+///
+/// Goes through the instrument file (see `open_instrument_store`), so only the
+/// first service after an edit of `instruments.json` pays for parsing it.
+pub fn load_instrument_db(path_manager: &PathManager) -> Result<InstrumentDB> {
+    Ok(open_instrument_store(path_manager)?
+        .map(|store| store.to_db())
+        .unwrap_or_default())
 }
 
 /// Helper to save InstrumentDB to disk.
+///
+/// Writes both `instruments.json`, the editable source, and its instrument file.
 pub fn save_instrument_db(db: &InstrumentDB, path_manager: &PathManager) -> Result<()> {
     let file_path = path_manager.get_common_file_path(INSTRUMENT_DB_FILE_NAME);
 
@@ -41,5 +63,24 @@ pub fn save_instrument_db(db: &InstrumentDB, path_manager: &PathManager) -> Resu
 
     save_state(&file_path, &instruments)
         .with_context(|| format!("Failed to save instruments to {:?}", file_path))?;
+
+    let store_path = path_manager.get_common_file_path(INSTRUMENT_STORE_FILE_NAME);
+    InstrumentStore::write(&store_path, db)
+        .with_context(|| format!("Failed to save instruments to {:?}", store_path))?;
     Ok(())
 }
+
+fn load_instrument_json(file_path: &Path) -> Result<InstrumentDB> {
+    let instruments: HashMap<InstrumentId, Instrument> = load_state(file_path)
+        .with_context(|| format!("Failed to load instruments from {:?}", file_path))?;
+    Ok(instruments.into_iter().collect())
+}
+
+/// Returns whether `source` was modified after `derived`, or `derived` is missing.
+fn is_newer(source: &Path, derived: &Path) -> Result<bool> {
+    let derived = match std::fs::metadata(derived) {
+        Ok(metadata) => metadata.modified()?,
+        Err(_) => return Ok(true),
+    };
+    Ok(std::fs::metadata(source)?.modified()? > derived)
+}
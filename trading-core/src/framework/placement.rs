@@ -0,0 +1,291 @@
+//! CPU placement hints for the threads of a service.
+//!
+//! A `Placement` tells a service which cores its runner threads may use, which NUMA
+//! node to stay on, and whether they should be scheduled with realtime priority. It
+//! is parsed from `CommonArgs` and applied by the executor to the threads that run its
+//! workers, so latency-critical services keep their runners on isolated cores.
+
+use anyhow::{bail, Context, Result};
+use serde::{Deserialize, Serialize};
+
+/// Number of cores a `cpu_set_t` can hold; higher ids cannot be pinned to.
+#[cfg(target_os = "linux")]
+pub const MAX_CPUS: usize = libc::CPU_SETSIZE as usize;
+/// Number of cores a `cpu_set_t` can hold; higher ids cannot be pinned to.
+#[cfg(not(target_os = "linux"))]
+pub const MAX_CPUS: usize = 1024;
+
+/// Kernel list of the cores currently online.
+const ONLINE_CPUS: &str = "/sys/devices/system/cpu/online";
+
+/// Where the threads of a service should run.
+#[derive(Serialize, Deserialize, Debug, Clone, Default, PartialEq, Eq)]
+pub struct Placement {
+    /// Cores to pin worker threads to, one core per worker (round-robin).
+    #[serde(default)]
+    pub cores: Vec<usize>,
+    /// NUMA node whose cores the threads are restricted to when `cores` is empty.
+    #[serde(default)]
+    pub numa_node: Option<usize>,
+    /// `SCHED_FIFO` priority (1-99) for the worker threads.
+    #[serde(default)]
+    pub rt_priority: Option<i32>,
+}
+
+impl Placement {
+    /// Returns whether no hint is set.
+    pub fn is_empty(&self) -> bool {
+        self.cores.is_empty() && self.numa_node.is_none() && self.rt_priority.is_none()
+    }
+
+    /// Renders the hints as the `CommonArgs` flags that carry them to a service.
+    ///
+    /// # Returns
+    ///
+    /// The flags and their values, empty if no hint is set.
+    pub fn to_args(&self) -> Vec<String> {
+        let mut args = Vec::new();
+        if !self.cores.is_empty() {
+            let cores: Vec<String> = self.cores.iter().map(|c| c.to_string()).collect();
+            args.push("--cpu-cores".to_string());
+            args.push(cores.join(","));
+        }
+        if let Some(node) = self.numa_node {
+            args.push("--numa-node".to_string());
+            args.push(node.to_string());
+        }
+        if let Some(priority) = self.rt_priority {
+            args.push("--rt-priority".to_string());
+            args.push(priority.to_string());
+        }
+        args
+    }
+
+    /// Applies the hints to the calling thread.
+    ///
+    /// # Arguments
+    ///
+    /// * `worker` - Index of the thread among the service's workers, used to pick its core.
+    ///
+    /// # Returns
+    ///
+    /// * `Ok(())` if every hint was applied.
+    /// * `Err` if a core is not online, or the OS rejected a hint (e.g. missing
+    ///   `CAP_SYS_NICE`).
+    pub fn apply_to_current_thread(&self, worker: usize) -> Result<()> {
+        let cpus = if !self.cores.is_empty() {
+            check_online(&self.cores)?;
+            vec![self.cores[worker % self.cores.len()]]
+        } else if let Some(node) = self.numa_node {
+            numa_node_cpus(node)?
+        } else {
+            Vec::new()
+        };
+        if !cpus.is_empty() {
+            set_affinity(&cpus)?;
+        }
+        if let Some(priority) = self.rt_priority {
+            set_realtime_priority(priority)?;
+        }
+        Ok(())
+    }
+
+    /// Undoes the hints on the calling thread, e.g. one inherited from a pinned parent.
+    ///
+    /// # Arguments
+    ///
+    /// * `allowed` - Cores the thread may run on again, as read by `current_affinity`.
+    ///
+    /// # Returns
+    ///
+    /// * `Ok(())` if the thread is back to the default scheduling.
+    /// * `Err` if the OS rejected the change.
+    pub fn clear_current_thread(&self, allowed: &[usize]) -> Result<()> {
+        if (!self.cores.is_empty() || self.numa_node.is_some()) && !allowed.is_empty() {
+            set_affinity(allowed)?;
+        }
+        if self.rt_priority.is_some() {
+            set_normal_priority()?;
+        }
+        Ok(())
+    }
+}
+
+/// Returns the cores the calling thread may run on, empty if unknown.
+#[cfg(target_os = "linux")]
+pub fn current_affinity() -> Vec<usize> {
+    // SAFETY: cpu_set_t is plain data, and a pid of 0 targets the calling thread.
+    unsafe {
+        let mut set: libc::cpu_set_t = std::mem::zeroed();
+        if libc::sched_getaffinity(0, std::mem::size_of::<libc::cpu_set_t>(), &mut set) != 0 {
+            return Vec::new();
+        }
+        (0..libc::CPU_SETSIZE as usize)
+            .filter(|&cpu| libc::CPU_ISSET(cpu, &set))
+            .collect()
+    }
+}
+
+/// Returns the cores the calling thread may run on, empty if unknown.
+#[cfg(not(target_os = "linux"))]
+pub fn current_affinity() -> Vec<usize> {
+    Vec::new()
+}
+
+/// Parses a kernel-style CPU list such as `"0-3,8,10-11"`.
+///
+/// # Arguments
+///
+/// * `list` - Comma-separated core ids and inclusive ranges.
+///
+/// # Returns
+///
+/// * `Ok(Vec<usize>)` with every listed core, in order.
+/// * `Err` if an entry is not a number or a range, or a core is `MAX_CPUS` or above.
+pub fn parse_cpu_list(list: &str) -> Result<Vec<usize>> {
+    let mut cpus = Vec::new();
+    for part in list.trim().split(',').filter(|p| !p.is_empty()) {
+        let (first, last) = match part.split_once('-') {
+            Some((first, last)) => (
+                first.trim().parse::<usize>().context("Invalid CPU range")?,
+                last.trim().parse::<usize>().context("Invalid CPU range")?,
+            ),
+            None => {
+                let cpu = part.trim().parse::<usize>().context("Invalid CPU id")?;
+                (cpu, cpu)
+            }
+        };
+        if last < first {
+            bail!("Invalid CPU range '{}'", part);
+        }
+        if last >= MAX_CPUS {
+            bail!("CPU '{}' is out of range (at most {})", part, MAX_CPUS - 1);
+        }
+        cpus.extend(first..=last);
+    }
+    Ok(cpus)
+}
+
+/// Parses the cores to pin to, as given by `--cpu-cores`.
+///
+/// # Arguments
+///
+/// * `list` - A kernel-style CPU list.
+///
+/// # Returns
+///
+/// * `Ok(Vec<usize>)` with every listed core, in order.
+/// * `Err` if the list is invalid or names a core that is not online.
+pub fn parse_core_list(list: &str) -> Result<Vec<usize>> {
+    let cores = parse_cpu_list(list)?;
+    check_online(&cores)?;
+    Ok(cores)
+}
+
+/// Fails on the first of `cores` that is not online; passes if the kernel does not
+/// say which are.
+fn check_online(cores: &[usize]) -> Result<()> {
+    let Ok(list) = std::fs::read_to_string(ONLINE_CPUS) else {
+        return match cores.iter().find(|&&cpu| cpu >= MAX_CPUS) {
+            Some(cpu) => bail!("CPU {} is out of range (at most {})", cpu, MAX_CPUS - 1),
+            None => Ok(()),
+        };
+    };
+    let online = parse_cpu_list(&list).with_context(|| format!("Invalid {}", ONLINE_CPUS))?;
+    match cores.iter().find(|cpu| !online.contains(cpu)) {
+        Some(cpu) => bail!("CPU {} is not online (online: {})", cpu, list.trim()),
+        None => Ok(()),
+    }
+}
+
+fn numa_node_cpus(node: usize) -> Result<Vec<usize>> {
+    let path = format!("/sys/devices/system/node/node{}/cpulist", node);
+    let list = std::fs::read_to_string(&path)
+        .with_context(|| format!("Unknown NUMA node {} ({})", node, path))?;
+    parse_cpu_list(&list)
+}
+
+#[cfg(target_os = "linux")]
+fn set_affinity(cpus: &[usize]) -> Result<()> {
+    // SAFETY: cpu_set_t is plain data, and a pid of 0 targets the calling thread.
+    unsafe {
+        let mut set: libc::cpu_set_t = std::mem::zeroed();
+        for &cpu in cpus {
+            if cpu >= MAX_CPUS {
+                bail!("CPU {} is out of range (at most {})", cpu, MAX_CPUS - 1);
+            }
+            libc::CPU_SET(cpu, &mut set);
+        }
+        if libc::sched_setaffinity(0, std::mem::size_of::<libc::cpu_set_t>(), &set) != 0 {
+            bail!(
+                "Failed to pin thread to cores {:?}: {}",
+                cpus,
+                std::io::Error::last_os_error()
+            );
+        }
+    }
+    Ok(())
+}
+
+#[cfg(not(target_os = "linux"))]
+fn set_affinity(cpus: &[usize]) -> Result<()> {
+    bail!("Thread pinning to {:?} is only supported on Linux", cpus)
+}
+
+fn set_realtime_priority(priority: i32) -> Result<()> {
+    let param = libc::sched_param {
+        sched_priority: priority,
+    };
+    // SAFETY: `param` outlives the call; a pid of 0 targets the calling thread.
+    if unsafe { libc::sched_setscheduler(0, libc::SCHED_FIFO, &param) } != 0 {
+        bail!(
+            "Failed to set realtime priority {}: {}",
+            priority,
+            std::io::Error::last_os_error()
+        );
+    }
+    Ok(())
+}
+
+fn set_normal_priority() -> Result<()> {
+    let param = libc::sched_param { sched_priority: 0 };
+    // SAFETY: `param` outlives the call; a pid of 0 targets the calling thread.
+    if unsafe { libc::sched_setscheduler(0, libc::SCHED_OTHER, &param) } != 0 {
+        bail!(
+            "Failed to reset thread priority: {}",
+            std::io::Error::last_os_error()
+        );
+    }
+    Ok(())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_parse_cpu_list_and_args_round_trip() {
+        assert_eq!(
+            parse_cpu_list("0-2,8,10-11\n").unwrap(),
+            vec![0, 1, 2, 8, 10, 11]
+        );
+        assert!(parse_cpu_list("3-1").is_err());
+        assert!(parse_cpu_list(&MAX_CPUS.to_string()).is_err());
+        assert!(parse_cpu_list("0-18446744073709551615").is_err());
+        if let Some(cpu) = current_affinity().first() {
+            assert_eq!(parse_core_list(&cpu.to_string()).unwrap(), vec![*cpu]);
+        }
+        assert!(parse_core_list(&(MAX_CPUS - 1).to_string()).is_err());
+
+        let placement = Placement {
+            cores: vec![2, 3],
+            numa_node: None,
+            rt_priority: Some(50),
+        };
+        assert_eq!(
+            placement.to_args(),
+            vec!["--cpu-cores", "2,3", "--rt-priority", "50"]
+        );
+        assert!(Placement::default().to_args().is_empty());
+    }
+}
@@ -1,19 +1,28 @@
 //! Generic Runner for processing data streams.
 //!
 //! A `Runner` wraps an input socket, a state container, and a callback function.
-//! It manages the event loop, thread spawning, and control messages (stop, update).
+//! It manages the event loop, its task on the shared executor, and control messages
+//! (stop, update).
 
-use crate::comms::socket::ReceiverSocket;
-use crate::comms::{build_subscriber, builder, Address};
+use crate::comms::topic::Topic;
+use crate::comms::trace::{self, Trace};
+use crate::comms::{Address, Wakeup};
+use crate::framework::conflate::{Backlog, Conflate, Latest};
+use crate::framework::executor;
+use crate::framework::inputs::Inputs;
+use crate::manifest::Binding;
+use crate::metrics::{RunnerMetrics, Tracer};
 use crate::model::identity::Id;
+use crate::model::order::unix_nanos;
 use serde::de::DeserializeOwned;
 use serde::Serialize;
 use std::{
     sync::{
-        mpsc::{self, Sender},
+        atomic::Ordering,
+        mpsc::{self, Receiver, Sender},
         Arc, Mutex,
     },
-    thread::{self, JoinHandle},
+    time::{Duration, Instant},
 };
 
 /// Commands sent to control the runner's lifecycle and configuration.
@@ -22,13 +31,87 @@ pub enum RunnerCommand {
     Stop,
 
     /// Update the listening address at runtime.
+    ///
+    /// Make-before-break: the current listener keeps delivering until the new
+    /// address has (see `framework::inputs`).
     UpdateAddress(Address),
 
     /// Add a new input source dynamically (Multiplexing).
     AddInput(Address),
 
     /// Remove an input source dynamically (Multiplexing).
+    ///
+    /// Deferred until the inputs being added meanwhile deliver.
     DisconnectInput(Address),
+
+    /// Receive only the messages published on these topics (all if empty).
+    Subscribe(Vec<Topic>),
+}
+
+/// How a runner waits for work when its input is idle.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub enum RunnerProfile {
+    /// Park on the input socket and the control channel together.
+    ///
+    /// Wakes within microseconds of a message or command and burns no CPU while idle.
+    #[default]
+    Blocking,
+
+    /// Spin on the input, yielding to the executor between polls, and fall back to
+    /// 1ms sleeps after a long idle period.
+    ///
+    /// Keeps an executor thread busy for the lowest possible hot-path latency.
+    BusyPoll,
+}
+
+/// Limits on how much backlog a batch runner drains before invoking its handler.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct BatchPolicy {
+    /// Maximum number of messages handed to the handler in one call.
+    pub max_messages: usize,
+    /// Maximum time spent draining the input before the handler is invoked.
+    pub max_latency: Duration,
+}
+
+impl Default for BatchPolicy {
+    fn default() -> Self {
+        Self {
+            max_messages: 1024,
+            max_latency: Duration::from_micros(100),
+        }
+    }
+}
+
+/// Handler invoked with every message drained during one pass of a batch runner.
+///
+/// The buffer is cleared (capacity kept) once the handler returns, so handlers may
+/// `drain(..)` it to take ownership of the inputs.
+pub type BatchCallback<State, Input> = Box<dyn FnMut(&mut State, &mut Vec<(Id, Input)>) + Send>;
+
+/// Handler invoked with each raw received frame, for inputs decoded in place.
+///
+/// The frame borrows the transport's receive buffer and is only valid for the call;
+/// decode it with `Packet::decode` into a borrowing type (e.g. `MarketDataBatchView`).
+pub type FrameCallback<State> = Box<dyn FnMut(&mut State, &[u8]) + Send>;
+
+/// How a runner hands received messages to its state.
+enum Delivery<State, Input> {
+    /// One callback per message, one state lock per message.
+    Single(Box<dyn FnMut(&mut State, Id, Input) + Send>),
+    /// One callback per drained burst, one state lock per burst.
+    Batch {
+        callback: BatchCallback<State, Input>,
+        policy: BatchPolicy,
+        buffer: Vec<(Id, Input)>,
+    },
+    /// One callback per raw frame, decoded by the handler without copying.
+    Frame(FrameCallback<State>),
+    /// One callback per stream with the latest value of each drained burst.
+    Conflate {
+        callback: Box<dyn FnMut(&mut State, Id, Input) + Send>,
+        policy: BatchPolicy,
+        backlog: Box<dyn Backlog<Input>>,
+    },
 }
 
 /// The structure used for a runner.
@@ -36,44 +119,159 @@ pub enum RunnerCommand {
 /// A runner is a component that handles exactly one input channel.
 /// This is usefull as I can abstract hotswapping of listening/writing ports for the runners.
 pub struct Runner<State, Input> {
-    handle: Option<JoinHandle<()>>,
+    /// Disconnects once the runner task has exited.
+    done: Option<Receiver<()>>,
     control_tx: Sender<RunnerCommand>,
+    wakeup: Wakeup,
+    metrics: Arc<RunnerMetrics>,
     _input_marker: std::marker::PhantomData<Input>,
     _state_marker: std::marker::PhantomData<State>,
 }
 
 impl<State, Input> Runner<State, Input> {
-    /// This will create the runner and start it in a separate thread.
+    /// This will create the runner and start it on the shared executor.
     ///
     /// # Arguments
     ///
     /// * `state` - Shared thread-safe access to the microservice state.
     /// * `callback` - To be executed for each incoming message.
-    /// * `address` - The initial address to listen on.
+    /// * `profile` - How the runner waits when its input is idle.
+    /// * `metrics` - Where the runner records its input latencies.
     ///
     /// # Returns
     ///
-    /// A new `Runner` instance holding the thread handle and control channel.
+    /// A new `Runner` instance holding the task's completion signal and control channel.
     pub(super) fn new(
         state: Arc<Mutex<State>>,
         callback: Box<dyn FnMut(&mut State, Id, Input) + Send>,
+        profile: RunnerProfile,
+        metrics: Arc<RunnerMetrics>,
+    ) -> Self
+    where
+        State: Send + 'static,
+        Input: Sync + Send + Serialize + DeserializeOwned + 'static,
+    {
+        Self::spawn(state, Delivery::Single(callback), profile, metrics)
+    }
+
+    /// Creates a runner that drains its input in bursts and starts it on the shared executor.
+    ///
+    /// # Arguments
+    ///
+    /// * `state` - Shared thread-safe access to the microservice state.
+    /// * `callback` - To be executed once per drained burst, under a single state lock.
+    /// * `policy` - Bounds on the size and draining time of a burst.
+    /// * `profile` - How the runner waits when its input is idle.
+    /// * `metrics` - Where the runner records its input latencies.
+    ///
+    /// # Returns
+    ///
+    /// A new `Runner` instance holding the task's completion signal and control channel.
+    pub(super) fn new_batch(
+        state: Arc<Mutex<State>>,
+        callback: BatchCallback<State, Input>,
+        policy: BatchPolicy,
+        profile: RunnerProfile,
+        metrics: Arc<RunnerMetrics>,
+    ) -> Self
+    where
+        State: Send + 'static,
+        Input: Sync + Send + Serialize + DeserializeOwned + 'static,
+    {
+        let delivery = Delivery::Batch {
+            callback,
+            buffer: Vec::with_capacity(policy.max_messages.max(1)),
+            policy,
+        };
+        Self::spawn(state, delivery, profile, metrics)
+    }
+
+    /// Creates a runner that hands raw frames to its handler and starts it on the shared executor.
+    ///
+    /// # Arguments
+    ///
+    /// * `state` - Shared thread-safe access to the microservice state.
+    /// * `callback` - To be executed for each received frame.
+    /// * `profile` - How the runner waits when its input is idle.
+    /// * `metrics` - Where the runner records its input latencies.
+    ///
+    /// # Returns
+    ///
+    /// A new `Runner` instance holding the task's completion signal and control channel.
+    pub(super) fn new_frame(
+        state: Arc<Mutex<State>>,
+        callback: FrameCallback<State>,
+        profile: RunnerProfile,
+        metrics: Arc<RunnerMetrics>,
+    ) -> Self
+    where
+        State: Send + 'static,
+        Input: Sync + Send + Serialize + DeserializeOwned + 'static,
+    {
+        Self::spawn(state, Delivery::Frame(callback), profile, metrics)
+    }
+
+    /// Creates a runner that conflates its backlog and starts it on the shared executor.
+    ///
+    /// Each pass drains the pending messages within `policy`, folds them down to the
+    /// latest value of every stream (see `Conflate`) and invokes `callback` once per
+    /// stream under a single state lock. Stale values are counted, not delivered.
+    ///
+    /// # Arguments
+    ///
+    /// * `state` - Shared thread-safe access to the microservice state.
+    /// * `callback` - To be executed with the latest value of each stream.
+    /// * `policy` - Bounds on the size and draining time of a burst.
+    /// * `profile` - How the runner waits when its input is idle.
+    /// * `metrics` - Where the runner records its input latencies.
+    ///
+    /// # Returns
+    ///
+    /// A new `Runner` instance holding the task's completion signal and control channel.
+    pub(super) fn new_conflating(
+        state: Arc<Mutex<State>>,
+        callback: Box<dyn FnMut(&mut State, Id, Input) + Send>,
+        policy: BatchPolicy,
+        profile: RunnerProfile,
+        metrics: Arc<RunnerMetrics>,
+    ) -> Self
+    where
+        State: Send + 'static,
+        Input: Conflate + Sync + Send + Serialize + DeserializeOwned + 'static,
+    {
+        let delivery = Delivery::Conflate {
+            callback,
+            policy,
+            backlog: Box::new(Latest::<Input>::new()),
+        };
+        Self::spawn(state, delivery, profile, metrics)
+    }
+
+    fn spawn(
+        state: Arc<Mutex<State>>,
+        delivery: Delivery<State, Input>,
+        profile: RunnerProfile,
+        metrics: Arc<RunnerMetrics>,
     ) -> Self
     where
         State: Send + 'static,
         Input: Sync + Send + Serialize + DeserializeOwned + 'static,
     {
         let (control_tx, control_rx) = mpsc::channel();
-        let handle = thread::spawn(move || {
-            // Create a runtime for the async runner loop
-            let rt = tokio::runtime::Builder::new_multi_thread()
-                .enable_all()
-                .build()
-                .unwrap();
-            rt.block_on(runner_loop(control_rx, state, callback));
+        let wakeup = Wakeup::new().unwrap();
+        let loop_wakeup = wakeup.clone();
+        let (done_tx, done_rx) = mpsc::channel::<()>();
+        let tracer = Tracer::new(metrics.clone());
+        executor::handle().spawn(async move {
+            runner_loop(control_rx, loop_wakeup, profile, state, delivery, tracer).await;
+            // Dropped on exit (or unwind), releasing `shutdown`.
+            drop(done_tx);
         });
         Self {
-            handle: Some(handle),
+            done: Some(done_rx),
             control_tx,
+            wakeup,
+            metrics,
             _input_marker: std::marker::PhantomData,
             _state_marker: std::marker::PhantomData,
         }
@@ -85,9 +283,7 @@ impl<State, Input> Runner<State, Input> {
     ///
     /// * `address` - The new address to bind/connect to.
     fn update_address(&mut self, address: Address) {
-        self.control_tx
-            .send(RunnerCommand::UpdateAddress(address))
-            .unwrap();
+        self.send_command(RunnerCommand::UpdateAddress(address));
     }
 
     /// Adds a new input source to the runner.
@@ -96,9 +292,7 @@ impl<State, Input> Runner<State, Input> {
     ///
     /// * `address` - The address to connect to.
     fn add_input(&mut self, address: Address) {
-        self.control_tx
-            .send(RunnerCommand::AddInput(address))
-            .unwrap();
+        self.send_command(RunnerCommand::AddInput(address));
     }
 
     /// Disconnects an input source from the runner.
@@ -107,22 +301,36 @@ impl<State, Input> Runner<State, Input> {
     ///
     /// * `address` - The address to disconnect from.
     fn disconnect_input(&mut self, address: Address) {
-        self.control_tx
-            .send(RunnerCommand::DisconnectInput(address))
-            .unwrap();
+        self.send_command(RunnerCommand::DisconnectInput(address));
+    }
+
+    /// Restricts the runner's input to some topics.
+    ///
+    /// # Arguments
+    ///
+    /// * `topics` - The topics to receive, empty to receive everything.
+    fn subscribe(&mut self, topics: Vec<Topic>) {
+        self.send_command(RunnerCommand::Subscribe(topics));
     }
 
     /// Shuts down the runner.
     ///
     /// # Panics
     ///
-    /// Panics if the thread join fails or channel send fails (which shouldn't happen in normal operation).
+    /// Panics if the channel send fails (which shouldn't happen in normal operation).
     fn shutdown(&mut self) {
-        self.control_tx.send(RunnerCommand::Stop).unwrap();
-        if let Some(handle) = self.handle.take() {
-            handle.join().unwrap();
+        self.send_command(RunnerCommand::Stop);
+        if let Some(done) = self.done.take() {
+            // Blocks until the task has exited and dropped its sender.
+            let _ = done.recv();
         }
     }
+
+    /// Queues a control command and wakes the loop if it is parked on its input.
+    fn send_command(&mut self, command: RunnerCommand) {
+        self.control_tx.send(command).unwrap();
+        self.wakeup.notify();
+    }
 }
 
 /// A trait for type-erased runners, allowing them to be stored in a homogeneous collection.
@@ -135,6 +343,15 @@ pub(crate) trait ManagedRunner: Send {
     fn add_input(&mut self, address: Address);
     /// Disconnects an input source from the runner.
     fn disconnect_input(&mut self, address: Address);
+    /// Restricts the runner's input to some topics.
+    fn subscribe(&mut self, topics: Vec<Topic>);
+    /// Applies a new binding of an output port, for runners that publish; ignored
+    /// by default.
+    fn update_output(&mut self, _port: &str, _binding: &Binding) {}
+    /// Returns the number of messages conflated away, 0 if the runner does not conflate.
+    fn conflated(&self) -> u64 {
+        0
+    }
 }
 
 impl<State, Input> ManagedRunner for Runner<State, Input>
@@ -157,67 +374,259 @@ where
     fn disconnect_input(&mut self, address: Address) {
         self.disconnect_input(address)
     }
+
+    fn subscribe(&mut self, topics: Vec<Topic>) {
+        self.subscribe(topics)
+    }
+
+    fn conflated(&self) -> u64 {
+        self.metrics.conflated.load(Ordering::Relaxed)
+    }
+}
+
+/// Periodic callback on the state of a service, without an input of its own.
+///
+/// Used for work that must happen even when no message arrives, e.g. flushing an
+/// update a rate limit held back once the flow goes quiet.
+pub(crate) struct Ticker {
+    stop: Option<tokio::sync::oneshot::Sender<()>>,
+    done: Option<Receiver<()>>,
+}
+
+impl Ticker {
+    /// Starts calling `callback` every `period`, on the shared executor.
+    pub(crate) fn spawn<State>(
+        state: Arc<Mutex<State>>,
+        period: Duration,
+        mut callback: Box<dyn FnMut(&mut State) + Send>,
+    ) -> Self
+    where
+        State: Send + 'static,
+    {
+        let (stop, mut stop_rx) = tokio::sync::oneshot::channel::<()>();
+        let (done_tx, done_rx) = mpsc::channel::<()>();
+        executor::handle().spawn(async move {
+            let mut interval = tokio::time::interval(period);
+            interval.set_missed_tick_behavior(tokio::time::MissedTickBehavior::Delay);
+            loop {
+                tokio::select! {
+                    _ = &mut stop_rx => break,
+                    _ = interval.tick() => {}
+                }
+                callback(&mut state.lock().unwrap());
+            }
+            drop(done_tx);
+        });
+        Self {
+            stop: Some(stop),
+            done: Some(done_rx),
+        }
+    }
+}
+
+impl ManagedRunner for Ticker {
+    fn shutdown(&mut self) {
+        if let Some(stop) = self.stop.take() {
+            let _ = stop.send(());
+        }
+        if let Some(done) = self.done.take() {
+            let _ = done.recv();
+        }
+    }
+
+    fn update_address(&mut self, _address: Address) {}
+
+    fn add_input(&mut self, _address: Address) {}
+
+    fn disconnect_input(&mut self, _address: Address) {}
+
+    fn subscribe(&mut self, _topics: Vec<Topic>) {}
 }
 
 async fn runner_loop<State, Input>(
     control_rx: mpsc::Receiver<RunnerCommand>,
+    wakeup: Wakeup,
+    profile: RunnerProfile,
     state: Arc<Mutex<State>>,
-    mut callback: Box<dyn FnMut(&mut State, Id, Input) + Send>,
+    mut delivery: Delivery<State, Input>,
+    mut tracer: Tracer,
 ) where
     Input: Serialize + DeserializeOwned + Sync + Send + 'static,
 {
-    // First setup the listener on the address
-    let mut listener: ReceiverSocket<Input> = builder::build_empty_subscriber().unwrap();
+    // Starts empty, the first binding connects it.
+    let mut listener: Inputs<Input> = Inputs::new().unwrap();
     let mut busy_count = 0;
 
     loop {
         let mut received_work = false;
 
-        // 1. Try to receive a message
-        match listener.try_recv().await {
-            Ok(packet) => {
-                // Call the callback
-                callback(&mut state.lock().unwrap(), packet.id(), packet.data());
-                received_work = true;
+        // 1. Try to receive messages
+        match &mut delivery {
+            Delivery::Single(callback) => match listener.try_recv().await {
+                Ok(packet) => {
+                    let (id, trace) = (packet.id(), packet.trace());
+                    if tracer.observe(id, trace, unix_nanos()) {
+                        let started = Instant::now();
+                        trace::with_origin(trace.origin_ns, || {
+                            callback(&mut state.lock().unwrap(), id, packet.data())
+                        });
+                        tracer.metrics().callback.record(started.elapsed());
+                    }
+                    received_work = true;
+                }
+                Err(_) => (),
+            },
+            Delivery::Batch {
+                callback,
+                policy,
+                buffer,
+            } => {
+                // Drain the backlog within the policy bounds, then lock once for the burst
+                let started = Instant::now();
+                let mut origin_ns = 0;
+                while buffer.len() < policy.max_messages.max(1) {
+                    match listener.try_recv().await {
+                        Ok(packet) => {
+                            let trace = packet.trace();
+                            if tracer.observe(packet.id(), trace, unix_nanos()) {
+                                origin_ns = earliest(origin_ns, trace.origin_ns);
+                                buffer.push((packet.id(), packet.data()));
+                            }
+                        }
+                        Err(_) => break,
+                    }
+                    if started.elapsed() >= policy.max_latency {
+                        break;
+                    }
+                }
+                if !buffer.is_empty() {
+                    let started = Instant::now();
+                    trace::with_origin(origin_ns, || callback(&mut state.lock().unwrap(), buffer));
+                    tracer.metrics().callback.record(started.elapsed());
+                    buffer.clear();
+                    received_work = true;
+                }
             }
-            Err(_) => (),
+            Delivery::Conflate {
+                callback,
+                policy,
+                backlog,
+            } => {
+                // Drain the backlog within the policy bounds, keeping one value per stream
+                let started = Instant::now();
+                let mut drained = 0;
+                let mut origin_ns = 0;
+                while drained < policy.max_messages.max(1) {
+                    match listener.try_recv().await {
+                        Ok(packet) => {
+                            drained += 1;
+                            let trace = packet.trace();
+                            if tracer.observe(packet.id(), trace, unix_nanos()) {
+                                origin_ns = earliest(origin_ns, trace.origin_ns);
+                                if backlog.push(packet.id(), packet.data()) {
+                                    tracer.metrics().conflated.fetch_add(1, Ordering::Relaxed);
+                                }
+                            }
+                        }
+                        Err(_) => break,
+                    }
+                    if started.elapsed() >= policy.max_latency {
+                        break;
+                    }
+                }
+                if !backlog.is_empty() {
+                    let started = Instant::now();
+                    trace::with_origin(origin_ns, || {
+                        let mut state = state.lock().unwrap();
+                        for (id, input) in backlog.drain() {
+                            callback(&mut state, id, input);
+                        }
+                    });
+                    tracer.metrics().callback.record(started.elapsed());
+                    received_work = true;
+                }
+            }
+            Delivery::Frame(callback) => match listener.try_recv_frame().await {
+                Ok(frame) => {
+                    // The payload is decoded by the handler, only read the header here.
+                    let (admitted, trace) = match Trace::peek(frame) {
+                        Some((id, trace)) => (tracer.observe(id, trace, unix_nanos()), trace),
+                        None => (true, Trace::default()),
+                    };
+                    if admitted {
+                        let started = Instant::now();
+                        trace::with_origin(trace.origin_ns, || {
+                            callback(&mut state.lock().unwrap(), frame)
+                        });
+                        tracer.metrics().callback.record(started.elapsed());
+                    }
+                    received_work = true;
+                }
+                Err(_) => (),
+            },
         }
 
         // 2. Try to receive a control message
         match control_rx.try_recv() {
             Ok(RunnerCommand::Stop) => break,
             Ok(RunnerCommand::UpdateAddress(addr)) => {
-                // For replacing the listener, we rebuild it
-                listener = build_subscriber(&addr).unwrap();
+                listener.update_address(addr);
                 received_work = true;
             }
             Ok(RunnerCommand::AddInput(addr)) => {
-                // For adding inputs, we use connect on the existing listener
-                // We unwrap here as this is a critical configuration error if it fails
-                listener.connect(&addr).await.unwrap();
+                listener.add_input(addr);
                 received_work = true;
             }
             Ok(RunnerCommand::DisconnectInput(addr)) => {
-                listener.disconnect(&addr).await.unwrap();
+                listener.disconnect_input(addr).await;
+                received_work = true;
+            }
+            Ok(RunnerCommand::Subscribe(new_topics)) => {
+                listener.subscribe(new_topics);
                 received_work = true;
             }
             Err(_) => (),
         }
+        listener.progress().await;
 
-        // 3. Backoff (Hybrid Spin/Sleep)
         if received_work {
             busy_count = 0;
-        } else {
-            busy_count += 1;
-            if busy_count < 2000 {
-                // High Perf: Yield to OS but stay scheduled (Nanoseconds/Microseconds latency)
-                std::thread::yield_now();
-            } else {
-                // Low Power: Sleep if really idle (1ms latency)
-                // Cap the counter to avoid overflow, just stay in sleep mode
-                busy_count = 2000;
-                tokio::time::sleep(tokio::time::Duration::from_millis(1)).await;
+            continue;
+        }
+
+        // 3. Idle: wait according to the profile
+        match profile {
+            RunnerProfile::Blocking => {
+                // Park on the input and the wakeup signal together. The signal is only
+                // cleared after waking and before re-checking the control channel, so a
+                // command queued at any point re-arms the next wait.
+                if let Err(e) = listener.wait_readable(&wakeup).await {
+                    log::error!("Runner failed to wait on its input: {}", e);
+                    tokio::time::sleep(tokio::time::Duration::from_millis(1)).await;
+                }
+                wakeup.drain();
+            }
+            RunnerProfile::BusyPoll => {
+                // Hybrid Spin/Sleep backoff
+                busy_count += 1;
+                if busy_count < 2000 {
+                    // High Perf: Yield to the other tasks but stay scheduled (Microseconds latency)
+                    tokio::task::yield_now().await;
+                } else {
+                    // Low Power: Sleep if really idle (1ms latency)
+                    // Cap the counter to avoid overflow, just stay in sleep mode
+                    busy_count = 2000;
+                    tokio::time::sleep(tokio::time::Duration::from_millis(1)).await;
+                }
             }
         }
     }
 }
+
+/// Returns the earlier of two trace origins, ignoring untraced (zero) ones.
+fn earliest(a: u64, b: u64) -> u64 {
+    match (a, b) {
+        (0, origin) | (origin, 0) => origin,
+        (a, b) => a.min(b),
+    }
+}
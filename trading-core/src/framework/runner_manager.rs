@@ -1,14 +1,22 @@
-use crate::framework::runner::{ManagedRunner, Runner};
+use crate::comms::topic;
+use crate::framework::conflate::Conflate;
+use crate::framework::runner::{
+    BatchCallback, BatchPolicy, FrameCallback, ManagedRunner, Runner, RunnerProfile, Ticker,
+};
 use crate::manifest::Binding;
+use crate::metrics;
 use crate::model::identity::Id;
 use serde::de::DeserializeOwned;
 use serde::Serialize;
 use std::collections::HashMap;
 use std::sync::{Arc, Mutex};
+use std::time::Duration;
 
 /// Manages multiple runners.
 ///
 /// It holds types-erased runners and allows controlling them via string identifiers.
+/// Every runner is a task on the shared executor (see `framework::executor`), so adding
+/// inputs does not add threads.
 pub struct RunnerManager {
     runners: HashMap<String, Box<dyn ManagedRunner>>,
     active_bindings: HashMap<String, Binding>,
@@ -37,30 +45,47 @@ impl RunnerManager {
         if let Some(runner) = self.runners.get_mut(name) {
             let old_binding = self.active_bindings.get(name);
 
+            // Narrow the subscription before (re)connecting, so no message outside
+            // the universe is queued in between.
+            let universe = binding.universe();
+            if old_binding.map_or(!universe.is_empty(), |old| old.universe() != universe) {
+                runner.subscribe(topic::universe_topics(&universe));
+            }
+
             match (old_binding, &binding) {
                 // Case: Variadic -> Variadic (Diff Logic)
                 (Some(Binding::Variadic(old_map)), Binding::Variadic(new_map)) => {
-                    // 1. Remove inputs that are in OLD but not in NEW
-                    for (id, source) in old_map {
-                        if !new_map.contains_key(id) {
-                            runner.disconnect_input(source.address.clone());
-                        }
-                    }
+                    // Make before break: the runner holds the disconnects back until
+                    // the inputs added before them deliver.
+                    let mut removed = Vec::new();
 
-                    // 2. Add or Update inputs from NEW
+                    // 1. Add or Update inputs from NEW
                     for (id, source) in new_map {
                         // Check if it existed
                         if let Some(old_source) = old_map.get(id) {
                             if old_source.address != source.address || old_source.id != source.id {
-                                // Changed: Disconnect old, Connect new
-                                runner.disconnect_input(old_source.address.clone());
+                                // Changed: Connect new, then Disconnect old
                                 runner.add_input(source.address.clone());
+                                removed.push(old_source.address.clone());
                             }
                         } else {
                             // New: Connect
                             runner.add_input(source.address.clone());
                         }
                     }
+
+                    // 2. Remove inputs that are in OLD but not in NEW
+                    for (id, source) in old_map {
+                        if !new_map.contains_key(id) {
+                            removed.push(source.address.clone());
+                        }
+                    }
+                    for address in removed {
+                        // Still wanted if another input moved onto it.
+                        if !new_map.values().any(|source| source.address == address) {
+                            runner.disconnect_input(address);
+                        }
+                    }
                 }
 
                 // Case: Any -> Single (Hot Swap)
@@ -96,8 +121,169 @@ impl RunnerManager {
         State: Send + 'static,
         Input: Sync + Send + Serialize + DeserializeOwned + 'static,
     {
-        let runner = Runner::new(state, callback);
-        self.runners.insert(name.into(), Box::new(runner));
+        self.add_runner_with_profile(name, state, callback, RunnerProfile::default());
+    }
+
+    /// Creates and starts a new runner with an explicit idle profile.
+    ///
+    /// Use `RunnerProfile::BusyPoll` for latency-critical inputs that can afford
+    /// a dedicated core; `add_runner` uses the blocking profile.
+    ///
+    /// # Arguments
+    ///
+    /// * `name` - Unique identifier for this runner (e.g. "market_data").
+    /// * `state` - Shared state.
+    /// * `callback` - The message processing function.
+    /// * `profile` - How the runner waits when its input is idle.
+    pub fn add_runner_with_profile<State, Input>(
+        &mut self,
+        name: impl Into<String>,
+        state: Arc<Mutex<State>>,
+        callback: Box<dyn FnMut(&mut State, Id, Input) + Send>,
+        profile: RunnerProfile,
+    ) where
+        State: Send + 'static,
+        Input: Sync + Send + Serialize + DeserializeOwned + 'static,
+    {
+        let name = name.into();
+        let runner = Runner::new(state, callback, profile, metrics::runner(&name));
+        self.runners.insert(name, Box::new(runner));
+    }
+
+    /// Creates and starts a runner that delivers its input in bursts.
+    ///
+    /// Each pass drains up to `policy.max_messages` pending messages (or for at most
+    /// `policy.max_latency`) and invokes `callback` once with all of them under a
+    /// single state lock, so handlers can coalesce bursts into one recompute.
+    ///
+    /// # Arguments
+    ///
+    /// * `name` - Unique identifier for this runner (e.g. "strategies").
+    /// * `state` - Shared state.
+    /// * `callback` - The burst processing function.
+    /// * `policy` - Bounds on the size and draining time of a burst.
+    pub fn add_batch_runner<State, Input>(
+        &mut self,
+        name: impl Into<String>,
+        state: Arc<Mutex<State>>,
+        callback: BatchCallback<State, Input>,
+        policy: BatchPolicy,
+    ) where
+        State: Send + 'static,
+        Input: Sync + Send + Serialize + DeserializeOwned + 'static,
+    {
+        let name = name.into();
+        let runner = Runner::new_batch(
+            state,
+            callback,
+            policy,
+            RunnerProfile::default(),
+            metrics::runner(&name),
+        );
+        self.runners.insert(name, Box::new(runner));
+    }
+
+    /// Creates and starts a runner that conflates its backlog.
+    ///
+    /// When the handler falls behind, only the latest value of every stream (see
+    /// `Conflate`) is delivered and the stale ones are counted, which bounds the
+    /// backlog and keeps decision latency flat under bursts.
+    ///
+    /// # Arguments
+    ///
+    /// * `name` - Unique identifier for this runner (e.g. "portfolio").
+    /// * `state` - Shared state.
+    /// * `callback` - The message processing function.
+    /// * `policy` - Bounds on the size and draining time of a burst.
+    pub fn add_conflating_runner<State, Input>(
+        &mut self,
+        name: impl Into<String>,
+        state: Arc<Mutex<State>>,
+        callback: Box<dyn FnMut(&mut State, Id, Input) + Send>,
+        policy: BatchPolicy,
+    ) where
+        State: Send + 'static,
+        Input: Conflate + Sync + Send + Serialize + DeserializeOwned + 'static,
+    {
+        let name = name.into();
+        let runner = Runner::new_conflating(
+            state,
+            callback,
+            policy,
+            RunnerProfile::default(),
+            metrics::runner(&name),
+        );
+        self.runners.insert(name, Box::new(runner));
+    }
+
+    /// Starts calling `callback` on the state every `period`, input or not.
+    ///
+    /// # Arguments
+    ///
+    /// * `name` - Unique identifier for this ticker (e.g. "flush").
+    /// * `state` - Shared state.
+    /// * `period` - Time between two calls.
+    /// * `callback` - The periodic work.
+    pub fn add_ticker<State>(
+        &mut self,
+        name: impl Into<String>,
+        state: Arc<Mutex<State>>,
+        period: Duration,
+        callback: Box<dyn FnMut(&mut State) + Send>,
+    ) where
+        State: Send + 'static,
+    {
+        let ticker = Ticker::spawn(state, period, callback);
+        self.runners.insert(name.into(), Box::new(ticker));
+    }
+
+    /// Returns the number of messages a runner conflated away.
+    ///
+    /// # Returns
+    ///
+    /// `None` if there is no runner named `name`, `Some(0)` if it does not conflate.
+    pub fn conflated(&self, name: &str) -> Option<u64> {
+        self.runners.get(name).map(|runner| runner.conflated())
+    }
+
+    /// Creates and starts a runner that hands raw frames to its handler.
+    ///
+    /// Used for inputs whose payload is read in place from the receive buffer
+    /// (e.g. `MarketDataBatchView`) instead of being decoded into an owned value.
+    ///
+    /// # Arguments
+    ///
+    /// * `name` - Unique identifier for this runner (e.g. "market_data").
+    /// * `state` - Shared state.
+    /// * `callback` - The frame processing function.
+    pub fn add_frame_runner<State>(
+        &mut self,
+        name: impl Into<String>,
+        state: Arc<Mutex<State>>,
+        callback: FrameCallback<State>,
+    ) where
+        State: Send + 'static,
+    {
+        let name = name.into();
+        let runner = Runner::<State, ()>::new_frame(
+            state,
+            callback,
+            RunnerProfile::default(),
+            metrics::runner(&name),
+        );
+        self.runners.insert(name, Box::new(runner));
+    }
+
+    /// Hands a new binding of an output port to the runners, for those publishing on it.
+    ///
+    /// # Arguments
+    ///
+    /// * `port` - The name of the output port.
+    /// * `binding` - Its binding information.
+    pub fn update_output(&mut self, port: &str, binding: &Binding) {
+        for runner in self.runners.values_mut() {
+            runner.update_output(port, binding);
+        }
     }
 
     /// Adds a pre-configured managed runner.
@@ -0,0 +1,407 @@
+//! Memory-mapped instrument files, the compact on-disk form of an `InstrumentDB`.
+//!
+//! Parsing a JSON universe costs every service seconds and its own copy of every
+//! string at startup. An instrument file is laid out to be used in place instead:
+//! services map it read-only and share its pages through the page cache.
+//!
+//! | offset | content |
+//! |--------|---------|
+//! | 0      | magic `b"INSTRDB\0"` |
+//! | 8      | file version (`u32`), then 4 reserved bytes |
+//! | 16     | slot count `n` (`u64`): ids `0..n` |
+//! | 24     | symbol index bucket count `m` (`u64`, a power of two) |
+//! | 32     | string pool length (`u64`) |
+//! | 40     | instrument table (`[Record; n]`), indexed by id |
+//! | ...    | symbol index (`[u32; m]`): an id, or `EMPTY` |
+//! | ...    | string pool: every distinct string once, as a `u32` length then UTF-8 |
+//!
+//! A `Record` is eight `u32`: the kind (`KIND_*`, `KIND_NONE` for an unused id),
+//! then the pool offsets of the symbol, exchange, sector, industry, country and
+//! currency of a stock, then a reserved word. The symbol index is an open-addressing
+//! table hashed with 64-bit FNV-1a and probed linearly. Every integer is
+//! little-endian.
+
+use super::mapping::Mapping;
+use anyhow::{bail, Context, Result};
+use std::collections::HashMap;
+use std::fs::File;
+use std::io::{BufWriter, Write};
+use std::path::Path;
+use trading::model::instrument::{Future, Instrument, InstrumentId, OptionContract, Stock};
+use trading::model::instrument_db::InstrumentDB;
+
+const MAGIC: [u8; 8] = *b"INSTRDB\0";
+const VERSION: u32 = 1;
+const HEADER_LEN: usize = 40;
+const RECORD_WORDS: usize = 8;
+const RECORD_LEN: usize = RECORD_WORDS * 4;
+/// Strings of a stock record, in record order.
+const STOCK_FIELDS: usize = 6;
+
+const KIND_NONE: u32 = 0;
+const KIND_STOCK: u32 = 1;
+const KIND_FUTURE: u32 = 2;
+const KIND_OPTION: u32 = 3;
+
+/// Free bucket of the symbol index.
+const EMPTY: u32 = u32::MAX;
+
+/// A read-only, memory-mapped instrument file.
+pub struct InstrumentStore {
+    map: Mapping,
+    slots: usize,
+    buckets: usize,
+    index_offset: usize,
+    pool_offset: usize,
+}
+
+impl InstrumentStore {
+    /// Writes the instruments of `db` to an instrument file.
+    ///
+    /// The file is written aside and renamed into place, so stores already mapping
+    /// the previous version keep reading it unchanged.
+    ///
+    /// # Arguments
+    ///
+    /// * `path` - The file to write.
+    /// * `db` - The instruments; their ids should be dense, as the table has a slot
+    ///   for every id up to the largest.
+    pub fn write(path: &Path, db: &InstrumentDB) -> Result<()> {
+        let slots = db.iter().map(|(id, _)| id + 1).max().unwrap_or(0);
+        if slots >= EMPTY as usize {
+            bail!(
+                "Instrument id {} is too large for an instrument file",
+                slots - 1
+            );
+        }
+        let mut table = vec![0u32; slots * RECORD_WORDS];
+        let mut pool = Pool::default();
+        for (&id, instrument) in db.iter() {
+            let record = &mut table[id * RECORD_WORDS..(id + 1) * RECORD_WORDS];
+            match instrument {
+                Instrument::Stock(stock) => {
+                    record[0] = KIND_STOCK;
+                    let fields = [
+                        stock.get_symbol(),
+                        stock.get_exchange(),
+                        stock.get_sector(),
+                        stock.get_industry(),
+                        stock.get_country(),
+                        stock.get_currency(),
+                    ];
+                    for (word, field) in record[1..=STOCK_FIELDS].iter_mut().zip(fields) {
+                        *word = pool.intern(field)?;
+                    }
+                }
+                Instrument::Future(_) => record[0] = KIND_FUTURE,
+                Instrument::Option(_) => record[0] = KIND_OPTION,
+            }
+        }
+
+        // At most half full, so probes stay short.
+        let buckets = (db.len() * 2).next_power_of_two().max(1);
+        let mut index = vec![EMPTY; buckets];
+        // Ascending ids, so a shared symbol resolves to the lowest id.
+        for id in 0..slots {
+            let record = &table[id * RECORD_WORDS..(id + 1) * RECORD_WORDS];
+            if record[0] != KIND_STOCK {
+                continue;
+            }
+            let symbol = pool.get(record[1]);
+            let mut bucket = hash(symbol) as usize & (buckets - 1);
+            loop {
+                match index[bucket] {
+                    EMPTY => {
+                        index[bucket] = id as u32;
+                        break;
+                    }
+                    other if pool.get(table[other as usize * RECORD_WORDS + 1]) == symbol => break,
+                    _ => bucket = (bucket + 1) & (buckets - 1),
+                }
+            }
+        }
+
+        if let Some(parent) = path.parent() {
+            std::fs::create_dir_all(parent).context("Failed to create parent directory")?;
+        }
+        // Per process: services starting together may all rebuild the same file.
+        let temp_path = path.with_extension(format!("tmp.{}", std::process::id()));
+        let file = File::create(&temp_path)
+            .with_context(|| format!("Failed to create {}", temp_path.display()))?;
+        let mut out = BufWriter::new(file);
+        let mut header = [0u8; HEADER_LEN];
+        header[0..8].copy_from_slice(&MAGIC);
+        header[8..12].copy_from_slice(&VERSION.to_le_bytes());
+        header[16..24].copy_from_slice(&(slots as u64).to_le_bytes());
+        header[24..32].copy_from_slice(&(buckets as u64).to_le_bytes());
+        header[32..40].copy_from_slice(&(pool.bytes.len() as u64).to_le_bytes());
+        out.write_all(&header)?;
+        for word in table.iter().chain(&index) {
+            out.write_all(&word.to_le_bytes())?;
+        }
+        out.write_all(&pool.bytes)?;
+        let file = out
+            .into_inner()
+            .map_err(|e| e.into_error())
+            .with_context(|| format!("Failed to write {}", temp_path.display()))?;
+        file.sync_all()?;
+        std::fs::rename(&temp_path, path)
+            .with_context(|| format!("Failed to rename {}", temp_path.display()))?;
+        Ok(())
+    }
+
+    /// Maps an instrument file and validates its layout.
+    ///
+    /// Every record and index entry is checked once here, so lookups need not.
+    ///
+    /// # Arguments
+    ///
+    /// * `path` - The file written by `InstrumentStore::write`.
+    pub fn open(path: &Path) -> Result<Self> {
+        let file = File::open(path)
+            .with_context(|| format!("Failed to open instrument file {}", path.display()))?;
+        let map = Mapping::new(&file)
+            .with_context(|| format!("Failed to map instrument file {}", path.display()))?;
+        let bytes = map.bytes();
+        if bytes.len() < HEADER_LEN || bytes[0..8] != MAGIC {
+            bail!("{} is not an instrument file", path.display());
+        }
+        let version = read_u32(bytes, 8);
+        if version != VERSION {
+            bail!(
+                "Unsupported instrument file version {} in {} (expected {})",
+                version,
+                path.display(),
+                VERSION
+            );
+        }
+        let slots = read_u64(bytes, 16) as usize;
+        let buckets = read_u64(bytes, 24) as usize;
+        let pool_len = read_u64(bytes, 32) as usize;
+        let index_offset = slots
+            .checked_mul(RECORD_LEN)
+            .and_then(|len| len.checked_add(HEADER_LEN));
+        let pool_offset =
+            index_offset.and_then(|offset| buckets.checked_mul(4)?.checked_add(offset));
+        let (index_offset, pool_offset) = match (index_offset, pool_offset) {
+            (Some(index), Some(pool))
+                if buckets.is_power_of_two() && pool.checked_add(pool_len) == Some(bytes.len()) =>
+            {
+                (index, pool)
+            }
+            _ => bail!("Instrument file {} has a corrupt header", path.display()),
+        };
+        let store = Self {
+            map,
+            slots,
+            buckets,
+            index_offset,
+            pool_offset,
+        };
+
+        for id in 0..slots {
+            let kind = store.word(id, 0);
+            let valid = match kind {
+                KIND_NONE | KIND_FUTURE | KIND_OPTION => true,
+                KIND_STOCK => (1..=STOCK_FIELDS).all(|field| {
+                    let offset = store.word(id, field) as usize;
+                    store.checked_string(offset).is_some()
+                }),
+                _ => false,
+            };
+            if !valid {
+                bail!(
+                    "Instrument file {} has a corrupt record {}",
+                    path.display(),
+                    id
+                );
+            }
+        }
+        // Probes end on a free bucket, so the index must have one.
+        let mut free = buckets == 0;
+        for bucket in 0..buckets {
+            match store.bucket(bucket) {
+                EMPTY => free = true,
+                id if (id as usize) < slots && store.word(id as usize, 0) == KIND_STOCK => {}
+                _ => bail!("Instrument file {} has a corrupt index", path.display()),
+            }
+        }
+        if !free {
+            bail!("Instrument file {} has a corrupt index", path.display());
+        }
+        Ok(store)
+    }
+
+    /// Returns the number of id slots, one more than the largest id.
+    pub fn len(&self) -> usize {
+        self.slots
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.slots == 0
+    }
+
+    /// Returns whether an instrument is defined under `id`.
+    pub fn contains(&self, id: InstrumentId) -> bool {
+        id < self.slots && self.word(id, 0) != KIND_NONE
+    }
+
+    /// Returns the ticker symbol of an instrument, borrowed from the mapping.
+    pub fn symbol(&self, id: InstrumentId) -> Option<&str> {
+        (id < self.slots && self.word(id, 0) == KIND_STOCK).then(|| self.field(id, 1))
+    }
+
+    /// Returns the ID of the instrument trading under `symbol`, in O(1).
+    ///
+    /// # Returns
+    ///
+    /// The lowest ID holding `symbol` if several do, as `InstrumentDB::get_id`.
+    pub fn get_id(&self, symbol: &str) -> Option<InstrumentId> {
+        if self.buckets == 0 {
+            return None;
+        }
+        let mut bucket = hash(symbol) as usize & (self.buckets - 1);
+        loop {
+            match self.bucket(bucket) {
+                EMPTY => return None,
+                id if self.field(id as usize, 1) == symbol => return Some(id as usize),
+                _ => bucket = (bucket + 1) & (self.buckets - 1),
+            }
+        }
+    }
+
+    /// Returns an owned copy of an instrument.
+    pub fn get(&self, id: InstrumentId) -> Option<Instrument> {
+        if id >= self.slots {
+            return None;
+        }
+        match self.word(id, 0) {
+            KIND_STOCK => Some(Instrument::Stock(Stock::new(
+                id,
+                self.field(id, 1),
+                self.field(id, 2),
+                self.field(id, 3),
+                self.field(id, 4),
+                self.field(id, 5),
+                self.field(id, 6),
+            ))),
+            KIND_FUTURE => Some(Instrument::Future(Future {})),
+            KIND_OPTION => Some(Instrument::Option(OptionContract {})),
+            _ => None,
+        }
+    }
+
+    /// Copies every instrument into an `InstrumentDB`, in one bulk load.
+    pub fn to_db(&self) -> InstrumentDB {
+        let mut db = InstrumentDB::with_capacity(self.slots);
+        db.extend((0..self.slots).filter_map(|id| Some((id, self.get(id)?))));
+        db
+    }
+
+    fn word(&self, id: InstrumentId, word: usize) -> u32 {
+        read_u32(self.map.bytes(), HEADER_LEN + id * RECORD_LEN + word * 4)
+    }
+
+    fn bucket(&self, bucket: usize) -> u32 {
+        read_u32(self.map.bytes(), self.index_offset + bucket * 4)
+    }
+
+    /// Returns a string field of a stock record, validated by `open`.
+    fn field(&self, id: InstrumentId, field: usize) -> &str {
+        self.checked_string(self.word(id, field) as usize)
+            .expect("instrument records are validated by open")
+    }
+
+    fn checked_string(&self, offset: usize) -> Option<&str> {
+        let pool = &self.map.bytes()[self.pool_offset..];
+        let start = offset.checked_add(4)?;
+        let len = u32::from_le_bytes(pool.get(offset..start)?.try_into().unwrap()) as usize;
+        std::str::from_utf8(pool.get(start..start.checked_add(len)?)?).ok()
+    }
+}
+
+/// The string pool of a file being written, each distinct string stored once.
+#[derive(Default)]
+struct Pool {
+    bytes: Vec<u8>,
+    offsets: HashMap<String, u32>,
+}
+
+impl Pool {
+    fn intern(&mut self, value: &str) -> Result<u32> {
+        if let Some(&offset) = self.offsets.get(value) {
+            return Ok(offset);
+        }
+        let offset = u32::try_from(self.bytes.len())
+            .context("Instrument strings exceed the 4GiB string pool")?;
+        self.bytes
+            .extend_from_slice(&(value.len() as u32).to_le_bytes());
+        self.bytes.extend_from_slice(value.as_bytes());
+        self.offsets.insert(value.to_string(), offset);
+        Ok(offset)
+    }
+
+    fn get(&self, offset: u32) -> &str {
+        let start = offset as usize + 4;
+        let len = read_u32(&self.bytes, offset as usize) as usize;
+        std::str::from_utf8(&self.bytes[start..start + len]).unwrap()
+    }
+}
+
+/// 64-bit FNV-1a, part of the file format: it must not change within a version.
+fn hash(symbol: &str) -> u64 {
+    symbol.bytes().fold(0xcbf2_9ce4_8422_2325, |hash, byte| {
+        (hash ^ byte as u64).wrapping_mul(0x0000_0100_0000_01b3)
+    })
+}
+
+fn read_u32(bytes: &[u8], at: usize) -> u32 {
+    u32::from_le_bytes(bytes[at..at + 4].try_into().unwrap())
+}
+
+fn read_u64(bytes: &[u8], at: usize) -> u64 {
+    u64::from_le_bytes(bytes[at..at + 8].try_into().unwrap())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_instruments_round_trip_through_the_mapping() {
+        let stock = |id, symbol: &str| {
+            let stock = Stock::new(id, symbol, "NASDAQ", "Tech", "Software", "USA", "USD");
+            (id, Instrument::Stock(stock))
+        };
+        let db: InstrumentDB = [
+            stock(0, "AAPL"),
+            stock(1, "MSFT"),
+            stock(3, "AAPL"),
+            (4, Instrument::Future(Future {})),
+        ]
+        .into_iter()
+        .collect();
+        let path = std::env::temp_dir().join(format!("instruments_{}.db", std::process::id()));
+        InstrumentStore::write(&path, &db).unwrap();
+
+        let store = InstrumentStore::open(&path).unwrap();
+        assert_eq!(store.len(), 5);
+        assert!(!store.contains(2));
+        assert_eq!(store.get(1), db.get(1).cloned());
+        assert_eq!(store.get(4), Some(Instrument::Future(Future {})));
+        assert_eq!(store.get_id("AAPL"), Some(0));
+        assert_eq!(store.get_id("MSFT"), Some(1));
+        assert_eq!(store.get_id("GOOG"), None);
+        // Strings are read in place, not copied out of the mapping.
+        let symbol = store.symbol(3).unwrap();
+        assert!(store.map.bytes().as_ptr_range().contains(&symbol.as_ptr()));
+
+        let loaded = store.to_db();
+        assert_eq!(loaded.len(), 4);
+        assert_eq!(loaded.get_by_symbol("MSFT"), db.get(1));
+
+        std::fs::write(&path, b"INSTRDB\0garbage").unwrap();
+        assert!(InstrumentStore::open(&path).is_err());
+        std::fs::remove_file(&path).unwrap();
+    }
+}
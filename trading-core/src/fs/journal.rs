@@ -0,0 +1,527 @@
+//! Append-only state journals with group commit.
+//!
+//! `save_state` rewrites and syncs a whole pretty-printed snapshot per change, so a
+//! service checkpointing often spends its time in `fsync`. A journal persists the
+//! changes instead: each event is appended as one binary record, and a snapshot of
+//! the whole state is only written now and then to compact the log. On restart,
+//! `Journal::open` loads the snapshot and replays the events recorded after it.
+//!
+//! Appends are handed to a writer thread, which writes every record queued since
+//! its last pass and syncs them with a single `fdatasync` (group commit). The
+//! caller never waits on the disk unless it asks to, with `wait_durable`.
+//!
+//! A journal `<path>` is two files:
+//!
+//! | file                 | content |
+//! |----------------------|---------|
+//! | `<path>.snapshot`    | header with magic `b"SNAPSHOT"`, then one record: the state |
+//! | `<path>.journal`     | header with magic `b"JOURNAL\0"`, then one record per event |
+//!
+//! A header is the magic, the file version (`u32`) and 4 reserved bytes. A record
+//! is its payload length (`u32`), the CRC-32 of its sequence number and payload
+//! (`u32`), its sequence number (`u64`) and the bincode payload. Events are
+//! numbered from 1; the snapshot carries the number of the last event it includes,
+//! so replay skips events already folded into it. Every integer is little-endian.
+
+use anyhow::{anyhow, bail, Context, Result};
+use serde::de::DeserializeOwned;
+use serde::Serialize;
+use std::fs::{File, OpenOptions};
+use std::io::{BufWriter, Write};
+use std::marker::PhantomData;
+use std::path::{Path, PathBuf};
+use std::sync::mpsc;
+use std::sync::{Arc, Condvar, Mutex};
+use std::thread::JoinHandle;
+
+const JOURNAL_MAGIC: [u8; 8] = *b"JOURNAL\0";
+const SNAPSHOT_MAGIC: [u8; 8] = *b"SNAPSHOT";
+const VERSION: u32 = 1;
+const HEADER_LEN: usize = 16;
+const RECORD_HEADER: usize = 16;
+
+/// State that can be rebuilt from a snapshot and the events applied since.
+pub trait Journaled: Serialize + DeserializeOwned + Default {
+    /// A change to the state, as recorded in the journal.
+    type Event: Serialize + DeserializeOwned;
+
+    /// Applies a replayed event; must match what the live service did with it.
+    fn apply(&mut self, event: &Self::Event);
+}
+
+enum Command {
+    Append { seq: u64, payload: Vec<u8> },
+    Snapshot { seq: u64, payload: Vec<u8> },
+}
+
+/// Progress of the writer thread, shared with the journal.
+#[derive(Default)]
+struct Durable {
+    /// Last sequence number synced to disk.
+    seq: u64,
+    /// First failure of the writer; the journal is unusable after it.
+    error: Option<String>,
+}
+
+/// The writing end of a journal, see the module documentation.
+pub struct Journal<S: Journaled> {
+    commands: Option<mpsc::Sender<Command>>,
+    durable: Arc<(Mutex<Durable>, Condvar)>,
+    writer: Option<JoinHandle<()>>,
+    /// Sequence number of the next event.
+    next_seq: u64,
+    since_snapshot: u64,
+    _state: PhantomData<fn() -> S>,
+}
+
+impl<S: Journaled> Journal<S> {
+    /// Opens (or creates) a journal and restores its state.
+    ///
+    /// A torn record at the end of the journal, left by a crash mid-write, is
+    /// dropped along with anything after it. A file holding no more than its
+    /// header, e.g. one whose creation was cut short, is treated as empty.
+    ///
+    /// # Arguments
+    ///
+    /// * `path` - The journal; its files are named by appending their suffix to it.
+    ///
+    /// # Returns
+    ///
+    /// The journal, positioned after the last event, and the restored state.
+    pub fn open(path: &Path) -> Result<(Self, S)> {
+        let snapshot_path = with_suffix(path, ".snapshot");
+        let journal_path = with_suffix(path, ".journal");
+        if let Some(parent) = path.parent() {
+            std::fs::create_dir_all(parent).context("Failed to create parent directory")?;
+        }
+
+        let bytes = read_if_exists(&snapshot_path)?;
+        let (mut state, snapshot_seq) = if bytes.len() > HEADER_LEN {
+            check_header(&bytes, SNAPSHOT_MAGIC, &snapshot_path)?;
+            let (seq, payload, _) = read_record(&bytes[HEADER_LEN..])
+                .ok_or_else(|| anyhow!("Snapshot {} is corrupt", snapshot_path.display()))?;
+            let state = bincode::deserialize(payload)
+                .with_context(|| format!("Failed to decode {}", snapshot_path.display()))?;
+            (state, seq)
+        } else {
+            (S::default(), 0)
+        };
+
+        let mut last_seq = snapshot_seq;
+        let mut since_snapshot = 0;
+        // Zero for a new (or never initialized) journal, then `open_journal` writes its header.
+        let mut valid_len = 0;
+        let bytes = read_if_exists(&journal_path)?;
+        if bytes.len() > HEADER_LEN {
+            check_header(&bytes, JOURNAL_MAGIC, &journal_path)?;
+            valid_len = HEADER_LEN;
+            while let Some((seq, payload, len)) = read_record(&bytes[valid_len..]) {
+                if seq > last_seq {
+                    if seq != last_seq + 1 {
+                        bail!(
+                            "Journal {} skips from event {} to {}",
+                            journal_path.display(),
+                            last_seq,
+                            seq
+                        );
+                    }
+                    let event: S::Event = bincode::deserialize(payload).with_context(|| {
+                        format!(
+                            "Failed to decode event {} of {}",
+                            seq,
+                            journal_path.display()
+                        )
+                    })?;
+                    state.apply(&event);
+                    last_seq = seq;
+                    since_snapshot += 1;
+                }
+                valid_len += len;
+            }
+            if valid_len < bytes.len() {
+                log::warn!(
+                    "Dropping {} torn bytes at the end of {}",
+                    bytes.len() - valid_len,
+                    journal_path.display()
+                );
+            }
+        }
+
+        let file = open_journal(&journal_path, valid_len)?;
+        let durable = Arc::new((
+            Mutex::new(Durable {
+                seq: last_seq,
+                error: None,
+            }),
+            Condvar::new(),
+        ));
+        let (commands, receiver) = mpsc::channel();
+        let writer = Writer {
+            journal_path,
+            snapshot_path,
+            out: BufWriter::new(file),
+            durable: durable.clone(),
+        };
+        let writer = std::thread::Builder::new()
+            .name("journal".to_string())
+            .spawn(move || writer.run(receiver))
+            .context("Failed to spawn journal writer")?;
+
+        let journal = Self {
+            commands: Some(commands),
+            durable,
+            writer: Some(writer),
+            next_seq: last_seq + 1,
+            since_snapshot,
+            _state: PhantomData,
+        };
+        Ok((journal, state))
+    }
+
+    /// Queues an event for writing.
+    ///
+    /// Returns as soon as the event is encoded; it is durable once `wait_durable`
+    /// returns for its sequence number.
+    ///
+    /// # Returns
+    ///
+    /// The sequence number of the event, or `Err` if the writer has failed.
+    pub fn append(&mut self, event: &S::Event) -> Result<u64> {
+        let payload = bincode::serialize(event).context("Failed to encode event")?;
+        let seq = self.next_seq;
+        self.send(Command::Append { seq, payload })?;
+        self.next_seq += 1;
+        self.since_snapshot += 1;
+        Ok(seq)
+    }
+
+    /// Compacts the journal into a snapshot of `state`.
+    ///
+    /// `state` must include every event appended so far. The snapshot is written by
+    /// the writer thread, in order with the events.
+    pub fn snapshot(&mut self, state: &S) -> Result<()> {
+        let payload = bincode::serialize(state).context("Failed to encode snapshot")?;
+        self.send(Command::Snapshot {
+            seq: self.next_seq - 1,
+            payload,
+        })?;
+        self.since_snapshot = 0;
+        Ok(())
+    }
+
+    /// Returns the number of events appended since the last snapshot, including
+    /// those replayed by `open`; callers compact when it grows past their budget.
+    pub fn events_since_snapshot(&self) -> u64 {
+        self.since_snapshot
+    }
+
+    /// Blocks until the event `seq` (and every one before it) is on disk.
+    pub fn wait_durable(&self, seq: u64) -> Result<()> {
+        let (lock, synced) = &*self.durable;
+        let mut durable = lock.lock().unwrap();
+        loop {
+            if let Some(error) = &durable.error {
+                bail!("Journal writer failed: {}", error);
+            }
+            if durable.seq >= seq {
+                return Ok(());
+            }
+            durable = synced.wait(durable).unwrap();
+        }
+    }
+
+    /// Blocks until every event appended so far is on disk.
+    pub fn sync(&self) -> Result<()> {
+        self.wait_durable(self.next_seq - 1)
+    }
+
+    fn send(&self, command: Command) -> Result<()> {
+        if let Some(error) = &self.durable.0.lock().unwrap().error {
+            bail!("Journal writer failed: {}", error);
+        }
+        self.commands
+            .as_ref()
+            .and_then(|commands| commands.send(command).ok())
+            .ok_or_else(|| anyhow!("Journal writer stopped"))
+    }
+}
+
+impl<S: Journaled> Drop for Journal<S> {
+    /// Flushes the queued events before returning.
+    fn drop(&mut self) {
+        self.commands.take();
+        if let Some(writer) = self.writer.take() {
+            let _ = writer.join();
+        }
+    }
+}
+
+struct Writer {
+    journal_path: PathBuf,
+    snapshot_path: PathBuf,
+    out: BufWriter<File>,
+    durable: Arc<(Mutex<Durable>, Condvar)>,
+}
+
+impl Writer {
+    fn run(mut self, commands: mpsc::Receiver<Command>) {
+        // One pass per wakeup: everything queued meanwhile shares one sync.
+        while let Ok(first) = commands.recv() {
+            let result = std::iter::once(first)
+                .chain(commands.try_iter())
+                .try_fold(None, |_, command| self.execute(command).map(Some))
+                .and_then(|seq| {
+                    self.out.flush()?;
+                    self.out.get_ref().sync_data()?;
+                    Ok(seq)
+                });
+            let (lock, synced) = &*self.durable;
+            let mut durable = lock.lock().unwrap();
+            match result {
+                Ok(Some(seq)) => durable.seq = durable.seq.max(seq),
+                Ok(None) => {}
+                Err(e) => {
+                    log::error!("Journal {}: {:#}", self.journal_path.display(), e);
+                    durable.error = Some(format!("{:#}", e));
+                }
+            }
+            synced.notify_all();
+            if durable.error.is_some() {
+                return;
+            }
+        }
+    }
+
+    /// Writes one command, returning the sequence number it makes durable when synced.
+    fn execute(&mut self, command: Command) -> Result<u64> {
+        match command {
+            Command::Append { seq, payload } => {
+                write_record(&mut self.out, seq, &payload)?;
+                Ok(seq)
+            }
+            Command::Snapshot { seq, payload } => {
+                // Events up to `seq` must be durable before the journal is reset,
+                // or a failed snapshot write would lose them.
+                self.out.flush()?;
+                self.out.get_ref().sync_data()?;
+
+                let temp_path = with_suffix(&self.snapshot_path, ".tmp");
+                let mut snapshot = BufWriter::new(
+                    File::create(&temp_path)
+                        .with_context(|| format!("Failed to create {}", temp_path.display()))?,
+                );
+                write_header(&mut snapshot, SNAPSHOT_MAGIC)?;
+                write_record(&mut snapshot, seq, &payload)?;
+                snapshot
+                    .into_inner()
+                    .map_err(|e| e.into_error())?
+                    .sync_all()?;
+                std::fs::rename(&temp_path, &self.snapshot_path)
+                    .with_context(|| format!("Failed to rename {}", temp_path.display()))?;
+                sync_parent(&self.snapshot_path)?;
+
+                // A crash before this point replays the old journal over the new
+                // snapshot, which skips the events it already holds.
+                self.out = BufWriter::new(open_journal(&self.journal_path, 0)?);
+                Ok(seq)
+            }
+        }
+    }
+}
+
+/// Returns `path` with `suffix` appended, unlike `with_extension`, which would name
+/// the files of `state.v1` and `state.v2` alike.
+fn with_suffix(path: &Path, suffix: &str) -> PathBuf {
+    let mut path = path.as_os_str().to_owned();
+    path.push(suffix);
+    PathBuf::from(path)
+}
+
+/// Reads a whole file, empty if it does not exist.
+fn read_if_exists(path: &Path) -> Result<Vec<u8>> {
+    match std::fs::read(path) {
+        Ok(bytes) => Ok(bytes),
+        Err(e) if e.kind() == std::io::ErrorKind::NotFound => Ok(Vec::new()),
+        Err(e) => Err(e).with_context(|| format!("Failed to read {}", path.display())),
+    }
+}
+
+/// Opens a journal for appending after its first `len` bytes, writing the header
+/// of a new one if `len` does not cover it.
+fn open_journal(path: &Path, len: usize) -> Result<File> {
+    let mut file = OpenOptions::new()
+        .create(true)
+        .write(true)
+        .append(true)
+        .open(path)
+        .with_context(|| format!("Failed to open {}", path.display()))?;
+    if len < HEADER_LEN {
+        file.set_len(0)?;
+        write_header(&mut file, JOURNAL_MAGIC)?;
+        file.sync_all()?;
+        sync_parent(path)?;
+    } else {
+        file.set_len(len as u64)?;
+    }
+    Ok(file)
+}
+
+fn write_header(out: &mut impl Write, magic: [u8; 8]) -> std::io::Result<()> {
+    let mut header = [0u8; HEADER_LEN];
+    header[0..8].copy_from_slice(&magic);
+    header[8..12].copy_from_slice(&VERSION.to_le_bytes());
+    out.write_all(&header)
+}
+
+fn check_header(bytes: &[u8], magic: [u8; 8], path: &Path) -> Result<()> {
+    if bytes.len() < HEADER_LEN || bytes[0..8] != magic {
+        bail!("{} is not a journal file", path.display());
+    }
+    let version = u32::from_le_bytes(bytes[8..12].try_into().unwrap());
+    if version != VERSION {
+        bail!(
+            "Unsupported journal version {} in {} (expected {})",
+            version,
+            path.display(),
+            VERSION
+        );
+    }
+    Ok(())
+}
+
+fn write_record(out: &mut impl Write, seq: u64, payload: &[u8]) -> Result<()> {
+    let len = u32::try_from(payload.len()).context("Journal record exceeds 4GiB")?;
+    let seq = seq.to_le_bytes();
+    out.write_all(&len.to_le_bytes())?;
+    out.write_all(&crc32(&[&seq, payload]).to_le_bytes())?;
+    out.write_all(&seq)?;
+    out.write_all(payload)?;
+    Ok(())
+}
+
+/// Reads the record at the start of `bytes`.
+///
+/// # Returns
+///
+/// Its sequence number, payload and total length, or `None` if it is incomplete or
+/// fails its checksum.
+fn read_record(bytes: &[u8]) -> Option<(u64, &[u8], usize)> {
+    let header = bytes.get(..RECORD_HEADER)?;
+    let len = u32::from_le_bytes(header[0..4].try_into().unwrap()) as usize;
+    let crc = u32::from_le_bytes(header[4..8].try_into().unwrap());
+    let seq = &header[8..16];
+    let payload = bytes.get(RECORD_HEADER..RECORD_HEADER.checked_add(len)?)?;
+    (crc32(&[seq, payload]) == crc).then(|| {
+        let seq = u64::from_le_bytes(seq.try_into().unwrap());
+        (seq, payload, RECORD_HEADER + len)
+    })
+}
+
+/// Makes a rename or creation in the directory of `path` durable.
+fn sync_parent(path: &Path) -> Result<()> {
+    #[cfg(unix)]
+    if let Some(parent) = path.parent().filter(|p| !p.as_os_str().is_empty()) {
+        File::open(parent)?.sync_all()?;
+    }
+    Ok(())
+}
+
+/// CRC-32 (IEEE) of the concatenation of `parts`.
+fn crc32(parts: &[&[u8]]) -> u32 {
+    const TABLE: [u32; 256] = {
+        let mut table = [0u32; 256];
+        let mut i = 0;
+        while i < 256 {
+            let mut crc = i as u32;
+            let mut bit = 0;
+            while bit < 8 {
+                crc = if crc & 1 != 0 {
+                    0xedb8_8320 ^ (crc >> 1)
+                } else {
+                    crc >> 1
+                };
+                bit += 1;
+            }
+            table[i] = crc;
+            i += 1;
+        }
+        table
+    };
+    let crc = parts
+        .iter()
+        .flat_map(|part| part.iter())
+        .fold(!0u32, |crc, &byte| {
+            TABLE[((crc ^ byte as u32) & 0xff) as usize] ^ (crc >> 8)
+        });
+    !crc
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use serde::Deserialize;
+
+    #[derive(Default, Serialize, Deserialize)]
+    struct Counter {
+        total: i64,
+        events: u64,
+    }
+
+    impl Journaled for Counter {
+        type Event = i64;
+
+        fn apply(&mut self, event: &i64) {
+            self.total += event;
+            self.events += 1;
+        }
+    }
+
+    #[test]
+    fn test_replay_snapshot_and_torn_tail() {
+        assert_eq!(crc32(&[b"1234", b"56789"]), 0xcbf4_3926);
+
+        let dir = std::env::temp_dir().join(format!("journal_{}", std::process::id()));
+        let path = dir.join("counter.v1");
+        {
+            let (mut journal, mut state) = Journal::<Counter>::open(&path).unwrap();
+            for event in [1, 2, 3] {
+                journal.append(&event).unwrap();
+                state.apply(&event);
+            }
+            journal.snapshot(&state).unwrap();
+            let seq = journal.append(&10).unwrap();
+            journal.wait_durable(seq).unwrap();
+            assert_eq!(seq, 4);
+        }
+
+        // A crash mid-append leaves a partial record behind.
+        let journal_path = dir.join("counter.v1.journal");
+        let mut file = OpenOptions::new().append(true).open(&journal_path).unwrap();
+        file.write_all(&[7, 0, 0, 0, 1, 2]).unwrap();
+        drop(file);
+
+        let (mut journal, state) = Journal::<Counter>::open(&path).unwrap();
+        assert_eq!((state.total, state.events), (16, 4));
+        assert_eq!(journal.events_since_snapshot(), 1);
+        assert_eq!(journal.append(&100).unwrap(), 5);
+        journal.sync().unwrap();
+        drop(journal);
+
+        let (_, state) = Journal::<Counter>::open(&path).unwrap();
+        assert_eq!(state.total, 116);
+
+        // A sibling journal has files of its own, and a header cut short is empty.
+        std::fs::write(dir.join("counter.v2.snapshot"), b"").unwrap();
+        std::fs::write(dir.join("counter.v2.journal"), &JOURNAL_MAGIC[..5]).unwrap();
+        let (mut journal, state) = Journal::<Counter>::open(&dir.join("counter.v2")).unwrap();
+        assert_eq!((state.total, state.events), (0, 0));
+        assert_eq!(journal.append(&1).unwrap(), 1);
+        journal.sync().unwrap();
+        drop(journal);
+        let (_, state) = Journal::<Counter>::open(&dir.join("counter.v2")).unwrap();
+        assert_eq!(state.total, 1);
+        let (_, state) = Journal::<Counter>::open(&path).unwrap();
+        assert_eq!(state.total, 116);
+        std::fs::remove_dir_all(&dir).unwrap();
+    }
+}
@@ -0,0 +1,108 @@
+//! Read-only file mappings shared by the on-disk stores.
+//!
+//! A file must not be modified while it is mapped: a `MAP_PRIVATE` mapping still
+//! shows writes to the file made by anyone, so the bytes under a borrowed `&[u8]`
+//! would change, and truncating it makes reading the mapping fault. The stores
+//! only ever replace their files by writing a new one aside and renaming it over
+//! the old, which leaves existing mappings on the old inode.
+
+use std::fs::File;
+
+/// Read-only mapping of a whole file.
+#[cfg(unix)]
+pub(crate) struct Mapping {
+    ptr: *mut libc::c_void,
+    len: usize,
+}
+
+// SAFETY: the mapping is read-only and, as long as its file is not modified while
+// mapped (see the module documentation), sharing it is like sharing `&[u8]`.
+#[cfg(unix)]
+unsafe impl Send for Mapping {}
+#[cfg(unix)]
+unsafe impl Sync for Mapping {}
+
+#[cfg(unix)]
+impl Mapping {
+    /// Maps `file`, which must not be modified until the mapping is dropped.
+    pub(crate) fn new(file: &File) -> std::io::Result<Self> {
+        use std::os::unix::io::AsRawFd;
+
+        let len = file.metadata()?.len() as usize;
+        if len == 0 {
+            return Ok(Self {
+                ptr: std::ptr::null_mut(),
+                len,
+            });
+        }
+        // SAFETY: a fresh private read-only mapping of an open file; it is unmapped on drop.
+        let ptr = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                len,
+                libc::PROT_READ,
+                libc::MAP_PRIVATE,
+                file.as_raw_fd(),
+                0,
+            )
+        };
+        if ptr == libc::MAP_FAILED {
+            return Err(std::io::Error::last_os_error());
+        }
+        Ok(Self { ptr, len })
+    }
+
+    pub(crate) fn bytes(&self) -> &[u8] {
+        if self.len == 0 {
+            return &[];
+        }
+        // SAFETY: `ptr` maps `len` readable bytes for as long as `self` lives.
+        unsafe { std::slice::from_raw_parts(self.ptr as *const u8, self.len) }
+    }
+
+    /// Hints the kernel to read ahead, for files walked front to back.
+    pub(crate) fn advise_sequential(&self) {
+        if self.len > 0 {
+            // SAFETY: advice on our own mapping; failure is harmless.
+            unsafe { libc::madvise(self.ptr, self.len, libc::MADV_SEQUENTIAL) };
+        }
+    }
+}
+
+#[cfg(unix)]
+impl Drop for Mapping {
+    fn drop(&mut self) {
+        if self.len > 0 {
+            // SAFETY: `ptr` and `len` come from a successful `mmap`.
+            unsafe { libc::munmap(self.ptr, self.len) };
+        }
+    }
+}
+
+/// Without `mmap`, the file is read into a word-aligned buffer instead.
+#[cfg(not(unix))]
+pub(crate) struct Mapping {
+    words: Vec<u64>,
+    len: usize,
+}
+
+#[cfg(not(unix))]
+impl Mapping {
+    pub(crate) fn new(file: &File) -> std::io::Result<Self> {
+        use std::io::Read;
+
+        let len = file.metadata()?.len() as usize;
+        let mut words = vec![0u64; len.div_ceil(8)];
+        // SAFETY: `u64` has no invalid bit patterns or padding.
+        let bytes = unsafe { std::slice::from_raw_parts_mut(words.as_mut_ptr() as *mut u8, len) };
+        (&*file).read_exact(bytes)?;
+        Ok(Self { words, len })
+    }
+
+    pub(crate) fn bytes(&self) -> &[u8] {
+        // SAFETY: the buffer holds at least `len` initialized bytes.
+        unsafe { std::slice::from_raw_parts(self.words.as_ptr() as *const u8, self.len) }
+    }
+
+    pub(crate) fn advise_sequential(&self) {}
+}
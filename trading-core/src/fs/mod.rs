@@ -1,5 +1,12 @@
+pub mod instrument_store;
+pub mod journal;
+mod mapping;
 pub mod paths;
 pub mod persistence;
+pub mod tick_store;
 
+pub use instrument_store::InstrumentStore;
+pub use journal::{Journal, Journaled};
 pub use paths::PathManager;
 pub use persistence::{load_state, save_state};
+pub use tick_store::{TickStore, TickWriter};
@@ -9,6 +9,9 @@ use std::path::Path;
 /// This function ensures data integrity by writing to a temporary file first
 /// and then renaming it to the target path.
 ///
+/// Each call rewrites and syncs the whole file: state updated continuously is
+/// better kept in a `Journal` (see `fs::journal`).
+///
 /// # Arguments
 ///
 /// * `path` - The target file path.
@@ -0,0 +1,275 @@
+//! Memory-mapped tick files for historical replay.
+//!
+//! A tick file is a sequence of frames, each one an archived `MarketDataBatch`
+//! (see `MarketDataBatch::archive_into`), followed by an index of frame offsets:
+//!
+//! | offset | content |
+//! |--------|---------|
+//! | 0      | magic `b"TICKS\0\0\0"` |
+//! | 8      | file version (`u32`), then 4 reserved bytes |
+//! | 16     | frame count `n` (`u64`) |
+//! | 24     | index offset (`u64`) |
+//! | 32     | frames, each starting on an 8-byte boundary |
+//! | index  | frame offsets (`[u64; n]`) |
+//!
+//! Every integer is little-endian. Since a mapping is page-aligned and every
+//! frame is 8-byte aligned, reading a frame borrows its columns straight from the
+//! page cache: there is nothing to parse.
+
+use super::mapping::Mapping;
+use anyhow::{bail, Context, Result};
+use std::fs::File;
+use std::io::{BufWriter, Seek, SeekFrom, Write};
+use std::path::{Path, PathBuf};
+use trading::model::market_data::{MarketDataBatch, MarketDataBatchView};
+
+const MAGIC: [u8; 8] = *b"TICKS\0\0\0";
+const VERSION: u32 = 1;
+const HEADER_LEN: usize = 32;
+
+/// Writes a tick file frame by frame.
+///
+/// Frames are written to a file aside, renamed over `path` by `finish` once its
+/// index is written: a `TickStore` still mapping the previous file keeps reading it.
+pub struct TickWriter {
+    path: PathBuf,
+    temp_path: PathBuf,
+    out: BufWriter<File>,
+    offsets: Vec<u64>,
+    position: u64,
+    scratch: Vec<u8>,
+}
+
+impl TickWriter {
+    /// Starts a tick file, replacing any file at `path` when finished.
+    ///
+    /// # Arguments
+    ///
+    /// * `path` - The file to write.
+    pub fn create(path: &Path) -> Result<Self> {
+        // Per process, like `InstrumentStore::write`.
+        let temp_path = path.with_extension(format!("tmp.{}", std::process::id()));
+        let file = File::create(&temp_path)
+            .with_context(|| format!("Failed to create tick file {}", temp_path.display()))?;
+        let mut out = BufWriter::new(file);
+        // Placeholder header, rewritten by `finish`.
+        out.write_all(&[0; HEADER_LEN])?;
+        Ok(Self {
+            path: path.to_path_buf(),
+            temp_path,
+            out,
+            offsets: Vec::new(),
+            position: HEADER_LEN as u64,
+            scratch: Vec::new(),
+        })
+    }
+
+    /// Appends one frame.
+    ///
+    /// # Arguments
+    ///
+    /// * `batch` - The batch replayed as one frame.
+    pub fn append(&mut self, batch: &MarketDataBatch) -> Result<()> {
+        self.scratch.clear();
+        batch.archive_into(&mut self.scratch);
+        self.out
+            .write_all(&self.scratch)
+            .with_context(|| format!("Failed to write tick file {}", self.temp_path.display()))?;
+        self.offsets.push(self.position);
+        // Archived batches are a whole number of words, so frames stay aligned.
+        self.position += self.scratch.len() as u64;
+        Ok(())
+    }
+
+    /// Returns the number of frames appended so far.
+    pub fn frames(&self) -> usize {
+        self.offsets.len()
+    }
+
+    /// Writes the index and header, syncs the file to disk and renames it into place.
+    pub fn finish(mut self) -> Result<()> {
+        for offset in &self.offsets {
+            self.out.write_all(&offset.to_le_bytes())?;
+        }
+        let mut header = [0u8; HEADER_LEN];
+        header[0..8].copy_from_slice(&MAGIC);
+        header[8..12].copy_from_slice(&VERSION.to_le_bytes());
+        header[16..24].copy_from_slice(&(self.offsets.len() as u64).to_le_bytes());
+        header[24..32].copy_from_slice(&self.position.to_le_bytes());
+        self.out.seek(SeekFrom::Start(0))?;
+        self.out.write_all(&header)?;
+        let file = self
+            .out
+            .into_inner()
+            .map_err(|e| e.into_error())
+            .with_context(|| format!("Failed to flush tick file {}", self.temp_path.display()))?;
+        file.sync_all()?;
+        std::fs::rename(&self.temp_path, &self.path)
+            .with_context(|| format!("Failed to rename {}", self.temp_path.display()))?;
+        Ok(())
+    }
+}
+
+/// A read-only, memory-mapped tick file.
+pub struct TickStore {
+    map: Mapping,
+    frames: usize,
+    index_offset: usize,
+}
+
+impl TickStore {
+    /// Maps a tick file and validates its header and index.
+    ///
+    /// # Arguments
+    ///
+    /// * `path` - The file written by `TickWriter`.
+    pub fn open(path: &Path) -> Result<Self> {
+        let file = File::open(path)
+            .with_context(|| format!("Failed to open tick file {}", path.display()))?;
+        let map = Mapping::new(&file)
+            .with_context(|| format!("Failed to map tick file {}", path.display()))?;
+        let bytes = map.bytes();
+        if bytes.len() < HEADER_LEN || bytes[0..8] != MAGIC {
+            bail!(
+                "{} is not a tick file (or was never finished)",
+                path.display()
+            );
+        }
+        let version = u32::from_le_bytes(bytes[8..12].try_into().unwrap());
+        if version != VERSION {
+            bail!(
+                "Unsupported tick file version {} in {} (expected {})",
+                version,
+                path.display(),
+                VERSION
+            );
+        }
+        let frames = read_u64(bytes, 16) as usize;
+        let index_offset = read_u64(bytes, 24) as usize;
+        let index_ok = index_offset >= HEADER_LEN
+            && index_offset % 8 == 0
+            && frames
+                .checked_mul(8)
+                .and_then(|len| index_offset.checked_add(len))
+                == Some(bytes.len());
+        if !index_ok {
+            bail!("Tick file {} has a corrupt index", path.display());
+        }
+        let store = Self {
+            map,
+            frames,
+            index_offset,
+        };
+        // Frames tile the space between the header and the index, in order.
+        let first = if frames == 0 {
+            index_offset
+        } else {
+            store.offset(0)
+        };
+        if first != HEADER_LEN {
+            bail!("Tick file {} has a corrupt index", path.display());
+        }
+        for frame in 0..frames {
+            let offset = store.offset(frame);
+            if offset % 8 != 0 || store.end(frame) <= offset {
+                bail!("Tick file {} has a corrupt frame {}", path.display(), frame);
+            }
+        }
+        store.map.advise_sequential();
+        Ok(store)
+    }
+
+    /// Returns the number of frames.
+    pub fn len(&self) -> usize {
+        self.frames
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.frames == 0
+    }
+
+    /// Returns a view over one frame, borrowing from the mapping.
+    ///
+    /// # Arguments
+    ///
+    /// * `frame` - Frame number, below `len()`.
+    pub fn get(&self, frame: usize) -> Result<MarketDataBatchView<'_>> {
+        if frame >= self.frames {
+            bail!("Frame {} out of range ({} frames)", frame, self.frames);
+        }
+        let bytes = &self.map.bytes()[self.offset(frame)..self.end(frame)];
+        MarketDataBatchView::from_archived(bytes).map_err(anyhow::Error::msg)
+    }
+
+    fn offset(&self, frame: usize) -> usize {
+        read_u64(self.map.bytes(), self.index_offset + 8 * frame) as usize
+    }
+
+    fn end(&self, frame: usize) -> usize {
+        if frame + 1 < self.frames {
+            self.offset(frame + 1)
+        } else {
+            self.index_offset
+        }
+    }
+}
+
+fn read_u64(bytes: &[u8], at: usize) -> u64 {
+    u64::from_le_bytes(bytes[at..at + 8].try_into().unwrap())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use trading::model::market_data::PriceUpdate;
+
+    #[test]
+    fn test_frames_round_trip_through_the_mapping() {
+        let path = std::env::temp_dir().join(format!("tick_store_{}.ticks", std::process::id()));
+        let mut writer = TickWriter::create(&path).unwrap();
+        writer
+            .append(&MarketDataBatch::new(vec![
+                PriceUpdate::new(1, 9.9, 10.1, 10.0, 100),
+                PriceUpdate::new(2, 19.9, 20.1, 20.0, 100),
+            ]))
+            .unwrap();
+        writer
+            .append(&MarketDataBatch::new(vec![PriceUpdate::new(
+                1, 10.9, 11.1, 11.0, 200,
+            )]))
+            .unwrap();
+        writer.finish().unwrap();
+
+        let store = TickStore::open(&path).unwrap();
+        assert_eq!(store.len(), 2);
+        let first = store.get(0).unwrap();
+        assert_eq!(first.get_instrument_ids(), &[1, 2]);
+        assert_eq!(first.get_last_prices(), &[10.0, 20.0]);
+        // Columns are read in place, not copied out of the mapping.
+        let column = first.get_last_prices().as_ptr() as *const u8;
+        assert!(store.map.bytes().as_ptr_range().contains(&column));
+        assert_eq!(store.get(1).unwrap().get_timestamps(), &[200]);
+        assert!(store.get(2).is_err());
+
+        // Rewriting the file leaves the open store on the old one.
+        let mut writer = TickWriter::create(&path).unwrap();
+        assert_eq!(TickStore::open(&path).unwrap().len(), 2);
+        writer
+            .append(&MarketDataBatch::new(vec![PriceUpdate::new(
+                3, 1.0, 1.0, 1.0, 300,
+            )]))
+            .unwrap();
+        writer.finish().unwrap();
+        assert_eq!(TickStore::open(&path).unwrap().len(), 1);
+        assert_eq!(store.get(1).unwrap().get_timestamps(), &[200]);
+
+        // An index offset that overflows with the index length is rejected.
+        let mut bytes = std::fs::read(&path).unwrap();
+        bytes[24..32].copy_from_slice(&(u64::MAX - 7).to_le_bytes());
+        let corrupt = path.with_extension("corrupt");
+        std::fs::write(&corrupt, &bytes).unwrap();
+        assert!(TickStore::open(&corrupt).is_err());
+        std::fs::remove_file(&corrupt).unwrap();
+        std::fs::remove_file(&path).unwrap();
+    }
+}
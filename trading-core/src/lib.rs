@@ -5,18 +5,25 @@
 //! ## Modules
 //! - `model`: Common data types (Order, Instrument) with identical serialization.
 //! - `args`: Standardized argument parsing.
+//! - `bench`: Harness of the `benches/` targets, with machine-readable output (`bench`
+//!   feature, enabled by the benches only).
 //! - `comms`: Generic ZMQ Exchange management.
 //! - `fs`: Centralized file system paths and state persistence.
 //! - `admin`: Dynamic parameter registry and HTTP Admin API.
+//! - `metrics`: Per-service latency histograms, served by the admin `Metrics` command.
 //! - `ffi`: C-compatible bindings for C++ integration.
 
 pub mod admin;
 pub mod args;
+#[cfg(feature = "bench")]
+pub mod bench;
 pub mod comms;
+pub mod ffi;
 pub mod framework;
 pub mod fs;
 pub mod macros;
 pub mod manifest;
+pub mod metrics;
 pub mod microservice;
 // pub mod model; // Moved to trading crate
 pub use framework::{
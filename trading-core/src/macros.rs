@@ -30,6 +30,66 @@ macro_rules! define_service {
         );
     };
 
+    // ------------------------------------------------------------------------
+    // Input Parsing: Ticker (periodic handler, not a port)
+    // ------------------------------------------------------------------------
+    (@step_inputs
+        {
+            name: $module_name:ident,
+            service_type: $service_type_name:literal,
+            outputs: { $($outputs_def:tt)* },
+            outputs_id: $outputs_id:ident,
+            manager_id: $manager_id:ident,
+            state_id: $state_id:ident,
+            bindings_id: $bindings_id:ident,
+            handler_type: $handler_type:ident
+        }
+        { $($manifest:tt)* }
+        { $($trait_fns:tt)* }
+        { $($manager_logic:tt)* }
+
+        $name:ident => fn $handler:ident() [ tick: $period:expr ] $(,)? $($rest:tt)*
+    ) => {
+        define_service!(@step_inputs
+            {
+                name: $module_name,
+                service_type: $service_type_name,
+                outputs: { $($outputs_def)* },
+                outputs_id: $outputs_id,
+                manager_id: $manager_id,
+                state_id: $state_id,
+                bindings_id: $bindings_id,
+                handler_type: $handler_type
+            }
+            { $($manifest)* }
+            {
+                $($trait_fns)*
+                fn $handler(&mut self, outputs: &mut Outputs);
+            }
+            {
+                $($manager_logic)*
+                {
+                    let outputs_clone = $outputs_id.clone();
+                    let name_str = stringify!($name);
+
+                    $manager_id.add_ticker::<$handler_type>(
+                        name_str,
+                        $state_id.clone(),
+                        $period,
+                        Box::new(move |state: &mut $handler_type| {
+                            if let Ok(mut guard) = outputs_clone.lock() {
+                                state.$handler(&mut *guard);
+                            } else {
+                                eprintln!("Failed to lock outputs for {}", name_str);
+                            }
+                        })
+                    );
+                }
+            }
+            $($rest)*
+        );
+    };
+
     // ------------------------------------------------------------------------
     // Input Parsing: Dispatcher
     // ------------------------------------------------------------------------
@@ -82,6 +142,91 @@ macro_rules! define_service {
         );
     };
 
+    // ------------------------------------------------------------------------
+    // Option Parsing: Explicit, batched delivery
+    // ------------------------------------------------------------------------
+    (@parse_opts
+        { $($ctx:tt)* }
+        { $($manifest:tt)* }
+        { $($trait_fns:tt)* }
+        { $($manager_logic:tt)* }
+        { $name:ident }
+        { $handler:ident }
+        { $type:ty }
+
+        [ required: $req:literal, variadic: $var:literal, batch: true ] $(,)? $($rest:tt)*
+    ) => {
+        define_service!(@accumulate_batch
+            { $($ctx)* }
+            { $($manifest)* }
+            { $($trait_fns)* }
+            { $($manager_logic)* }
+            name: $name,
+            handler: $handler,
+            type: $type,
+            required: $req,
+            variadic: $var,
+            rest: { $($rest)* }
+        );
+    };
+
+    // ------------------------------------------------------------------------
+    // Option Parsing: Explicit, conflated delivery
+    // ------------------------------------------------------------------------
+    (@parse_opts
+        { $($ctx:tt)* }
+        { $($manifest:tt)* }
+        { $($trait_fns:tt)* }
+        { $($manager_logic:tt)* }
+        { $name:ident }
+        { $handler:ident }
+        { $type:ty }
+
+        [ required: $req:literal, variadic: $var:literal, conflate: true ] $(,)? $($rest:tt)*
+    ) => {
+        define_service!(@accumulate_conflate
+            { $($ctx)* }
+            { $($manifest)* }
+            { $($trait_fns)* }
+            { $($manager_logic)* }
+            name: $name,
+            handler: $handler,
+            type: $type,
+            required: $req,
+            variadic: $var,
+            rest: { $($rest)* }
+        );
+    };
+
+    // ------------------------------------------------------------------------
+    // Option Parsing: Explicit, in-place (view) delivery
+    // ------------------------------------------------------------------------
+    (@parse_opts
+        { $($ctx:tt)* }
+        { $($manifest:tt)* }
+        { $($trait_fns:tt)* }
+        { $($manager_logic:tt)* }
+        { $name:ident }
+        { $handler:ident }
+        { $type:ty }
+
+        [ required: $req:literal, variadic: $var:literal, view: $view:ident ] $(,)? $($rest:tt)*
+    ) => {
+        define_service!(@accumulate_view
+            { $($ctx)* }
+            { $($manifest)* }
+            { $($trait_fns)* }
+            { $($manager_logic)* }
+            name: $name,
+            handler: $handler,
+            type: $type,
+            view: $view,
+            required: $req,
+            variadic: $var,
+            rest: { $($rest)* }
+        );
+    };
+
     // ------------------------------------------------------------------------
     // Option Parsing: Default
     // ------------------------------------------------------------------------
@@ -187,6 +332,246 @@ macro_rules! define_service {
         );
     };
 
+    // ------------------------------------------------------------------------
+    // Accumulation Step: batched delivery
+    // ------------------------------------------------------------------------
+    (@accumulate_batch
+        {
+            name: $module_name:ident,
+            service_type: $service_type_name:literal,
+            outputs: { $($outputs_def:tt)* },
+            outputs_id: $outputs_id:ident,
+            manager_id: $manager_id:ident,
+            state_id: $state_id:ident,
+            bindings_id: $bindings_id:ident,
+            handler_type: $handler_type:ident
+        }
+        { $($manifest:tt)* }
+        { $($trait_fns:tt)* }
+        { $($manager_logic:tt)* }
+        name: $name:ident,
+        handler: $handler:ident,
+        type: $type:ty,
+        required: $req:expr,
+        variadic: $var:expr,
+        rest: { $($rest:tt)* }
+    ) => {
+        define_service!(@step_inputs
+            {
+                name: $module_name,
+                service_type: $service_type_name,
+                outputs: { $($outputs_def)* },
+                outputs_id: $outputs_id,
+                manager_id: $manager_id,
+                state_id: $state_id,
+                bindings_id: $bindings_id,
+                handler_type: $handler_type
+            }
+            {
+                $($manifest)*
+                $crate::manifest::PortDefinition {
+                    name: stringify!($name).to_string(),
+                    data_type: stringify!($type).split("::").last().unwrap_or(stringify!($type)).to_string(),
+                    required: $req,
+                    is_variadic: $var,
+                },
+            }
+            {
+                $($trait_fns)*
+                fn $handler(&mut self, batch: &mut Vec<($crate::model::identity::Id, $type)>, outputs: &mut Outputs);
+            }
+            {
+                $($manager_logic)*
+                {
+                    // Logic to add a batch runner and bindings for this input
+                    let outputs_clone = $outputs_id.clone();
+                    // Bind identifiers hygienically
+                    let name_str = stringify!($name);
+
+                    $manager_id.add_batch_runner::<$handler_type, $type>(
+                        name_str,
+                        $state_id.clone(),
+                        Box::new(move |state: &mut $handler_type, batch: &mut Vec<($crate::model::identity::Id, $type)>| {
+                            if let Ok(mut guard) = outputs_clone.lock() {
+                                state.$handler(batch, &mut *guard);
+                            } else {
+                                eprintln!("Failed to lock outputs for {}", name_str);
+                            }
+                        }),
+                        $crate::framework::runner::BatchPolicy::default(),
+                    );
+
+                     if let Some(binding) = $bindings_id.inputs.get(name_str) {
+                         $manager_id.update_from_binding(name_str, binding.clone());
+                     }
+                }
+            }
+            $($rest)*
+        );
+    };
+
+    // ------------------------------------------------------------------------
+    // Accumulation Step: conflated delivery
+    // ------------------------------------------------------------------------
+    (@accumulate_conflate
+        {
+            name: $module_name:ident,
+            service_type: $service_type_name:literal,
+            outputs: { $($outputs_def:tt)* },
+            outputs_id: $outputs_id:ident,
+            manager_id: $manager_id:ident,
+            state_id: $state_id:ident,
+            bindings_id: $bindings_id:ident,
+            handler_type: $handler_type:ident
+        }
+        { $($manifest:tt)* }
+        { $($trait_fns:tt)* }
+        { $($manager_logic:tt)* }
+        name: $name:ident,
+        handler: $handler:ident,
+        type: $type:ty,
+        required: $req:expr,
+        variadic: $var:expr,
+        rest: { $($rest:tt)* }
+    ) => {
+        define_service!(@step_inputs
+            {
+                name: $module_name,
+                service_type: $service_type_name,
+                outputs: { $($outputs_def)* },
+                outputs_id: $outputs_id,
+                manager_id: $manager_id,
+                state_id: $state_id,
+                bindings_id: $bindings_id,
+                handler_type: $handler_type
+            }
+            {
+                $($manifest)*
+                $crate::manifest::PortDefinition {
+                    name: stringify!($name).to_string(),
+                    data_type: stringify!($type).split("::").last().unwrap_or(stringify!($type)).to_string(),
+                    required: $req,
+                    is_variadic: $var,
+                },
+            }
+            {
+                $($trait_fns)*
+                fn $handler(&mut self, id: $crate::model::identity::Id, data: $type, outputs: &mut Outputs);
+            }
+            {
+                $($manager_logic)*
+                {
+                    // Logic to add a conflating runner and bindings for this input
+                    let outputs_clone = $outputs_id.clone();
+                    // Bind identifiers hygienically
+                    let name_str = stringify!($name);
+
+                    $manager_id.add_conflating_runner::<$handler_type, $type>(
+                        name_str,
+                        $state_id.clone(),
+                        Box::new(move |state: &mut $handler_type, id: $crate::model::identity::Id, data: $type| {
+                            if let Ok(mut guard) = outputs_clone.lock() {
+                                state.$handler(id, data, &mut *guard);
+                            } else {
+                                eprintln!("Failed to lock outputs for {}", name_str);
+                            }
+                        }),
+                        $crate::framework::runner::BatchPolicy::default(),
+                    );
+
+                     if let Some(binding) = $bindings_id.inputs.get(name_str) {
+                         $manager_id.update_from_binding(name_str, binding.clone());
+                     }
+                }
+            }
+            $($rest)*
+        );
+    };
+
+    // ------------------------------------------------------------------------
+    // Accumulation Step: in-place (view) delivery
+    // ------------------------------------------------------------------------
+    (@accumulate_view
+        {
+            name: $module_name:ident,
+            service_type: $service_type_name:literal,
+            outputs: { $($outputs_def:tt)* },
+            outputs_id: $outputs_id:ident,
+            manager_id: $manager_id:ident,
+            state_id: $state_id:ident,
+            bindings_id: $bindings_id:ident,
+            handler_type: $handler_type:ident
+        }
+        { $($manifest:tt)* }
+        { $($trait_fns:tt)* }
+        { $($manager_logic:tt)* }
+        name: $name:ident,
+        handler: $handler:ident,
+        type: $type:ty,
+        view: $view:ident,
+        required: $req:expr,
+        variadic: $var:expr,
+        rest: { $($rest:tt)* }
+    ) => {
+        define_service!(@step_inputs
+            {
+                name: $module_name,
+                service_type: $service_type_name,
+                outputs: { $($outputs_def)* },
+                outputs_id: $outputs_id,
+                manager_id: $manager_id,
+                state_id: $state_id,
+                bindings_id: $bindings_id,
+                handler_type: $handler_type
+            }
+            {
+                $($manifest)*
+                $crate::manifest::PortDefinition {
+                    name: stringify!($name).to_string(),
+                    data_type: stringify!($type).split("::").last().unwrap_or(stringify!($type)).to_string(),
+                    required: $req,
+                    is_variadic: $var,
+                },
+            }
+            {
+                $($trait_fns)*
+                fn $handler(&mut self, id: $crate::model::identity::Id, data: $view<'_>, outputs: &mut Outputs);
+            }
+            {
+                $($manager_logic)*
+                {
+                    // Logic to add a frame runner and bindings for this input
+                    let outputs_clone = $outputs_id.clone();
+                    // Bind identifiers hygienically
+                    let name_str = stringify!($name);
+
+                    $manager_id.add_frame_runner::<$handler_type>(
+                        name_str,
+                        $state_id.clone(),
+                        Box::new(move |state: &mut $handler_type, frame: &[u8]| {
+                            // Decode in place: the view borrows from the receive buffer
+                            match $crate::comms::Packet::<$view<'_>>::decode(frame) {
+                                Ok(packet) => {
+                                    if let Ok(mut guard) = outputs_clone.lock() {
+                                        state.$handler(packet.id(), packet.data(), &mut *guard);
+                                    } else {
+                                        eprintln!("Failed to lock outputs for {}", name_str);
+                                    }
+                                }
+                                Err(e) => eprintln!("Failed to decode frame for {}: {}", name_str, e),
+                            }
+                        })
+                    );
+
+                     if let Some(binding) = $bindings_id.inputs.get(name_str) {
+                         $manager_id.update_from_binding(name_str, binding.clone());
+                     }
+                }
+            }
+            $($rest)*
+        );
+    };
+
     // ------------------------------------------------------------------------
     // Final Step: Generate Module
     // ------------------------------------------------------------------------
@@ -264,6 +649,7 @@ macro_rules! define_service {
                             if let Some(Binding::Single(source)) = $bindings_id.outputs.get(port_name) {
                                 comms::build_publisher::<$out_type>(&source.address, id)
                                     .map_err(|e| format!("Failed to create publisher for {}: {}", port_name, e))?
+                                    .with_metrics($crate::metrics::output(port_name))
                             } else {
                                 return Err(format!("Missing binding for output port '{}'", port_name));
                             }
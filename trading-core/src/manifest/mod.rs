@@ -3,6 +3,7 @@ use std::str::FromStr;
 use serde::{Deserialize, Serialize};
 
 use crate::comms::Address;
+use crate::model::instrument::InstrumentId;
 
 #[derive(Serialize, Deserialize, Debug, Clone)]
 pub struct ServiceManifest {
@@ -40,6 +41,26 @@ pub struct PortDefinition {
 pub struct Source {
     pub address: Address,
     pub id: usize, // Unique Process ID / Strategy ID
+    /// Instruments the consumer trades, for market data inputs; empty means all.
+    ///
+    /// The runner subscribes only to the market data partitions covering them.
+    #[serde(default, skip_serializing_if = "Vec::is_empty")]
+    pub universe: Vec<InstrumentId>,
+    /// How the consumers of a market data output subscribe, for its publisher.
+    ///
+    /// `None` when unknown (e.g. bindings written by hand): the publisher then
+    /// sends both whole batches and partitions.
+    #[serde(default, skip_serializing_if = "Option::is_none")]
+    pub subscribers: Option<Subscribers>,
+}
+
+/// The topics the consumers of a market data output subscribe to (see `comms::topic`).
+#[derive(Serialize, Deserialize, Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub struct Subscribers {
+    /// A consumer takes every instrument, so subscribes to whole batches on `ALL`.
+    pub whole: bool,
+    /// A consumer declares a universe, so subscribes to partitions.
+    pub partitioned: bool,
 }
 
 #[derive(Serialize, Deserialize, Debug, Clone)]
@@ -69,6 +90,30 @@ impl FromStr for Binding {
     }
 }
 
+impl Binding {
+    /// Returns the instrument universe declared by the sources of this binding.
+    ///
+    /// # Returns
+    ///
+    /// The union of the sources' universes, empty if any of them takes everything.
+    pub fn universe(&self) -> Vec<InstrumentId> {
+        let sources: Vec<&Source> = match self {
+            Binding::Single(source) => vec![source],
+            Binding::Variadic(sources) => sources.values().collect(),
+        };
+        if sources.iter().any(|source| source.universe.is_empty()) {
+            return Vec::new();
+        }
+        let mut universe: Vec<InstrumentId> = sources
+            .iter()
+            .flat_map(|source| source.universe.iter().copied())
+            .collect();
+        universe.sort_unstable();
+        universe.dedup();
+        universe
+    }
+}
+
 impl ServiceBindings {
     pub fn new() -> Self {
         Self {
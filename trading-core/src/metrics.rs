@@ -0,0 +1,415 @@
+//! Per-service latency metrics.
+//!
+//! Every runner and every output socket of a process records into an entry of a
+//! process-wide registry, keyed by its port name, and services may register named
+//! histograms of their own (e.g. the risk checks of the portfolio manager).
+//! Recording is a handful of relaxed atomic increments, cheap enough to stay on the
+//! hot path; `snapshot` summarizes the registry for the admin `Metrics` command.
+
+use crate::comms::topic::Topic;
+use crate::comms::Trace;
+use crate::model::identity::Id;
+use serde::{Deserialize, Serialize};
+use std::collections::{BTreeMap, HashMap};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex, OnceLock};
+use std::time::Duration;
+
+/// Sub-buckets per power of two: values are binned to within 1/32 (~3%).
+const SUB_BITS: u32 = 5;
+const SUB_BUCKETS: usize = 1 << SUB_BITS;
+const BUCKETS: usize = (u64::BITS - SUB_BITS + 1) as usize * SUB_BUCKETS;
+
+/// Lock-free log-linear (HDR-style) latency histogram over nanoseconds.
+///
+/// Values below 32ns are counted exactly; above, every power of two is split into
+/// 32 linear sub-buckets, so percentiles are reported within ~3% over the whole
+/// `u64` range with a fixed 2k-bucket footprint.
+pub struct LatencyHistogram {
+    buckets: Box<[AtomicU64]>,
+    count: AtomicU64,
+    max_ns: AtomicU64,
+}
+
+impl Default for LatencyHistogram {
+    fn default() -> Self {
+        Self {
+            buckets: (0..BUCKETS).map(|_| AtomicU64::new(0)).collect(),
+            count: AtomicU64::new(0),
+            max_ns: AtomicU64::new(0),
+        }
+    }
+}
+
+impl LatencyHistogram {
+    /// Records one sample.
+    pub fn record(&self, elapsed: Duration) {
+        self.record_ns(elapsed.as_nanos().min(u64::MAX as u128) as u64);
+    }
+
+    /// Records one sample, in nanoseconds.
+    pub fn record_ns(&self, ns: u64) {
+        self.buckets[bucket_of(ns)].fetch_add(1, Ordering::Relaxed);
+        self.count.fetch_add(1, Ordering::Relaxed);
+        self.max_ns.fetch_max(ns, Ordering::Relaxed);
+    }
+
+    /// Returns the number of samples recorded.
+    pub fn count(&self) -> u64 {
+        self.count.load(Ordering::Relaxed)
+    }
+
+    /// Returns the largest sample recorded, in nanoseconds.
+    pub fn max_ns(&self) -> u64 {
+        self.max_ns.load(Ordering::Relaxed)
+    }
+
+    /// Returns an upper bound of the `quantile` (0.0-1.0) of the samples, in nanoseconds.
+    pub fn percentile_ns(&self, quantile: f64) -> u64 {
+        let count = self.count();
+        if count == 0 {
+            return 0;
+        }
+        let rank = ((count as f64) * quantile).ceil().max(1.0) as u64;
+        let mut seen = 0;
+        for (bucket, samples) in self.buckets.iter().enumerate() {
+            seen += samples.load(Ordering::Relaxed);
+            if seen >= rank {
+                return upper_bound(bucket).min(self.max_ns());
+            }
+        }
+        self.max_ns()
+    }
+
+    /// Summarizes the samples recorded so far.
+    pub fn snapshot(&self) -> HistogramSnapshot {
+        HistogramSnapshot {
+            count: self.count(),
+            p50_ns: self.percentile_ns(0.5),
+            p99_ns: self.percentile_ns(0.99),
+            p999_ns: self.percentile_ns(0.999),
+            max_ns: self.max_ns(),
+        }
+    }
+}
+
+fn bucket_of(ns: u64) -> usize {
+    if ns < SUB_BUCKETS as u64 {
+        return ns as usize;
+    }
+    // The top SUB_BITS + 1 significant bits select the bucket.
+    let shift = u64::BITS - 1 - ns.leading_zeros() - SUB_BITS;
+    let sub = (ns >> shift) as usize & (SUB_BUCKETS - 1);
+    (shift as usize + 1) * SUB_BUCKETS + sub
+}
+
+/// Largest value binned into `bucket`.
+fn upper_bound(bucket: usize) -> u64 {
+    if bucket < SUB_BUCKETS {
+        return bucket as u64;
+    }
+    let shift = (bucket / SUB_BUCKETS - 1) as u32;
+    let sub = (bucket % SUB_BUCKETS) as u128;
+    let bound = ((SUB_BUCKETS as u128 + sub + 1) << shift) - 1;
+    bound.min(u64::MAX as u128) as u64
+}
+
+/// Summary of a `LatencyHistogram`.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq, Serialize, Deserialize)]
+pub struct HistogramSnapshot {
+    pub count: u64,
+    pub p50_ns: u64,
+    pub p99_ns: u64,
+    pub p999_ns: u64,
+    pub max_ns: u64,
+}
+
+/// What a runner records about its input.
+#[derive(Default)]
+pub struct RunnerMetrics {
+    /// Messages received.
+    pub messages: AtomicU64,
+    /// Messages missing from the sequence of their sender.
+    pub gaps: AtomicU64,
+    /// Copies of messages already received, dropped (e.g. during a hot swap).
+    pub duplicates: AtomicU64,
+    /// Messages folded into a newer one, for conflating runners.
+    pub conflated: AtomicU64,
+    /// From the send of a message to its receipt by the runner.
+    pub queue_wait: LatencyHistogram,
+    /// Time spent in the handler, per call.
+    pub callback: LatencyHistogram,
+    /// From the event at the origin of a message's chain (e.g. the tick) to its receipt.
+    pub since_origin: LatencyHistogram,
+}
+
+impl RunnerMetrics {
+    pub fn snapshot(&self, name: &str) -> RunnerSnapshot {
+        RunnerSnapshot {
+            name: name.to_string(),
+            messages: self.messages.load(Ordering::Relaxed),
+            gaps: self.gaps.load(Ordering::Relaxed),
+            duplicates: self.duplicates.load(Ordering::Relaxed),
+            conflated: self.conflated.load(Ordering::Relaxed),
+            queue_wait: self.queue_wait.snapshot(),
+            callback: self.callback.snapshot(),
+            since_origin: self.since_origin.snapshot(),
+        }
+    }
+}
+
+/// What an output socket records about its sends.
+#[derive(Default)]
+pub struct OutputMetrics {
+    /// Messages sent.
+    pub messages: AtomicU64,
+    /// Messages discarded before being sent, e.g. folded into a newer one by a full
+    /// queue.
+    pub dropped: AtomicU64,
+    /// Time spent encoding a message, per send.
+    pub serialization: LatencyHistogram,
+}
+
+impl OutputMetrics {
+    pub fn snapshot(&self, name: &str) -> OutputSnapshot {
+        OutputSnapshot {
+            name: name.to_string(),
+            messages: self.messages.load(Ordering::Relaxed),
+            dropped: self.dropped.load(Ordering::Relaxed),
+            serialization: self.serialization.snapshot(),
+        }
+    }
+}
+
+/// Summary of a `RunnerMetrics`.
+#[derive(Debug, Clone, PartialEq, Eq, Serialize, Deserialize)]
+pub struct RunnerSnapshot {
+    pub name: String,
+    pub messages: u64,
+    pub gaps: u64,
+    pub duplicates: u64,
+    pub conflated: u64,
+    pub queue_wait: HistogramSnapshot,
+    pub callback: HistogramSnapshot,
+    pub since_origin: HistogramSnapshot,
+}
+
+/// Summary of an `OutputMetrics`.
+#[derive(Debug, Clone, PartialEq, Eq, Serialize, Deserialize)]
+pub struct OutputSnapshot {
+    pub name: String,
+    pub messages: u64,
+    #[serde(default)]
+    pub dropped: u64,
+    pub serialization: HistogramSnapshot,
+}
+
+/// Summary of a histogram registered by the service itself.
+#[derive(Debug, Clone, PartialEq, Eq, Serialize, Deserialize)]
+pub struct NamedHistogram {
+    pub name: String,
+    pub histogram: HistogramSnapshot,
+}
+
+/// Metrics of every runner and output of a service, by port name.
+#[derive(Debug, Clone, Default, PartialEq, Eq, Serialize, Deserialize)]
+pub struct MetricsSnapshot {
+    pub runners: Vec<RunnerSnapshot>,
+    pub outputs: Vec<OutputSnapshot>,
+    /// Service-specific histograms, by name.
+    #[serde(default)]
+    pub histograms: Vec<NamedHistogram>,
+}
+
+#[derive(Default)]
+struct Registry {
+    runners: BTreeMap<String, Arc<RunnerMetrics>>,
+    outputs: BTreeMap<String, Arc<OutputMetrics>>,
+    histograms: BTreeMap<String, Arc<LatencyHistogram>>,
+}
+
+fn registry() -> &'static Mutex<Registry> {
+    static REGISTRY: OnceLock<Mutex<Registry>> = OnceLock::new();
+    REGISTRY.get_or_init(Default::default)
+}
+
+/// Returns the metrics of the runner of an input port, registering them if needed.
+///
+/// A runner rebuilt under the same name (e.g. on a hot swap) keeps its counters.
+pub fn runner(name: &str) -> Arc<RunnerMetrics> {
+    registry()
+        .lock()
+        .unwrap()
+        .runners
+        .entry(name.to_string())
+        .or_default()
+        .clone()
+}
+
+/// Returns the metrics of an output port, registering them if needed.
+pub fn output(name: &str) -> Arc<OutputMetrics> {
+    registry()
+        .lock()
+        .unwrap()
+        .outputs
+        .entry(name.to_string())
+        .or_default()
+        .clone()
+}
+
+/// Returns a service-specific histogram, registering it if needed.
+pub fn histogram(name: &str) -> Arc<LatencyHistogram> {
+    registry()
+        .lock()
+        .unwrap()
+        .histograms
+        .entry(name.to_string())
+        .or_default()
+        .clone()
+}
+
+/// Summarizes every registered runner, output and histogram, sorted by name.
+pub fn snapshot() -> MetricsSnapshot {
+    let registry = registry().lock().unwrap();
+    MetricsSnapshot {
+        runners: registry
+            .runners
+            .iter()
+            .map(|(name, metrics)| metrics.snapshot(name))
+            .collect(),
+        outputs: registry
+            .outputs
+            .iter()
+            .map(|(name, metrics)| metrics.snapshot(name))
+            .collect(),
+        histograms: registry
+            .histograms
+            .iter()
+            .map(|(name, histogram)| NamedHistogram {
+                name: name.clone(),
+                histogram: histogram.snapshot(),
+            })
+            .collect(),
+    }
+}
+
+/// Records the trace headers of the messages received by one runner.
+pub(crate) struct Tracer {
+    metrics: Arc<RunnerMetrics>,
+    /// Sequence number and send time of the last message admitted from every sender,
+    /// per topic: a sender counts each topic separately.
+    last: HashMap<(Id, Topic), (u64, u64)>,
+}
+
+impl Tracer {
+    pub(crate) fn new(metrics: Arc<RunnerMetrics>) -> Self {
+        Self {
+            metrics,
+            last: HashMap::new(),
+        }
+    }
+
+    pub(crate) fn metrics(&self) -> &RunnerMetrics {
+        &self.metrics
+    }
+
+    /// Records the receipt, at `now_ns`, of a message from `sender`.
+    ///
+    /// # Returns
+    ///
+    /// `false` if the message is a copy of one already admitted, as when a source
+    /// reaches the runner over two sockets during a swap; the caller drops it.
+    pub(crate) fn observe(&mut self, sender: Id, trace: Trace, now_ns: u64) -> bool {
+        if trace.seq != 0 {
+            // A copy is neither later in the sequence nor in time. A restarted sender
+            // starts over from 1, but with later send times.
+            if let Some(&(seq, sent_ns)) = self.last.get(&(sender, trace.topic)) {
+                if trace.seq <= seq && trace.sent_ns <= sent_ns {
+                    self.metrics.duplicates.fetch_add(1, Ordering::Relaxed);
+                    return false;
+                }
+            }
+        }
+        self.metrics.messages.fetch_add(1, Ordering::Relaxed);
+        if trace.sent_ns != 0 {
+            self.metrics
+                .queue_wait
+                .record_ns(now_ns.saturating_sub(trace.sent_ns));
+        }
+        if trace.origin_ns != 0 {
+            self.metrics
+                .since_origin
+                .record_ns(now_ns.saturating_sub(trace.origin_ns));
+        }
+        if trace.seq != 0 {
+            // A sender restarting from 1 is a new sequence, not a gap.
+            let stream = (sender, trace.topic);
+            if let Some((last, _)) = self.last.insert(stream, (trace.seq, trace.sent_ns)) {
+                if trace.seq > last + 1 {
+                    self.metrics
+                        .gaps
+                        .fetch_add(trace.seq - last - 1, Ordering::Relaxed);
+                }
+            }
+        }
+        true
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_histogram_percentiles_and_gaps() {
+        for ns in [0, 31, 32, 33, 1000, 123_456_789, u64::MAX] {
+            let bucket = bucket_of(ns);
+            assert!(bucket < BUCKETS);
+            assert!(upper_bound(bucket) >= ns);
+            assert!(upper_bound(bucket) - ns <= ns / 32);
+        }
+
+        let histogram = LatencyHistogram::default();
+        for ns in 1..=1000 {
+            histogram.record_ns(ns * 1000);
+        }
+        let snapshot = histogram.snapshot();
+        assert_eq!(snapshot.count, 1000);
+        assert!((500_000..=516_000).contains(&snapshot.p50_ns));
+        assert!((990_000..=1_000_000).contains(&snapshot.p99_ns));
+        assert_eq!(snapshot.max_ns, 1_000_000);
+
+        super::histogram("test-histogram").record_ns(42);
+        let named = super::snapshot()
+            .histograms
+            .into_iter()
+            .find(|named| named.name == "test-histogram")
+            .unwrap();
+        assert_eq!(named.histogram.max_ns, 42);
+
+        let mut tracer = Tracer::new(Arc::default());
+        let trace = |seq| Trace {
+            seq,
+            topic: crate::comms::topic::ALL,
+            origin_ns: 100,
+            sent_ns: 140 + seq,
+        };
+        for seq in [1, 2, 5, 6] {
+            assert!(tracer.observe(7, trace(seq), 200));
+        }
+        assert!(tracer.observe(8, trace(4), 200));
+        // The same packet over a second socket, then a restart of the sender.
+        assert!(!tracer.observe(7, trace(5), 200));
+        let restarted = Trace {
+            sent_ns: 190,
+            ..trace(1)
+        };
+        assert!(tracer.observe(8, restarted, 200));
+        let snapshot = tracer.metrics().snapshot("input");
+        assert_eq!(snapshot.messages, 6);
+        assert_eq!(snapshot.gaps, 2);
+        assert_eq!(snapshot.duplicates, 1);
+        assert_eq!(snapshot.queue_wait.max_ns, 59);
+        assert_eq!(snapshot.since_origin.p50_ns, 100);
+    }
+}
@@ -1,22 +1,31 @@
 use std::sync::{Arc, Mutex};
+use std::time::Duration;
 
 use crate::{
     define_service,
     framework::runner_manager::RunnerManager,
     manifest::{ServiceBindings, ServiceBlueprint},
     microservice::configuration::Configurable,
-    model::{execution::ExecutionResult, identity::Id, order::Order, portfolio::Actual},
+    model::{
+        execution_batch::ExecutionBatch, identity::Id, market_data::MarketDataBatchView,
+        order_batch::OrderBatch, portfolio::Actual,
+    },
 };
 use trading::Broker;
 
+/// How often the broker is asked for the updates it held back.
+const FLUSH_INTERVAL: Duration = Duration::from_millis(10);
+
 define_service!(
     name: broker_gateway,
     service_type: "BrokerGateway",
     inputs: {
-        orders => fn on_order(Order) [ required: true, variadic: false ]
+        orders => fn on_orders(OrderBatch) [ required: true, variadic: false, batch: true ]
+        market_data => fn on_market_data(MarketDataBatch) [ required: false, variadic: false, view: MarketDataBatchView ]
+        flush => fn on_flush() [ tick: FLUSH_INTERVAL ]
     },
     outputs: {
-        execution_result => ExecutionResult,
+        execution_result => ExecutionBatch,
         portfolio => Actual
     }
 );
@@ -29,31 +38,66 @@ impl<State> broker_gateway::Handler for State
 where
     State: Broker + Send + 'static,
 {
-    fn on_order(&mut self, _id: Id, data: Order, outputs: &mut broker_gateway::Outputs) {
-        let (executions, portfolio_update) = self.on_order(data);
-
-        // Publish Execution Results
-        if !executions.is_empty() {
-            tokio::task::block_in_place(|| {
-                tokio::runtime::Handle::current().block_on(async {
-                    for exec in executions {
-                        let _ = outputs.execution_result.send(exec).await;
-                    }
-                });
-            });
+    fn on_orders(
+        &mut self,
+        batch: &mut Vec<(Id, OrderBatch)>,
+        outputs: &mut broker_gateway::Outputs,
+    ) {
+        // Merge the burst so the broker sees one batch and reports one snapshot.
+        let mut drained = batch.drain(..).map(|(_, orders)| orders);
+        let Some(mut orders) = drained.next() else {
+            return;
+        };
+        for more in drained {
+            orders.orders_mut().extend(more);
         }
+        let (executions, portfolio_update) = self.on_orders(orders);
+        publish(executions, portfolio_update, outputs);
+    }
 
-        // Publish Portfolio
-        if let Some(actual) = portfolio_update {
-            tokio::task::block_in_place(|| {
-                tokio::runtime::Handle::current().block_on(async {
-                    let _ = outputs.portfolio.send(actual).await;
-                });
-            });
+    fn on_market_data(
+        &mut self,
+        _id: Id,
+        data: MarketDataBatchView<'_>,
+        outputs: &mut broker_gateway::Outputs,
+    ) {
+        let (executions, portfolio_update) = Broker::on_market_data(self, data);
+        publish(executions, portfolio_update, outputs);
+    }
+
+    fn on_flush(&mut self, outputs: &mut broker_gateway::Outputs) {
+        if let Some(portfolio_update) = Broker::flush(self) {
+            publish(
+                ExecutionBatch::new(Vec::new()),
+                Some(portfolio_update),
+                outputs,
+            );
         }
     }
 }
 
+fn publish(
+    executions: ExecutionBatch,
+    portfolio_update: Option<Actual>,
+    outputs: &mut broker_gateway::Outputs,
+) {
+    if executions.is_empty() && portfolio_update.is_none() {
+        return;
+    }
+    crate::framework::executor::block_in_place(|| {
+        tokio::runtime::Handle::current().block_on(async {
+            // Publish Execution Results
+            if !executions.is_empty() {
+                let _ = outputs.execution_result.send(executions).await;
+            }
+            // Publish Portfolio
+            if let Some(actual) = portfolio_update {
+                let _ = outputs.portfolio.send(actual).await;
+            }
+        });
+    });
+}
+
 impl<State> BrokerGateway<State> {
     pub fn new() -> Self {
         Self {
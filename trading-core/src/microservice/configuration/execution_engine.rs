@@ -6,7 +6,7 @@ use crate::{
     manifest::{ServiceBindings, ServiceBlueprint},
     microservice::configuration::Configurable,
     model::{
-        execution::ExecutionResult, identity::Id, order::Order, portfolio::Actual,
+        execution_batch::ExecutionBatch, identity::Id, order_batch::OrderBatch, portfolio::Actual,
         portfolio::Target,
     },
 };
@@ -17,14 +17,30 @@ define_service!(
     service_type: "ExecutionEngine",
     inputs: {
         target => fn on_target(Target) [ required: true, variadic: false ]
-        execution_result => fn on_execution(ExecutionResult) [ required: true, variadic: false ]
+        execution_result => fn on_executions(ExecutionBatch) [ required: true, variadic: false ]
     },
     outputs: {
-        orders => Order,
+        orders => OrderBatch,
         portfolio => Actual
     }
 );
 
+/// Publishes the orders of a pass, staged on the `orders` output as one batch, then
+/// empties the batch for the next pass.
+fn send(outputs: &mut execution_engine::Outputs, portfolio_update: Option<Actual>) {
+    crate::framework::executor::block_in_place(|| {
+        tokio::runtime::Handle::current().block_on(async {
+            if !outputs.orders.staged().is_empty() {
+                let _ = outputs.orders.send_staged().await;
+            }
+            if let Some(actual) = portfolio_update {
+                let _ = outputs.portfolio.send(actual).await;
+            }
+        });
+    });
+    outputs.orders.staged().clear();
+}
+
 pub struct ExecutionEngine<State> {
     _state_phantom: std::marker::PhantomData<State>,
 }
@@ -34,38 +50,20 @@ where
     State: Executor + Send + 'static,
 {
     fn on_target(&mut self, _id: Id, data: Target, outputs: &mut execution_engine::Outputs) {
-        let (orders, portfolio_update) = self.on_target(data);
-
-        tokio::task::block_in_place(|| {
-            tokio::runtime::Handle::current().block_on(async {
-                for order in orders {
-                    let _ = outputs.orders.send(order).await;
-                }
-                if let Some(actual) = portfolio_update {
-                    let _ = outputs.portfolio.send(actual).await;
-                }
-            });
-        });
+        let orders = outputs.orders.staged().orders_mut();
+        let portfolio_update = self.on_target_into(data, orders);
+        send(outputs, portfolio_update);
     }
 
-    fn on_execution(
+    fn on_executions(
         &mut self,
         _id: Id,
-        data: ExecutionResult,
+        data: ExecutionBatch,
         outputs: &mut execution_engine::Outputs,
     ) {
-        let (orders, portfolio_update) = self.on_execution(data);
-
-        tokio::task::block_in_place(|| {
-            tokio::runtime::Handle::current().block_on(async {
-                for order in orders {
-                    let _ = outputs.orders.send(order).await;
-                }
-                if let Some(actual) = portfolio_update {
-                    let _ = outputs.portfolio.send(actual).await;
-                }
-            });
-        });
+        let orders = outputs.orders.staged().orders_mut();
+        let portfolio_update = self.on_executions_into(data, orders);
+        send(outputs, portfolio_update);
     }
 }
 
@@ -3,20 +3,42 @@
 //! This module defines the `Feeder` service type using the `define_service!` macro.
 //! The `Feeder` acts as the source of truth for market data in the system pipeline.
 //! It reads from a `DataFeed` implementation and publishes `MarketDataBatch` messages
-//! to its output port.
+//! to its output port, either as the feed pushes them or by polling it at the feed's
+//! `Pacing` (as fast as possible, fixed rate, or replaying recorded timestamps).
+//!
+//! Pushed batches wait in a queue bounded by the feed's `PushQueue`; when it is
+//! full, the feed thread either blocks or the oldest batch is conflated into the
+//! next, counted as dropped in the output metrics.
+//!
+//! On transports with topic filtering (ZMQ), every batch is published whole on the
+//! catch-all topic and split by instrument partition, one topic per partition (see
+//! `comms::topic`): consumers declaring an instrument universe only receive the
+//! partitions they need, the others one batch per tick. Each form is only encoded
+//! while a consumer subscribes to it, as told by the `Subscribers` of the output
+//! binding.
 
+use crate::comms::topic::{self, Partitioner};
 use crate::comms::Address;
+use crate::comms::SenderSocket;
 use crate::define_service;
+use crate::framework::executor;
 use crate::framework::runner::ManagedRunner;
 use crate::framework::runner_manager::RunnerManager;
-use crate::manifest::ServiceBlueprint;
+use crate::manifest::{Binding, ServiceBlueprint, Subscribers};
+use crate::metrics::OutputMetrics;
 use crate::microservice::configuration::Configurable;
 use log::{error, info};
-use std::sync::mpsc::{self, Sender};
-use std::sync::{Arc, Mutex};
-use std::thread::{self, JoinHandle};
+use std::collections::VecDeque;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::mpsc::{self, Receiver};
+use std::sync::{Arc, Condvar, Mutex};
+use std::time::{Duration, Instant};
+use tokio::sync::{oneshot, Notify};
 use trading::model::market_data::MarketDataBatch;
-use trading::traits::data_feed::DataFeed;
+use trading::traits::data_feed::{DataFeed, MarketDataSink, Overflow, Pacing, PushQueue};
+
+/// Back-off when an as-fast-as-possible feed has nothing ready.
+const IDLE_BACKOFF: Duration = Duration::from_millis(1);
 
 define_service!(
     name: feeder_gen,
@@ -38,15 +60,19 @@ impl Feeder {
 
 // Custom Runner for Feeder Source
 pub struct FeederRunner {
-    handle: Option<JoinHandle<()>>,
-    stop_tx: Sender<()>,
+    /// Disconnects once the feeder task has exited.
+    done: Option<Receiver<()>>,
+    stop_tx: Option<oneshot::Sender<()>>,
+    audience: Arc<Audience>,
 }
 
 impl ManagedRunner for FeederRunner {
     fn shutdown(&mut self) {
-        let _ = self.stop_tx.send(());
-        if let Some(handle) = self.handle.take() {
-            let _ = handle.join();
+        if let Some(stop_tx) = self.stop_tx.take() {
+            let _ = stop_tx.send(());
+        }
+        if let Some(done) = self.done.take() {
+            let _ = done.recv();
         }
     }
 
@@ -62,6 +88,16 @@ impl ManagedRunner for FeederRunner {
     fn disconnect_input(&mut self, _address: Address) {
         log::warn!("Feeder received disconnect_input but it is a Source node.");
     }
+
+    fn subscribe(&mut self, _topics: Vec<crate::comms::topic::Topic>) {
+        log::warn!("Feeder received subscribe but it is a Source node.");
+    }
+
+    fn update_output(&mut self, port: &str, binding: &Binding) {
+        if let ("market_data", Binding::Single(source)) = (port, binding) {
+            self.audience.set(source.subscribers);
+        }
+    }
 }
 
 impl Configurable for Feeder {
@@ -81,55 +117,62 @@ impl Configurable for Feeder {
             .ok_or("Missing binding for 'market_data' output")?
             .clone();
 
-        let (stop_tx, stop_rx) = mpsc::channel();
-
-        // The Feeder is a simple loop that continually polls the DataFeed trait
-        // and publishes to the output.
-        let handle = thread::spawn(move || {
-            let rt = tokio::runtime::Runtime::new().unwrap();
-            rt.block_on(async move {
-                let address = match market_data_out {
-                    crate::manifest::Binding::Single(source) => source.address,
-                    _ => panic!("Feeder output 'market_data' must be a Single binding"),
-                };
-
-                let publisher =
-                    crate::comms::build_publisher::<MarketDataBatch>(&address, id).unwrap();
-
-                info!("Feeder runner started. Publishing to {:?}", address);
-
-                let mut ticker = tokio::time::interval(std::time::Duration::from_millis(50));
-
-                loop {
-                    // Check stop signal non-blocking
-                    if stop_rx.try_recv().is_ok() {
-                        info!("Feeder received stop signal.");
-                        break;
-                    }
-
-                    ticker.tick().await;
-
-                    let batch_opt = {
-                        let mut guard = state.lock().unwrap();
-                        guard.get_market_data()
-                    };
-
-                    if let Some(batch) = batch_opt {
-                        if batch.get_count() > 0 {
-                            if let Err(e) = publisher.send(batch).await {
-                                error!("Feeder failed to send batch: {}", e);
-                            }
-                        }
-                    }
+        let (stop_tx, stop_rx) = oneshot::channel();
+        let (done_tx, done_rx) = mpsc::channel::<()>();
+        let audience = Arc::new(Audience::default());
+        let publisher_audience = audience.clone();
+
+        // The Feeder offers the DataFeed a push sink first and falls back to polling
+        // it at its own pacing. It runs on the shared runner executor.
+        executor::handle().spawn(async move {
+            let address = match market_data_out {
+                Binding::Single(source) => {
+                    publisher_audience.set(source.subscribers);
+                    source.address
                 }
-            });
+                _ => panic!("Feeder output 'market_data' must be a Single binding"),
+            };
+
+            let metrics = crate::metrics::output("market_data");
+            let mut publisher = Publisher::new(
+                crate::comms::build_publisher::<MarketDataBatch>(&address, id)
+                    .unwrap()
+                    .with_metrics(metrics.clone()),
+                publisher_audience,
+            );
+
+            info!("Feeder runner started. Publishing to {:?}", address);
+
+            let queue = {
+                let feed = state.lock().unwrap();
+                Arc::new(PushBuffer::new(feed.push_queue(), metrics))
+            };
+            let pusher = Pusher(queue.clone());
+            let sink = MarketDataSink::new(move |batch| pusher.0.push(batch));
+            let (pushing, pacing) = {
+                let mut feed = state.lock().unwrap();
+                (feed.start_push(sink), feed.pacing())
+            };
+
+            if pushing {
+                info!("Feeder in push mode.");
+                run_push(&queue, &mut publisher, stop_rx).await;
+            } else {
+                info!("Feeder polling with {:?}.", pacing);
+                run_polled(&state, pacing, &mut publisher, stop_rx).await;
+            }
+            // Releases a feed thread blocked on a full queue.
+            queue.stop();
+            info!("Feeder stopped.");
+            drop(done_tx);
         });
 
         manager.add_managed_runner(
             "feeder_source",
             Box::new(FeederRunner {
-                handle: Some(handle),
-                stop_tx,
+                done: Some(done_rx),
+                stop_tx: Some(stop_tx),
+                audience,
             }),
         );
 
@@ -140,3 +183,491 @@ impl Configurable for Feeder {
         &feeder_gen::MANIFEST
     }
 }
+
+/// Which forms of the batches the consumers of the output subscribe to.
+struct Audience {
+    whole: AtomicBool,
+    partitioned: AtomicBool,
+}
+
+impl Default for Audience {
+    /// Both forms, until told otherwise.
+    fn default() -> Self {
+        Self {
+            whole: AtomicBool::new(true),
+            partitioned: AtomicBool::new(true),
+        }
+    }
+}
+
+impl Audience {
+    /// Follows the subscribers of a new output binding, both forms if unknown.
+    fn set(&self, subscribers: Option<Subscribers>) {
+        let subscribers = subscribers.unwrap_or(Subscribers {
+            whole: true,
+            partitioned: true,
+        });
+        self.whole.store(subscribers.whole, Ordering::Relaxed);
+        self.partitioned
+            .store(subscribers.partitioned, Ordering::Relaxed);
+    }
+}
+
+/// The output socket, and the partitioner when the transport supports topics.
+///
+/// ZMQ drops the topics nobody subscribed to on the publisher side, but only once
+/// they are encoded: the audience says which forms a consumer reads at all.
+struct Publisher {
+    socket: SenderSocket<MarketDataBatch>,
+    partitioner: Option<Partitioner>,
+    audience: Arc<Audience>,
+}
+
+impl Publisher {
+    fn new(socket: SenderSocket<MarketDataBatch>, audience: Arc<Audience>) -> Self {
+        let partitioner = socket.supports_topics().then(Partitioner::new);
+        Self {
+            socket,
+            partitioner,
+            audience,
+        }
+    }
+
+    async fn publish(&mut self, batch: MarketDataBatch) {
+        if batch.get_count() == 0 {
+            return;
+        }
+        let Some(partitioner) = self.partitioner.as_mut() else {
+            if let Err(e) = self.socket.send(batch).await {
+                error!("Feeder failed to send batch: {}", e);
+            }
+            return;
+        };
+        if self.audience.whole.load(Ordering::Relaxed) {
+            if let Err(e) = self.socket.send_topic(&topic::ALL, &batch).await {
+                error!("Feeder failed to send batch: {}", e);
+            }
+        }
+        if !self.audience.partitioned.load(Ordering::Relaxed) {
+            return;
+        }
+        for (topic, part) in partitioner.split(&batch) {
+            if let Err(e) = self.socket.send_topic(&topic, part).await {
+                error!("Feeder failed to send partition batch: {}", e);
+            }
+        }
+    }
+}
+
+/// Batches pushed by the feed and not yet published, see the module documentation.
+struct PushBuffer {
+    state: Mutex<Pushed>,
+    /// Signalled when the publisher takes a batch, for feed threads waiting on room.
+    room: Condvar,
+    /// Signalled when a batch is queued or the feed drops its sink.
+    ready: Notify,
+    config: PushQueue,
+    metrics: Arc<OutputMetrics>,
+}
+
+#[derive(Default)]
+struct Pushed {
+    batches: VecDeque<MarketDataBatch>,
+    /// Set once the feed dropped every clone of its sink.
+    closed: bool,
+    /// Set once the feeder stopped; pushes are refused.
+    stopped: bool,
+}
+
+impl PushBuffer {
+    fn new(config: PushQueue, metrics: Arc<OutputMetrics>) -> Self {
+        Self {
+            state: Mutex::default(),
+            room: Condvar::new(),
+            ready: Notify::new(),
+            config: PushQueue {
+                capacity: config.capacity.max(1),
+                ..config
+            },
+            metrics,
+        }
+    }
+
+    /// Queues a batch from the feed, applying the overflow policy when full.
+    ///
+    /// # Returns
+    ///
+    /// `false` once the feeder has stopped.
+    fn push(&self, mut batch: MarketDataBatch) -> bool {
+        let mut state = self.state.lock().unwrap();
+        while !state.stopped && state.batches.len() >= self.config.capacity {
+            match self.config.overflow {
+                Overflow::Block => state = self.room.wait(state).unwrap(),
+                Overflow::ConflateOldest => {
+                    let mut oldest = state.batches.pop_front().unwrap();
+                    let next = state.batches.front_mut().unwrap_or(&mut batch);
+                    oldest.merge_latest(next);
+                    *next = oldest;
+                    self.metrics.dropped.fetch_add(1, Ordering::Relaxed);
+                }
+            }
+        }
+        if state.stopped {
+            return false;
+        }
+        state.batches.push_back(batch);
+        drop(state);
+        self.ready.notify_one();
+        true
+    }
+
+    /// Takes the oldest batch, waiting for one.
+    ///
+    /// # Returns
+    ///
+    /// `None` once the feed dropped its sink and every batch was taken.
+    async fn next(&self) -> Option<MarketDataBatch> {
+        loop {
+            {
+                let mut state = self.state.lock().unwrap();
+                if let Some(batch) = state.batches.pop_front() {
+                    drop(state);
+                    self.room.notify_one();
+                    return Some(batch);
+                }
+                if state.closed {
+                    return None;
+                }
+            }
+            // A notification sent meanwhile is kept as a permit.
+            self.ready.notified().await;
+        }
+    }
+
+    fn close(&self) {
+        self.state.lock().unwrap().closed = true;
+        self.ready.notify_one();
+    }
+
+    fn stop(&self) {
+        self.state.lock().unwrap().stopped = true;
+        self.room.notify_all();
+    }
+}
+
+/// The feed's end of the queue, closing it when the last sink is dropped.
+struct Pusher(Arc<PushBuffer>);
+
+impl Drop for Pusher {
+    fn drop(&mut self) {
+        self.0.close();
+    }
+}
+
+/// Publishes every batch the feed pushes into its sink, as soon as it arrives.
+async fn run_push(
+    queue: &PushBuffer,
+    publisher: &mut Publisher,
+    mut stop_rx: oneshot::Receiver<()>,
+) {
+    loop {
+        tokio::select! {
+            _ = &mut stop_rx => break,
+            batch = queue.next() => match batch {
+                Some(batch) => publisher.publish(batch).await,
+                None => {
+                    info!("Feed dropped its sink, nothing left to publish.");
+                    let _ = stop_rx.await;
+                    break;
+                }
+            },
+        }
+    }
+}
+
+/// Polls the feed and publishes its batches at the requested pacing.
+async fn run_polled(
+    state: &Mutex<Box<dyn DataFeed + Send>>,
+    pacing: Pacing,
+    publisher: &mut Publisher,
+    mut stop_rx: oneshot::Receiver<()>,
+) {
+    let mut ticker = match pacing {
+        Pacing::FixedRate(period) => Some(tokio::time::interval(period)),
+        _ => None,
+    };
+    // Replay clock origin: first batch timestamp and the instant it was published.
+    let mut origin: Option<(u64, Instant)> = None;
+
+    loop {
+        if let Some(ticker) = ticker.as_mut() {
+            tokio::select! {
+                _ = &mut stop_rx => break,
+                _ = ticker.tick() => {}
+            }
+        } else if !matches!(stop_rx.try_recv(), Err(oneshot::error::TryRecvError::Empty)) {
+            break;
+        }
+
+        let batch = state.lock().unwrap().get_market_data();
+        let Some(batch) = batch else {
+            if ticker.is_none() {
+                tokio::select! {
+                    _ = &mut stop_rx => break,
+                    _ = tokio::time::sleep(IDLE_BACKOFF) => {}
+                }
+            }
+            continue;
+        };
+
+        if let Pacing::ReplayClock { tick, speed } = pacing {
+            if let Some(&timestamp) = batch.get_timestamps().iter().max() {
+                let (first, started) = *origin.get_or_insert((timestamp, Instant::now()));
+                let due = replay_offset(tick, timestamp.saturating_sub(first), speed)
+                    .and_then(|offset| started.checked_add(offset));
+                match due {
+                    Some(due) => tokio::select! {
+                        _ = &mut stop_rx => break,
+                        _ = tokio::time::sleep_until(due.into()) => {}
+                    },
+                    None => log::warn!(
+                        "Feeder: batch at {} is out of replay clock range, publishing it now",
+                        timestamp
+                    ),
+                }
+            }
+        }
+
+        publisher.publish(batch).await;
+        if pacing == Pacing::AsFastAsPossible {
+            // Let the other runners of the service make progress between batches.
+            tokio::task::yield_now().await;
+        }
+    }
+}
+
+/// Returns how long after the first batch one `span` ticks later is due.
+///
+/// # Returns
+///
+/// * `Some(Duration)` for the replay offset.
+/// * `None` if it does not fit a `Duration`, e.g. with a huge span or a tiny speed.
+fn replay_offset(tick: Duration, span: u64, speed: f64) -> Option<Duration> {
+    // `Pacing::replay_clock` rejects such speeds; a hand-built variant replays as recorded.
+    let speed = if speed.is_finite() && speed > 0.0 {
+        speed
+    } else {
+        1.0
+    };
+    Duration::try_from_secs_f64(tick.as_secs_f64() * (span as f64 / speed)).ok()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_replay_offset_does_not_overflow() {
+        let tick = Duration::from_nanos(1);
+        assert_eq!(
+            replay_offset(tick, 4_000, 2.0),
+            Some(Duration::from_micros(2))
+        );
+        assert_eq!(
+            replay_offset(tick, 1_000, f64::NAN),
+            Some(Duration::from_micros(1))
+        );
+        assert_eq!(
+            replay_offset(Duration::from_secs(1), u64::MAX, 1e-300),
+            None
+        );
+        assert!(Pacing::replay_clock(tick, 0.0).is_err());
+        assert!(Pacing::replay_clock(tick, f64::INFINITY).is_err());
+    }
+
+    #[test]
+    fn test_full_push_queue_blocks_or_conflates() {
+        use futures::executor::block_on;
+        use trading::model::market_data::PriceUpdate;
+
+        let tick =
+            |id, price| MarketDataBatch::new(vec![PriceUpdate::new(id, price, price, price, 0)]);
+
+        let queue = PushBuffer::new(
+            PushQueue {
+                capacity: 2,
+                overflow: Overflow::ConflateOldest,
+            },
+            Arc::default(),
+        );
+        for (id, price) in [(1, 1.0), (2, 2.0), (1, 3.0)] {
+            assert!(queue.push(tick(id, price)));
+        }
+        assert_eq!(queue.metrics.dropped.load(Ordering::Relaxed), 1);
+        let merged = block_on(queue.next()).unwrap();
+        assert_eq!(merged.get_instrument_ids(), &[1, 2]);
+        assert_eq!(merged.get_last_prices(), &[1.0, 2.0]);
+        assert_eq!(block_on(queue.next()).unwrap().get_last_prices(), &[3.0]);
+
+        let queue = Arc::new(PushBuffer::new(
+            PushQueue {
+                capacity: 1,
+                overflow: Overflow::Block,
+            },
+            Arc::default(),
+        ));
+        let pusher = Pusher(queue.clone());
+        assert!(pusher.0.push(tick(1, 1.0)));
+        let feed = std::thread::spawn(move || {
+            let pushed = pusher.0.push(tick(1, 2.0));
+            (pushed, pusher.0.push(tick(1, 3.0)))
+        });
+        std::thread::sleep(Duration::from_millis(20));
+        assert!(!feed.is_finished());
+        assert_eq!(block_on(queue.next()).unwrap().get_last_prices(), &[1.0]);
+        // The second push got the room, the third waits for more until the stop.
+        std::thread::sleep(Duration::from_millis(20));
+        assert!(!feed.is_finished());
+        queue.stop();
+        assert_eq!(feed.join().unwrap(), (true, false));
+        assert_eq!(queue.metrics.dropped.load(Ordering::Relaxed), 0);
+        // The feed thread dropped its sink: what is queued is the last of it.
+        assert_eq!(block_on(queue.next()).unwrap().get_last_prices(), &[2.0]);
+        assert!(block_on(queue.next()).is_none());
+    }
+
+    /// A topic-filtering transport recording what it is sent.
+    #[derive(Clone, Default)]
+    struct Wire(Arc<Mutex<Vec<(topic::Topic, Vec<u8>)>>>);
+
+    #[async_trait::async_trait]
+    impl crate::comms::transport::TransportOutput for Wire {
+        async fn send_bytes(&mut self, data: &[u8]) -> anyhow::Result<()> {
+            self.send_topic(&topic::ALL, data).await
+        }
+
+        fn supports_topics(&self) -> bool {
+            true
+        }
+
+        async fn send_topic(&mut self, topic: &topic::Topic, data: &[u8]) -> anyhow::Result<()> {
+            self.0.lock().unwrap().push((*topic, data.to_vec()));
+            Ok(())
+        }
+    }
+
+    impl Wire {
+        /// Returns the instruments of every batch a subscriber to `topics` receives.
+        fn received(&self, topics: &[topic::Topic]) -> Vec<Vec<usize>> {
+            self.0
+                .lock()
+                .unwrap()
+                .iter()
+                .filter(|(topic, _)| topics.contains(topic))
+                .map(|(_, bytes)| {
+                    let packet = crate::comms::Packet::<MarketDataBatch>::decode(bytes).unwrap();
+                    packet.data().get_instrument_ids().to_vec()
+                })
+                .collect()
+        }
+
+        /// Returns the sender and trace of every packet a subscriber to `topics` receives.
+        fn traces(&self, topics: &[topic::Topic]) -> Vec<(usize, crate::comms::Trace)> {
+            self.0
+                .lock()
+                .unwrap()
+                .iter()
+                .filter(|(topic, _)| topics.contains(topic))
+                .map(|(_, bytes)| crate::comms::Trace::peek(bytes).unwrap())
+                .collect()
+        }
+    }
+
+    #[tokio::test]
+    async fn test_consumer_without_universe_gets_one_batch_per_tick() {
+        use crate::comms::topic::PARTITIONS;
+        use crate::manifest::Source;
+        use trading::model::market_data::PriceUpdate;
+
+        let wire = Wire::default();
+        let mut publisher =
+            Publisher::new(SenderSocket::new(Box::new(wire.clone()), 1), Arc::default());
+        for tick in 0..2 {
+            publisher
+                .publish(MarketDataBatch::new(vec![
+                    PriceUpdate::new(1, 1.0, 1.0, 1.0, tick),
+                    PriceUpdate::new(2, 2.0, 2.0, 2.0, tick),
+                    PriceUpdate::new(1 + PARTITIONS, 3.0, 3.0, 3.0, tick),
+                ]))
+                .await;
+        }
+
+        // Without a universe, ZMQ subscribers listen on `ALL` only.
+        let whole = vec![1, 2, 1 + PARTITIONS];
+        assert_eq!(
+            wire.received(&[topic::ALL]),
+            vec![whole.clone(), whole.clone()]
+        );
+        assert_eq!(
+            wire.received(&topic::universe_topics(&[2])),
+            vec![vec![2], vec![2]]
+        );
+
+        // Once every consumer declares a universe, whole batches are not encoded.
+        let mut runner = FeederRunner {
+            done: None,
+            stop_tx: None,
+            audience: publisher.audience.clone(),
+        };
+        let mut binding = Source {
+            address: Address::Memory("feed".to_string()),
+            id: 1,
+            universe: Vec::new(),
+            subscribers: Some(Subscribers {
+                whole: false,
+                partitioned: true,
+            }),
+        };
+        runner.update_output("market_data", &Binding::Single(binding.clone()));
+        let batch = || MarketDataBatch::new(vec![PriceUpdate::new(2, 2.0, 2.0, 2.0, 2)]);
+        publisher.publish(batch()).await;
+        assert_eq!(wire.received(&[topic::ALL]).len(), 2);
+        assert_eq!(wire.received(&topic::universe_topics(&[2])).len(), 3);
+
+        binding.subscribers = Some(Subscribers {
+            whole: true,
+            partitioned: false,
+        });
+        runner.update_output("market_data", &Binding::Single(binding));
+        publisher.publish(batch()).await;
+        assert_eq!(wire.received(&[topic::ALL]).len(), 3);
+        assert_eq!(wire.received(&topic::universe_topics(&[2])).len(), 3);
+    }
+
+    #[tokio::test]
+    async fn test_partition_subscribers_see_no_gaps() {
+        use crate::metrics::Tracer;
+        use trading::model::market_data::PriceUpdate;
+
+        let wire = Wire::default();
+        let mut publisher =
+            Publisher::new(SenderSocket::new(Box::new(wire.clone()), 1), Arc::default());
+        for tick in 0..3 {
+            let mut updates = vec![PriceUpdate::new(1, 1.0, 1.0, 1.0, tick)];
+            if tick != 1 {
+                updates.push(PriceUpdate::new(2, 2.0, 2.0, 2.0, tick));
+            }
+            publisher.publish(MarketDataBatch::new(updates)).await;
+        }
+
+        for topics in [vec![topic::ALL], topic::universe_topics(&[2])] {
+            let mut tracer = Tracer::new(Arc::default());
+            for (sender, trace) in wire.traces(&topics) {
+                assert!(tracer.observe(sender, trace, trace.sent_ns));
+            }
+            let snapshot = tracer.metrics().snapshot("market_data");
+            assert!(snapshot.messages >= 2);
+            assert_eq!(snapshot.gaps, 0);
+        }
+    }
+}
@@ -53,6 +53,11 @@ where
                 .as_mut()
                 .map(|runners| runners.update_from_binding(&name, binding));
         }
+        for (name, binding) in config.outputs {
+            self.runners
+                .as_mut()
+                .map(|runners| runners.update_output(&name, &binding));
+        }
     }
 
     pub fn shutdown(&mut self) {
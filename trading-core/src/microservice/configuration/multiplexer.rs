@@ -13,7 +13,7 @@ define_service!(
     name: multiplexer,
     service_type: "Multiplexer",
     inputs: {
-        strategies => fn on_allocation_batch(AllocationBatch) [ required: true, variadic: true ]
+        strategies => fn on_allocation_batches(AllocationBatch) [ required: true, variadic: true, batch: true ]
     },
     outputs: {
         allocation => AllocationBatch
@@ -28,15 +28,25 @@ impl<State> multiplexer::Handler for State
 where
     State: Multiplexist + Send + 'static,
 {
-    fn on_allocation_batch(
+    fn on_allocation_batches(
         &mut self,
-        id: Id,
-        data: AllocationBatch,
+        batch: &mut Vec<(Id, AllocationBatch)>,
         outputs: &mut multiplexer::Outputs,
     ) {
-        let output_batch = self.on_allocation_batch(id, data);
+        // The output is the aggregate over every source, so each result supersedes
+        // the previous one: only the last of the burst is sent, once per pass.
+        let mut output_batch = None;
+        for (id, data) in batch.drain(..) {
+            let aggregate = self.on_allocation_batch(id, data);
+            if !aggregate.is_empty() {
+                output_batch = Some(aggregate);
+            }
+        }
+        let Some(output_batch) = output_batch else {
+            return;
+        };
 
-        tokio::task::block_in_place(|| {
+        crate::framework::executor::block_in_place(|| {
             tokio::runtime::Handle::current().block_on(async {
                 let _ = outputs.allocation.send(output_batch).await;
             });
@@ -8,7 +8,7 @@ use crate::{
     model::{
         allocation_batch::AllocationBatch,
         identity::Id,
-        market_data::PriceUpdate,
+        market_data::MarketDataBatch,
         portfolio::{Actual, Target},
     },
 };
@@ -19,8 +19,8 @@ define_service!(
     service_type: "PortfolioManager",
     inputs: {
         allocation => fn on_allocation(AllocationBatch) [ required: true, variadic: false ]
-        portfolio => fn on_portfolio(Actual) [ required: false, variadic: false ]
-        market_data => fn on_market_data(PriceUpdate) [ required: false, variadic: false ]
+        portfolio => fn on_portfolio(Actual) [ required: false, variadic: false, conflate: true ]
+        market_data => fn on_market_data(MarketDataBatch) [ required: false, variadic: false, conflate: true ]
     },
     outputs: {
         target => Target
@@ -42,7 +42,7 @@ where
         outputs: &mut portfolio_manager::Outputs,
     ) {
         if let Some(target) = self.on_allocation(data) {
-            tokio::task::block_in_place(|| {
+            crate::framework::executor::block_in_place(|| {
                 tokio::runtime::Handle::current().block_on(async {
                     let _ = outputs.target.send(target).await;
                 });
@@ -52,7 +52,7 @@ where
 
     fn on_portfolio(&mut self, _id: Id, data: Actual, outputs: &mut portfolio_manager::Outputs) {
         if let Some(target) = self.on_portfolio(data) {
-            tokio::task::block_in_place(|| {
+            crate::framework::executor::block_in_place(|| {
                 tokio::runtime::Handle::current().block_on(async {
                     let _ = outputs.target.send(target).await;
                 });
@@ -63,11 +63,11 @@ where
     fn on_market_data(
         &mut self,
         _id: Id,
-        data: PriceUpdate,
+        data: MarketDataBatch,
         outputs: &mut portfolio_manager::Outputs,
     ) {
-        if let Some(target) = self.on_market_data(data) {
-            tokio::task::block_in_place(|| {
+        if let Some(target) = self.on_market_data_batch(data) {
+            crate::framework::executor::block_in_place(|| {
                 tokio::runtime::Handle::current().block_on(async {
                     let _ = outputs.target.send(target).await;
                 });
@@ -103,3 +103,22 @@ where
         &portfolio_manager::MANIFEST
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::manifest::PortDefinition;
+    use crate::microservice::configuration::feeder::feeder_gen;
+
+    #[test]
+    fn test_market_data_input_takes_the_feeder_batches() {
+        let data_type = |ports: &[PortDefinition], name: &str| {
+            let port = ports.iter().find(|port| port.name == name).unwrap();
+            port.data_type.clone()
+        };
+        assert_eq!(
+            data_type(&portfolio_manager::MANIFEST.inputs, "market_data"),
+            data_type(&feeder_gen::MANIFEST.outputs, "market_data")
+        );
+    }
+}
@@ -6,7 +6,7 @@ use crate::microservice::configuration::Configurable;
 use crate::model::identity::Id;
 use crate::{
     framework::runner_manager::RunnerManager,
-    model::{allocation_batch::AllocationBatch, market_data::MarketDataBatch},
+    model::{allocation_batch::AllocationBatch, market_data::MarketDataBatchView},
 };
 use trading::Strategist; // External trait
 
@@ -14,7 +14,7 @@ define_service!(
     name: strategy,
     service_type: "Strategy",
     inputs: {
-        market_data => fn on_market_data(MarketDataBatch) [ required: true, variadic: false ]
+        market_data => fn on_market_data(MarketDataBatch) [ required: true, variadic: false, view: MarketDataBatchView ]
     },
     outputs: {
         allocation => AllocationBatch
@@ -37,13 +37,22 @@ impl<State> strategy::Handler for State
 where
     State: Strategist + Send + 'static,
 {
-    fn on_market_data(&mut self, _id: Id, data: MarketDataBatch, outputs: &mut strategy::Outputs) {
-        let allocation_batch = self.on_market_data(data);
-        tokio::task::block_in_place(|| {
+    fn on_market_data(
+        &mut self,
+        _id: Id,
+        data: MarketDataBatchView<'_>,
+        outputs: &mut strategy::Outputs,
+    ) {
+        let allocation_batch = self.on_market_data_view(data);
+        if allocation_batch.is_empty() {
+            return;
+        }
+        crate::framework::executor::block_in_place(|| {
             tokio::runtime::Handle::current().block_on(async {
-                let _ = outputs.allocation.send(allocation_batch).await;
+                let _ = outputs.allocation.send_ref(&allocation_batch).await;
             });
         });
+        self.recycle(allocation_batch);
     }
 }
 
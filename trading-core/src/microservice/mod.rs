@@ -83,6 +83,21 @@ where
     where
         F: FnOnce(&CommonArgs) -> Config::State,
     {
+        // Must happen before the first socket is created and the first runner started.
+        if let Err(e) = comms::transports::zmq::set_io_threads(args.get_zmq_io_threads()) {
+            log::warn!("Microservice: {}", e);
+        }
+        if let Err(e) = crate::framework::executor::set_worker_threads(args.get_runner_threads()) {
+            log::warn!("Microservice: {}", e);
+        }
+        match args.get_placement() {
+            Ok(placement) => {
+                if let Err(e) = crate::framework::executor::set_placement(placement) {
+                    log::warn!("Microservice: {}", e);
+                }
+            }
+            Err(e) => log::warn!("Microservice: ignoring placement hints: {}", e),
+        }
         let state = initial_state(&args);
         Self {
             state: Arc::new(Mutex::new(state)),
@@ -221,6 +236,9 @@ where
                     serde_json::to_value(self.registry.clone()).unwrap(),
                 )),
                 AdminCommand::Status => AdminPayload::new_response(AdminResponse::Ok),
+                AdminCommand::Metrics => {
+                    AdminPayload::new_response(AdminResponse::Metrics(crate::metrics::snapshot()))
+                }
                 AdminCommand::UpdateRegistry { key, value } => {
                     self.registry.update_parameter(&key, value);
                     if let Some(callback) = self.on_registry_update.as_mut() {
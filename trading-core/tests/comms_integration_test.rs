@@ -26,7 +26,7 @@ async fn test_zmq_pipeline_end_to_end() -> Result<()> {
 
     // 3. Create Publisher (Simulating Engine/Market Data Source)
     // builder returns Result<SenderSocket<T>> directly
-    let publisher: SenderSocket<MarketDataBatch> =
+    let mut publisher: SenderSocket<MarketDataBatch> =
         build_publisher(&pub_addr, source_identity.get_identifier())?;
 
     // 4. Create Subscriber (Simulating Strategy)
@@ -59,7 +59,7 @@ async fn test_zmq_pipeline_end_to_end() -> Result<()> {
     // 9. Verify Allocation (New Port)
     let alloc_addr = Address::zmq_tcp("127.0.0.1", 5996);
 
-    let alloc_sender: SenderSocket<Allocation> =
+    let mut alloc_sender: SenderSocket<Allocation> =
         build_publisher(&alloc_addr, source_identity.get_identifier())?;
     let mut alloc_receiver: ReceiverSocket<Allocation> = build_subscriber(&alloc_addr)?;
 
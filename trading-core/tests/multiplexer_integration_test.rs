@@ -42,7 +42,7 @@ fn test_multiplexer_dynamic_add_strategy() {
 
     // 2. Setup Dummy Publishers (Strategies)
     let id1 = Identity::new("strategy_1", "1.0", 1);
-    let publisher1 =
+    let mut publisher1 =
         build_publisher::<AllocationBatch>(&strategy_1_addr, id1.get_identifier()).unwrap();
     let id2 = Identity::new("strategy_2", "1.0", 2);
     let _publisher2 =
@@ -63,6 +63,8 @@ fn test_multiplexer_dynamic_add_strategy() {
             Binding::Single(Source {
                 address: admin_addr,
                 id: 0,
+                universe: Vec::new(),
+                subscribers: None,
             }),
         );
         // Initial dummy connection for allocation input
@@ -75,6 +77,8 @@ fn test_multiplexer_dynamic_add_strategy() {
             Binding::Single(Source {
                 address: execution_addr_clone,
                 id: 0,
+                universe: Vec::new(),
+                subscribers: None,
             }),
         );
 
@@ -122,6 +126,8 @@ fn test_multiplexer_dynamic_add_strategy() {
         Source {
             address: Address::zmq_tcp("127.0.0.1", strategy_1_port),
             id: 1,
+            universe: Vec::new(),
+            subscribers: None,
         },
     );
     new_inputs.insert("strategies".to_string(), Binding::Variadic(strategies_map));
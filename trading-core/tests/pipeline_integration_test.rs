@@ -17,6 +17,7 @@ use trading_core::{
         allocation::{Allocation, Position},
         allocation_batch::AllocationBatch,
         execution::{ExecutionResult, ExecutionStatus},
+        execution_batch::ExecutionBatch,
         identity::Id,
         market_data::PriceUpdate,
         order::{Order, OrderSide, OrderType},
@@ -46,11 +47,11 @@ impl Manager for SimpleManager {
         // Super simple logic: If we see Apple, buy 10 units.
         let mut p = Portfolio::new();
         for alloc in batch.iter() {
-            for (inst_id, _) in alloc.get_positions() {
-                p.update_position(*inst_id, 10.0);
+            for pos in alloc.get_positions() {
+                p.update_position(pos.get_instrument_id(), 10.0);
             }
         }
-        Some(Target(p))
+        Some(Target::new(p))
     }
     fn on_portfolio(&mut self, _portfolio: Actual) -> Option<Target> {
         None
@@ -66,10 +67,11 @@ impl Executor for SimpleExecutor {
     fn on_target(&mut self, target: Target) -> (Vec<Order>, Option<Actual>) {
         let mut orders = Vec::new();
         // For every position in target, create a buy order (assuming we have 0)
-        for (inst_id, pos) in &target.0.positions {
+        for pos in &target.0.positions {
+            let inst_id = pos.get_instrument_id();
             orders.push(Order::new(
-                format!("ord-{}", inst_id),
-                format!("{}", inst_id),
+                inst_id as u64,
+                inst_id,
                 OrderSide::buy(),
                 OrderType::market(),
                 0.0,
@@ -107,6 +109,8 @@ fn make_binding(port: u16) -> Binding {
     Binding::Single(trading_core::manifest::Source {
         address: Address::Zmq(format!("tcp://127.0.0.1:{}", port)),
         id: 0,
+        universe: Vec::new(),
+        subscribers: None,
     })
 }
 
@@ -195,7 +199,7 @@ fn test_pipeline_integration() {
     // --- TEST INJECTION ---
     // Inject Allocation into Mux Input (simulate Strategy)
     // We use a raw publisher for this
-    let strategy_pub = trading_core::comms::build_publisher::<AllocationBatch>(
+    let mut strategy_pub = trading_core::comms::build_publisher::<AllocationBatch>(
         &Address::Zmq(format!("tcp://127.0.0.1:{}", port_alloc_input)),
         Id::from(999usize),
     )
@@ -221,7 +225,7 @@ fn test_pipeline_integration() {
     // (Implies: Strat -> Mux -> PM -> Exec -> Broker -> Exec Result)
     // We can listen to `port_exec_result_output`.
 
-    let mut result_sub = trading_core::comms::build_subscriber::<ExecutionResult>(&Address::Zmq(
+    let mut result_sub = trading_core::comms::build_subscriber::<ExecutionBatch>(&Address::Zmq(
         format!("tcp://127.0.0.1:{}", port_exec_result_output),
     ))
     .unwrap();
@@ -240,7 +244,11 @@ fn test_pipeline_integration() {
         });
 
     if let Some(Ok(packet)) = result {
-        let exec_res = packet.data();
+        let exec_res = packet
+            .data()
+            .into_iter()
+            .next()
+            .expect("empty execution batch");
         println!("Received Execution: {:?}", exec_res);
         assert_eq!(exec_res.status, ExecutionStatus::Filled);
         assert_eq!(exec_res.last_filled_quantity, 10.0); // SimpleManager converted 0.5 -> 10.0